@@ -22,6 +22,7 @@
 #include "tfrt/core_runtime/op_attrs.h"
 #include "tfrt/core_runtime/op_utils.h"
 #include "tfrt/cpu/core_runtime/cpu_op_registry.h"
+#include "tfrt/cpu/ops/tf/buffer_forwarding.h"
 
 namespace tfrt {
 namespace compat {
@@ -151,7 +152,7 @@ static AsyncValueRef<DenseHostTensor> TfConv2DOp(
 }
 
 static std::array<AsyncValueRef<DenseHostTensor>, 6> TfFusedBatchNormV3Op(
-    const DenseHostTensor& input, const DenseHostTensor& scale,
+    Argument<DenseHostTensor> input, const DenseHostTensor& scale,
     const DenseHostTensor& bias, const DenseHostTensor& mean,
     const DenseHostTensor& variance, const OpAttrsRef& attrs,
     const TensorMetadata& output_md0, const TensorMetadata& output_md1,
@@ -166,12 +167,6 @@ static std::array<AsyncValueRef<DenseHostTensor>, 6> TfFusedBatchNormV3Op(
     results[i] = result.CopyRef();
   }
 
-  auto output = DenseHostTensor::CreateUninitialized(output_md0, host);
-  if (!output) {
-    result.SetError("out of memory allocating tensor");
-    return results;
-  }
-
   if (output_md1.IsValid() || output_md2.IsValid() || output_md3.IsValid() ||
       output_md4.IsValid() || output_md5.IsValid()) {
     result.SetError("TfFusedBatchNormV3Op only supports one valid output");
@@ -190,8 +185,20 @@ static std::array<AsyncValueRef<DenseHostTensor>, 6> TfFusedBatchNormV3Op(
     return results;
   }
 
+  // Batch normalization is computed independently for each input element, so
+  // the input can be forwarded to the output.
+  AsyncValueRef<DenseHostTensor> output =
+      ForwardInputOrAllocateOutput(exec_ctx, output_md0, input);
+  if (output.IsError()) {
+    result = std::move(output);
+    for (int i = 0; i < 6; ++i) {
+      results[i] = result.CopyRef();
+    }
+    return results;
+  }
+
   AsyncValueRef<Chain> chain;
-  switch (input.dtype()) {
+  switch (input->dtype()) {
     default:
       chain = EmitErrorAsync(exec_ctx,
                              "unsupported dtype for TfFusedBatchNormV3Op");
@@ -199,13 +206,13 @@ static std::array<AsyncValueRef<DenseHostTensor>, 6> TfFusedBatchNormV3Op(
 #define DTYPE_FLOAT(ENUM)                                                 \
   case DType::ENUM:                                                       \
     chain = FusedBatchNormV3Impl<EigenTypeForDTypeKind<DType::ENUM>>(     \
-        input, scale, bias, mean, variance, output.getPointer(), epsilon, \
+        *input, scale, bias, mean, variance, &output.get(), epsilon,      \
         exec_ctx);                                                        \
     break;
 #include "tfrt/dtype/dtype.def"  // NOLINT
   }
 
-  result = ForwardValue(output.getValue(), std::move(chain));
+  result = ForwardOutput(std::move(output), std::move(chain));
   for (int i = 0; i < 6; ++i) {
     results[i] = result.CopyRef();
   }
@@ -72,6 +72,17 @@ static Expected<TensorMetadata> TfBinaryComparisonOpMd(
   return CwiseBinaryOpMd(lhs, rhs, DType::I1);
 }
 
+// The fused ops apply the binary operations to the fusion inputs one by one,
+// so the result has the broadcasted shape of all the arguments.
+static Expected<TensorMetadata> TfFusedCwiseOpMd(
+    const TensorMetadata& x, VariadicOpArg<TensorMetadata> fusion_inputs) {
+  TensorMetadata result = x;
+  for (size_t i = 0; i < fusion_inputs.size(); ++i) {
+    TFRT_ASSIGN_OR_RETURN(result, CwiseBinaryOpMd(result, fusion_inputs[i]));
+  }
+  return result;
+}
+
 static Expected<TensorMetadata> ConstOpMd(const OpAttrsRef& attrs) {
   tfrt::DenseAttr dense_attr;
   if (!attrs.Get("value", &dense_attr)) {
@@ -491,6 +502,7 @@ GetAllTFMetadataFunctions() {
     result->emplace_back("tf.Tanh", TFRT_METADATA(UnaryIdentityMd));
     result->emplace_back("tf.MatMul", TFRT_METADATA(MatMulMd));
     result->emplace_back("tf._FusedMatMul", TFRT_METADATA(MatMulMd));
+    result->emplace_back("tf._FusedCwise", TFRT_METADATA(TfFusedCwiseOpMd));
     result->emplace_back("tf.Less", TFRT_METADATA(TfBinaryComparisonOpMd));
     result->emplace_back("tf.Log", TFRT_METADATA(UnaryIdentityMd));
     result->emplace_back("tf.Log1p", TFRT_METADATA(UnaryIdentityMd));
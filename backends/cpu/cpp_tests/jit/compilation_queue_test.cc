@@ -0,0 +1,127 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "tfrt/cpu/jit/cpurt.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/support/latch.h"
+#include "tfrt/support/mutex.h"
+
+namespace tfrt {
+namespace {
+
+using ::tfrt::cpu::jit::CompilationQueue;
+using ::tfrt::cpu::jit::JitExecutable;
+
+std::unique_ptr<HostContext> CreateTestHostContext() {
+  return std::make_unique<HostContext>(
+      [](const DecodedDiagnostic&) {}, CreateMallocAllocator(),
+      CreateMultiThreadedWorkQueue(/*num_threads=*/2,
+                                   /*num_blocking_threads=*/4));
+}
+
+ExecutionContext CreateExecutionContext(HostContext* host) {
+  Expected<RCReference<RequestContext>> req_ctx =
+      RequestContextBuilder(host, /*resource_context=*/nullptr).build();
+  EXPECT_TRUE(!!req_ctx);
+  return ExecutionContext(std::move(*req_ctx));
+}
+
+TEST(CompilationQueueTest, BoundsConcurrentCompilations) {
+  auto host = CreateTestHostContext();
+  ExecutionContext exec_ctx = CreateExecutionContext(host.get());
+
+  auto queue = std::make_shared<CompilationQueue>(
+      /*max_concurrent_compilations=*/2);
+  JitExecutable::CompilationTaskRunner runner =
+      CompilationQueue::TaskRunner(queue);
+
+  const int num_tasks = 8;
+  std::atomic<int> running{0};
+  std::atomic<int> max_running{0};
+  latch done(num_tasks);
+
+  for (int i = 0; i < num_tasks; ++i) {
+    runner(
+        /*num_specializations=*/i, {}, {},
+        [&]() {
+          int now = ++running;
+          int max = max_running.load();
+          while (now > max && !max_running.compare_exchange_weak(max, now)) {
+          }
+          std::this_thread::sleep_for(std::chrono::milliseconds(5));
+          --running;
+          done.count_down();
+        },
+        exec_ctx);
+  }
+
+  done.wait();
+  host->Quiesce();
+  EXPECT_LE(max_running.load(), 2);
+  EXPECT_EQ(queue->num_pending(), 0);
+}
+
+TEST(CompilationQueueTest, RunsPendingTasksInOrder) {
+  auto host = CreateTestHostContext();
+  ExecutionContext exec_ctx = CreateExecutionContext(host.get());
+
+  auto queue = std::make_shared<CompilationQueue>(
+      /*max_concurrent_compilations=*/1);
+  JitExecutable::CompilationTaskRunner runner =
+      CompilationQueue::TaskRunner(queue);
+
+  // The first task keeps the only compilation slot until it is released.
+  latch release(1);
+  runner(0, {}, {}, [&]() { release.wait(); }, exec_ctx);
+
+  mutex mu;
+  std::vector<int> order;
+  latch done(3);
+  for (int i = 1; i <= 3; ++i) {
+    runner(
+        i, {}, {},
+        [&, i]() {
+          {
+            mutex_lock lock(mu);
+            order.push_back(i);
+          }
+          done.count_down();
+        },
+        exec_ctx);
+  }
+  EXPECT_EQ(queue->num_pending(), 3);
+
+  release.count_down();
+  done.wait();
+  host->Quiesce();
+  EXPECT_EQ(order, std::vector<int>({1, 2, 3}));
+  EXPECT_EQ(queue->num_pending(), 0);
+}
+
+}  // namespace
+}  // namespace tfrt
@@ -0,0 +1,198 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/SmallVector.h"
+#include "tfrt/cpu/jit/cpurt.h"
+#include "tfrt/dtype/dtype.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_context.h"
+
+namespace tfrt {
+namespace {
+
+using ::tfrt::cpu::jit::CompilationOptions;
+using ::tfrt::cpu::jit::Executable;
+using ::tfrt::cpu::jit::JitExecutable;
+using ::tfrt::cpu::jit::MemrefDesc;
+using ::tfrt::cpu::jit::OperandConstraint;
+using ::tfrt::cpu::jit::SpecializationsCache;
+
+using Key = SpecializationsCache::Key;
+
+llvm::hash_code Hash(const Key& key) {
+  return llvm::hash_combine_range(key.begin(), key.end());
+}
+
+// Allocates an entry for the key and marks it as compiled (with an error, to
+// avoid compiling a real executable).
+AsyncValueRef<Executable> AllocateCompiled(SpecializationsCache& cache,
+                                           const Key& key) {
+  SpecializationsCache::Entry entry = cache.Allocate(key, Hash(key));
+  EXPECT_TRUE(entry.allocated);
+  entry.executable.SetError("compiled");
+  return entry.executable;
+}
+
+TEST(SpecializationsCacheTest, FindAllocated) {
+  SpecializationsCache cache(/*capacity=*/0);
+  Key key = {2, 10, 20};
+
+  EXPECT_FALSE(cache.Find(key, Hash(key)));
+
+  SpecializationsCache::Entry entry = cache.Allocate(key, Hash(key));
+  EXPECT_TRUE(entry.allocated);
+  EXPECT_EQ(entry.specialization, 0u);
+
+  // The second allocation returns the in-flight executable.
+  SpecializationsCache::Entry again = cache.Allocate(key, Hash(key));
+  EXPECT_FALSE(again.allocated);
+  EXPECT_EQ(again.executable, entry.executable);
+
+  EXPECT_EQ(cache.Find(key, Hash(key)), entry.executable);
+  EXPECT_EQ(cache.size(), 1u);
+  entry.executable.SetError("compiled");
+}
+
+TEST(SpecializationsCacheTest, HashCollision) {
+  SpecializationsCache cache(/*capacity=*/0);
+  Key key0 = {1, 10};
+  Key key1 = {1, 11};
+
+  // Store both keys with the same hash.
+  llvm::hash_code hash = Hash(key0);
+  SpecializationsCache::Entry entry0 = cache.Allocate(key0, hash);
+  EXPECT_FALSE(cache.Find(key1, hash));
+  SpecializationsCache::Entry entry1 = cache.Allocate(key1, hash);
+  EXPECT_TRUE(entry1.allocated);
+  EXPECT_NE(entry0.executable, entry1.executable);
+
+  EXPECT_EQ(cache.Find(key0, hash), entry0.executable);
+  EXPECT_EQ(cache.Find(key1, hash), entry1.executable);
+
+  entry0.executable.SetError("compiled");
+  entry1.executable.SetError("compiled");
+}
+
+TEST(SpecializationsCacheTest, EvictLeastRecentlyUsed) {
+  SpecializationsCache cache(/*capacity=*/2);
+  Key key0 = {1, 10};
+  Key key1 = {1, 11};
+  Key key2 = {1, 12};
+
+  AsyncValueRef<Executable> executable0 = AllocateCompiled(cache, key0);
+  AllocateCompiled(cache, key1);
+
+  // Use key0, so that key1 becomes the least recently used.
+  EXPECT_EQ(cache.Find(key0, Hash(key0)), executable0);
+
+  AllocateCompiled(cache, key2);
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_TRUE(cache.Find(key0, Hash(key0)));
+  EXPECT_FALSE(cache.Find(key1, Hash(key1)));
+  EXPECT_TRUE(cache.Find(key2, Hash(key2)));
+
+  // Evicted executable stays alive while it is referenced.
+  EXPECT_TRUE(executable0.IsError());
+}
+
+TEST(SpecializationsCacheTest, DoNotEvictPendingCompilation) {
+  SpecializationsCache cache(/*capacity=*/1);
+  Key key0 = {1, 10};
+  Key key1 = {1, 11};
+
+  SpecializationsCache::Entry entry0 = cache.Allocate(key0, Hash(key0));
+  SpecializationsCache::Entry entry1 = cache.Allocate(key1, Hash(key1));
+
+  // Both compilations are in flight, so the cache is temporarily above its
+  // capacity.
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_FALSE(cache.Allocate(key0, Hash(key0)).allocated);
+
+  entry0.executable.SetError("compiled");
+  entry1.executable.SetError("compiled");
+}
+
+// Returns a fake memref operand of the given shape.
+MemrefDesc FakeMemref(ArrayRef<Index> sizes) {
+  MemrefDesc desc;
+  desc.dtype = DType::F32;
+  desc.data = nullptr;
+  desc.offset = 0;
+  desc.sizes.assign(sizes.begin(), sizes.end());
+  desc.strides.assign(sizes.size(), 1);
+  return desc;
+}
+
+TEST(SpecializationsCacheTest, JitExecutableEvictsSpecializations) {
+  auto host = std::make_unique<HostContext>(
+      [](const DecodedDiagnostic&) {}, CreateMallocAllocator(),
+      CreateSingleThreadedWorkQueue());
+  Expected<RCReference<RequestContext>> req_ctx =
+      RequestContextBuilder(host.get(), /*resource_context=*/nullptr).build();
+  ASSERT_TRUE(!!req_ctx);
+  ExecutionContext exec_ctx(std::move(*req_ctx));
+
+  const char* mlir_module = R"(
+    func @compute(%arg0: memref<?x?xf32>) {
+      return
+    })";
+
+  CompilationOptions opts;
+  opts.max_num_specializations = 2;
+
+  // Compile specializations in the caller thread.
+  auto runner = [](size_t, ArrayRef<OperandConstraint>, ArrayRef<MemrefDesc>,
+                   TaskFunction task, const ExecutionContext&) { task(); };
+
+  Expected<JitExecutable> jit_executable =
+      JitExecutable::Instantiate(mlir_module, "compute", opts, runner);
+  ASSERT_FALSE(jit_executable.takeError());
+
+  auto get_executable = [&](ArrayRef<Index> sizes) {
+    llvm::SmallVector<MemrefDesc> operands;
+    operands.push_back(FakeMemref(sizes));
+    Expected<AsyncValueRef<Executable>> executable =
+        jit_executable->GetExecutable(operands, exec_ctx);
+    EXPECT_FALSE(executable.takeError());
+    EXPECT_TRUE(executable->IsConcrete());
+    return std::move(*executable);
+  };
+
+  // Dimensions of size 1 are part of the symbolic shape, so each of these
+  // operands needs its own specialization.
+  AsyncValueRef<Executable> executable0 = get_executable({1, 1});
+  AsyncValueRef<Executable> executable1 = get_executable({1, 8});
+  EXPECT_EQ(get_executable({1, 1}), executable0);
+
+  // The third specialization evicts the least recently used one.
+  AsyncValueRef<Executable> executable2 = get_executable({8, 1});
+  EXPECT_EQ(get_executable({1, 1}), executable0);
+  EXPECT_EQ(get_executable({8, 1}), executable2);
+  EXPECT_NE(get_executable({1, 8}), executable1);
+
+  // The evicted executable is still alive while it is referenced.
+  EXPECT_TRUE(executable1.IsConcrete());
+}
+
+}  // namespace
+}  // namespace tfrt
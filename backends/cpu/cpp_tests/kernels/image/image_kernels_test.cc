@@ -0,0 +1,201 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit tests for the image resize and decode kernels.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "third_party/libjpeg_turbo/jpeglib.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/host_context/kernel_registry.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+#include "tfrt/tensor/tensor_shape.h"
+#include "tfrt/utils/kernel_runner.h"
+
+namespace tfrt {
+namespace {
+
+using ::testing::ElementsAreArray;
+using ::testing::Each;
+using ::testing::FloatNear;
+
+std::unique_ptr<HostContext> CreateTestHostContext() {
+  auto host = std::make_unique<HostContext>(
+      [](const DecodedDiagnostic&) {}, CreateMallocAllocator(),
+      CreateMultiThreadedWorkQueue(/*num_threads=*/2,
+                                   /*num_blocking_threads=*/1));
+  RegisterStaticKernels(host->GetMutableRegistry());
+  return host;
+}
+
+DenseHostTensor MakeTensor(HostContext* host, ArrayRef<Index> dims,
+                           ArrayRef<uint8_t> values) {
+  auto tensor =
+      DenseHostTensor::CreateUninitialized<uint8_t>(TensorShape(dims), host);
+  std::copy(values.begin(), values.end(), tensor->data<uint8_t>());
+  return std::move(*tensor);
+}
+
+ArrayRef<float> Values(const DenseHostTensor& tensor) {
+  return {tensor.data<float>(),
+          static_cast<size_t>(tensor.shape().GetNumElements())};
+}
+
+// Returns a jpeg image of `width` x `height` pixels with the `rgb` color.
+std::string EncodeJpeg(int width, int height, ArrayRef<uint8_t> rgb) {
+  jpeg_compress_struct cinfo;
+  jpeg_error_mgr jerr;
+  cinfo.err = jpeg_std_error(&jerr);
+  jpeg_create_compress(&cinfo);
+
+  unsigned char* buffer = nullptr;
+  unsigned long size = 0;  // NOLINT(runtime/int)
+  jpeg_mem_dest(&cinfo, &buffer, &size);
+  cinfo.image_width = width;
+  cinfo.image_height = height;
+  cinfo.input_components = 3;
+  cinfo.in_color_space = JCS_RGB;
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, /*quality=*/100, /*force_baseline=*/TRUE);
+  jpeg_start_compress(&cinfo, /*write_all_tables=*/TRUE);
+
+  std::vector<uint8_t> row;
+  for (int x = 0; x < width; ++x) row.insert(row.end(), rgb.begin(), rgb.end());
+  while (cinfo.next_scanline < cinfo.image_height) {
+    JSAMPROW row_pointer = row.data();
+    jpeg_write_scanlines(&cinfo, &row_pointer, 1);
+  }
+  jpeg_finish_compress(&cinfo);
+  jpeg_destroy_compress(&cinfo);
+
+  std::string image(reinterpret_cast<const char*>(buffer), size);
+  free(buffer);
+  return image;
+}
+
+TEST(ImageKernelsTest, ResizeBilinear) {
+  auto host = CreateTestHostContext();
+  KernelRunner runner("tfrt_test.resize_bilinear", host.get());
+  runner.SetArgs(MakeTensor(host.get(), {2, 2, 1}, {0, 100, 200, 40}),
+                 Index{4}, Index{4});
+
+  const auto& output = runner.RunAndGetResult<DenseHostTensor>();
+  EXPECT_EQ(output.shape(), TensorShape({4, 4, 1}));
+  EXPECT_THAT(Values(output),
+              ElementsAreArray({0.0f, 50.0f, 100.0f, 100.0f,    //
+                                100.0f, 85.0f, 70.0f, 70.0f,    //
+                                200.0f, 120.0f, 40.0f, 40.0f,   //
+                                200.0f, 120.0f, 40.0f, 40.0f}));
+}
+
+TEST(ImageKernelsTest, ResizeNearestNeighborBatch) {
+  auto host = CreateTestHostContext();
+  KernelRunner runner("tfrt_test.resize_nearest_neighbor", host.get());
+  runner.SetArgs(MakeTensor(host.get(), {2, 1, 2, 1}, {0, 100, 200, 40}),
+                 Index{1}, Index{4});
+
+  const auto& output = runner.RunAndGetResult<DenseHostTensor>();
+  EXPECT_EQ(output.shape(), TensorShape({2, 1, 4, 1}));
+  EXPECT_THAT(Values(output), ElementsAreArray({0.0f, 0.0f, 100.0f, 100.0f,  //
+                                                200.0f, 200.0f, 40.0f, 40.0f}));
+}
+
+TEST(ImageKernelsTest, ResizeEmptyInputIsError) {
+  auto host = CreateTestHostContext();
+  for (auto dims : {std::vector<Index>{0, 2, 1}, std::vector<Index>{2, 0, 1},
+                    std::vector<Index>{3, 0, 2, 1}}) {
+    KernelRunner runner("tfrt_test.resize_bilinear", host.get());
+    runner.SetArgs(MakeTensor(host.get(), dims, {}), Index{4}, Index{4});
+    runner.Run(1);
+    EXPECT_TRUE(runner.GetAsyncValueAt(0)->IsError());
+  }
+}
+
+TEST(ImageKernelsTest, DecodeAndResizeJpeg) {
+  auto host = CreateTestHostContext();
+  KernelRunner runner("tfrt_test.decode_and_resize_jpeg", host.get());
+  // The second image is large enough to be downscaled by the decoder.
+  runner.SetArgs(Index{4}, Index{6}, EncodeJpeg(6, 3, {40, 80, 120}),
+                 EncodeJpeg(64, 48, {200, 100, 20}));
+  runner.AddArrayAttribute<float>({20.0f})
+      .AddArrayAttribute<float>({2.0f, 4.0f, 10.0f});
+
+  const auto& output = runner.RunAndGetResult<DenseHostTensor>();
+  EXPECT_EQ(output.shape(), TensorShape({2, 4, 6, 3}));
+  ArrayRef<float> values = Values(output);
+  const size_t num_pixels = 4 * 6;
+  for (size_t i = 0; i < num_pixels; ++i) {
+    EXPECT_NEAR(values[3 * i], (40 - 20) / 2.0f, 1.0f);
+    EXPECT_NEAR(values[3 * i + 1], (80 - 20) / 4.0f, 1.0f);
+    EXPECT_NEAR(values[3 * i + 2], (120 - 20) / 10.0f, 1.0f);
+  }
+  ArrayRef<float> second = values.drop_front(3 * num_pixels);
+  for (size_t i = 0; i < num_pixels; ++i) {
+    EXPECT_NEAR(second[3 * i], (200 - 20) / 2.0f, 1.0f);
+    EXPECT_NEAR(second[3 * i + 1], (100 - 20) / 4.0f, 1.0f);
+    EXPECT_NEAR(second[3 * i + 2], (20 - 20) / 10.0f, 1.0f);
+  }
+}
+
+TEST(ImageKernelsTest, DecodeAndResizeJpegWithoutNormalization) {
+  auto host = CreateTestHostContext();
+  KernelRunner runner("tfrt_test.decode_and_resize_jpeg", host.get());
+  runner.SetArgs(Index{2}, Index{2}, EncodeJpeg(8, 8, {90, 90, 90}));
+  runner.AddArrayAttribute<float>({0.0f}).AddArrayAttribute<float>({1.0f});
+
+  const auto& output = runner.RunAndGetResult<DenseHostTensor>();
+  EXPECT_EQ(output.shape(), TensorShape({1, 2, 2, 3}));
+  EXPECT_THAT(Values(output), Each(FloatNear(90.0f, 2.0f)));
+}
+
+TEST(ImageKernelsTest, DecodeAndResizeJpegErrors) {
+  auto host = CreateTestHostContext();
+  std::string image = EncodeJpeg(4, 4, {0, 0, 0});
+
+  // Not a jpeg image.
+  KernelRunner not_jpeg("tfrt_test.decode_and_resize_jpeg", host.get());
+  not_jpeg.SetArgs(Index{2}, Index{2}, std::string("not a jpeg"));
+  not_jpeg.AddArrayAttribute<float>({0.0f}).AddArrayAttribute<float>({1.0f});
+  not_jpeg.Run(1);
+  EXPECT_TRUE(not_jpeg.GetAsyncValueAt(0)->IsError());
+
+  // Empty output size.
+  KernelRunner empty_output("tfrt_test.decode_and_resize_jpeg", host.get());
+  empty_output.SetArgs(Index{0}, Index{2}, image);
+  empty_output.AddArrayAttribute<float>({0.0f}).AddArrayAttribute<float>(
+      {1.0f});
+  empty_output.Run(1);
+  EXPECT_TRUE(empty_output.GetAsyncValueAt(0)->IsError());
+
+  // Zero standard deviation.
+  KernelRunner zero_stddev("tfrt_test.decode_and_resize_jpeg", host.get());
+  zero_stddev.SetArgs(Index{2}, Index{2}, image);
+  zero_stddev.AddArrayAttribute<float>({0.0f}).AddArrayAttribute<float>(
+      {0.0f});
+  zero_stddev.Run(1);
+  EXPECT_TRUE(zero_stddev.GetAsyncValueAt(0)->IsError());
+}
+
+}  // namespace
+}  // namespace tfrt
@@ -0,0 +1,168 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Image resize tests and benchmarks.
+
+#include "../../../lib/kernels/image/resize_op.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "tfrt/dtype/dtype.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+#include "tfrt/tensor/tensor_metadata.h"
+#include "tfrt/tensor/tensor_shape.h"
+
+namespace tfrt {
+namespace image {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+std::unique_ptr<HostContext> CreateTestHostContext(int num_threads) {
+  return std::make_unique<HostContext>(
+      [](const DecodedDiagnostic&) {}, CreateMallocAllocator(),
+      CreateMultiThreadedWorkQueue(num_threads, num_threads));
+}
+
+TEST(ResizeOpTest, Bilinear) {
+  std::vector<uint8_t> input = {0, 100, 200, 40};
+  std::vector<float> output(16);
+
+  ImageResizer resizer(ResizeMethod::kBilinear, 2, 2, 4, 4, 1);
+  resizer.ResizeRows(input.data(), output.data(), 0, 4);
+
+  EXPECT_THAT(output, ElementsAreArray({0.0f, 50.0f, 100.0f, 100.0f,    //
+                                        100.0f, 85.0f, 70.0f, 70.0f,    //
+                                        200.0f, 120.0f, 40.0f, 40.0f,   //
+                                        200.0f, 120.0f, 40.0f, 40.0f}));
+}
+
+TEST(ResizeOpTest, BilinearChannels) {
+  // Two pixels with three channels resized to four pixels.
+  std::vector<float> input = {0.0f, 10.0f, 20.0f, 100.0f, 110.0f, 120.0f};
+  std::vector<float> output(12);
+
+  ImageResizer resizer(ResizeMethod::kBilinear, 1, 2, 1, 4, 3);
+  resizer.ResizeRows(input.data(), output.data(), 0, 1);
+
+  EXPECT_THAT(output, ElementsAreArray({0.0f, 10.0f, 20.0f,     //
+                                        50.0f, 60.0f, 70.0f,    //
+                                        100.0f, 110.0f, 120.0f,  //
+                                        100.0f, 110.0f, 120.0f}));
+}
+
+TEST(ResizeOpTest, NearestNeighbor) {
+  std::vector<uint8_t> input = {0, 100, 200, 40};
+  std::vector<float> output(16);
+
+  ImageResizer resizer(ResizeMethod::kNearestNeighbor, 2, 2, 4, 4, 1);
+  resizer.ResizeRows(input.data(), output.data(), 0, 4);
+
+  EXPECT_THAT(output, ElementsAreArray({0.0f, 0.0f, 100.0f, 100.0f,      //
+                                        0.0f, 0.0f, 100.0f, 100.0f,      //
+                                        200.0f, 200.0f, 40.0f, 40.0f,    //
+                                        200.0f, 200.0f, 40.0f, 40.0f}));
+}
+
+TEST(ResizeOpTest, Normalization) {
+  std::vector<uint8_t> input = {10, 20, 30, 40};
+  std::vector<float> output(4);
+
+  std::vector<float> mean = {10.0f, 20.0f};
+  std::vector<float> stddev = {2.0f};
+  ImageResizer resizer(ResizeMethod::kNearestNeighbor, 1, 2, 1, 2, 2,
+                       {mean, stddev});
+  resizer.ResizeRows(input.data(), output.data(), 0, 1);
+
+  EXPECT_THAT(output, ElementsAre(0.0f, 0.0f, 10.0f, 10.0f));
+}
+
+TEST(ResizeOpTest, BatchRows) {
+  // Two images with a single row, only the second image is resized.
+  std::vector<uint8_t> input = {0, 100, 200, 40};
+  std::vector<float> output(8, -1.0f);
+
+  ImageResizer resizer(ResizeMethod::kBilinear, 1, 2, 1, 4, 1);
+  resizer.ResizeRows(input.data(), output.data(), 1, 2);
+
+  EXPECT_THAT(output, ElementsAre(-1.0f, -1.0f, -1.0f, -1.0f,  //
+                                  200.0f, 120.0f, 40.0f, 40.0f));
+}
+
+}  // namespace
+
+template <typename T>
+void BenchmarkResize(benchmark::State& state, int num_threads,
+                     ResizeMethod method, Index batch_size,
+                     Index input_height, Index input_width) {
+  static constexpr Index kOutputSize = 224;
+  static constexpr Index kChannels = 3;
+
+  auto host = CreateTestHostContext(num_threads);
+  Expected<RCReference<RequestContext>> req_ctx =
+      RequestContextBuilder(host.get(), /*resource_context=*/nullptr).build();
+  ASSERT_FALSE(!req_ctx);
+  ExecutionContext exec_ctx(std::move(*req_ctx));
+
+  TensorMetadata input_md(
+      GetDType<T>(), {batch_size, input_height, input_width, kChannels});
+  TensorMetadata output_md(GetDType<float>(),
+                           {batch_size, kOutputSize, kOutputSize, kChannels});
+
+  auto input = DenseHostTensor::CreateUninitialized(input_md, host.get());
+  auto output = DenseHostTensor::CreateUninitialized(output_md, host.get());
+  std::fill_n(input->template data<T>(), input_md.shape.GetNumElements(),
+              T(1));
+
+  std::vector<float> mean = {123.68f, 116.78f, 103.94f};
+  std::vector<float> stddev = {58.4f, 57.12f, 57.38f};
+
+  for (auto _ : state) {
+    AsyncValueRef<Chain> done = ResizeImages(
+        *input, output.getPointer(), method, {mean, stddev}, exec_ctx);
+    host->Await(done.CopyRCRef());
+  }
+
+  state.SetItemsProcessed(batch_size * state.iterations());
+}
+
+#define BM_Resize(T, METHOD, threads, B, H, W)                              \
+  static void BM_##METHOD##_##T##_##B##x##H##x##W##_tpool_##threads(        \
+      benchmark::State& state) {                                            \
+    BenchmarkResize<T>(state, threads, ResizeMethod::k##METHOD, B, H, W);   \
+  }                                                                         \
+  BENCHMARK(BM_##METHOD##_##T##_##B##x##H##x##W##_tpool_##threads)
+
+// Typical ImageNet image sizes resized to 224x224.
+BM_Resize(uint8_t, Bilinear, 1, 1, 375, 500);
+BM_Resize(uint8_t, Bilinear, 8, 32, 375, 500);
+BM_Resize(uint8_t, Bilinear, 8, 32, 480, 640);
+BM_Resize(float, Bilinear, 8, 32, 375, 500);
+BM_Resize(uint8_t, NearestNeighbor, 1, 1, 375, 500);
+BM_Resize(uint8_t, NearestNeighbor, 8, 32, 375, 500);
+BM_Resize(float, NearestNeighbor, 8, 32, 375, 500);
+
+}  // namespace image
+}  // namespace tfrt
@@ -14,7 +14,7 @@
 
 //  Tensorflow operations buffer forwarding unit tests.
 
-#include "../../../lib/ops/tf/buffer_forwarding.h"
+#include "tfrt/cpu/ops/tf/buffer_forwarding.h"
 
 #include "benchmark/benchmark.h"
 #include "gtest/gtest.h"
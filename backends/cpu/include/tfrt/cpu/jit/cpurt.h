@@ -26,6 +26,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <list>
 #include <memory>
 #include <string>
 #include <type_traits>
@@ -41,10 +42,13 @@
 #include "tfrt/cpu/jit/async_runtime.h"
 #include "tfrt/cpu/jit/async_runtime_api.h"
 #include "tfrt/dtype/dtype.h"
+#include "tfrt/host_context/execution_context.h"
 #include "tfrt/host_context/kernel_utils.h"
 #include "tfrt/host_context/task_function.h"
 #include "tfrt/support/forward_decls.h"
 #include "tfrt/support/msan.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
 
 // Forward declare Eigen types.
 namespace Eigen {
@@ -54,6 +58,7 @@ class ThreadPoolInterface;
 namespace tfrt {
 
 class ExecutionContext;
+class ResourceContext;
 class Tensor;
 
 namespace cpu {
@@ -193,6 +198,11 @@ struct CompilationOptions {
   // Change the default value to `kEnabled` once the problem is fixed.
   Specialization specialization = Specialization::kAlways;
 
+  // The maximum number of specialized executables kept by a JitExecutable. When
+  // the limit is reached the least recently used compiled specializations are
+  // evicted. Zero means that the number of specializations is unbounded.
+  size_t max_num_specializations = 128;
+
   // Register dialects that are allowed in the serialized module.
   std::function<void(mlir::DialectRegistry&)> register_dialects;
 
@@ -864,6 +874,77 @@ auto AsyncValuesCache<Key, Value>::Allocate(Key key) -> Entry {
   return {emplaced.first->getSecond().AsPtr(), true, cache_.size()};
 }
 
+//----------------------------------------------------------------------------//
+// Cache for specialized executables.
+//----------------------------------------------------------------------------//
+
+// Cache for the executables specialized to the operands shapes and values.
+//
+// Entries are looked up by the full specialization key, so a hash collision
+// never returns an executable compiled for different operands. If `capacity`
+// is not zero, the least recently used compiled executables are evicted once
+// the cache grows beyond the capacity. Executables that are still being
+// compiled are never evicted, so that concurrent requests for the same
+// specialization share a single compilation.
+//
+// Executables are returned as owning references, and an evicted executable is
+// destroyed only when its last user drops the reference.
+class SpecializationsCache {
+ public:
+  // Symbolic shapes of all operands followed by the bytes of the operands with
+  // a value constraint.
+  using Key = llvm::SmallVector<int64_t, 16>;
+
+  struct Entry {
+    AsyncValueRef<Executable> executable;
+    // True if the executable was allocated by this call, and the caller is
+    // responsible for eventually setting the error or emplacing the value.
+    bool allocated;
+    // Sequence number of the specialization in this cache.
+    size_t specialization;
+  };
+
+  explicit SpecializationsCache(size_t capacity) : capacity_(capacity) {}
+
+  // Returns the cached executable for the given key, or nullptr if it is not in
+  // the cache. `hash` must be the hash of the `key`.
+  AsyncValueRef<Executable> Find(const Key& key, llvm::hash_code hash);
+
+  // Returns the cached executable for the given key if it exists, otherwise
+  // allocates an async value in the unconstructed state for it.
+  Entry Allocate(const Key& key, llvm::hash_code hash);
+
+  // Returns the number of cached executables.
+  size_t size() const;
+
+ private:
+  struct Node {
+    llvm::hash_code hash;
+    Key key;
+    AsyncValueRef<Executable> executable;
+  };
+
+  // Cached nodes, the most recently used node is in the front.
+  using LruList = std::list<std::shared_ptr<Node>>;
+
+  LruList::iterator Lookup(const Key& key, llvm::hash_code hash)
+      TFRT_REQUIRES(mu_);
+  void MaybeEvict() TFRT_REQUIRES(mu_);
+
+  const size_t capacity_;
+
+  mutable tfrt::mutex mu_;
+  LruList lru_ TFRT_GUARDED_BY(mu_);
+  llvm::DenseMap<llvm::hash_code, llvm::SmallVector<LruList::iterator, 1>>
+      index_ TFRT_GUARDED_BY(mu_);
+  size_t num_allocated_ TFRT_GUARDED_BY(mu_) = 0;
+
+  // The node of the last cache hit, accessed with std::atomic_load/store. It is
+  // checked before taking the mutex, so that a stream of calls with the same
+  // operands does not contend on the lock or reorder the LRU list.
+  std::shared_ptr<Node> hot_;
+};
+
 //----------------------------------------------------------------------------//
 // Result of compiling MLIR module to executable kernel function.
 //----------------------------------------------------------------------------//
@@ -1195,7 +1276,7 @@ class JitExecutable {
 
   // Returns default executable that accepts all compatible operands
   // (operands rank and all static dimensions should match the operands).
-  AsyncValuePtr<Executable> DefaultExecutable() const;
+  AsyncValueRef<Executable> DefaultExecutable() const;
 
   // Returns an executable that may be specialized for the operands shape or
   // values. Can return default executable if no specialization is required, or
@@ -1211,11 +1292,14 @@ class JitExecutable {
   // JitExecutable, and successive calls with operands of the same shape
   // (symbolic shape) are cheap. If compilation fails, then the returned async
   // value will hold a compilation error message. Compilation errors are never
-  // retried.
+  // retried (unless the failed specialization is evicted from the cache).
+  //
+  // The returned reference keeps the executable alive even if it is evicted
+  // from the specializations cache while it is executing.
   //
   // Note: This function never falls back on the default executable if
   // specialization compilation fails.
-  Expected<AsyncValuePtr<Executable>> GetExecutable(
+  Expected<AsyncValueRef<Executable>> GetExecutable(
       ArrayRef<MemrefDesc> operands, const ExecutionContext& exec_ctx,
       const Listener* listener = nullptr);
 
@@ -1282,13 +1366,66 @@ class JitExecutable {
   CompilationTaskRunner runner_;
 
   // Executables specialized for the arguments shapes or/and values.
-  using Specializations = AsyncValuesCache<llvm::hash_code, Executable>;
-  std::unique_ptr<Specializations> specializations_;
+  std::unique_ptr<SpecializationsCache> specializations_;
+};
+
+// Compilation queue runs specialization compilation tasks in the host context
+// blocking work queue, at most `max_concurrent_compilations` at a time, and
+// keeps the rest pending in FIFO order. Share one queue between JitExecutables
+// to bound the total number of threads busy with compilation, and to keep a
+// burst of new shapes from starving the kernels execution.
+class CompilationQueue
+    : public std::enable_shared_from_this<CompilationQueue> {
+ public:
+  // The number of concurrent compilations in the queue shared by the cpurt
+  // kernels (see `GetCompilationTaskRunner` below).
+  static constexpr size_t kDefaultMaxConcurrentCompilations = 2;
+
+  explicit CompilationQueue(size_t max_concurrent_compilations)
+      : max_concurrent_compilations_(max_concurrent_compilations) {
+    assert(max_concurrent_compilations > 0);
+  }
+
+  // Returns a compilation task runner that can be passed to the
+  // `JitExecutable::Instantiate`. The runner keeps the queue alive.
+  static JitExecutable::CompilationTaskRunner TaskRunner(
+      std::shared_ptr<CompilationQueue> queue);
+
+  // Returns the number of tasks waiting for a compilation slot.
+  size_t num_pending() const;
+
+ private:
+  void Enqueue(TaskFunction task, const ExecutionContext& exec_ctx);
+
+  struct PendingTask {
+    TaskFunction task;
+    ExecutionContext exec_ctx;
+  };
+
+  // Runs `task` in a compilation slot owned by the caller, and then the pending
+  // tasks, until the queue is empty.
+  void Run(PendingTask task);
+
+  // Returns the next pending task, or releases the compilation slot of the
+  // caller if there is none.
+  Optional<PendingTask> TakeNext();
+
+  const size_t max_concurrent_compilations_;
+
+  mutable tfrt::mutex mu_;
+  size_t num_running_ TFRT_GUARDED_BY(mu_) = 0;
+  std::list<PendingTask> pending_ TFRT_GUARDED_BY(mu_);
 };
 
 // Resource context caches all JitExecutables in the async value cache.
 using JitExecutableCache = AsyncValuesCache<intptr_t, JitExecutable>;
 
+// Returns a compilation task runner backed by the compilation queue owned by
+// the resource context. All JitExecutables instantiated by the cpurt kernels
+// with the same resource context share this queue.
+JitExecutable::CompilationTaskRunner GetCompilationTaskRunner(
+    ResourceContext* res_ctx);
+
 }  // namespace jit
 }  // namespace cpu
 }  // namespace tfrt
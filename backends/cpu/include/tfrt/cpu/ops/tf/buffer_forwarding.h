@@ -21,6 +21,7 @@
 
 #include <type_traits>
 
+#include "tfrt/host_context/chain.h"
 #include "tfrt/host_context/execution_context.h"
 #include "tfrt/host_context/host_context.h"
 #include "tfrt/host_context/kernel_utils.h"
@@ -31,6 +32,12 @@ namespace tfrt {
 
 // Forwards one of the input buffers to the output, or allocates a new
 // DenseHostTensor if buffer forwarding is not possible.
+//
+// An input is forwarded if the caller holds the last reference to it, it has
+// the dtype and shape of the output, and no other tensor shares its buffer.
+// Ops must only pass inputs that they can overwrite while computing the
+// output, i.e. inputs that are not read after the output element at the same
+// position is written.
 AsyncValueRef<DenseHostTensor> ForwardInputOrAllocateOutput(
     const ExecutionContext& exec_ctx, const TensorMetadata& output_md,
     ArrayRef<Argument<DenseHostTensor>> inputs);
@@ -74,6 +81,11 @@ AsyncValueRef<DenseHostTensor> ForwardInputOrAllocateOutput(
                                       ArrayRef<Argument<Tensor>>(inputs));
 }
 
+// Makes the `output` returned by ForwardInputOrAllocateOutput available once
+// the kernel computing it completes `chain`, or sets it to the error of `chain`.
+AsyncValueRef<DenseHostTensor> ForwardOutput(
+    AsyncValueRef<DenseHostTensor> output, AsyncValueRef<Chain> chain);
+
 }  // namespace tfrt
 
 #endif  // TFRT_BACKENDS_CPU_OPS_TF_BUFFER_FORWARDING_H_
@@ -24,13 +24,16 @@
 #include <sys/types.h>
 
 #include <algorithm>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <numeric>
 #include <string>
 #include <utility>
 
+#include "llvm/ADT/ScopeExit.h"
 #include "llvm/ExecutionEngine/Orc/Core.h"
 #include "llvm/ExecutionEngine/Orc/Mangling.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -90,6 +93,8 @@
 #include "tfrt/host_context/async_value_ref.h"
 #include "tfrt/host_context/diagnostic.h"
 #include "tfrt/host_context/host_buffer.h"
+#include "tfrt/host_context/resource_context.h"
+#include "tfrt/metrics/common_metrics.h"
 #include "tfrt/support/error_util.h"
 #include "tfrt/support/string_util.h"
 #include "tfrt/tensor/dense_host_tensor.h"
@@ -1181,6 +1186,14 @@ JitCompilationContext::Instantiate(CompilationOptions opts,
 /*static*/ Expected<Executable> JitCompilationContext::Compile(
     std::unique_ptr<JitCompilationContext> ctx,
     Optional<size_t> specialization) {
+  // Export the compilation time, including failed compilations.
+  auto compilation_start = std::chrono::steady_clock::now();
+  auto record_compile_time = llvm::make_scope_exit([&] {
+    std::chrono::duration<double, std::milli> compile_time =
+        std::chrono::steady_clock::now() - compilation_start;
+    metrics::GetCpurtCompileTimeHistogram()->Record(compile_time.count());
+  });
+
   mlir::FuncOp entry_func = ctx->entrypoint();
   std::string entrypoint = entry_func.getName().str();
 
@@ -1658,6 +1671,173 @@ SymbolicShapesResolver::Resolve(ArrayRef<MemrefDesc> operands) {
   return {normalize.begin(), normalize.end()};
 }
 
+//----------------------------------------------------------------------------//
+// SpecializationsCache implementation.
+//----------------------------------------------------------------------------//
+
+AsyncValueRef<Executable> SpecializationsCache::Find(const Key& key,
+                                                     llvm::hash_code hash) {
+  // Fast path: the operands match the last cache hit.
+  std::shared_ptr<Node> hot = std::atomic_load(&hot_);
+  if (hot && hot->hash == hash && hot->key == key) {
+    metrics::GetCpurtSpecializationCacheHitsCounter()->Increment();
+    return hot->executable;
+  }
+
+  tfrt::mutex_lock lock(mu_);
+  auto it = Lookup(key, hash);
+  if (it == lru_.end()) {
+    metrics::GetCpurtSpecializationCacheMissesCounter()->Increment();
+    return nullptr;
+  }
+
+  metrics::GetCpurtSpecializationCacheHitsCounter()->Increment();
+  lru_.splice(lru_.begin(), lru_, it);
+  std::atomic_store(&hot_, *it);
+  return (*it)->executable;
+}
+
+auto SpecializationsCache::Allocate(const Key& key, llvm::hash_code hash)
+    -> Entry {
+  tfrt::mutex_lock lock(mu_);
+  auto it = Lookup(key, hash);
+  if (it != lru_.end()) return {(*it)->executable, false, num_allocated_};
+
+  auto node = std::make_shared<Node>();
+  node->hash = hash;
+  node->key = key;
+  node->executable = MakeUnconstructedAsyncValueRef<Executable>();
+
+  lru_.push_front(node);
+  index_[hash].push_back(lru_.begin());
+  MaybeEvict();
+
+  return {node->executable, true, num_allocated_++};
+}
+
+size_t SpecializationsCache::size() const {
+  tfrt::mutex_lock lock(mu_);
+  return lru_.size();
+}
+
+auto SpecializationsCache::Lookup(const Key& key, llvm::hash_code hash)
+    -> LruList::iterator {
+  auto bucket = index_.find(hash);
+  if (bucket == index_.end()) return lru_.end();
+  for (LruList::iterator it : bucket->second)
+    if ((*it)->key == key) return it;
+  return lru_.end();
+}
+
+void SpecializationsCache::MaybeEvict() {
+  if (capacity_ == 0) return;
+
+  // Walk from the least recently used node, and skip the executables that are
+  // still being compiled.
+  auto it = lru_.end();
+  while (lru_.size() > capacity_ && it != lru_.begin()) {
+    --it;
+    if ((*it)->executable.IsUnavailable()) continue;
+
+    auto bucket = index_.find((*it)->hash);
+    assert(bucket != index_.end() && "evicted node must be indexed");
+    llvm::erase_value(bucket->second, it);
+    if (bucket->second.empty()) index_.erase(bucket);
+
+    std::shared_ptr<Node> hot = std::atomic_load(&hot_);
+    if (hot == *it) std::atomic_store(&hot_, std::shared_ptr<Node>());
+
+    it = lru_.erase(it);
+    metrics::GetCpurtSpecializationCacheEvictionsCounter()->Increment();
+  }
+}
+
+//----------------------------------------------------------------------------//
+// CompilationQueue implementation.
+//----------------------------------------------------------------------------//
+
+/*static*/ JitExecutable::CompilationTaskRunner CompilationQueue::TaskRunner(
+    std::shared_ptr<CompilationQueue> queue) {
+  return [queue = std::move(queue)](
+             size_t, ArrayRef<OperandConstraint>, ArrayRef<MemrefDesc>,
+             TaskFunction task, const ExecutionContext& exec_ctx) {
+    queue->Enqueue(std::move(task), exec_ctx);
+  };
+}
+
+void CompilationQueue::Enqueue(TaskFunction task,
+                               const ExecutionContext& exec_ctx) {
+  {
+    tfrt::mutex_lock lock(mu_);
+    if (num_running_ == max_concurrent_compilations_) {
+      pending_.push_back({std::move(task), exec_ctx});
+      return;
+    }
+    ++num_running_;
+  }
+  Run({std::move(task), exec_ctx});
+}
+
+size_t CompilationQueue::num_pending() const {
+  tfrt::mutex_lock lock(mu_);
+  return pending_.size();
+}
+
+auto CompilationQueue::TakeNext() -> Optional<PendingTask> {
+  tfrt::mutex_lock lock(mu_);
+  if (pending_.empty()) {
+    --num_running_;
+    return llvm::None;
+  }
+  PendingTask next = std::move(pending_.front());
+  pending_.pop_front();
+  return {std::move(next)};
+}
+
+void CompilationQueue::Run(PendingTask task) {
+  // The task is shared with the blocking work queue task, so that it can still
+  // be run here if the work queue rejects it.
+  auto next = std::make_shared<PendingTask>(std::move(task));
+  while (next) {
+    // Compilation occupies a thread for a long time, so it runs in the blocking
+    // work queue. When the task completes it hands its compilation slot over to
+    // the next pending task.
+    Optional<TaskFunction> rejected =
+        next->exec_ctx.host()->work_queue().AddBlockingTask(
+            TaskFunction([queue = shared_from_this(), next]() {
+              next->task();
+              if (Optional<PendingTask> pending = queue->TakeNext())
+                queue->Run(std::move(*pending));
+            }),
+            /*allow_queuing=*/true);
+    if (!rejected.hasValue()) return;
+
+    // If the blocking work queue is full, compile in the caller thread, because
+    // the compilation task must always run. The pending tasks are handed over
+    // in this loop, so a full work queue does not grow the stack.
+    rejected.reset();
+    next->task();
+    Optional<PendingTask> pending = TakeNext();
+    next = pending ? std::make_shared<PendingTask>(std::move(*pending))
+                   : nullptr;
+  }
+}
+
+namespace {
+// Compilation queue owned by the resource context.
+struct SharedCompilationQueue {
+  std::shared_ptr<CompilationQueue> queue = std::make_shared<CompilationQueue>(
+      CompilationQueue::kDefaultMaxConcurrentCompilations);
+};
+}  // namespace
+
+JitExecutable::CompilationTaskRunner GetCompilationTaskRunner(
+    ResourceContext* res_ctx) {
+  auto* shared = res_ctx->GetOrCreateResource<SharedCompilationQueue>(
+      "cpurt.compilation_queue");
+  return CompilationQueue::TaskRunner(shared->queue);
+}
+
 //----------------------------------------------------------------------------//
 // JitExecutable implementation.
 //----------------------------------------------------------------------------//
@@ -1735,7 +1915,8 @@ JitExecutable::JitExecutable(string_view mlir_module, string_view entrypoint,
       symbolic_shapes_resolver_(signature_, constraints_),
       has_default_executable_(default_executable.hasValue()),
       runner_(std::move(runner)),
-      specializations_(std::make_unique<Specializations>()) {
+      specializations_(std::make_unique<SpecializationsCache>(
+          compilation_opts_.max_num_specializations)) {
   // Initialize default executable if it is available.
   if (has_default_executable_) {
     default_executable_ =
@@ -1746,53 +1927,43 @@ JitExecutable::JitExecutable(string_view mlir_module, string_view entrypoint,
   }
 }
 
-AsyncValuePtr<Executable> JitExecutable::DefaultExecutable() const {
-  return default_executable_.AsPtr();
+AsyncValueRef<Executable> JitExecutable::DefaultExecutable() const {
+  return default_executable_;
 }
 
 ArrayRef<OperandConstraint> JitExecutable::constraints() const {
   return constraints_;
 }
 
-// Hashes the given operands.
-// Note: due to value specialization, the resulting hash might depend on the
+// Builds the key of the specialization for the given operands.
+// Note: due to value specialization, the resulting key might depend on the
 // values (and not only on the types) of the operands.
-static llvm::hash_code HashOperands(ArrayRef<MemrefDesc> operands,
-                                    ArrayRef<SymbolicShape> symbolic_shapes,
-                                    ArrayRef<OperandConstraint> constraints) {
-  llvm::hash_code hash(0);
-
-  // Compute hash based on the symbolic shapes of the operands.
+static void BuildSpecializationKey(ArrayRef<MemrefDesc> operands,
+                                   ArrayRef<SymbolicShape> symbolic_shapes,
+                                   ArrayRef<OperandConstraint> constraints,
+                                   SpecializationsCache::Key* key) {
+  // Append the symbolic shapes of the operands.
   for (const SymbolicShape& shape : symbolic_shapes) {
-    hash = llvm::hash_combine(
-        hash, shape.size(),
-        llvm::hash_combine_range(shape.begin(), shape.end()));
+    key->push_back(shape.size());
+    key->append(shape.begin(), shape.end());
   }
 
-  // Mix values of arguments to be sunk into the hash.
+  // Append values of arguments to be sunk into the compiled function.
   for (int i = 0; i < constraints.size(); ++i) {
     if (constraints[i] != OperandConstraint::kValue) continue;
     const MemrefDesc& operand = operands[i];
-    const auto* data = static_cast<uint8_t*>(operand.data);
     size_t rank = operand.sizes.size();
     assert(rank == 0 || rank == 1);
     size_t num_values = rank == 0 ? 1 : operand.sizes[0];
     Index len = num_values * GetHostSize(operand.dtype);
-    hash = llvm::hash_combine(hash, llvm::hash_combine_range(data, data + len));
+    key->push_back(len);
+    size_t offset = key->size();
+    key->resize(offset + (len + sizeof(int64_t) - 1) / sizeof(int64_t), 0);
+    std::memcpy(key->data() + offset, operand.data, len);
   }
-  return hash;
 }
 
-// TODO(ezhulenev): The fast path should be free of mutex to find the
-// pre-compiled specialization. Maybe use atomic pointers (multiple atomic
-// pointers?) to keep the most commonly used specialization available without
-// doing a lookup in the AsyncValuesCache.
-//
-// TODO(ezhulenev): The number of specializations should be bounded, ideally we
-// should only keep N most common specializations, and for everything else
-// fall back on the default executable. However what to do if default executable
-// is not available, and the number of specializations is above N?
-Expected<AsyncValuePtr<Executable>> JitExecutable::GetExecutable(
+Expected<AsyncValueRef<Executable>> JitExecutable::GetExecutable(
     ArrayRef<MemrefDesc> operands, const ExecutionContext& exec_ctx,
     const Listener* listener) {
   // Do not try to compile specialized executable if it is explicitly disabled.
@@ -1827,13 +1998,14 @@ Expected<AsyncValuePtr<Executable>> JitExecutable::GetExecutable(
     return MakeStringError("failed to resolve symbolic shapes");
   }
 
-  // We rely on the hash code to find the specialized executable. In case of
-  // a collision (practically impossible) incompatible operands will be rejected
-  // by the executable operands verification.
-  llvm::hash_code hash = HashOperands(operands, *symbolic_shapes, constraints_);
+  // Specializations are cached by the full key, the hash code is only used to
+  // speed up the lookup.
+  SpecializationsCache::Key key;
+  BuildSpecializationKey(operands, *symbolic_shapes, constraints_, &key);
+  llvm::hash_code hash = llvm::hash_combine_range(key.begin(), key.end());
 
   // Maybe return Executable from the cache.
-  if (auto cached = specializations_->Find(hash)) {
+  if (AsyncValueRef<Executable> cached = specializations_->Find(key, hash)) {
     // Always use specialized kernel if required by the compilation options.
     if (compilation_opts_.specialization == Specialization::kAlways)
       return cached;
@@ -1867,16 +2039,15 @@ Expected<AsyncValuePtr<Executable>> JitExecutable::GetExecutable(
 
   // Allocate a placeholder for the compiled specialization only after we are
   // ready to dispatch the compilation task.
-  Specializations::Entry entry = specializations_->Allocate(hash);
+  SpecializationsCache::Entry entry = specializations_->Allocate(key, hash);
 
   // We lost the race; some other invocation will do the compilation.
-  if (!entry.allocated) return entry.ptr;
+  if (!entry.allocated) return entry.executable;
 
-  // Get the specialization id from the size of the specializations cache.
-  size_t specialization = entry.size - 1;
+  size_t specialization = entry.specialization;
 
   // Construct the task that will do the specialized executable compilation.
-  auto compile = TaskFunction([ctx = std::move(*ctx), ref = entry.ptr.CopyRef(),
+  auto compile = TaskFunction([ctx = std::move(*ctx), ref = entry.executable,
                                specialization]() mutable {
     Expected<Executable> executable =
         JitCompilationContext::Compile(std::move(ctx), specialization);
@@ -1895,9 +2066,9 @@ Expected<AsyncValuePtr<Executable>> JitExecutable::GetExecutable(
   // Use the default executable while we are compiling a specialized version if
   // this is not explicitly disabled by the compilation options.
   if (compilation_opts_.specialization == Specialization::kAlways)
-    return entry.ptr;
+    return entry.executable;
   else
-    return has_default_executable_ ? DefaultExecutable() : entry.ptr;
+    return has_default_executable_ ? DefaultExecutable() : entry.executable;
 }
 
 //----------------------------------------------------------------------------//
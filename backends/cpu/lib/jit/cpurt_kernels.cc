@@ -77,8 +77,14 @@ static AsyncValueRef<JitExecutable> Compile(CompilationUnitAttribute kernel,
   // We lost the race; some other invocation will do the compilation.
   if (!entry.allocated) return entry.ptr.CopyRef();
 
+  // Specializations of all kernels are compiled in one shared queue, so that
+  // a burst of new operand shapes does not occupy all the threads.
+  JitExecutable::CompilationTaskRunner runner =
+      GetCompilationTaskRunner(res_ctx);
+
   // Compile kernel asynchronously in the host context thread pool.
-  EnqueueWork(exec_ctx, [kernel, host, ref = entry.ptr.CopyRef()]() {
+  EnqueueWork(exec_ctx, [kernel, host, runner = std::move(runner),
+                         ref = entry.ptr.CopyRef()]() mutable {
     CompilationOptions opts;
     opts.num_worker_threads = host->GetNumWorkerThreads();
 
@@ -86,8 +92,8 @@ static AsyncValueRef<JitExecutable> Compile(CompilationUnitAttribute kernel,
     string_view module = kernel.serialized_operation();
 
     // Instantiate new JitExecutable from the MLIR source.
-    Expected<JitExecutable> jit_executable =
-        JitExecutable::Instantiate(module, entrypoint, opts);
+    Expected<JitExecutable> jit_executable = JitExecutable::Instantiate(
+        module, entrypoint, opts, std::move(runner));
 
     // Set the allocated async value state to error or concrete.
     if (auto err = jit_executable.takeError())
@@ -151,7 +157,7 @@ static void Execute(Argument<JitExecutable> jit_executable,
     return EmitErrors(results, std::move(err), exec_ctx);
 
   // Get an executable that might be specialized to the operands.
-  Expected<AsyncValuePtr<Executable>> executable =
+  Expected<AsyncValueRef<Executable>> executable =
       jit_executable->GetExecutable(memrefs, exec_ctx);
   if (auto err = executable.takeError())
     return EmitErrors(results, std::move(err), exec_ctx);
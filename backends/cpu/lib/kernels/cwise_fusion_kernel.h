@@ -0,0 +1,446 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Fused coefficient wise kernel: evaluates a chain of coefficient wise unary
+// and binary operations in a single pass over memory.
+
+#ifndef TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_CWISE_FUSION_KERNEL_H_
+#define TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_CWISE_FUSION_KERNEL_H_
+
+#include <algorithm>
+#include <memory>
+
+#include "./cwise_binary_kernels.h"
+#include "./cwise_unary_kernels.h"
+#include "llvm/ADT/STLExtras.h"
+#include "tfrt/common/compat/eigen/tensor_types.h"
+#include "tfrt/common/ops/tf/bcast.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/attribute_utils.h"
+#include "tfrt/host_context/chain.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/parallel_for.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+
+namespace tfrt {
+namespace cpu {
+
+// Coefficient wise operations supported by the fused kernel. Binary operations
+// take the result of the previous operation as the left operand, and the next
+// fusion input as the right operand.
+enum class FusedCwiseOp {
+  kAdd,
+  kSub,
+  kMul,
+  kDiv,
+  kBiasAdd,
+  kRelu,
+  kLog,
+  kLog1p,
+  kRsqrt,
+  kSigmoid,
+};
+
+// Parses the name of a fused operation (the Tensorflow op name without the
+// dialect prefix, e.g. "AddV2").
+inline Expected<FusedCwiseOp> ParseFusedCwiseOp(string_view name) {
+  if (name == "AddV2") return FusedCwiseOp::kAdd;
+  if (name == "Sub") return FusedCwiseOp::kSub;
+  if (name == "Mul") return FusedCwiseOp::kMul;
+  if (name == "RealDiv") return FusedCwiseOp::kDiv;
+  if (name == "BiasAdd") return FusedCwiseOp::kBiasAdd;
+  if (name == "Relu") return FusedCwiseOp::kRelu;
+  if (name == "Log") return FusedCwiseOp::kLog;
+  if (name == "Log1p") return FusedCwiseOp::kLog1p;
+  if (name == "Rsqrt") return FusedCwiseOp::kRsqrt;
+  if (name == "Sigmoid") return FusedCwiseOp::kSigmoid;
+  return MakeStringError("Unsupported fused cwise operation: ", name);
+}
+
+inline bool IsBinaryFusedCwiseOp(FusedCwiseOp op) {
+  switch (op) {
+    case FusedCwiseOp::kAdd:
+    case FusedCwiseOp::kSub:
+    case FusedCwiseOp::kMul:
+    case FusedCwiseOp::kDiv:
+    case FusedCwiseOp::kBiasAdd:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Parses the `fused_ops` attribute of the fused coefficient wise op.
+inline Expected<SmallVector<FusedCwiseOp, 4>> ParseFusedCwiseOps(
+    AggregateAttr fused_ops_attr) {
+  SmallVector<FusedCwiseOp, 4> fused_ops;
+  for (int i = 0; i < fused_ops_attr.GetNumElements(); ++i) {
+    TFRT_ASSIGN_OR_RETURN(
+        FusedCwiseOp op,
+        ParseFusedCwiseOp(
+            fused_ops_attr.GetAttribute(i).cast<StringAttr>().GetValue()));
+    fused_ops.push_back(op);
+  }
+  return std::move(fused_ops);
+}
+
+namespace internal {
+
+// Number of elements processed by all fused operations before moving to the
+// next elements, small enough to keep the intermediate results in L1.
+static constexpr Index kFusedCwiseTileSize = 1024;
+
+// How the right operand of a binary operation maps to the elements of the
+// fused kernel input.
+enum class FusedCwiseOperand {
+  // Unary operation, no operand.
+  kNone,
+  // Operand has the same shape as the input.
+  kFull,
+  // Operand has a single element.
+  kScalar,
+  // Operand is a vector of the size of the input inner dimension.
+  kInner,
+};
+
+template <typename T>
+struct FusedCwiseStep {
+  FusedCwiseOp op;
+  FusedCwiseOperand operand;
+  const T* data;
+  Index size;
+};
+
+template <typename T>
+using FusedCwiseTile =
+    Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor, Index>,
+                     Eigen::Unaligned>;
+
+template <typename T>
+using FusedCwiseConstTile =
+    Eigen::TensorMap<const Eigen::Tensor<T, 1, Eigen::RowMajor, Index>,
+                     Eigen::Unaligned>;
+
+template <typename F, typename T>
+void FusedCwiseBinary(const FusedCwiseStep<T>& step, const T* src, T* dst,
+                      Index offset, Index size) {
+  FusedCwiseConstTile<T> src_t(src, size);
+  FusedCwiseTile<T> dst_t(dst, size);
+
+  switch (step.operand) {
+    case FusedCwiseOperand::kFull:
+      dst_t = src_t.binaryExpr(
+          FusedCwiseConstTile<T>(step.data + offset, size), F());
+      break;
+
+    case FusedCwiseOperand::kScalar:
+      dst_t = src_t.unaryExpr(functor::BindRightScalar<T, T, F>(*step.data));
+      break;
+
+    case FusedCwiseOperand::kInner:
+      // Split the tile at the inner dimension boundaries.
+      for (Index i = 0; i < size;) {
+        Index col = (offset + i) % step.size;
+        Index len = std::min(size - i, step.size - col);
+        FusedCwiseTile<T>(dst + i, len) =
+            FusedCwiseConstTile<T>(src + i, len)
+                .binaryExpr(FusedCwiseConstTile<T>(step.data + col, len), F());
+        i += len;
+      }
+      break;
+
+    case FusedCwiseOperand::kNone:
+      llvm_unreachable("binary operation without an operand");
+  }
+}
+
+template <typename F, typename T>
+void FusedCwiseUnary(const T* src, T* dst, Index size) {
+  FusedCwiseTile<T>(dst, size) =
+      FusedCwiseConstTile<T>(src, size).unaryExpr(F());
+}
+
+// Applies the fused operation to `size` elements starting at `offset`. `src`
+// and `dst` might be the same buffer.
+template <typename T>
+void FusedCwiseApply(const FusedCwiseStep<T>& step, const T* src, T* dst,
+                     Index offset, Index size) {
+  switch (step.op) {
+    case FusedCwiseOp::kAdd:
+    case FusedCwiseOp::kBiasAdd:
+      return FusedCwiseBinary<Eigen::internal::scalar_sum_op<T>>(step, src, dst,
+                                                                offset, size);
+    case FusedCwiseOp::kSub:
+      return FusedCwiseBinary<Eigen::internal::scalar_difference_op<T>>(
+          step, src, dst, offset, size);
+    case FusedCwiseOp::kMul:
+      return FusedCwiseBinary<Eigen::internal::scalar_product_op<T>>(
+          step, src, dst, offset, size);
+    case FusedCwiseOp::kDiv:
+      return FusedCwiseBinary<Eigen::internal::scalar_quotient_op<T>>(
+          step, src, dst, offset, size);
+    case FusedCwiseOp::kRelu:
+      FusedCwiseTile<T>(dst, size) =
+          FusedCwiseConstTile<T>(src, size).cwiseMax(static_cast<T>(0));
+      return;
+    case FusedCwiseOp::kLog:
+      return FusedCwiseUnary<Eigen::internal::scalar_log_op<T>>(src, dst, size);
+    case FusedCwiseOp::kLog1p:
+      return FusedCwiseUnary<Eigen::internal::scalar_log1p_op<T>>(src, dst,
+                                                                 size);
+    case FusedCwiseOp::kRsqrt:
+      return FusedCwiseUnary<Eigen::internal::scalar_rsqrt_op<T>>(src, dst,
+                                                                 size);
+    case FusedCwiseOp::kSigmoid:
+      return FusedCwiseUnary<Eigen::internal::scalar_logistic_op<T>>(src, dst,
+                                                                    size);
+  }
+}
+
+// Returns the cost of computing one element of the fused operation.
+template <typename T>
+double FusedCwiseComputeCost(FusedCwiseOp op) {
+  using Eigen::internal::functor_traits;
+  switch (op) {
+    case FusedCwiseOp::kAdd:
+    case FusedCwiseOp::kBiasAdd:
+      return functor_traits<Eigen::internal::scalar_sum_op<T>>::Cost;
+    case FusedCwiseOp::kSub:
+      return functor_traits<Eigen::internal::scalar_difference_op<T>>::Cost;
+    case FusedCwiseOp::kMul:
+      return functor_traits<Eigen::internal::scalar_product_op<T>>::Cost;
+    case FusedCwiseOp::kDiv:
+      return functor_traits<Eigen::internal::scalar_quotient_op<T>>::Cost;
+    case FusedCwiseOp::kRelu:
+      return functor_traits<Eigen::internal::scalar_max_op<T, T>>::Cost;
+    case FusedCwiseOp::kLog:
+      return functor_traits<Eigen::internal::scalar_log_op<T>>::Cost;
+    case FusedCwiseOp::kLog1p:
+      return functor_traits<Eigen::internal::scalar_log1p_op<T>>::Cost;
+    case FusedCwiseOp::kRsqrt:
+      return functor_traits<Eigen::internal::scalar_rsqrt_op<T>>::Cost;
+    case FusedCwiseOp::kSigmoid:
+      return functor_traits<Eigen::internal::scalar_logistic_op<T>>::Cost;
+  }
+  return 0;
+}
+
+// Returns how `operand` maps to the elements of `input`, or kNone if the
+// operand requires a broadcast that can't be evaluated in a single pass.
+inline FusedCwiseOperand GetFusedCwiseOperand(const DenseHostTensor& input,
+                                              const DenseHostTensor& operand) {
+  const TensorShape& input_shape = input.shape();
+  const TensorShape& operand_shape = operand.shape();
+  const int input_rank = input_shape.GetRank();
+
+  if (operand_shape == input_shape) return FusedCwiseOperand::kFull;
+  if (operand.NumElements() == 1 && operand_shape.GetRank() <= input_rank)
+    return FusedCwiseOperand::kScalar;
+  if (input_rank >= 1 && operand_shape.GetRank() == 1 &&
+      operand_shape.GetDimensionSize(0) ==
+          input_shape.GetDimensionSize(input_rank - 1))
+    return FusedCwiseOperand::kInner;
+  return FusedCwiseOperand::kNone;
+}
+
+// Evaluates the fused operations one by one with the regular coefficient wise
+// kernels, materializing all the intermediate results. Used when the fusion
+// inputs must be broadcasted in a way not supported by the fused kernel.
+template <typename T, typename FusionInputsRange>
+Error UnfusedCwise(const DenseHostTensor& input,
+                   FusionInputsRange fusion_inputs, DenseHostTensor* output,
+                   ArrayRef<FusedCwiseOp> ops,
+                   const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  DenseHostTensor acc = input.CopyRef();
+  bool acc_is_input = true;
+  int next_input = 0;
+
+  for (FusedCwiseOp op : ops) {
+    if (IsBinaryFusedCwiseOp(op)) {
+      const DenseHostTensor& operand = fusion_inputs[next_input++];
+      TFRT_ASSIGN_OR_RETURN(auto shape,
+                            GetBroadcastedShape(acc.shape(), operand.shape()));
+      auto result = DenseHostTensor::CreateUninitialized(
+          TensorMetadata(acc.dtype(), shape), host);
+      if (!result) return MakeStringError("out of memory allocating tensor");
+
+      Error error = Error::success();
+      switch (op) {
+        case FusedCwiseOp::kAdd:
+        case FusedCwiseOp::kBiasAdd:
+          error = SyncBinaryKernel<functor::Add::Functor<T>>(
+              acc, operand, result.getPointer(), exec_ctx);
+          break;
+        case FusedCwiseOp::kSub:
+          error = SyncBinaryKernel<functor::Sub::Functor<T>>(
+              acc, operand, result.getPointer(), exec_ctx);
+          break;
+        case FusedCwiseOp::kMul:
+          error = SyncBinaryKernel<functor::Mul::Functor<T>>(
+              acc, operand, result.getPointer(), exec_ctx);
+          break;
+        case FusedCwiseOp::kDiv:
+          error = SyncBinaryKernel<functor::Div::Functor<T>>(
+              acc, operand, result.getPointer(), exec_ctx);
+          break;
+        default:
+          llvm_unreachable("not a binary operation");
+      }
+      if (error) return error;
+
+      acc = std::move(*result);
+      acc_is_input = false;
+
+    } else {
+      // Unary operations are evaluated in place, except for the input.
+      DenseHostTensor result = acc.CopyRef();
+      if (acc_is_input) {
+        auto allocated =
+            DenseHostTensor::CreateUninitialized(acc.metadata(), host);
+        if (!allocated)
+          return MakeStringError("out of memory allocating tensor");
+        result = std::move(*allocated);
+        acc_is_input = false;
+      }
+
+      FusedCwiseStep<T> step{op, FusedCwiseOperand::kNone, nullptr, 0};
+      FusedCwiseApply<T>(step, acc.data<T>(), result.data<T>(), 0,
+                         acc.NumElements());
+      acc = std::move(result);
+    }
+  }
+
+  if (acc.shape() != output->shape())
+    return MakeStringError("Fused cwise result shape ", acc.shape(),
+                           " doesn't match output shape ", output->shape());
+
+  std::copy(acc.data<T>(), acc.data<T>() + acc.NumElements(),
+            output->data<T>());
+  return Error::success();
+}
+
+}  // namespace internal
+
+// Computes `output` by applying the chain of coefficient wise `fused_ops` to
+// `input`. Each binary operation consumes the next fusion input.
+//
+// If all fusion inputs have the same shape as `input`, a single element, or
+// the size of the `input` inner dimension (e.g. BiasAdd), the operations are
+// evaluated in one pass over memory: for each small tile of elements all the
+// operations are applied back to back while the tile stays in cache. Otherwise
+// the operations are evaluated one by one.
+//
+// `output` might share the buffer with `input`.
+template <typename T, typename FusionInputsRange>
+AsyncValueRef<Chain> FusedCwise(const DenseHostTensor& input,
+                                FusionInputsRange fusion_inputs,
+                                DenseHostTensor* output,
+                                ArrayRef<FusedCwiseOp> fused_ops,
+                                const ExecutionContext& exec_ctx) {
+  static_assert(std::is_same<std::decay_t<decltype(fusion_inputs[0])>,
+                             DenseHostTensor>::value,
+                "fusion_inputs must be a range of DenseHostTensor");
+
+  HostContext* host = exec_ctx.host();
+
+  if (fused_ops.empty())
+    return MakeErrorAsyncValueRef(
+        host, "FusedCwise must specify fused operations");
+
+  const size_t num_binary_ops =
+      llvm::count_if(fused_ops, IsBinaryFusedCwiseOp);
+  if (num_binary_ops != fusion_inputs.size())
+    return MakeErrorAsyncValueRef(
+        host, StrCat("FusedCwise expected ", num_binary_ops,
+                     " fusion inputs, got ", fusion_inputs.size()));
+
+  // Build the fused kernel steps, and keep the input buffers alive until the
+  // kernel completes.
+  struct Fusion {
+    DenseHostTensor input;
+    DenseHostTensor output;
+    SmallVector<DenseHostTensor, 4> operands;
+    SmallVector<internal::FusedCwiseStep<T>, 4> steps;
+  };
+
+  auto fusion = std::make_unique<Fusion>();
+  bool fusible = input.shape() == output->shape();
+  ParallelFor::ElementCost cost;
+  cost.bytes_loaded = sizeof(T);
+  cost.bytes_stored = sizeof(T);
+
+  int next_input = 0;
+  for (FusedCwiseOp op : fused_ops) {
+    internal::FusedCwiseStep<T> step{op, internal::FusedCwiseOperand::kNone,
+                                     nullptr, 0};
+    if (IsBinaryFusedCwiseOp(op)) {
+      const DenseHostTensor& operand = fusion_inputs[next_input++];
+      step.operand = internal::GetFusedCwiseOperand(input, operand);
+      step.data = operand.data<T>();
+      step.size = operand.NumElements();
+      fusible &= step.operand != internal::FusedCwiseOperand::kNone;
+      if (step.operand == internal::FusedCwiseOperand::kFull)
+        cost.bytes_loaded += sizeof(T);
+      fusion->operands.push_back(operand.CopyRef());
+    }
+    cost.compute_cycles += internal::FusedCwiseComputeCost<T>(op);
+    fusion->steps.push_back(step);
+  }
+
+  if (!fusible) {
+    if (auto err = internal::UnfusedCwise<T>(input, fusion_inputs, output,
+                                             fused_ops, exec_ctx))
+      return MakeErrorAsyncValueRef(host, StrCat(err));
+    return MakeAvailableAsyncValueRef<Chain>(host);
+  }
+
+  fusion->input = input.CopyRef();
+  fusion->output = output->CopyRef();
+
+  const size_t num_elements = input.NumElements();
+
+  ParallelFor parallel_for(exec_ctx);
+  return parallel_for.Execute(
+      num_elements, ParallelFor::BlockSizes::Cost(cost),
+      [fusion = std::move(fusion)](size_t begin, size_t end) {
+        const T* src = fusion->input.template data<T>();
+        T* dst = fusion->output.template data<T>();
+
+        for (size_t offset = begin; offset < end;
+             offset += internal::kFusedCwiseTileSize) {
+          Index size = std::min<Index>(end - offset,
+                                       internal::kFusedCwiseTileSize);
+
+          // The first operation reads the input, all the following operations
+          // update the output tile in place.
+          const T* tile_src = src + offset;
+          T* tile_dst = dst + offset;
+          for (const auto& step : fusion->steps) {
+            internal::FusedCwiseApply<T>(step, tile_src, tile_dst, offset,
+                                         size);
+            tile_src = tile_dst;
+          }
+        }
+      });
+}
+
+}  // namespace cpu
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_CWISE_FUSION_KERNEL_H_
@@ -14,12 +14,21 @@
 
 // This file implements kernels that process images.
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "jpeg/jpeg_mem.h"
-#include "resize_bilinear_op.h"
+#include "llvm/ADT/STLExtras.h"
+#include "resize_op.h"
 #include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/host_context/attribute_utils.h"
 #include "tfrt/host_context/function.h"
 #include "tfrt/host_context/kernel_utils.h"
+#include "tfrt/host_context/parallel_for.h"
 #include "tfrt/support/error_util.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
 #include "tfrt/tensor/dense_host_tensor.h"
 #include "tfrt/tensor/dense_host_tensor_view.h"
 #include "tfrt/tensor/dense_tensor_utils.h"
@@ -70,56 +79,189 @@ static AsyncValueRef<DenseHostTensor> DecodeJpeg(
   return output;
 }
 
-// IDEA(donglin): allocate tensor buffer outside this kernel
-// Returns tf.compat.v1.image.resize(input, [height, width])
-static AsyncValueRef<DenseHostTensor> ResizeBilinear(
-    Argument<DenseHostTensor> input, Index height, Index width,
+// Returns the error if `normalization` can't be applied to images with
+// `channels` channels.
+static Error VerifyNormalization(ResizeNormalization normalization,
+                                 Index channels) {
+  auto verify_size = [&](ArrayRef<float> values, string_view name) -> Error {
+    if (values.size() != 1 && static_cast<Index>(values.size()) != channels)
+      return MakeStringError(name, " must have 1 or ", channels, " elements");
+    return Error::success();
+  };
+  if (auto err = verify_size(normalization.mean, "mean")) return err;
+  if (auto err = verify_size(normalization.stddev, "stddev")) return err;
+  if (llvm::is_contained(normalization.stddev, 0.0f))
+    return MakeStringError("stddev must not be zero");
+  return Error::success();
+}
+
+// Returns tf.compat.v1.image.resize(input, [height, width], method). The input
+// can be a single image or a batch of images with uint8 or float elements.
+template <ResizeMethod method>
+static AsyncValueRef<DenseHostTensor> Resize(const DenseHostTensor& input,
+                                             Index height, Index width,
+                                             const ExecutionContext& exec_ctx) {
+  TFRT_TRACE_SCOPE(Default, method == ResizeMethod::kBilinear
+                                ? "ResizeBilinear"
+                                : "ResizeNearestNeighbor");
+  const TensorShape& shape = input.shape();
+  const int rank = shape.GetRank();
+  if (rank != 3 && rank != 4)
+    return EmitErrorAsync(exec_ctx, "input tensor rank must be 3 or 4");
+  if (input.dtype() != DType::UI8 && input.dtype() != DType::F32)
+    return EmitErrorAsync(exec_ctx, "input tensor dtype must be ui8 or f32");
+  if (height <= 0 || width <= 0)
+    return EmitErrorAsync(exec_ctx, "output size must be positive");
+  if (shape.GetDimensionSize(rank - 3) <= 0 ||
+      shape.GetDimensionSize(rank - 2) <= 0)
+    return EmitErrorAsync(exec_ctx, "input image size must be positive");
+
+  // Resized images keep the batch dimension of the input, if it has one.
+  SmallVector<Index, 4> dims;
+  shape.GetDimensions(&dims);
+  dims[rank - 3] = height;
+  dims[rank - 2] = width;
+
+  auto output = DenseHostTensor::CreateUninitialized<float>(TensorShape(dims),
+                                                            exec_ctx.host());
+  if (!output) return EmitErrorAsync(exec_ctx, "cannot allocate tensor");
+
+  AsyncValueRef<Chain> chain = ResizeImages(input, output.getPointer(), method,
+                                            /*normalization=*/{}, exec_ctx);
+  return ForwardValue(output.getValue(), std::move(chain));
+}
+
+// Decodes a batch of jpeg images, and returns them resized to [height, width]
+// and normalized with `mean` and `stddev` in a single float tensor with
+// [batch, height, width, 3] shape.
+//
+// Every image is decoded and resized in the same task, and is resized directly
+// from the uint8 decoded pixels into the output tensor, so that there are no
+// full resolution float intermediates. If the image is at least twice as large
+// as the requested size, it is downscaled by the jpeg decoder (DCT scaling)
+// before the resize, which is a lot cheaper than decoding all of its pixels.
+static AsyncValueRef<DenseHostTensor> DecodeAndResizeJpeg(
+    Index height, Index width, RemainingArguments images,
+    ArrayAttribute<float> mean, ArrayAttribute<float> stddev,
     const ExecutionContext& exec_ctx) {
-  using ReturnTy = Expected<DenseHostTensor>;
-  return EnqueueWork(
-      exec_ctx,
-      [input = input.ValueRef(), height, width, exec_ctx]() -> ReturnTy {
-        TFRT_TRACE_SCOPE(Default, "ResizeBilinear");
-        const TensorShape& shape = input->shape();
-        if (shape.GetRank() != 3) {
-          auto diag = EmitError(exec_ctx, "input tensor shape must be 3");
-          return MakeStringError(diag.message);
-        }
+  static constexpr Index kChannels = 3;
+
+  if (height <= 0 || width <= 0)
+    return EmitErrorAsync(exec_ctx, "output size must be positive");
+  if (auto err = VerifyNormalization({mean.data(), stddev.data()}, kChannels))
+    return EmitErrorAsync(exec_ctx, std::move(err));
+
+  const Index batch_size = images.size();
+  auto output = DenseHostTensor::MakeConstructedAsyncValueRef(
+      TensorMetadata(GetDType<float>(),
+                     {batch_size, height, width, kChannels}),
+      exec_ctx.host());
+  if (!output) return EmitErrorAsync(exec_ctx, "cannot allocate tensor");
+
+  struct DecodeState {
+    SmallVector<RCReference<AsyncValue>, 8> images;
+    std::vector<float> mean;
+    std::vector<float> stddev;
+    DenseHostTensor output;
+
+    mutex mu;
+    std::string error TFRT_GUARDED_BY(mu);
+  };
 
-        Index batch_size = 1;
-        Index input_height = shape.GetDimensionSize(0);
-        Index input_width = shape.GetDimensionSize(1);
-        Index channels = shape.GetDimensionSize(2);
-        float height_scale = input_height / static_cast<float>(height);
-        float width_scale = input_width / static_cast<float>(width);
-
-        // Create the temporary output tensor with batch_size=1. This follows
-        // the same logic in tf.image.resize which adds a batch dimension if the
-        // input image does not have the batch dimension. It is easier to port
-        // the code from TF to TFRT by following the same logic. And in the
-        // future we may also want this kernel to process input image with or
-        // without the batch dimension.
-        auto dht = DenseHostTensor::CreateUninitialized<float>(
-            TensorShape({batch_size, height, width, channels}),
-            exec_ctx.host());
-        if (!dht) {
-          auto diag = EmitError(exec_ctx, "cannot allocate tensor");
-          return MakeStringError(diag.message);
+  auto state = std::make_shared<DecodeState>();
+  for (AsyncValue* image : images.values())
+    state->images.push_back(FormRef(image));
+  state->mean.assign(mean.data().begin(), mean.data().end());
+  state->stddev.assign(stddev.data().begin(), stddev.data().end());
+  state->output = output->CopyRef();
+
+  auto decode = [state, height, width](size_t begin, size_t end) {
+    TFRT_TRACE_SCOPE(Default, "DecodeAndResizeJpeg");
+    const Index output_image_size = height * width * kChannels;
+    std::vector<uint8_t> decoded;
+
+    for (size_t i = begin; i < end; ++i) {
+      const std::string& data = state->images[i]->get<std::string>();
+      if (!llvm::StringRef(data).startswith("\xff\xd8\xff")) {
+        mutex_lock lock(state->mu);
+        state->error = "image does not have jpeg format";
+        return;
+      }
+
+      jpeg::UncompressFlags flags;
+      flags.components = kChannels;
+      flags.dct_method = JDCT_IFAST;
+
+      // Pick the largest DCT scaling ratio that still decodes at least the
+      // requested number of pixels in both dimensions.
+      int image_width = 0;
+      int image_height = 0;
+      if (jpeg::GetImageInfo(data.data(), data.size(), &image_width,
+                             &image_height, /*components=*/nullptr)) {
+        for (int ratio : {8, 4, 2}) {
+          if ((image_width + ratio - 1) / ratio >= width &&
+              (image_height + ratio - 1) / ratio >= height) {
+            flags.ratio = ratio;
+            break;
+          }
         }
-        resize_image(input.get(), height_scale, width_scale, *dht);
-
-        // Remove the batch_size dimension before returning the result.
-        TensorMetadata output_metadata(GetDType<float>(),
-                                       {height, width, channels});
-        DenseHostTensor output(output_metadata, dht->ReleaseBuffer());
-        return std::move(output);
-      });
+      }
+
+      Index input_height = 0;
+      Index input_width = 0;
+      const uint8_t* pixels = jpeg::Uncompress(
+          data.data(), data.size(), flags, nullptr /* nwarn */,
+          [&](int w, int h, int c) -> uint8_t* {
+            input_height = h;
+            input_width = w;
+            decoded.resize(static_cast<size_t>(w) * h * c);
+            return decoded.data();
+          });
+      if (pixels == nullptr) {
+        mutex_lock lock(state->mu);
+        state->error = "failed to decode jpeg image";
+        return;
+      }
+      if (input_height <= 0 || input_width <= 0) {
+        mutex_lock lock(state->mu);
+        state->error = "jpeg image size must be positive";
+        return;
+      }
+
+      ImageResizer resizer(ResizeMethod::kBilinear, input_height, input_width,
+                           height, width, kChannels,
+                           {state->mean, state->stddev});
+      resizer.ResizeRows(pixels,
+                         state->output.data<float>() + i * output_image_size,
+                         0, height);
+    }
+  };
+
+  auto done = [state, output = output.CopyRef(), exec_ctx]() {
+    mutex_lock lock(state->mu);
+    if (!state->error.empty()) {
+      output.SetError(EmitError(exec_ctx, state->error));
+    } else {
+      output.SetStateConcrete();
+    }
+  };
+
+  // Decoding dominates the cost of the kernel, each image is a separate block.
+  ParallelFor(exec_ctx).Execute(batch_size, ParallelFor::BlockSizes::Fixed(1),
+                                std::move(decode), std::move(done));
+
+  return output;
 }
 
 // This is the entrypoint to the library.
 void RegisterImageKernels(KernelRegistry* registry) {
   registry->AddKernel("tfrt_test.decode_jpeg", TFRT_KERNEL(DecodeJpeg));
-  registry->AddKernel("tfrt_test.resize_bilinear", TFRT_KERNEL(ResizeBilinear));
+  registry->AddKernel("tfrt_test.resize_bilinear",
+                      TFRT_KERNEL(Resize<ResizeMethod::kBilinear>));
+  registry->AddKernel("tfrt_test.resize_nearest_neighbor",
+                      TFRT_KERNEL(Resize<ResizeMethod::kNearestNeighbor>));
+  registry->AddKernel("tfrt_test.decode_and_resize_jpeg",
+                      TFRT_KERNEL(DecodeAndResizeJpeg));
 }
 
 }  // namespace image
@@ -86,6 +86,11 @@ uint8_t* Uncompress(const void* srcdata, int datasize,
                     const UncompressFlags& flags, int64_t* nwarn,
                     std::function<uint8_t*(int, int, int)> allocate_output);
 
+// Read jpeg header and get image information.  Returns true on success.
+// The width, height, and components points may be null.
+bool GetImageInfo(const void* srcdata, int datasize, int* width, int* height,
+                  int* components);
+
 }  // namespace jpeg
 }  // namespace image
 }  // namespace tfrt
@@ -0,0 +1,298 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements the functions to resize images.
+//
+// Inner loops are written over contiguous float rows without cross-iteration
+// dependencies, so that the compiler can vectorize them for the target ISA.
+
+#include "resize_op.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+
+#include "tfrt/dtype/dtype.h"
+
+namespace tfrt {
+namespace image {
+namespace {
+
+using CachedInterpolation = ImageResizer::CachedInterpolation;
+
+void compute_interpolation_weights(const Index out_size, const Index in_size,
+                                   const float scale,
+                                   CachedInterpolation* interpolation) {
+  interpolation[out_size].lower = 0;
+  interpolation[out_size].upper = 0;
+  for (Index i = out_size - 1; i >= 0; --i) {
+    const float in = static_cast<float>(i) * scale;
+    const float in_f = std::floor(in);
+    interpolation[i].lower =
+        std::max(static_cast<Index>(in_f), static_cast<Index>(0));
+    interpolation[i].upper =
+        std::min(static_cast<Index>(std::ceil(in)), in_size - 1);
+    interpolation[i].lerp = in - in_f;
+  }
+}
+
+void compute_nearest_indices(const Index out_size, const Index in_size,
+                             const float scale,
+                             CachedInterpolation* interpolation) {
+  for (Index i = 0; i < out_size; ++i) {
+    const Index in = static_cast<Index>(std::floor(i * scale));
+    interpolation[i].lower = std::min(in, in_size - 1);
+    interpolation[i].upper = interpolation[i].lower;
+    interpolation[i].lerp = 0.0f;
+  }
+}
+
+// Linearly interpolates between the `top` and `bottom` input rows.
+template <typename T>
+void interpolate_rows(const T* top, const T* bottom, const float lerp,
+                      const Index size, float* __restrict output) {
+  for (Index i = 0; i < size; ++i) {
+    const float t = static_cast<float>(top[i]);
+    const float b = static_cast<float>(bottom[i]);
+    output[i] = t + (b - t) * lerp;
+  }
+}
+
+// Linearly interpolates between the columns of the vertically interpolated
+// `row`. If `kChannels` is zero, the number of channels is only known at run
+// time, otherwise the channels loop is fully unrolled.
+template <int kChannels>
+void interpolate_columns(const float* __restrict row,
+                         const CachedInterpolation* xs,
+                         const Index output_width, const Index num_channels,
+                         float* __restrict output) {
+  const Index channels = kChannels ? kChannels : num_channels;
+  for (Index x = 0; x < output_width; ++x) {
+    const float* left = row + xs[x].lower;
+    const float* right = row + xs[x].upper;
+    const float lerp = xs[x].lerp;
+    float* out = output + x * channels;
+    for (Index c = 0; c < channels; ++c) {
+      out[c] = left[c] + (right[c] - left[c]) * lerp;
+    }
+  }
+}
+
+// Copies the nearest input pixels of the `row`.
+template <int kChannels, typename T>
+void gather_columns(const T* __restrict row, const CachedInterpolation* xs,
+                    const Index output_width, const Index num_channels,
+                    float* __restrict output) {
+  const Index channels = kChannels ? kChannels : num_channels;
+  for (Index x = 0; x < output_width; ++x) {
+    const T* in = row + xs[x].lower;
+    float* out = output + x * channels;
+    for (Index c = 0; c < channels; ++c) out[c] = static_cast<float>(in[c]);
+  }
+}
+
+void normalize_row(const float* __restrict mean,
+                   const float* __restrict inv_stddev, const Index size,
+                   float* __restrict output) {
+  for (Index i = 0; i < size; ++i)
+    output[i] = (output[i] - mean[i]) * inv_stddev[i];
+}
+
+}  // namespace
+
+ImageResizer::ImageResizer(ResizeMethod method, Index input_height,
+                           Index input_width, Index output_height,
+                           Index output_width, Index channels,
+                           ResizeNormalization normalization)
+    : method_(method),
+      input_height_(input_height),
+      input_width_(input_width),
+      output_height_(output_height),
+      output_width_(output_width),
+      channels_(channels),
+      ys_(output_height + 1),
+      xs_(output_width + 1) {
+  // An empty input has no pixels to interpolate from.
+  assert(input_height > 0 && input_width > 0);
+  assert(output_height > 0 && output_width > 0);
+  const float height_scale = input_height / static_cast<float>(output_height);
+  const float width_scale = input_width / static_cast<float>(output_width);
+
+  if (method == ResizeMethod::kBilinear) {
+    compute_interpolation_weights(output_height, input_height, height_scale,
+                                  ys_.data());
+    compute_interpolation_weights(output_width, input_width, width_scale,
+                                  xs_.data());
+  } else {
+    compute_nearest_indices(output_height, input_height, height_scale,
+                            ys_.data());
+    compute_nearest_indices(output_width, input_width, width_scale,
+                            xs_.data());
+  }
+
+  // Scale x interpolation weights to avoid a multiplication during iteration.
+  for (auto& x : xs_) {
+    x.lower *= channels;
+    x.upper *= channels;
+  }
+
+  if (normalization.mean.empty() && normalization.stddev.empty()) return;
+
+  const Index out_row_size = output_width * channels;
+  row_mean_.resize(out_row_size);
+  row_inv_stddev_.resize(out_row_size);
+  for (Index i = 0; i < out_row_size; ++i) {
+    const Index c = i % channels;
+    row_mean_[i] = normalization.mean.empty()
+                       ? 0.0f
+                       : normalization.mean[c % normalization.mean.size()];
+    row_inv_stddev_[i] =
+        normalization.stddev.empty()
+            ? 1.0f
+            : 1.0f / normalization.stddev[c % normalization.stddev.size()];
+  }
+}
+
+template <typename T>
+void ImageResizer::ResizeRows(const T* input, float* output, Index begin,
+                              Index end) const {
+  const Index in_row_size = input_width_ * channels_;
+  const Index out_row_size = output_width_ * channels_;
+
+  // Input rows interpolated along the height dimension.
+  std::vector<float> row;
+  if (method_ == ResizeMethod::kBilinear) row.resize(in_row_size);
+
+  for (Index r = begin; r < end; ++r) {
+    const T* image = input + (r / output_height_) * input_image_size();
+    const CachedInterpolation& y = ys_[r % output_height_];
+    float* out = output + r * out_row_size;
+
+    if (method_ == ResizeMethod::kBilinear) {
+      interpolate_rows(image + y.lower * in_row_size,
+                       image + y.upper * in_row_size, y.lerp, in_row_size,
+                       row.data());
+      switch (channels_) {
+        case 1:
+          interpolate_columns<1>(row.data(), xs_.data(), output_width_,
+                                 channels_, out);
+          break;
+        case 3:
+          interpolate_columns<3>(row.data(), xs_.data(), output_width_,
+                                 channels_, out);
+          break;
+        case 4:
+          interpolate_columns<4>(row.data(), xs_.data(), output_width_,
+                                 channels_, out);
+          break;
+        default:
+          interpolate_columns<0>(row.data(), xs_.data(), output_width_,
+                                 channels_, out);
+          break;
+      }
+    } else {
+      const T* in = image + y.lower * in_row_size;
+      switch (channels_) {
+        case 1:
+          gather_columns<1>(in, xs_.data(), output_width_, channels_, out);
+          break;
+        case 3:
+          gather_columns<3>(in, xs_.data(), output_width_, channels_, out);
+          break;
+        case 4:
+          gather_columns<4>(in, xs_.data(), output_width_, channels_, out);
+          break;
+        default:
+          gather_columns<0>(in, xs_.data(), output_width_, channels_, out);
+          break;
+      }
+    }
+
+    if (!row_mean_.empty())
+      normalize_row(row_mean_.data(), row_inv_stddev_.data(), out_row_size,
+                    out);
+  }
+}
+
+template <typename T>
+ParallelFor::ElementCost ImageResizer::RowCost() const {
+  const Index in_row_size = input_width_ * channels_;
+  const Index out_row_size = output_width_ * channels_;
+
+  ParallelFor::ElementCost cost;
+  cost.bytes_stored = out_row_size * sizeof(float);
+  if (method_ == ResizeMethod::kBilinear) {
+    cost.bytes_loaded = 2 * in_row_size * sizeof(T);
+    cost.compute_cycles = 3 * in_row_size + 3 * out_row_size;
+  } else {
+    cost.bytes_loaded = out_row_size * sizeof(T);
+    cost.compute_cycles = out_row_size;
+  }
+  if (!row_mean_.empty()) cost.compute_cycles += 2 * out_row_size;
+  return cost;
+}
+
+template void ImageResizer::ResizeRows<uint8_t>(const uint8_t*, float*, Index,
+                                                Index) const;
+template void ImageResizer::ResizeRows<float>(const float*, float*, Index,
+                                              Index) const;
+template ParallelFor::ElementCost ImageResizer::RowCost<uint8_t>() const;
+template ParallelFor::ElementCost ImageResizer::RowCost<float>() const;
+
+AsyncValueRef<Chain> ResizeImages(const DenseHostTensor& input,
+                                  DenseHostTensor* output,
+                                  ResizeMethod method,
+                                  ResizeNormalization normalization,
+                                  const ExecutionContext& exec_ctx) {
+  const TensorShape& input_shape = input.shape();
+  const TensorShape& output_shape = output->shape();
+  const int rank = input_shape.GetRank();
+  assert(rank == 3 || rank == 4);
+  assert(output_shape.GetRank() == rank);
+  assert(output->dtype() == DType::F32);
+
+  const int height_dim = rank - 3;
+  const Index batch_size = rank == 4 ? input_shape.GetDimensionSize(0) : 1;
+
+  auto resizer = std::make_shared<ImageResizer>(
+      method, input_shape.GetDimensionSize(height_dim),
+      input_shape.GetDimensionSize(height_dim + 1),
+      output_shape.GetDimensionSize(height_dim),
+      output_shape.GetDimensionSize(height_dim + 1),
+      input_shape.GetDimensionSize(height_dim + 2), normalization);
+
+  const size_t num_rows =
+      batch_size * output_shape.GetDimensionSize(height_dim);
+
+  auto resize = [&](auto type_tag) {
+    using T = decltype(type_tag);
+    ParallelFor parallel_for(exec_ctx);
+    return parallel_for.Execute(
+        num_rows, ParallelFor::BlockSizes::Cost(resizer->RowCost<T>()),
+        [resizer, input = input.CopyRef(), output = output->CopyRef()](
+            size_t begin, size_t end) mutable {
+          resizer->ResizeRows<T>(input.data<T>(), output.data<float>(), begin,
+                                 end);
+        });
+  };
+
+  if (input.dtype() == DType::UI8) return resize(uint8_t{});
+  assert(input.dtype() == DType::F32);
+  return resize(float{});
+}
+
+}  // namespace image
+}  // namespace tfrt
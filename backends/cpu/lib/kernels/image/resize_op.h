@@ -0,0 +1,121 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares the functions to resize images.
+
+#ifndef TFRT_BACKENDS_CPU_LIB_KERNELS_IMAGE_RESIZE_OP_H_
+#define TFRT_BACKENDS_CPU_LIB_KERNELS_IMAGE_RESIZE_OP_H_
+
+#include <vector>
+
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/chain.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/parallel_for.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+
+namespace tfrt {
+namespace image {
+
+enum class ResizeMethod { kBilinear, kNearestNeighbor };
+
+// Per channel normalization fused into the resize:
+//
+//   output = (resized - mean[c]) / stddev[c]
+//
+// `mean` and `stddev` have one element per channel, or a single element that
+// is used for all channels. Empty arrays disable the normalization.
+struct ResizeNormalization {
+  ArrayRef<float> mean;
+  ArrayRef<float> stddev;
+};
+
+// Resizes images with the same semantics as tf.compat.v1.image.resize, i.e.
+// with `align_corners` and `half_pixel_centers` both set to false. Input
+// images have [height, width, channels] layout and uint8 or float elements,
+// resized images always have float elements. Input and output sizes must be
+// positive.
+//
+// ImageResizer precomputes the interpolation tables for one pair of input and
+// output sizes, and then computes every output row independently, so that the
+// rows of a batch of images can be split between ParallelFor blocks.
+class ImageResizer {
+ public:
+  ImageResizer(ResizeMethod method, Index input_height, Index input_width,
+               Index output_height, Index output_width, Index channels,
+               ResizeNormalization normalization = {});
+
+  // Computes output rows [begin, end) of a batch of images. Rows are numbered
+  // across the batch, i.e. row `r` is the row `r % output_height` of the image
+  // `r / output_height`. `input` and `output` point to the first image of the
+  // batch.
+  template <typename T>
+  void ResizeRows(const T* input, float* output, Index begin, Index end) const;
+
+  // Returns the cost of computing a single output row from `T` input.
+  template <typename T>
+  ParallelFor::ElementCost RowCost() const;
+
+  Index input_image_size() const {
+    return input_height_ * input_width_ * channels_;
+  }
+  Index output_image_size() const {
+    return output_height_ * output_width_ * channels_;
+  }
+
+  // Interpolation weights for one output coordinate.
+  struct CachedInterpolation {
+    Index lower;  // Lower source index used in the interpolation
+    Index upper;  // Upper source index used in the interpolation
+    // 1-D linear iterpolation scale (see:
+    // https://en.wikipedia.org/wiki/Bilinear_interpolation)
+    float lerp;
+  };
+
+ private:
+  ResizeMethod method_;
+  Index input_height_;
+  Index input_width_;
+  Index output_height_;
+  Index output_width_;
+  Index channels_;
+
+  std::vector<CachedInterpolation> ys_;
+  // Source indices are pre-multiplied by the number of channels.
+  std::vector<CachedInterpolation> xs_;
+
+  // Normalization parameters repeated for every pixel of an output row, so
+  // that normalizing a row is a simple elementwise loop. Empty if the
+  // normalization is disabled.
+  std::vector<float> row_mean_;
+  std::vector<float> row_inv_stddev_;
+};
+
+// Resizes uint8 or float `input` images with [batch, height, width, channels]
+// or [height, width, channels] shape into the float `output` images with the
+// same rank. Output rows are computed in parallel, the returned chain becomes
+// available when all of them are written.
+AsyncValueRef<Chain> ResizeImages(const DenseHostTensor& input,
+                                  DenseHostTensor* output,
+                                  ResizeMethod method,
+                                  ResizeNormalization normalization,
+                                  const ExecutionContext& exec_ctx);
+
+}  // namespace image
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_CPU_LIB_KERNELS_IMAGE_RESIZE_OP_H_
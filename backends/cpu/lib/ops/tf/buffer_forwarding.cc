@@ -14,8 +14,9 @@
 
 // Tensorflow operations input buffer forwarding.
 
-#include "buffer_forwarding.h"
+#include "tfrt/cpu/ops/tf/buffer_forwarding.h"
 
+#include "tfrt/metrics/common_metrics.h"
 #include "tfrt/tensor/dense_host_tensor.h"
 
 namespace tfrt {
@@ -39,12 +40,18 @@ AsyncValueRef<DenseHostTensor> ForwardInputOrAllocateOutput(
     // Check that no other tensors share the buffer with the input.
     if (!input->buffer()->IsExclusiveDataOwner()) continue;
 
+    metrics::GetCpuForwardedBuffersCounter()->Increment();
+    metrics::GetCpuForwardedBytesCounter()->IncrementBy(
+        output_md.GetHostSizeInBytes());
+
     // We can't forward the input AsyncValue because we must return constructed
     // but not yet available value.
     auto dht = input->CopyRef();
     return MakeConstructedAsyncValueRef<DenseHostTensor>(host, std::move(dht));
   }
 
+  metrics::GetCpuAllocatedBuffersCounter()->Increment();
+
   AsyncValueRef<DenseHostTensor> allocated =
       DenseHostTensor::MakeConstructedAsyncValueRef(output_md, host);
   if (!allocated)
@@ -53,4 +60,13 @@ AsyncValueRef<DenseHostTensor> ForwardInputOrAllocateOutput(
   return allocated;
 }
 
+AsyncValueRef<DenseHostTensor> ForwardOutput(
+    AsyncValueRef<DenseHostTensor> output, AsyncValueRef<Chain> chain) {
+  chain.AndThen([output = output.CopyRef(), chain = chain.CopyRef()]() {
+    chain.IsError() ? output.SetError(chain.GetError())
+                    : output.SetStateConcrete();
+  });
+  return output;
+}
+
 }  // namespace tfrt
@@ -19,6 +19,7 @@
 #include "../../kernels/cpu_kernels.h"
 #include "concat_op.h"
 #include "constant_ops.h"
+#include "cwise_fusion_ops.h"
 #include "cwise_binary_ops.h"
 #include "cwise_unary_ops.h"
 #include "matmul_fusion_ops.h"
@@ -30,6 +31,7 @@
 #include "tfrt/core_runtime/op_attrs.h"
 #include "tfrt/core_runtime/op_utils.h"
 #include "tfrt/cpu/core_runtime/cpu_op_registry.h"
+#include "tfrt/cpu/ops/tf/buffer_forwarding.h"
 #include "tfrt/host_context/async_value_ref.h"
 #include "tfrt/host_context/chain.h"
 #include "tfrt/host_context/kernel_utils.h"
@@ -69,29 +71,27 @@ static Expected<DenseHostTensor> TfConstOp(const OpAttrsRef& attrs,
 //===----------------------------------------------------------------------===//
 
 static AsyncValueRef<DenseHostTensor> TfReluOp(
-    const DenseHostTensor& A, const TensorMetadata& B_md,
+    Argument<DenseHostTensor> A, const TensorMetadata& B_md,
     const ExecutionContext& exec_ctx) {
-  HostContext* host = exec_ctx.host();
-
-  auto dest = DenseHostTensor::CreateUninitialized(B_md, host);
-  if (!dest) {
-    return EmitErrorAsync(exec_ctx, "out of memory allocating result");
-  }
+  // Forward input tensor or allocate new output tensor.
+  AsyncValueRef<DenseHostTensor> dest =
+      ForwardInputOrAllocateOutput(exec_ctx, B_md, A);
+  if (dest.IsError()) return dest;
 
   AsyncValueRef<Chain> chain;
-  switch (A.dtype()) {
+  switch (A->dtype()) {
     default:
       chain = EmitErrorAsync(exec_ctx, "unsupported dtype for relu");
       break;
 #define DTYPE_NUMERIC(ENUM)                                \
   case DType::ENUM:                                        \
     chain = cpu::Relu<EigenTypeForDTypeKind<DType::ENUM>>( \
-        A, dest.getPointer(), exec_ctx);                   \
+        *A, &dest.get(), exec_ctx);                        \
     break;
 #include "tfrt/dtype/dtype.def"  // NOLINT
   }
 
-  return ForwardValue(dest.getValue(), std::move(chain));
+  return ForwardOutput(std::move(dest), std::move(chain));
 }
 
 //===----------------------------------------------------------------------===//
@@ -201,17 +201,16 @@ static AsyncValueRef<DenseHostTensor> TfMeanOp(
 //===----------------------------------------------------------------------===//
 // TODO(b/161888722) Use Eigen broadcasting instead of dispatching by rank.
 static AsyncValueRef<DenseHostTensor> TfBiasAddOp(
-    const DenseHostTensor& input, const DenseHostTensor& bias,
+    Argument<DenseHostTensor> input, const DenseHostTensor& bias,
     const TensorMetadata& output_md, const ExecutionContext& exec_ctx) {
-  HostContext* host = exec_ctx.host();
-  auto output = DenseHostTensor::CreateUninitialized(output_md, host);
-  if (!output) {
-    return EmitErrorAsync(exec_ctx, "out of memory allocating tensor");
-  }
+  // Only the input can be forwarded to the output, the bias is broadcasted.
+  AsyncValueRef<DenseHostTensor> output =
+      ForwardInputOrAllocateOutput(exec_ctx, output_md, input);
+  if (output.IsError()) return output;
 
   AsyncValueRef<Chain> chain;
-  size_t input_rank = input.shape().GetRank();
-  switch (input.dtype()) {
+  size_t input_rank = input->shape().GetRank();
+  switch (input->dtype()) {
     default:
       chain = EmitErrorAsync(exec_ctx, "unsupported dtype for TfBiasAddOp");
       break;
@@ -220,26 +219,26 @@ static AsyncValueRef<DenseHostTensor> TfBiasAddOp(
     switch (input_rank) {                                            \
       case 2:                                                        \
         chain = cpu::BiasAdd<EigenTypeForDTypeKind<DType::ENUM>, 2>( \
-            input, bias, output.getPointer(), exec_ctx);             \
+            *input, bias, &output.get(), exec_ctx);                  \
         break;                                                       \
       case 3:                                                        \
         chain = cpu::BiasAdd<EigenTypeForDTypeKind<DType::ENUM>, 3>( \
-            input, bias, output.getPointer(), exec_ctx);             \
+            *input, bias, &output.get(), exec_ctx);                  \
         break;                                                       \
       case 4:                                                        \
         chain = cpu::BiasAdd<EigenTypeForDTypeKind<DType::ENUM>, 4>( \
-            input, bias, output.getPointer(), exec_ctx);             \
+            *input, bias, &output.get(), exec_ctx);                  \
         break;                                                       \
       case 5:                                                        \
         chain = cpu::BiasAdd<EigenTypeForDTypeKind<DType::ENUM>, 5>( \
-            input, bias, output.getPointer(), exec_ctx);             \
+            *input, bias, &output.get(), exec_ctx);                  \
         break;                                                       \
     }                                                                \
     break;
 #include "tfrt/dtype/dtype.def"  // NOLINT
   }
 
-  return ForwardValue(output.getValue(), std::move(chain));
+  return ForwardOutput(std::move(output), std::move(chain));
 }
 
 }  // namespace
@@ -262,6 +261,7 @@ void RegisterTfCpuOps(CpuOpRegistry* op_registry) {
   RegisterTfConstantCpuOps(op_registry);
   RegisterTfUnaryCpuOps(op_registry);
   RegisterTfBinaryCpuOps(op_registry);
+  RegisterTfCwiseFusionCpuOps(op_registry);
   RegisterTfShapeCpuOps(op_registry);
   RegisterTfSofmaxCpuOps(op_registry);
   RegisterTfMatmulFusionCpuOps(op_registry);
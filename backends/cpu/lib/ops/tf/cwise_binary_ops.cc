@@ -24,12 +24,12 @@
 #include <type_traits>
 
 #include "../../kernels/cwise_binary_kernels.h"
-#include "buffer_forwarding.h"
 #include "tfrt/common/compat/eigen/eigen_dtype.h"
 #include "tfrt/common/ops/tf/metadata_functions.h"
 #include "tfrt/core_runtime/op_attrs.h"
 #include "tfrt/core_runtime/op_utils.h"
 #include "tfrt/cpu/core_runtime/cpu_op_registry.h"
+#include "tfrt/cpu/ops/tf/buffer_forwarding.h"
 #include "tfrt/host_context/async_value_ref.h"
 #include "tfrt/host_context/chain.h"
 #include "tfrt/host_context/kernel_utils.h"
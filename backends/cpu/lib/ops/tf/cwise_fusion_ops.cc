@@ -0,0 +1,80 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Tensorflow coefficient wise fusion operations.
+
+#include "cwise_fusion_ops.h"
+
+#include "../../kernels/cwise_fusion_kernel.h"
+#include "tfrt/compiler/fused_cwise_dtypes.h"
+#include "tfrt/core_runtime/op_attrs.h"
+#include "tfrt/core_runtime/op_utils.h"
+#include "tfrt/cpu/core_runtime/cpu_op_registry.h"
+#include "tfrt/cpu/ops/tf/buffer_forwarding.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/chain.h"
+#include "tfrt/host_context/kernel_utils.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+#include "type_dispatch.h"
+
+namespace tfrt {
+namespace {
+
+// Evaluates a chain of coefficient wise operations created by the
+// `tfrt-fuse-cwise-ops` pass. The `fused_ops` attribute lists the fused
+// operations, and each binary operation takes the next fusion input as its
+// right operand.
+static AsyncValueRef<DenseHostTensor> TfFusedCwiseOp(
+    Argument<DenseHostTensor> x,
+    RepeatedArguments<DenseHostTensor> fusion_inputs, const OpAttrsRef& attrs,
+    const TensorMetadata& output_md, const ExecutionContext& exec_ctx) {
+  // Only the first input can be forwarded to the output, fusion inputs are
+  // read after the output is updated by the previous fused operations.
+  AsyncValueRef<DenseHostTensor> output =
+      ForwardInputOrAllocateOutput(exec_ctx, output_md, x);
+  if (output.IsError()) return output;
+
+  auto fused_ops =
+      cpu::ParseFusedCwiseOps(attrs.GetAsserting<AggregateAttr>("fused_ops"));
+  if (!fused_ops) return EmitErrorAsync(exec_ctx, fused_ops.takeError());
+
+  // Dispatch based on the input data type.
+  auto unsupported = [&](DType dtype) -> AsyncValueRef<Chain> {
+    return EmitErrorAsync(exec_ctx, StrCat("Unsupported input dtype: ", dtype));
+  };
+
+  auto dispatch = [&](auto type_tag) -> AsyncValueRef<Chain> {
+    using T = decltype(type_tag);
+    return cpu::FusedCwise<T>(*x, fusion_inputs, &output.get(), *fused_ops,
+                              exec_ctx);
+  };
+
+  // The tfrt-fuse-cwise-ops pass only fuses ops of the same types.
+  FusedCwiseDTypes::Apply<internal::GetTypeDispatch>::Type type_dispatch(
+      x->dtype());
+  AsyncValueRef<Chain> done = type_dispatch(dispatch, unsupported);
+
+  return ForwardOutput(std::move(output), std::move(done));
+}
+
+}  // namespace
+
+void RegisterTfCwiseFusionCpuOps(CpuOpRegistry* op_registry) {
+  op_registry->AddOp("tf._FusedCwise", TFRT_CPU_OP(TfFusedCwiseOp),
+                     CpuOpFlags::NoSideEffects, {"fused_ops"});
+}
+
+}  // namespace tfrt
@@ -23,6 +23,7 @@
 #include "tfrt/common/compat/eigen/eigen_evaluator.h"
 #include "tfrt/core_runtime/op_utils.h"
 #include "tfrt/cpu/core_runtime/cpu_op_registry.h"
+#include "tfrt/cpu/ops/tf/buffer_forwarding.h"
 #include "tfrt/host_context/async_value_ref.h"
 #include "tfrt/host_context/chain.h"
 #include "tfrt/host_context/kernel_utils.h"
@@ -34,17 +35,16 @@ namespace {
 
 template <bool log>
 static AsyncValueRef<DenseHostTensor> TfSoftmaxOp(
-    const DenseHostTensor& logits, const TensorMetadata& output_md,
+    Argument<DenseHostTensor> logits, const TensorMetadata& output_md,
     const ExecutionContext& exec_ctx) {
-  HostContext* host = exec_ctx.host();
-
-  auto dest = DenseHostTensor::CreateUninitialized(output_md, host);
-  if (!dest) {
-    return EmitErrorAsync(exec_ctx, "out of memory allocating result");
-  }
+  // The softmax kernel reduces the logits before it writes to the output, so
+  // the logits can be forwarded to the output.
+  AsyncValueRef<DenseHostTensor> dest =
+      ForwardInputOrAllocateOutput(exec_ctx, output_md, logits);
+  if (dest.IsError()) return dest;
 
   AsyncValueRef<Chain> chain;
-  switch (logits.dtype()) {
+  switch (logits->dtype()) {
     default:
       chain = EmitErrorAsync(exec_ctx, "unsupported dtype");
       break;
@@ -52,12 +52,12 @@ static AsyncValueRef<DenseHostTensor> TfSoftmaxOp(
   case DType::ENUM: {                                                     \
     chain = ::tfrt::cpu::Softmax<EigenTypeForDTypeKind<DType::ENUM>, log, \
                                  compat::AsyncEigenEvaluator>(            \
-        logits, dest.getPointer(), exec_ctx);                             \
+        *logits, &dest.get(), exec_ctx);                                  \
   } break;
 #include "tfrt/dtype/dtype.def"  // NOLINT
   }
 
-  return ForwardValue(dest.getValue(), std::move(chain));
+  return ForwardOutput(std::move(dest), std::move(chain));
 }
 
 }  // namespace
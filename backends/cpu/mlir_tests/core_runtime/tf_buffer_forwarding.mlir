@@ -120,3 +120,116 @@ func @do_not_forward_binary_op_arguments() {
 
   tfrt.return
 }
+
+// CHECK: --- Running 'forward_activation_chain'
+func @forward_activation_chain() {
+  %ch0 = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch0 "cpu"
+
+  %operand = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [2, 3], values = [-1.0 : f32, -0.5 : f32, 0.0 : f32, 0.5 : f32, 1.0 : f32, 1.5 : f32] } : 1
+  %bias = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [3], values = [1.0 : f32, 2.0 : f32, 3.0 : f32] } : 1
+
+  // All intermediate results of the chain share the buffer of the operand.
+  // CHECK: DenseHostTensor: buffer=[[ADDR:.*]]
+  %ch1 = corert.executeop.seq(%cpu, %ch0) "tfrt_test.print_address"(%operand) : 0
+  %ch2, %relu = corert.executeop.seq(%cpu, %ch1) "tf.Relu"(%operand) { T = f32 } : 1
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 3], values = [0.000000e+00, 0.000000e+00, 0.000000e+00, 5.000000e-01, 1.000000e+00, 1.500000e+00]
+  %ch3 = corert.executeop.seq(%cpu, %ch2) "tfrt_test.print"(%relu) : 0
+  %ch4, %bias_add = corert.executeop.seq(%cpu, %ch3) "tf.BiasAdd"(%relu, %bias)
+    { T = f32, data_format = "NHWC" } : 1
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 3], values = [1.000000e+00, 2.000000e+00, 3.000000e+00, 1.500000e+00, 3.000000e+00, 4.500000e+00]
+  %ch5 = corert.executeop.seq(%cpu, %ch4) "tfrt_test.print"(%bias_add) : 0
+  %ch6, %softmax = corert.executeop.seq(%cpu, %ch5) "tf.Softmax"(%bias_add) { T = f32 } : 1
+  // CHECK: DenseHostTensor: buffer=[[ADDR]]
+  %ch7 = corert.executeop.seq(%cpu, %ch6) "tfrt_test.print_address"(%softmax) : 0
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 3], values = [[SOFTMAX:.*]]
+  %ch8 = corert.executeop.seq(%cpu, %ch7) "tfrt_test.print"(%softmax) : 0
+
+  tfrt.return
+}
+
+// CHECK: --- Running 'do_not_forward_activation_chain'
+func @do_not_forward_activation_chain() {
+  %ch0 = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch0 "cpu"
+
+  %operand = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [2, 3], values = [-1.0 : f32, -0.5 : f32, 0.0 : f32, 0.5 : f32, 1.0 : f32, 1.5 : f32] } : 1
+  %bias = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [3], values = [1.0 : f32, 2.0 : f32, 3.0 : f32] } : 1
+
+  // Every input is still used after its op, so no buffer is forwarded and the
+  // results match the ones computed in place.
+  %ch1, %relu = corert.executeop.seq(%cpu, %ch0) "tf.Relu"(%operand) { T = f32 } : 1
+  %ch2, %bias_add = corert.executeop.seq(%cpu, %ch1) "tf.BiasAdd"(%relu, %bias)
+    { T = f32, data_format = "NHWC" } : 1
+  %ch3, %softmax = corert.executeop.seq(%cpu, %ch2) "tf.Softmax"(%bias_add) { T = f32 } : 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 3], values = [-1.000000e+00, -5.000000e-01, 0.000000e+00, 5.000000e-01, 1.000000e+00, 1.500000e+00]
+  %ch4 = corert.executeop.seq(%cpu, %ch3) "tfrt_test.print"(%operand) : 0
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 3], values = [0.000000e+00, 0.000000e+00, 0.000000e+00, 5.000000e-01, 1.000000e+00, 1.500000e+00]
+  %ch5 = corert.executeop.seq(%cpu, %ch4) "tfrt_test.print"(%relu) : 0
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 3], values = [1.000000e+00, 2.000000e+00, 3.000000e+00, 1.500000e+00, 3.000000e+00, 4.500000e+00]
+  %ch6 = corert.executeop.seq(%cpu, %ch5) "tfrt_test.print"(%bias_add) : 0
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 3], values = [[SOFTMAX]]
+  %ch7 = corert.executeop.seq(%cpu, %ch6) "tfrt_test.print"(%softmax) : 0
+
+  tfrt.return
+}
+
+// CHECK: --- Running 'forward_fused_batch_norm_input'
+func @forward_fused_batch_norm_input() {
+  %ch0 = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch0 "cpu"
+
+  %input = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [1, 2, 2, 1], values = [1.0 : f32, -1.0 : f32, -1.0 : f32, 1.0 : f32] } : 1
+  %scale = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [1], values = [3.0 : f32] } : 1
+  %bias = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [1], values = [1.0 : f32] } : 1
+  %mean = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [1], values = [0.5 : f32] } : 1
+  %variance = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [1], values = [4.0 : f32] } : 1
+
+  // CHECK: DenseHostTensor: buffer=[[ADDR:.*]]
+  %ch1 = corert.executeop.seq(%cpu, %ch0) "tfrt_test.print_address"(%input) : 0
+  %ch2, %res: 6 = corert.executeop.seq(%cpu, %ch1) "tf.FusedBatchNormV3"(%input, %scale, %bias, %mean, %variance)
+    { T = f32, U = f32, epsilon = 0.0 : f32, data_format = "NHWC", is_training = false } : 6
+  // CHECK: DenseHostTensor: buffer=[[ADDR]]
+  %ch3 = corert.executeop.seq(%cpu, %ch2) "tfrt_test.print_address"(%res#0) : 0
+  // CHECK: DenseHostTensor dtype = f32, shape = [1, 2, 2, 1], values = [[BATCH_NORM:.*]]
+  %ch4 = corert.executeop.seq(%cpu, %ch3) "tfrt_test.print"(%res#0) : 0
+
+  tfrt.return
+}
+
+// CHECK: --- Running 'do_not_forward_fused_batch_norm_input'
+func @do_not_forward_fused_batch_norm_input() {
+  %ch0 = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch0 "cpu"
+
+  %input = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [1, 2, 2, 1], values = [1.0 : f32, -1.0 : f32, -1.0 : f32, 1.0 : f32] } : 1
+  %scale = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [1], values = [3.0 : f32] } : 1
+  %bias = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [1], values = [1.0 : f32] } : 1
+  %mean = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [1], values = [0.5 : f32] } : 1
+  %variance = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [1], values = [4.0 : f32] } : 1
+
+  // The input is still used after the op, so it is not forwarded.
+  %ch1, %res: 6 = corert.executeop.seq(%cpu, %ch0) "tf.FusedBatchNormV3"(%input, %scale, %bias, %mean, %variance)
+    { T = f32, U = f32, epsilon = 0.0 : f32, data_format = "NHWC", is_training = false } : 6
+  // CHECK: DenseHostTensor dtype = f32, shape = [1, 2, 2, 1], values = [[BATCH_NORM]]
+  %ch2 = corert.executeop.seq(%cpu, %ch1) "tfrt_test.print"(%res#0) : 0
+  // CHECK: DenseHostTensor dtype = f32, shape = [1, 2, 2, 1], values = [1.000000e+00, -1.000000e+00, -1.000000e+00, 1.000000e+00]
+  %ch3 = corert.executeop.seq(%cpu, %ch2) "tfrt_test.print"(%input) : 0
+
+  tfrt.return
+}
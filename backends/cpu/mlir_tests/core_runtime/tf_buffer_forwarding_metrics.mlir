@@ -0,0 +1,53 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: bef_executor --test_init_function=register_op_handlers_cpu --print_metrics %s.bef | FileCheck %s
+
+func @register_op_handlers_cpu() {
+  %null = "corert.create_null_op_handler"() : () -> !corert.ophandler
+  %cpu = "corert.create_cpu_op_handler"(%null) : (!corert.ophandler) -> !corert.ophandler
+  corert.register_op_handler %cpu "cpu"
+  tfrt.return
+}
+
+// A small activation graph where every op but the last one can compute its
+// output in the buffer of its input. Only the last op, whose input is still
+// used afterwards, allocates a new output.
+
+// CHECK: --- Running 'activation_graph'
+func @activation_graph() {
+  %ch0 = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch0 "cpu"
+
+  %input = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [2, 3], values = [-1.0 : f32, -0.5 : f32, 0.0 : f32, 0.5 : f32, 1.0 : f32, 1.5 : f32] } : 1
+  %bias = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [3], values = [1.0 : f32, 2.0 : f32, 3.0 : f32] } : 1
+
+  %ch1, %relu = corert.executeop.seq(%cpu, %ch0) "tf.Relu"(%input) { T = f32 } : 1
+  %ch2, %bias_add = corert.executeop.seq(%cpu, %ch1) "tf.BiasAdd"(%relu, %bias)
+    { T = f32, data_format = "NHWC" } : 1
+  %ch3, %softmax = corert.executeop.seq(%cpu, %ch2) "tf.Softmax"(%bias_add) { T = f32 } : 1
+  %ch4, %log = corert.executeop.seq(%cpu, %ch3) "tf.Log"(%softmax) : 1
+  %ch5, %sigmoid = corert.executeop.seq(%cpu, %ch4) "tf.Sigmoid"(%log) : 1
+  %ch6 = corert.executeop.seq(%cpu, %ch5) "tfrt_test.print"(%log) : 0
+  %ch7 = corert.executeop.seq(%cpu, %ch6) "tfrt_test.print"(%sigmoid) : 0
+
+  tfrt.return
+}
+
+// Four outputs of 24 bytes reuse the buffer of their input.
+// CHECK: tensorflow_runtime_cpu_buffer_forwarding_allocated 1
+// CHECK: tensorflow_runtime_cpu_buffer_forwarding_forwarded 4
+// CHECK: tensorflow_runtime_cpu_buffer_forwarding_forwarded_bytes 96
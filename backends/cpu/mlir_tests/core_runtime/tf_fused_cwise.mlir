@@ -0,0 +1,85 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: bef_executor --test_init_function=register_op_handlers_cpu %s.bef | FileCheck %s
+
+func @register_op_handlers_cpu() {
+  %null = "corert.create_null_op_handler"() : () -> !corert.ophandler
+  %cpu = "corert.create_cpu_op_handler"(%null) : (!corert.ophandler) -> !corert.ophandler
+  corert.register_op_handler %cpu "cpu"
+  tfrt.return
+}
+
+// CHECK: --- Running 'fused_cwise_bias_relu_mul_f32'
+func @fused_cwise_bias_relu_mul_f32() -> !tfrt.chain {
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %x = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [2, 3], values = [-1.0 : f32, -0.5 : f32, 0.0 : f32, 0.5 : f32, 1.0 : f32, 1.5 : f32] } : 1
+  %bias = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [3], values = [1.0 : f32, 2.0 : f32, 3.0 : f32] } : 1
+  %scale = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [1], values = [2.0 : f32] } : 1
+
+  %result = corert.executeop(%cpu) "tf._FusedCwise"(%x, %bias, %scale)
+    { T = f32, fused_ops = ["BiasAdd", "Relu", "Mul"] } : 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 3]
+  // CHECK-SAME: values = [0.000000e+00, 3.000000e+00, 6.000000e+00, 3.000000e+00, 6.000000e+00, 9.000000e+00]
+  %ch_print = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%result) : 0
+
+  tfrt.return %ch_print : !tfrt.chain
+}
+
+// CHECK: --- Running 'fused_cwise_sub_sigmoid_f32'
+func @fused_cwise_sub_sigmoid_f32() -> !tfrt.chain {
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %x = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [2, 2], values = [1.0 : f32, 2.0 : f32, 3.0 : f32, 4.0 : f32] } : 1
+  %y = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [2, 2], values = [1.0 : f32, 2.0 : f32, 3.0 : f32, 4.0 : f32] } : 1
+
+  %result = corert.executeop(%cpu) "tf._FusedCwise"(%x, %y)
+    { T = f32, fused_ops = ["Sub", "Sigmoid"] } : 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 2]
+  // CHECK-SAME: values = [5.000000e-01, 5.000000e-01, 5.000000e-01, 5.000000e-01]
+  %ch_print = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%result) : 0
+
+  tfrt.return %ch_print : !tfrt.chain
+}
+
+// Fusion inputs that broadcast the other way are evaluated unfused.
+// CHECK: --- Running 'fused_cwise_broadcast_f32'
+func @fused_cwise_broadcast_f32() -> !tfrt.chain {
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %x = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [2, 3], values = [-1.0 : f32, -0.5 : f32, 0.0 : f32, 0.5 : f32, 1.0 : f32, 1.5 : f32] } : 1
+  %y = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [2, 1], values = [1.0 : f32, -1.0 : f32] } : 1
+
+  %result = corert.executeop(%cpu) "tf._FusedCwise"(%x, %y)
+    { T = f32, fused_ops = ["AddV2", "Relu"] } : 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 3]
+  // CHECK-SAME: values = [0.000000e+00, 5.000000e-01, 1.000000e+00, 0.000000e+00, 0.000000e+00, 5.000000e-01]
+  %ch_print = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%result) : 0
+
+  tfrt.return %ch_print : !tfrt.chain
+}
@@ -0,0 +1,158 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks measuring the per-call overhead of BEF function execution for
+// small graphs, where decoding the function and setting up the executor state
+// is a significant part of the total cost, and comparing the kernel scheduling
+// policies of the executor on a multi-threaded work queue.
+
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "gtest/gtest.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Parser.h"
+#include "tfrt/basic_kernels/opdefs/tfrt_base.h"
+#include "tfrt/bef_converter/mlir_to_bef.h"
+#include "tfrt/bef_executor/bef_file.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/function.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/host_context/kernel_registry.h"
+#include "tfrt/support/logging.h"
+#include "tfrt/support/string_util.h"
+#include "tfrt/utils/mlir_runner_util.h"
+
+namespace tfrt {
+namespace testing {
+namespace {
+
+// Returns a function with `num_kernels` tfrt.add.i32 kernels that all depend
+// only on the function argument.
+std::string WideFunction(int num_kernels) {
+  std::string body;
+  for (int i = 0; i < num_kernels; ++i)
+    body += StrCat("  %x", i, " = tfrt.add.i32 %arg0, %arg0\n");
+  return StrCat("func @main(%arg0: i32) -> i32 {\n", body, "  tfrt.return %x",
+                num_kernels - 1, " : i32\n}\n");
+}
+
+// Returns a function with a chain of `num_kernels` tfrt.add.i32 kernels.
+std::string DeepFunction(int num_kernels) {
+  std::string body = "  %x0 = tfrt.add.i32 %arg0, %arg0\n";
+  for (int i = 1; i < num_kernels; ++i)
+    body += StrCat("  %x", i, " = tfrt.add.i32 %x", i - 1, ", %x", i - 1, "\n");
+  return StrCat("func @main(%arg0: i32) -> i32 {\n", body, "  tfrt.return %x",
+                num_kernels - 1, " : i32\n}\n");
+}
+
+void RunBenchmark(benchmark::State& state, const std::string& mlir_input) {
+  mlir::MLIRContext context;
+  mlir::DialectRegistry registry;
+  registry.insert<compiler::TFRTDialect>();
+  context.appendDialectRegistry(registry);
+
+  TfrtMlirRunner::Builder builder;
+  builder.set_mlir_fn_name("main")
+      .set_mlir_input(mlir_input)
+      .add_input<int32_t>(1)
+      .set_mlir_context(&context);
+  auto runner = builder.Compile();
+
+  for (auto _ : state) {
+    auto results = runner.Run();
+    benchmark::DoNotOptimize(results);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_ExecuteWideFunction(benchmark::State& state) {
+  RunBenchmark(state, WideFunction(state.range(0)));
+}
+BENCHMARK(BM_ExecuteWideFunction)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+void BM_ExecuteDeepFunction(benchmark::State& state) {
+  RunBenchmark(state, DeepFunction(state.range(0)));
+}
+BENCHMARK(BM_ExecuteDeepFunction)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+void RunMultiThreadedBenchmark(benchmark::State& state,
+                               const std::string& mlir_input,
+                               KernelScheduling kernel_scheduling) {
+  mlir::MLIRContext context;
+  mlir::DialectRegistry registry;
+  registry.insert<compiler::TFRTDialect>();
+  context.appendDialectRegistry(registry);
+
+  HostContext host(
+      [](const DecodedDiagnostic& diag) {
+        TFRT_LOG(FATAL) << "Encountered error: " << diag.message;
+      },
+      CreateMallocAllocator(),
+      CreateMultiThreadedWorkQueue(/*num_threads=*/4,
+                                   /*num_blocking_threads=*/4));
+  RegisterStaticKernels(host.GetMutableRegistry());
+
+  mlir::OwningModuleRef module = mlir::parseSourceString(mlir_input, &context);
+  BefBuffer bef_buffer =
+      ConvertMLIRToBEF(module.get(), /*disable_optional_sections=*/true);
+  auto bef_file = BEFFile::Open(bef_buffer, host.GetKernelRegistry(),
+                                host.diag_handler(), host.allocator());
+  const Function* func = bef_file->GetFunction("main");
+
+  auto arg = MakeAvailableAsyncValueRef<int32_t>(1);
+  AsyncValue* args[] = {arg.GetAsyncValue()};
+
+  ExecutionContext exec_ctx(*RequestContextBuilder(&host, nullptr).build());
+  exec_ctx.set_kernel_scheduling(kernel_scheduling);
+
+  for (auto _ : state) {
+    RCReference<AsyncValue> results[1];
+    func->Execute(exec_ctx, args, results);
+    host.Await(results);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_StreamTaskWideFunction(benchmark::State& state) {
+  RunMultiThreadedBenchmark(state, WideFunction(state.range(0)),
+                            KernelScheduling::kStreamTask);
+}
+BENCHMARK(BM_StreamTaskWideFunction)->Arg(16)->Arg(64)->Arg(256);
+
+void BM_WorkStealingWideFunction(benchmark::State& state) {
+  RunMultiThreadedBenchmark(state, WideFunction(state.range(0)),
+                            KernelScheduling::kWorkStealing);
+}
+BENCHMARK(BM_WorkStealingWideFunction)->Arg(16)->Arg(64)->Arg(256);
+
+void BM_StreamTaskDeepFunction(benchmark::State& state) {
+  RunMultiThreadedBenchmark(state, DeepFunction(state.range(0)),
+                            KernelScheduling::kStreamTask);
+}
+BENCHMARK(BM_StreamTaskDeepFunction)->Arg(16)->Arg(64)->Arg(256);
+
+void BM_WorkStealingDeepFunction(benchmark::State& state) {
+  RunMultiThreadedBenchmark(state, DeepFunction(state.range(0)),
+                            KernelScheduling::kWorkStealing);
+}
+BENCHMARK(BM_WorkStealingDeepFunction)->Arg(16)->Arg(64)->Arg(256);
+
+}  // namespace
+}  // namespace testing
+}  // namespace tfrt
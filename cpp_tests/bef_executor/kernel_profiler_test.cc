@@ -0,0 +1,186 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit test for the BEF executor KernelProfiler.
+
+#include "tfrt/bef_executor/kernel_profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Parser.h"
+#include "tfrt/basic_kernels/opdefs/tfrt_base.h"
+#include "tfrt/bef_converter/mlir_to_bef.h"
+#include "tfrt/bef_executor/bef_file.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/function.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/host_context/kernel_registry.h"
+#include "tfrt/support/logging.h"
+
+namespace tfrt {
+namespace {
+
+constexpr const char* kChainFunction = R"mlir(
+func @main(%arg0: i32) -> i32 {
+  %x0 = tfrt.add.i32 %arg0, %arg0
+  %x1 = tfrt.add.i32 %x0, %x0
+  %x2 = tfrt.add.i32 %x1, %x1
+  tfrt.return %x2 : i32
+}
+)mlir";
+
+TEST(KernelProfilerTest, RecordsKernelsOfExecutedFunction) {
+  mlir::MLIRContext context;
+  mlir::DialectRegistry registry;
+  registry.insert<compiler::TFRTDialect>();
+  context.appendDialectRegistry(registry);
+
+  HostContext host(
+      [](const DecodedDiagnostic& diag) {
+        TFRT_LOG(FATAL) << "Encountered error: " << diag.message;
+      },
+      CreateMallocAllocator(), CreateSingleThreadedWorkQueue());
+  RegisterStaticKernels(host.GetMutableRegistry());
+
+  mlir::OwningModuleRef module =
+      mlir::parseSourceString(kChainFunction, &context);
+  BefBuffer bef_buffer =
+      ConvertMLIRToBEF(module.get(), /*disable_optional_sections=*/true);
+  auto bef_file = BEFFile::Open(bef_buffer, host.GetKernelRegistry(),
+                                host.diag_handler(), host.allocator());
+  const Function* func = bef_file->GetFunction("main");
+
+  auto arg = MakeAvailableAsyncValueRef<int32_t>(1);
+  AsyncValue* args[] = {arg.GetAsyncValue()};
+
+  KernelProfiler profiler;
+  ExecutionContext exec_ctx(*RequestContextBuilder(&host, nullptr).build());
+  exec_ctx.set_kernel_profiler(&profiler);
+
+  for (int i = 0; i < 2; ++i) {
+    RCReference<AsyncValue> results[1];
+    func->Execute(exec_ctx, args, results);
+    host.Await(results);
+    EXPECT_EQ(results[0]->get<int32_t>(), 8);
+  }
+  host.Quiesce();
+
+  // Three tfrt.add.i32 kernels and the tfrt.return kernel per execution.
+  auto events = profiler.GetEvents();
+  ASSERT_EQ(events.size(), 8);
+  EXPECT_EQ(profiler.num_dropped_events(), 0);
+
+  std::sort(events.begin(), events.end(), [](const auto& x, const auto& y) {
+    return std::make_pair(x.invocation_id, x.start_ns) <
+           std::make_pair(y.invocation_id, y.start_ns);
+  });
+  EXPECT_NE(events[0].invocation_id, events[4].invocation_id);
+  for (int i = 0; i < 8; ++i) {
+    const auto& event = events[i];
+    EXPECT_EQ(event.function, func);
+    EXPECT_LE(event.ready_ns, event.start_ns);
+    EXPECT_LE(event.start_ns, event.end_ns);
+    EXPECT_TRUE(event.ran_inline);
+    // Each kernel is made ready by the previous one in the chain.
+    if (i % 4 != 0) EXPECT_EQ(event.producer_id, events[i - 1].kernel_id);
+  }
+
+  std::string report;
+  llvm::raw_string_ostream os(report);
+  profiler.PrintReport(os);
+  EXPECT_THAT(report, ::testing::HasSubstr("Kernel profile: 8 kernel"));
+  EXPECT_THAT(report, ::testing::HasSubstr("Function 'main'"));
+  EXPECT_THAT(report, ::testing::HasSubstr("Top kernels"));
+  EXPECT_THAT(report, ::testing::HasSubstr("Critical path"));
+  EXPECT_THAT(report, ::testing::HasSubstr("Average parallelism"));
+}
+
+TEST(KernelProfilerTest, OverwritesOldestEventsWhenBufferIsFull) {
+  KernelProfiler profiler(/*max_events_per_thread=*/2);
+  KernelProfileEvent event = {};
+  for (int i = 0; i < 3; ++i) {
+    event.kernel_id = i;
+    profiler.Record(event);
+  }
+  auto events = profiler.GetEvents();
+  ASSERT_EQ(events.size(), 2);
+  EXPECT_EQ(events[0].kernel_id, 1);
+  EXPECT_EQ(events[1].kernel_id, 2);
+  EXPECT_EQ(profiler.num_dropped_events(), 1);
+}
+
+TEST(KernelProfilerTest, GetEventsWhileRecording) {
+  KernelProfiler profiler(/*max_events_per_thread=*/64);
+  std::atomic<bool> done{false};
+  std::thread thread([&] {
+    KernelProfileEvent event = {};
+    for (uint32_t i = 0; !done.load(); ++i) {
+      event.kernel_id = i;
+      event.producer_id = i;
+      profiler.Record(event);
+    }
+  });
+  for (int i = 0; i < 100; ++i) {
+    auto events = profiler.GetEvents();
+    EXPECT_LE(events.size(), 64);
+    // Torn events are skipped.
+    for (const auto& event : events)
+      EXPECT_EQ(event.kernel_id, event.producer_id);
+  }
+  done.store(true);
+  thread.join();
+  EXPECT_EQ(profiler.GetEvents().size(), 64);
+}
+
+class TestLocationHandler : public LocationHandler {
+ public:
+  DecodedLocation DecodeLocation(Location loc) const override {
+    return OpaqueLocation{"kernel" + std::to_string(loc.data)};
+  }
+};
+
+TEST(KernelProfilerTest, WritesMeanRunTimePerLocation) {
+  TestLocationHandler handler;
+  auto make_event = [&](int location, int64_t run_ns) {
+    KernelProfileEvent event = {};
+    if (location >= 0) event.location = Location(&handler, location);
+    event.start_ns = 100;
+    event.end_ns = 100 + run_ns;
+    return event;
+  };
+  KernelProfileEvent events[] = {make_event(1, 300), make_event(0, 50),
+                                 make_event(1, 100), make_event(-1, 1000)};
+
+  std::string profile;
+  llvm::raw_string_ostream os(profile);
+  KernelProfiler::WriteCostProfile(events, os);
+  EXPECT_EQ(os.str(),
+            "# <mean_ns> <count> <location>\n"
+            "50 1 kernel0\n"
+            "200 2 kernel1\n");
+}
+
+}  // namespace
+}  // namespace tfrt
@@ -0,0 +1,153 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file has unit tests for tfrt::SyncMemoryPlanner.
+
+#include "tfrt/bef_executor/sync_memory_planner.h"
+
+#include <cstdint>
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_buffer.h"
+
+namespace tfrt {
+namespace {
+
+class SyncMemoryPlannerTest : public ::testing::Test {
+ protected:
+  // Executes two kernels: the first one allocates a buffer that is released
+  // by the second one, which allocates a buffer that outlives the execution
+  // if `result` is not null.
+  void Execute(RCReference<HostBuffer>* result = nullptr,
+               size_t second_size = 64) {
+    planner_.BeginExecution(allocator_.get());
+
+    auto first = planner_.AllocateBuffer(64, 16);
+    ASSERT_TRUE(first);
+    first_data_ = first->data();
+    planner_.EndKernel();
+
+    auto second = planner_.AllocateBuffer(second_size, 16);
+    ASSERT_TRUE(second);
+    second_data_ = second->data();
+    first.reset();
+    if (result) *result = std::move(second);
+    second.reset();
+    planner_.EndKernel();
+
+    planner_.EndExecution(/*success=*/true);
+  }
+
+  std::unique_ptr<HostAllocator> allocator_ = CreateMallocAllocator();
+  SyncMemoryPlanner planner_;
+  void* first_data_ = nullptr;
+  void* second_data_ = nullptr;
+};
+
+TEST_F(SyncMemoryPlannerTest, ReusesOffsetsOfReleasedBuffers) {
+  ASSERT_FALSE(planner_.HasPlan());
+  Execute();
+  ASSERT_TRUE(planner_.HasPlan());
+
+  const SyncMemoryPlanStats& stats = planner_.stats();
+  EXPECT_EQ(stats.num_buffers, 2);
+  EXPECT_EQ(stats.num_planned_buffers, 2);
+  EXPECT_EQ(stats.total_bytes, 128);
+  EXPECT_EQ(stats.peak_bytes, 128);
+  EXPECT_EQ(stats.planned_bytes, 128);
+
+  // Both buffers are live during the second kernel and get distinct slices of
+  // the arena, which is reused by the following executions.
+  Execute();
+  void* first_data = first_data_;
+  void* second_data = second_data_;
+  EXPECT_NE(first_data, second_data);
+  Execute();
+  EXPECT_EQ(first_data_, first_data);
+  EXPECT_EQ(second_data_, second_data);
+  EXPECT_TRUE(planner_.HasPlan());
+}
+
+TEST_F(SyncMemoryPlannerTest, SharesOffsetsOfDisjointLifetimes) {
+  auto execute = [this] {
+    planner_.BeginExecution(allocator_.get());
+    for (int i = 0; i < 3; ++i) {
+      auto buffer = planner_.AllocateBuffer(256, 64);
+      ASSERT_TRUE(buffer);
+      first_data_ = buffer->data();
+      buffer.reset();
+      planner_.EndKernel();
+    }
+    planner_.EndExecution(/*success=*/true);
+  };
+
+  execute();
+  ASSERT_TRUE(planner_.HasPlan());
+  EXPECT_EQ(planner_.stats().num_planned_buffers, 3);
+  EXPECT_EQ(planner_.stats().total_bytes, 768);
+  EXPECT_EQ(planner_.stats().peak_bytes, 256);
+  EXPECT_EQ(planner_.stats().planned_bytes, 256);
+
+  execute();
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(first_data_) % 64, 0);
+}
+
+TEST_F(SyncMemoryPlannerTest, DoesNotPlanBuffersOutlivingExecution) {
+  RCReference<HostBuffer> result;
+  Execute(&result);
+  ASSERT_TRUE(planner_.HasPlan());
+  EXPECT_EQ(planner_.stats().num_buffers, 2);
+  EXPECT_EQ(planner_.stats().num_planned_buffers, 1);
+  EXPECT_EQ(planner_.stats().planned_bytes, 64);
+
+  // The result of the previous execution is not overwritten.
+  void* result_data = result->data();
+  Execute(&result);
+  EXPECT_NE(first_data_, result_data);
+}
+
+TEST_F(SyncMemoryPlannerTest, DoesNotReuseReferencedArena) {
+  Execute();
+  ASSERT_TRUE(planner_.HasPlan());
+
+  // Keep a slice of the arena alive after the execution.
+  planner_.BeginExecution(allocator_.get());
+  auto first = planner_.AllocateBuffer(64, 16);
+  planner_.EndKernel();
+  auto second = planner_.AllocateBuffer(64, 16);
+  planner_.EndKernel();
+  planner_.EndExecution(/*success=*/true);
+
+  Execute();
+  EXPECT_NE(first_data_, first->data());
+  EXPECT_NE(second_data_, second->data());
+}
+
+TEST_F(SyncMemoryPlannerTest, DropsPlanIfShapesChange) {
+  Execute();
+  ASSERT_TRUE(planner_.HasPlan());
+
+  Execute(/*result=*/nullptr, /*second_size=*/128);
+  EXPECT_FALSE(planner_.HasPlan());
+
+  // Buffers are still allocated individually.
+  Execute();
+  EXPECT_NE(first_data_, nullptr);
+  EXPECT_FALSE(planner_.HasPlan());
+}
+
+}  // namespace
+}  // namespace tfrt
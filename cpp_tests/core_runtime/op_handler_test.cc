@@ -20,6 +20,7 @@
 
 #include "gtest/gtest.h"
 #include "tfrt/core_runtime/core_runtime.h"
+#include "tfrt/core_runtime/core_runtime_op.h"
 #include "tfrt/cpp_tests/test_util.h"
 #include "tfrt/cpu/core_runtime/cpu_op_handler.h"
 #include "tfrt/cpu/core_runtime/null_op_handler.h"
@@ -39,6 +40,22 @@ class DummyOpHandler : public OpHandler {
   }
 };
 
+// Counts MakeOp() calls, and supports all ops except "unsupported".
+class CountingOpHandler : public OpHandler {
+ public:
+  explicit CountingOpHandler(CoreRuntime* runtime)
+      : OpHandler("counting", runtime, /*fallback=*/nullptr) {}
+
+  Expected<CoreRuntimeOp> MakeOp(string_view op_name) override {
+    ++num_make_op_calls;
+    if (op_name == "unsupported")
+      return MakeStringError(op_name, " is not supported.");
+    return CoreRuntimeOp([](const OpInvocation&) {}, /*is_fallback=*/false);
+  }
+
+  int num_make_op_calls = 0;
+};
+
 static std::unique_ptr<CoreRuntime> CreateCoreRuntime() {
   constexpr const char* kCpuOpHandlerName = "cpu";
   auto diag_handler = [](const DecodedDiagnostic& diag) {
@@ -84,5 +101,34 @@ TEST(OpHandlerTest, Registration) {
   ASSERT_EQ(core_runtime->GetOpHandler(chain_name), chain_root);
   ASSERT_FALSE(core_runtime->GetOpHandler(op_handler_name));
 }
+
+TEST(OpHandlerTest, OpDispatchCache) {
+  auto core_runtime = CreateCoreRuntime();
+  auto op_handler = std::make_unique<CountingOpHandler>(core_runtime.get());
+  CountingOpHandler* counting = op_handler.get();
+  core_runtime->TakeOpHandler(std::move(op_handler));
+
+  // The op is made once, and then served from the cache.
+  auto op0 = core_runtime->GetOrMakeOp("test.op", counting);
+  auto op1 = core_runtime->GetOrMakeOp("test.op", counting);
+  ASSERT_TRUE(!!op0);
+  ASSERT_TRUE(!!op1);
+  ASSERT_EQ(*op0, *op1);
+  ASSERT_EQ(counting->num_make_op_calls, 1);
+
+  // Different ops are cached separately.
+  auto op2 = core_runtime->GetOrMakeOp("test.other_op", counting);
+  ASSERT_TRUE(!!op2);
+  ASSERT_NE(*op0, *op2);
+  ASSERT_EQ(counting->num_make_op_calls, 2);
+
+  // Unsupported ops are not cached.
+  for (int i = 0; i < 2; ++i) {
+    auto unsupported = core_runtime->GetOrMakeOp("unsupported", counting);
+    ASSERT_FALSE(!!unsupported);
+    llvm::consumeError(unsupported.takeError());
+  }
+  ASSERT_EQ(counting->num_make_op_calls, 4);
+}
 }  // namespace
 }  // namespace tfrt
@@ -0,0 +1,144 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file has unit tests for tfrt::OpMetadataCache.
+
+#include "tfrt/core_runtime/op_metadata_cache.h"
+
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+#include "gtest/gtest.h"
+#include "tfrt/core_runtime/op_attrs.h"
+#include "tfrt/host_context/async_value.h"
+#include "tfrt/support/ref_count.h"
+#include "tfrt/tensor/tensor_metadata.h"
+
+namespace tfrt {
+namespace {
+
+static RCReference<AsyncValue> TestMetadataFn(
+    const ExecutionContext& exec_ctx, ArrayRef<TensorMetadata> inputs,
+    const OpAttrsRef& attrs, MutableArrayRef<TensorMetadata> results) {
+  return {};
+}
+
+static RCReference<AsyncValue> OtherMetadataFn(
+    const ExecutionContext& exec_ctx, ArrayRef<TensorMetadata> inputs,
+    const OpAttrsRef& attrs, MutableArrayRef<TensorMetadata> results) {
+  return {};
+}
+
+TEST(OpMetadataCacheTest, SameInputsSameKey) {
+  OpAttrs attrs0;
+  ASSERT_TRUE(attrs0.Set<bool>("transpose", true));
+  ASSERT_TRUE(attrs0.SetArray<int64_t>("dims", {1, 2, 3}));
+
+  OpAttrs attrs1;
+  ASSERT_TRUE(attrs1.Set<bool>("transpose", true));
+  ASSERT_TRUE(attrs1.SetArray<int64_t>("dims", {1, 2, 3}));
+
+  TensorMetadata arg(DType::F32, {2, 3});
+
+  auto key0 = OpMetadataCache::MakeKey(TestMetadataFn, OpAttrsRef(attrs0),
+                                       arg, /*num_results=*/1);
+  auto key1 = OpMetadataCache::MakeKey(TestMetadataFn, OpAttrsRef(attrs1),
+                                       arg, /*num_results=*/1);
+  ASSERT_TRUE(key0.IsValid());
+  ASSERT_EQ(key0, key1);
+
+  // Frozen attributes produce the same key.
+  auto key2 = OpMetadataCache::MakeKey(TestMetadataFn, attrs0.freeze(), arg,
+                                       /*num_results=*/1);
+  ASSERT_EQ(key0, key2);
+}
+
+TEST(OpMetadataCacheTest, DifferentInputsDifferentKeys) {
+  OpAttrs attrs;
+  ASSERT_TRUE(attrs.Set<bool>("transpose", true));
+  TensorMetadata arg(DType::F32, {2, 3});
+  auto key = OpMetadataCache::MakeKey(TestMetadataFn, OpAttrsRef(attrs), arg,
+                                      /*num_results=*/1);
+
+  // Different metadata function.
+  ASSERT_FALSE(key == OpMetadataCache::MakeKey(
+                          OtherMetadataFn, OpAttrsRef(attrs), arg, 1));
+
+  // Different number of results.
+  ASSERT_FALSE(key == OpMetadataCache::MakeKey(TestMetadataFn,
+                                               OpAttrsRef(attrs), arg, 2));
+
+  // Different attribute value.
+  OpAttrs other_attrs;
+  ASSERT_TRUE(other_attrs.Set<bool>("transpose", false));
+  ASSERT_FALSE(key == OpMetadataCache::MakeKey(
+                          TestMetadataFn, OpAttrsRef(other_attrs), arg, 1));
+
+  // Different argument dtype and shape.
+  TensorMetadata i32_arg(DType::I32, {2, 3});
+  ASSERT_FALSE(key == OpMetadataCache::MakeKey(
+                          TestMetadataFn, OpAttrsRef(attrs), i32_arg, 1));
+  TensorMetadata other_shape_arg(DType::F32, {3, 2});
+  ASSERT_FALSE(key == OpMetadataCache::MakeKey(TestMetadataFn,
+                                               OpAttrsRef(attrs),
+                                               other_shape_arg, 1));
+}
+
+TEST(OpMetadataCacheTest, LookupAndInsert) {
+  OpMetadataCache cache;
+
+  OpAttrs attrs;
+  ASSERT_TRUE(attrs.Set<int32_t>("axis", 1));
+  TensorMetadata arg(DType::F32, {2, 3});
+  auto key = OpMetadataCache::MakeKey(TestMetadataFn, OpAttrsRef(attrs), arg,
+                                      /*num_results=*/1);
+
+  TensorMetadata result;
+  ASSERT_FALSE(cache.Lookup(key, result));
+
+  cache.Insert(key, TensorMetadata(DType::F32, {3}));
+  ASSERT_TRUE(cache.Lookup(key, result));
+  ASSERT_EQ(result, TensorMetadata(DType::F32, {3}));
+
+  // Different attributes still miss the cache.
+  OpAttrs other_attrs;
+  ASSERT_TRUE(other_attrs.Set<int32_t>("axis", 0));
+  auto other_key = OpMetadataCache::MakeKey(
+      TestMetadataFn, OpAttrsRef(other_attrs), arg, /*num_results=*/1);
+  ASSERT_FALSE(cache.Lookup(other_key, result));
+}
+
+static void BM_MakeKeyAndLookup(benchmark::State& state) {
+  OpMetadataCache cache;
+
+  OpAttrs attrs;
+  attrs.Set<bool>("transpose_a", false);
+  attrs.Set<bool>("transpose_b", false);
+  TensorMetadata args[] = {TensorMetadata(DType::F32, {128, 256}),
+                           TensorMetadata(DType::F32, {256, 64})};
+  cache.Insert(OpMetadataCache::MakeKey(TestMetadataFn, OpAttrsRef(attrs),
+                                        args, /*num_results=*/1),
+               TensorMetadata(DType::F32, {128, 64}));
+
+  TensorMetadata result;
+  for (auto _ : state) {
+    auto key = OpMetadataCache::MakeKey(TestMetadataFn, OpAttrsRef(attrs),
+                                        args, /*num_results=*/1);
+    benchmark::DoNotOptimize(cache.Lookup(key, result));
+  }
+}
+BENCHMARK(BM_MakeKeyAndLookup);
+
+}  // namespace
+}  // namespace tfrt
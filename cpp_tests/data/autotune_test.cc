@@ -0,0 +1,142 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit tests for AutotuneController and the autotuned PrefetchDataset.
+
+#include "../../lib/data/autotune.h"
+
+#include <chrono>
+
+#include "../../lib/data/prefetch_dataset.h"
+#include "dataset_test_util.h"
+#include "gtest/gtest.h"
+#include "tfrt/host_context/async_value_ref.h"
+
+namespace tfrt {
+namespace data {
+namespace {
+
+using std::chrono::milliseconds;
+
+class AutotuneTest : public DatasetTest<> {
+ protected:
+  // Records `count` GetNext() calls whose elements were not available, and
+  // `wait` of total consumer wait time.
+  void RecordConsumerWaits(AutotuneKnob* knob, int count,
+                           std::chrono::nanoseconds wait) {
+    for (int i = 0; i < count; ++i) {
+      auto element = MakeUnconstructedAsyncValueRef<bool>(&host_);
+      knob->RecordGetNext(element.GetAsyncValue(), /*producer_idle=*/false);
+      element.emplace(false);
+    }
+    knob->RecordConsumerWait(wait);
+  }
+
+  // Records `count` GetNext() calls whose elements were available while the
+  // producer was idle.
+  void RecordProducerIdle(AutotuneKnob* knob, int count) {
+    for (int i = 0; i < count; ++i) {
+      auto element = MakeAvailableAsyncValueRef<bool>(&host_, false);
+      knob->RecordGetNext(element.GetAsyncValue(), /*producer_idle=*/true);
+    }
+  }
+};
+
+TEST_F(AutotuneTest, GrowsWhenConsumerWaits) {
+  auto& controller = AutotuneController::Get(&host_);
+  auto knob = controller.MakeKnob(/*initial_value=*/2, /*min_value=*/1,
+                                  /*max_value=*/16);
+
+  RecordConsumerWaits(knob.get(), 32, milliseconds(10));
+  controller.Tune(milliseconds(50));
+  EXPECT_EQ(knob->value(), 4);
+
+  RecordConsumerWaits(knob.get(), 32, milliseconds(10));
+  controller.Tune(milliseconds(50));
+  EXPECT_EQ(knob->value(), 8);
+}
+
+TEST_F(AutotuneTest, ShrinksWhenProducerIsIdle) {
+  auto& controller = AutotuneController::Get(&host_);
+  auto knob = controller.MakeKnob(/*initial_value=*/16, /*min_value=*/1,
+                                  /*max_value=*/16);
+
+  RecordProducerIdle(knob.get(), 32);
+  controller.Tune(milliseconds(50));
+  EXPECT_EQ(knob->value(), 14);
+}
+
+TEST_F(AutotuneTest, KeepsValueWithoutEnoughSamples) {
+  auto& controller = AutotuneController::Get(&host_);
+  auto knob = controller.MakeKnob(/*initial_value=*/4, /*min_value=*/1,
+                                  /*max_value=*/16);
+
+  RecordConsumerWaits(knob.get(), 4, milliseconds(10));
+  controller.Tune(milliseconds(50));
+  EXPECT_EQ(knob->value(), 4);
+}
+
+TEST_F(AutotuneTest, StaysWithinBounds) {
+  auto& controller = AutotuneController::Get(&host_);
+  auto knob = controller.MakeKnob(/*initial_value=*/12, /*min_value=*/2,
+                                  /*max_value=*/16);
+
+  RecordConsumerWaits(knob.get(), 32, milliseconds(10));
+  controller.Tune(milliseconds(50));
+  EXPECT_EQ(knob->value(), 16);
+
+  for (int i = 0; i < 32; ++i) {
+    RecordProducerIdle(knob.get(), 32);
+    controller.Tune(milliseconds(50));
+  }
+  EXPECT_EQ(knob->value(), 2);
+}
+
+TEST_F(AutotuneTest, SharesMemoryBudget) {
+  auto& controller = AutotuneController::Get(&host_);
+  controller.set_memory_budget(20 * 1024);
+
+  // The knob that waits the longest gets the memory first.
+  auto knob_1 = controller.MakeKnob(/*initial_value=*/4, /*min_value=*/1,
+                                    /*max_value=*/64);
+  auto knob_2 = controller.MakeKnob(/*initial_value=*/4, /*min_value=*/1,
+                                    /*max_value=*/64);
+  knob_1->RecordElementBytes(1024);
+  knob_2->RecordElementBytes(1024);
+
+  RecordConsumerWaits(knob_1.get(), 32, milliseconds(5));
+  RecordConsumerWaits(knob_2.get(), 32, milliseconds(10));
+  controller.Tune(milliseconds(50));
+  EXPECT_EQ(knob_1->value(), 8);
+  EXPECT_EQ(knob_2->value(), 8);
+
+  // Only 4 KB of the budget are left.
+  RecordConsumerWaits(knob_1.get(), 32, milliseconds(5));
+  RecordConsumerWaits(knob_2.get(), 32, milliseconds(10));
+  controller.Tune(milliseconds(50));
+  EXPECT_EQ(knob_1->value(), 8);
+  EXPECT_EQ(knob_2->value(), 12);
+}
+
+TEST_F(AutotuneTest, AutotunedPrefetchDatasetReturnsAllElements) {
+  auto prefetch = TakeRef(host_.Construct<PrefetchDataset>(
+      MakeRange(100), kAutotune, /*is_deterministic=*/true, &host_));
+  auto iterator = prefetch->MakeIterator(IteratorContext());
+
+  EXPECT_EQ(GetAll(iterator.get()), Range(0, 100));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tfrt
@@ -0,0 +1,295 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit tests for CacheDataset.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "../../lib/data/cache_dataset.h"
+#include "../../lib/data/range_dataset.h"
+#include "../../lib/data/repeat_dataset.h"
+#include "dataset_test_util.h"
+#include "gtest/gtest.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "tfrt/host_context/async_value_ref.h"
+
+namespace tfrt {
+namespace data {
+namespace {
+
+// Returns the range [0, size), and counts the iterators made over it. The
+// iterators made while `fail_iterators` is true return an error in place of
+// the element at `error_index`.
+class CountingRangeDataset : public Dataset {
+ public:
+  CountingRangeDataset(int32_t size, HostContext* host)
+      : range_(TakeRef(
+            host->Construct<RangeDataset>(0, size, 1, DType::I32, host))),
+        host_(host) {}
+
+  RCReference<Iterator> MakeIterator(const IteratorContext& context) override {
+    ++num_iterators_;
+    return TakeRef(host_->Construct<CountingRangeIterator>(
+        range_->MakeIterator(context), fail_iterators_ ? error_index_ : -1,
+        host_->allocator()));
+  }
+
+  void FailIterators(int error_index) {
+    fail_iterators_ = true;
+    error_index_ = error_index;
+  }
+  void StopFailingIterators() { fail_iterators_ = false; }
+
+  int num_iterators() const { return num_iterators_; }
+
+ private:
+  class CountingRangeIterator : public Iterator {
+   public:
+    CountingRangeIterator(RCReference<Iterator> input, int error_index,
+                          HostAllocator* allocator)
+        : input_(std::move(input)),
+          error_index_(error_index),
+          allocator_(allocator) {}
+
+    IterationResult GetNext(const ExecutionContext& exec_ctx) override {
+      auto result = input_->GetNext(exec_ctx);
+      if (index_++ != error_index_) return result;
+      return IterationResult::Error(
+          MakeErrorAsyncValueRef(exec_ctx.host(), "input error"), 1);
+    }
+
+   private:
+    void Destroy() override {
+      internal::DestroyImpl<CountingRangeIterator>(this, allocator_);
+    }
+
+    RCReference<Iterator> input_;
+    const int error_index_;
+    int index_ = 0;
+    HostAllocator* allocator_;
+  };
+
+  void Destroy() override {
+    internal::DestroyImpl<CountingRangeDataset>(this, host_->allocator());
+  }
+
+  RCReference<Dataset> range_;
+  HostContext* host_;
+  int num_iterators_ = 0;
+  bool fail_iterators_ = false;
+  int error_index_ = -1;
+};
+
+class CacheDatasetTest : public DatasetTest<::testing::TestWithParam<bool>> {
+ protected:
+  CacheDatasetTest()
+      : DatasetTest(/*num_threads=*/2),
+        input_(TakeRef(host_.Construct<CountingRangeDataset>(8, &host_))) {}
+
+  void SetUp() override {
+    if (!UseFile()) return;
+    // Parameterized test names contain a '/'.
+    std::string name =
+        ::testing::UnitTest::GetInstance()->current_test_info()->name();
+    std::replace(name.begin(), name.end(), '/', '_');
+    dir_ = ::testing::TempDir() + "/cache_dataset_test_" + name;
+    llvm::sys::fs::remove_directories(dir_);
+    ASSERT_FALSE(llvm::sys::fs::create_directories(dir_));
+  }
+
+  void TearDown() override {
+    if (UseFile()) llvm::sys::fs::remove_directories(dir_);
+  }
+
+  // Whether the elements are cached in a file rather than in memory.
+  bool UseFile() const { return GetParam(); }
+
+  std::string CachePath() const {
+    return UseFile() ? dir_ + "/elements.cache" : "";
+  }
+
+  RCReference<CacheDataset> MakeCache() {
+    return TakeRef(
+        host_.Construct<CacheDataset>(input_.CopyRef(), CachePath(), &host_));
+  }
+
+  // Returns the names of the files in the cache directory.
+  std::vector<std::string> CacheDirFiles() {
+    std::vector<std::string> files;
+    std::error_code error_code;
+    for (llvm::sys::fs::directory_iterator it(dir_, error_code), end;
+         it != end && !error_code; it.increment(error_code)) {
+      files.push_back(llvm::sys::path::filename(it->path()).str());
+    }
+    return files;
+  }
+
+  RCReference<CountingRangeDataset> input_;
+  std::string dir_;
+};
+
+TEST_P(CacheDatasetTest, RepeatReadsInputOnce) {
+  auto repeat =
+      TakeRef(host_.Construct<RepeatDataset>(MakeCache(), 2, &host_));
+  auto values = GetAll(repeat->MakeIterator(IteratorContext()).get());
+
+  auto expected = Range(0, 8);
+  expected.insert(expected.end(), expected.begin(), expected.end());
+  EXPECT_EQ(values, expected);
+  EXPECT_EQ(input_->num_iterators(), 1);
+  if (UseFile()) {
+    host_.Quiesce();
+    EXPECT_EQ(CacheDirFiles(), std::vector<std::string>({"elements.cache"}));
+  }
+}
+
+TEST_P(CacheDatasetTest, ReusesCacheFile) {
+  if (!UseFile()) return;
+  EXPECT_EQ(GetAll(MakeCache()->MakeIterator(IteratorContext()).get()),
+            Range(0, 8));
+  // Another dataset with the same path reads the file. Its first pass checks
+  // the file against the input, and the next one only reads the file.
+  auto cache = MakeCache();
+  EXPECT_EQ(GetAll(cache->MakeIterator(IteratorContext()).get()), Range(0, 8));
+  EXPECT_EQ(input_->num_iterators(), 2);
+  EXPECT_EQ(GetAll(cache->MakeIterator(IteratorContext()).get()), Range(0, 8));
+  EXPECT_EQ(input_->num_iterators(), 2);
+}
+
+TEST_P(CacheDatasetTest, RejectsCacheFileOfOtherInput) {
+  if (!UseFile()) return;
+  EXPECT_EQ(GetAll(MakeCache()->MakeIterator(IteratorContext()).get()),
+            Range(0, 8));
+
+  // Returns the error of the first element of `input` that does not match the
+  // cache file, after checking that the elements before it are `expected`.
+  auto get_mismatch = [&](RCReference<Dataset> input,
+                          std::vector<int32_t> expected) -> std::string {
+    auto cache = TakeRef(
+        host_.Construct<CacheDataset>(std::move(input), CachePath(), &host_));
+    auto iterator = cache->MakeIterator(IteratorContext());
+    for (int32_t value : expected) {
+      auto result = GetNext(iterator.get());
+      if (result.eof.IsError()) return "unexpected error";
+      EXPECT_EQ(result.values[0]->get<int32_t>(), value);
+    }
+    auto result = GetNext(iterator.get());
+    if (!result.eof.IsError()) return "no error";
+    return result.eof.GetError().message;
+  };
+
+  EXPECT_EQ(get_mismatch(MakeRange(5), Range(0, 5)),
+            "cache file " + CachePath() +
+                " does not match the input dataset: the input has 5 "
+                "elements, the file has 8");
+  EXPECT_EQ(get_mismatch(MakeRange(10), Range(0, 8)),
+            "cache file " + CachePath() +
+                " does not match the input dataset: the input has more than 8 "
+                "elements, as many as the file");
+  EXPECT_EQ(get_mismatch(TakeRef(host_.Construct<RangeDataset>(
+                             0, 8, 1, DType::I64, &host_)),
+                         {}),
+            "cache file " + CachePath() +
+                " does not match the input dataset: value 0 of element 0 has a "
+                "different type");
+}
+
+TEST_P(CacheDatasetTest, DestroyedIteratorDoesNotCache) {
+  auto cache = MakeCache();
+  auto iterator = cache->MakeIterator(IteratorContext());
+  GetNext(iterator.get());
+  GetNext(iterator.get());
+  host_.Quiesce();
+  if (UseFile()) {
+    // The elements are written to a temporary file as they are returned.
+    auto files = CacheDirFiles();
+    ASSERT_EQ(files.size(), 1);
+    EXPECT_EQ(files[0].find("elements.cache.tmp-"), 0);
+  }
+  iterator.reset();
+  host_.Quiesce();
+  // The partially written file is removed.
+  if (UseFile()) EXPECT_TRUE(CacheDirFiles().empty());
+
+  // The next iterator writes the cache again.
+  EXPECT_EQ(GetAll(cache->MakeIterator(IteratorContext()).get()),
+            Range(0, 8));
+  EXPECT_EQ(GetAll(cache->MakeIterator(IteratorContext()).get()),
+            Range(0, 8));
+  EXPECT_EQ(input_->num_iterators(), 2);
+}
+
+TEST_P(CacheDatasetTest, InputErrorIsNotCached) {
+  auto cache = MakeCache();
+  input_->FailIterators(/*error_index=*/3);
+  auto expected = Range(0, 8);
+  expected[3] = kError;
+  EXPECT_EQ(GetAll(cache->MakeIterator(IteratorContext()).get()), expected);
+  host_.Quiesce();
+  if (UseFile()) EXPECT_TRUE(CacheDirFiles().empty());
+
+  // The next iterator reads the input again, and caches it.
+  input_->StopFailingIterators();
+  EXPECT_EQ(GetAll(cache->MakeIterator(IteratorContext()).get()),
+            Range(0, 8));
+  EXPECT_EQ(GetAll(cache->MakeIterator(IteratorContext()).get()),
+            Range(0, 8));
+  EXPECT_EQ(input_->num_iterators(), 2);
+}
+
+TEST_P(CacheDatasetTest, TruncatedCacheFile) {
+  if (!UseFile()) return;
+  EXPECT_EQ(GetAll(MakeCache()->MakeIterator(IteratorContext()).get()),
+            Range(0, 8));
+  uint64_t size;
+  ASSERT_FALSE(llvm::sys::fs::file_size(CachePath(), size));
+
+  // Each int32_t value takes 24 bytes. Cut the last one in the middle, then
+  // at its start.
+  for (uint64_t truncated_size : {size - 4, size - 24}) {
+    int fd;
+    ASSERT_FALSE(llvm::sys::fs::openFileForReadWrite(
+        CachePath(), fd, llvm::sys::fs::CD_OpenExisting,
+        llvm::sys::fs::OF_None));
+    ASSERT_FALSE(llvm::sys::fs::resize_file(fd, truncated_size));
+    llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+
+    auto iterator = MakeCache()->MakeIterator(IteratorContext());
+    for (int32_t i = 0; i < 7; ++i) {
+      auto result = GetNext(iterator.get());
+      ASSERT_FALSE(result.eof.IsError());
+      EXPECT_EQ(result.values[0]->get<int32_t>(), i);
+    }
+    auto result = GetNext(iterator.get());
+    ASSERT_TRUE(result.eof.IsError());
+    EXPECT_NE(result.eof.GetError().message.find("corrupted cache file"),
+              std::string::npos);
+    result = GetNext(iterator.get());
+    ASSERT_FALSE(result.eof.IsError());
+    EXPECT_TRUE(result.eof.get());
+  }
+  // Each new dataset checks the file against the input.
+  EXPECT_EQ(input_->num_iterators(), 3);
+}
+
+INSTANTIATE_TEST_SUITE_P(MemoryAndFile, CacheDatasetTest,
+                         ::testing::Values(false, true));
+
+}  // namespace
+}  // namespace data
+}  // namespace tfrt
@@ -0,0 +1,100 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file defines the common fixture of the dataset unit tests.
+#ifndef TFRT_CPP_TESTS_DATA_DATASET_TEST_UTIL_H_
+#define TFRT_CPP_TESTS_DATA_DATASET_TEST_UTIL_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "../../lib/data/range_dataset.h"
+#include "gtest/gtest.h"
+#include "tfrt/data/dataset.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_context.h"
+
+namespace tfrt {
+namespace data {
+
+// The value returned by DatasetTest::GetAll() in place of an error.
+constexpr int32_t kError = -1;
+
+// A test fixture that runs dataset iterators on a multi-threaded work queue.
+// `Base` is the gtest fixture to derive from, e.g. ::testing::TestWithParam<T>
+// for parameterized tests.
+template <typename Base = ::testing::Test>
+class DatasetTest : public Base {
+ protected:
+  explicit DatasetTest(int num_threads = 4)
+      : host_([](const DecodedDiagnostic&) {}, CreateMallocAllocator(),
+              CreateMultiThreadedWorkQueue(num_threads,
+                                           /*num_blocking_threads=*/1)),
+        exec_ctx_(*RequestContextBuilder(&host_, nullptr).build()) {}
+
+  // Returns a dataset of the int32_t range [0, size).
+  RCReference<Dataset> MakeRange(int32_t size) {
+    return TakeRef(
+        host_.Construct<RangeDataset>(0, size, 1, DType::I32, &host_));
+  }
+
+  // Blocks until the values and the eof of `result` are available.
+  void Await(const IterationResult& result) {
+    SmallVector<RCReference<AsyncValue>, 4> values;
+    for (AsyncValue* value : result.AsyncValues())
+      values.push_back(FormRef(value));
+    host_.Await(values);
+  }
+
+  // Returns the next element of `iterator` once it is available.
+  IterationResult GetNext(Iterator* iterator) {
+    IterationResult result = iterator->GetNext(exec_ctx_);
+    Await(result);
+    return result;
+  }
+
+  // Returns the int32_t values of `iterator` until its end, with kError in
+  // place of errors.
+  std::vector<int32_t> GetAll(Iterator* iterator) {
+    std::vector<int32_t> values;
+    while (true) {
+      IterationResult result = GetNext(iterator);
+      if (result.eof.IsError()) {
+        values.push_back(kError);
+        continue;
+      }
+      if (result.eof.get()) return values;
+      values.push_back(result.values[0]->get<int32_t>());
+    }
+  }
+
+  HostContext host_;
+  ExecutionContext exec_ctx_;
+};
+
+// Returns the values [start, stop).
+inline std::vector<int32_t> Range(int32_t start, int32_t stop) {
+  std::vector<int32_t> values;
+  for (int32_t i = start; i < stop; ++i) values.push_back(i);
+  return values;
+}
+
+}  // namespace data
+}  // namespace tfrt
+
+#endif  // TFRT_CPP_TESTS_DATA_DATASET_TEST_UTIL_H_
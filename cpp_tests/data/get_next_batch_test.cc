@@ -0,0 +1,335 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests and benchmarks for Iterator::GetNextBatch().
+
+#include <memory>
+#include <vector>
+
+#include "../../lib/data/batch_dataset.h"
+#include "../../lib/data/filter_dataset.h"
+#include "../../lib/data/map_dataset.h"
+#include "../../lib/data/memory_dataset.h"
+#include "../../lib/data/range_dataset.h"
+#include "../../lib/data/slice_dataset.h"
+#include "benchmark/benchmark.h"
+#include "dataset_test_util.h"
+#include "gtest/gtest.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Parser.h"
+#include "tfrt/basic_kernels/opdefs/tfrt_base.h"
+#include "tfrt/bef/bef_buffer.h"
+#include "tfrt/bef_converter/mlir_to_bef.h"
+#include "tfrt/bef_executor/bef_file.h"
+#include "tfrt/data/dataset.h"
+#include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/function.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/host_context/kernel_registry.h"
+#include "tfrt/tensor/dense_host_tensor_view.h"
+
+namespace tfrt {
+namespace data {
+namespace {
+
+constexpr const char* kFunctions = R"mlir(
+func @add_one(%x: i32) -> i32 {
+  %one = tfrt.constant.i32 1
+  %y = tfrt.add.i32 %x, %one
+  tfrt.return %y : i32
+}
+
+func @is_even(%x: i32) -> i1 {
+  %zero = tfrt.constant.i32 0
+  %two = tfrt.constant.i32 2
+  %quotient, %remainder = tfrt.div.i32 %x, %two
+  %even = tfrt.equal.i32 %remainder, %zero
+  tfrt.return %even : i1
+}
+)mlir";
+
+// Loads the BEF file with the map and filter functions.
+class GetNextBatchTest : public DatasetTest<> {
+ protected:
+  GetNextBatchTest() {
+    RegisterStaticKernels(host_.GetMutableRegistry());
+
+    mlir::MLIRContext context;
+    mlir::DialectRegistry registry;
+    registry.insert<compiler::TFRTDialect>();
+    context.appendDialectRegistry(registry);
+    mlir::OwningModuleRef module =
+        mlir::parseSourceString(kFunctions, &context);
+    bef_buffer_ =
+        ConvertMLIRToBEF(module.get(), /*disable_optional_sections=*/true);
+    bef_file_ = BEFFile::Open(bef_buffer_, host_.GetKernelRegistry(),
+                              host_.diag_handler(), host_.allocator());
+  }
+
+  // Returns range(0, size) -> map(add_one).
+  RCReference<Dataset> MakeRangeMapDataset(int32_t size) {
+    return TakeRef(host_.Construct<MapDataset>(
+        MakeRange(size), RCArray<AsyncValue>(ArrayRef<AsyncValue*>()),
+        FormRef(bef_file_->GetFunction("add_one")),
+        /*num_parallel_calls=*/1, /*is_deterministic=*/true, &host_));
+  }
+
+  // Returns range(0, size) -> filter(is_even).
+  RCReference<Dataset> MakeRangeFilterDataset(int32_t size) {
+    return TakeRef(host_.Construct<FilterDataset>(
+        MakeRange(size), FormRef(bef_file_->GetFunction("is_even")), &host_));
+  }
+
+  // Returns the value of an element with a single int32_t component, or -1 at
+  // the end of the iterator.
+  int32_t GetValue(const IterationResult& result) {
+    Await(result);
+    if (result.eof.get()) return -1;
+    return result.values[0]->get<int32_t>();
+  }
+
+  // Returns the values of `results`, or -1 for the end of the iterator.
+  std::vector<int32_t> GetValues(ArrayRef<IterationResult> results) {
+    std::vector<int32_t> values;
+    for (const auto& result : results) values.push_back(GetValue(result));
+    return values;
+  }
+
+  BefBuffer bef_buffer_;
+  RCReference<BEFFile> bef_file_;
+};
+
+TEST_F(GetNextBatchTest, RangeDataset) {
+  auto dataset = TakeRef(host_.Construct<RangeDataset>(
+      0, 10, 3, DType::I32, &host_));
+  auto iterator = dataset->MakeIterator(IteratorContext());
+
+  SmallVector<IterationResult, 4> results;
+  iterator->GetNextBatch(exec_ctx_, 3, &results);
+  iterator->GetNextBatch(exec_ctx_, 3, &results);
+  ASSERT_EQ(results.size(), 6);
+  std::vector<int32_t> values;
+  for (const auto& result : results) values.push_back(GetValue(result));
+  EXPECT_EQ(values, std::vector<int32_t>({0, 3, 6, 9, -1, -1}));
+}
+
+TEST_F(GetNextBatchTest, SliceDataset) {
+  auto dataset = TakeRef(host_.Construct<SliceDataset<int32_t>>(
+      std::vector<int32_t>{4, 5, 6}, &host_));
+  auto iterator = dataset->MakeIterator(IteratorContext());
+
+  SmallVector<IterationResult, 4> results;
+  iterator->GetNextBatch(exec_ctx_, 4, &results);
+  ASSERT_EQ(results.size(), 4);
+  std::vector<int32_t> values;
+  for (const auto& result : results) values.push_back(GetValue(result));
+  EXPECT_EQ(values, std::vector<int32_t>({4, 5, 6, -1}));
+}
+
+TEST_F(GetNextBatchTest, MapDatasetMatchesGetNext) {
+  auto batched = MakeRangeMapDataset(5)->MakeIterator(IteratorContext());
+  auto unbatched = MakeRangeMapDataset(5)->MakeIterator(IteratorContext());
+
+  SmallVector<IterationResult, 4> results;
+  batched->GetNextBatch(exec_ctx_, 7, &results);
+  ASSERT_EQ(results.size(), 7);
+  for (const auto& result : results) {
+    auto expected = unbatched->GetNext(exec_ctx_);
+    EXPECT_EQ(GetValue(result), GetValue(expected));
+  }
+}
+
+TEST_F(GetNextBatchTest, MemoryDataset) {
+  auto dataset = TakeRef(
+      host_.Construct<MemoryDataset<int32_t>>(MakeRange(5), &host_));
+  auto iterator = dataset->MakeIterator(IteratorContext());
+
+  // Fills the buffer from the input iterator.
+  SmallVector<IterationResult, 4> results;
+  iterator->GetNextBatch(exec_ctx_, 3, &results);
+  EXPECT_EQ(GetValues(results), std::vector<int32_t>({0, 1, 2}));
+
+  // The input iterator reaches its end in the middle of the batch, and the
+  // rest of the batch is replayed from the buffer.
+  results.clear();
+  iterator->GetNextBatch(exec_ctx_, 5, &results);
+  EXPECT_EQ(GetValues(results), std::vector<int32_t>({3, 4, 0, 1, 2}));
+
+  // Replays the buffer, wrapping around its end.
+  results.clear();
+  iterator->GetNextBatch(exec_ctx_, 7, &results);
+  EXPECT_EQ(GetValues(results),
+            std::vector<int32_t>({3, 4, 0, 1, 2, 3, 4}));
+}
+
+TEST_F(GetNextBatchTest, MemoryDatasetMatchesGetNext) {
+  auto make_iterator = [&]() {
+    auto dataset = TakeRef(
+        host_.Construct<MemoryDataset<int32_t>>(MakeRange(4), &host_));
+    return dataset->MakeIterator(IteratorContext());
+  };
+  auto batched = make_iterator();
+  auto unbatched = make_iterator();
+
+  for (size_t count : {1, 3, 2, 6, 5}) {
+    SmallVector<IterationResult, 8> results;
+    batched->GetNextBatch(exec_ctx_, count, &results);
+    ASSERT_EQ(results.size(), count);
+    for (const auto& result : results) {
+      auto expected = unbatched->GetNext(exec_ctx_);
+      EXPECT_EQ(GetValue(result), GetValue(expected));
+    }
+  }
+}
+
+TEST_F(GetNextBatchTest, EmptyMemoryDataset) {
+  auto dataset = TakeRef(
+      host_.Construct<MemoryDataset<int32_t>>(MakeRange(0), &host_));
+  auto iterator = dataset->MakeIterator(IteratorContext());
+
+  SmallVector<IterationResult, 4> results;
+  iterator->GetNextBatch(exec_ctx_, 3, &results);
+  EXPECT_EQ(GetValues(results),
+            std::vector<int32_t>({-1, -1, -1}));
+}
+
+TEST_F(GetNextBatchTest, FilterDataset) {
+  auto iterator =
+      MakeRangeFilterDataset(9)->MakeIterator(IteratorContext());
+
+  SmallVector<IterationResult, 4> results;
+  iterator->GetNextBatch(exec_ctx_, 2, &results);
+  iterator->GetNextBatch(exec_ctx_, 5, &results);
+  EXPECT_EQ(GetValues(results),
+            std::vector<int32_t>({0, 2, 4, 6, 8, -1, -1}));
+}
+
+TEST_F(GetNextBatchTest, FilterDatasetMatchesGetNext) {
+  auto batched =
+      MakeRangeFilterDataset(20)->MakeIterator(IteratorContext());
+  auto unbatched =
+      MakeRangeFilterDataset(20)->MakeIterator(IteratorContext());
+
+  for (size_t count : {3, 1, 4, 8}) {
+    SmallVector<IterationResult, 8> results;
+    batched->GetNextBatch(exec_ctx_, count, &results);
+    ASSERT_EQ(results.size(), count);
+    for (const auto& result : results) {
+      auto expected = unbatched->GetNext(exec_ctx_);
+      EXPECT_EQ(GetValue(result), GetValue(expected));
+    }
+  }
+}
+
+TEST_F(GetNextBatchTest, BatchDataset) {
+  auto dataset = TakeRef(host_.Construct<BatchDataset<int32_t>>(
+      MakeRangeMapDataset(6), /*batch_size=*/4,
+      /*same_input_metadata=*/true, &host_));
+  auto iterator = dataset->MakeIterator(IteratorContext());
+
+  std::vector<std::vector<int32_t>> batches;
+  while (true) {
+    auto result = iterator->GetNext(exec_ctx_);
+    Await(result);
+    if (result.eof.get()) break;
+    DHTArrayView<int32_t> view(&result.values[0]->get<DenseHostTensor>());
+    batches.emplace_back(view.begin(), view.end());
+  }
+  EXPECT_EQ(batches, std::vector<std::vector<int32_t>>({{1, 2, 3, 4}, {5, 6}}));
+}
+
+// Hides the GetNextBatch() implementation of the input iterator, so that its
+// elements are fetched one by one.
+class PerElementDataset : public Dataset {
+ public:
+  PerElementDataset(RCReference<Dataset> input, HostContext* host)
+      : input_(std::move(input)), host_(host) {}
+
+  RCReference<Iterator> MakeIterator(const IteratorContext& context) override {
+    return TakeRef(host_->Construct<PerElementIterator>(
+        input_->MakeIterator(context), host_->allocator()));
+  }
+
+ private:
+  class PerElementIterator : public Iterator {
+   public:
+    PerElementIterator(RCReference<Iterator> input, HostAllocator* allocator)
+        : input_(std::move(input)), allocator_(allocator) {}
+
+    IterationResult GetNext(const ExecutionContext& exec_ctx) override {
+      return input_->GetNext(exec_ctx);
+    }
+
+   private:
+    void Destroy() override {
+      internal::DestroyImpl<PerElementIterator>(this, allocator_);
+    }
+
+    RCReference<Iterator> input_;
+    HostAllocator* allocator_;
+  };
+
+  void Destroy() override {
+    internal::DestroyImpl<PerElementDataset>(this, host_->allocator());
+  }
+
+  RCReference<Dataset> input_;
+  HostContext* host_;
+};
+
+// Runs the benchmarks with the fixture of the tests.
+class GetNextBatchBenchmark : public GetNextBatchTest {
+ public:
+  // Iterates over range -> map(add_one) -> batch, with the map iterator called
+  // either once per element or once per batch.
+  void RangeMapBatch(benchmark::State& state, bool per_element) {
+    constexpr int32_t kBatchSize = 32;
+    constexpr int32_t kNumElements = 64 * kBatchSize;
+
+    RCReference<Dataset> input = MakeRangeMapDataset(kNumElements);
+    if (per_element)
+      input = TakeRef(
+          host_.Construct<PerElementDataset>(std::move(input), &host_));
+    auto dataset = TakeRef(host_.Construct<BatchDataset<int32_t>>(
+        std::move(input), kBatchSize, /*same_input_metadata=*/true, &host_));
+
+    for (auto _ : state) {
+      auto iterator = dataset->MakeIterator(IteratorContext());
+      for (int32_t i = 0; i < kNumElements / kBatchSize; ++i)
+        Await(iterator->GetNext(exec_ctx_));
+    }
+
+    state.SetItemsProcessed(kNumElements * state.iterations());
+  }
+
+ private:
+  void TestBody() override {}
+};
+
+void BM_RangeMapBatchPerElement(benchmark::State& state) {
+  GetNextBatchBenchmark().RangeMapBatch(state, /*per_element=*/true);
+}
+BENCHMARK(BM_RangeMapBatchPerElement);
+
+void BM_RangeMapBatchBatched(benchmark::State& state) {
+  GetNextBatchBenchmark().RangeMapBatch(state, /*per_element=*/false);
+}
+BENCHMARK(BM_RangeMapBatchBatched);
+
+}  // namespace
+}  // namespace data
+}  // namespace tfrt
@@ -0,0 +1,233 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit tests for the parallel iterator of InterleaveDataset.
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../../lib/data/interleave_dataset.h"
+#include "../../lib/data/range_dataset.h"
+#include "dataset_test_util.h"
+#include "gtest/gtest.h"
+#include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/function.h"
+#include "tfrt/host_context/kernel_registry.h"
+
+namespace tfrt {
+namespace data {
+namespace {
+
+// A function that maps an int32_t `x` to a dataset of the `x % 3 + 1` values
+// starting at `x * 10`. The dataset of `slow_input` only becomes available
+// after `delay`, and the function fails for `error_input`.
+class RangeFunction : public Function {
+ public:
+  RangeFunction(HostContext* host, int32_t slow_input = -1,
+                std::chrono::milliseconds delay = std::chrono::milliseconds(0),
+                int32_t error_input = -1)
+      : Function("range", FunctionKind::kNativeFunction,
+                 {host->GetKernelRegistry().GetType("i32")},
+                 {host->GetKernelRegistry().GetType("!tfrt_data.dataset")}),
+        host_(host),
+        slow_input_(slow_input),
+        delay_(delay),
+        error_input_(error_input) {}
+
+  // Waits for the tasks that may still hold references to this function.
+  ~RangeFunction() override { host_->Quiesce(); }
+
+  void Execute(const ExecutionContext& exec_ctx,
+               ArrayRef<AsyncValue*> arguments,
+               MutableArrayRef<RCReference<AsyncValue>> results) const final {
+    HostContext* host = exec_ctx.host();
+    // The function is also called on the error values past the end of the
+    // input.
+    if (arguments[0]->IsError()) {
+      results[0] = FormRef(arguments[0]);
+      return;
+    }
+    int32_t value = arguments[0]->get<int32_t>();
+    if (value == error_input_) {
+      results[0] = MakeErrorAsyncValueRef(host, "range function failed");
+      return;
+    }
+    RCReference<Dataset> dataset = TakeRef(host->Construct<RangeDataset>(
+        value * 10, value * 10 + value % 3 + 1, 1, DType::I32, host));
+    if (value != slow_input_) {
+      results[0] = MakeAvailableAsyncValueRef<RCReference<Dataset>>(
+          host, std::move(dataset));
+      return;
+    }
+    auto result = MakeUnconstructedAsyncValueRef<RCReference<Dataset>>(host);
+    results[0] = result.CopyRCRef();
+    EnqueueWork(exec_ctx, [delay = delay_, result = std::move(result),
+                           dataset = std::move(dataset)]() mutable {
+      std::this_thread::sleep_for(delay);
+      result.emplace(std::move(dataset));
+    });
+  }
+
+  void AddRef() const final {}
+  void DropRef() const final {}
+
+ private:
+  HostContext* const host_;
+  const int32_t slow_input_;
+  const std::chrono::milliseconds delay_;
+  const int32_t error_input_;
+};
+
+class ParallelInterleaveDatasetTest : public DatasetTest<> {
+ protected:
+  // Returns an iterator of the sequential InterleaveDataset over the range
+  // [0, size).
+  RCReference<Iterator> MakeSequentialIterator(const Function* fn, int32_t size,
+                                               int64_t cycle_length,
+                                               int64_t block_length) {
+    auto interleave = TakeRef(host_.Construct<InterleaveDataset>(
+        MakeRange(size), cycle_length, block_length, FormRef(fn),
+        /*arity=*/1, &host_));
+    return interleave->MakeIterator(IteratorContext());
+  }
+
+  // Returns an iterator of the parallel InterleaveDataset over the range
+  // [0, size).
+  RCReference<Iterator> MakeParallelIterator(
+      const Function* fn, int32_t size, int64_t cycle_length,
+      int64_t block_length, int64_t prefetch_input_elements,
+      bool is_deterministic) {
+    auto interleave = TakeRef(host_.Construct<InterleaveDataset>(
+        MakeRange(size), cycle_length, block_length,
+        /*buffer_output_elements=*/2, prefetch_input_elements,
+        is_deterministic, FormRef(fn), /*arity=*/1, &host_));
+    return interleave->MakeIterator(IteratorContext());
+  }
+};
+
+// Returns the values of RangeFunction for the inputs [0, size).
+std::vector<int32_t> AllValues(int32_t size) {
+  std::vector<int32_t> values;
+  for (int32_t i = 0; i < size; ++i) {
+    for (int32_t j = 0; j < i % 3 + 1; ++j) values.push_back(i * 10 + j);
+  }
+  return values;
+}
+
+TEST_F(ParallelInterleaveDatasetTest, DeterministicOrderMatchesSequential) {
+  RangeFunction fn(&host_);
+  for (int64_t block_length : {1, 2, 3}) {
+    auto expected = GetAll(
+        MakeSequentialIterator(&fn, 16, /*cycle_length=*/3, block_length)
+            .get());
+    auto iterator = MakeParallelIterator(&fn, 16, /*cycle_length=*/3,
+                                         block_length,
+                                         /*prefetch_input_elements=*/2,
+                                         /*is_deterministic=*/true);
+    EXPECT_EQ(GetAll(iterator.get()), expected)
+        << "block_length=" << block_length;
+  }
+}
+
+TEST_F(ParallelInterleaveDatasetTest, DeterministicOrderWithSlowElement) {
+  // The first element becomes available last, but its values still come
+  // first.
+  RangeFunction fn(&host_, /*slow_input=*/0, std::chrono::milliseconds(50));
+  auto expected = GetAll(
+      MakeSequentialIterator(&fn, 16, /*cycle_length=*/2, /*block_length=*/2)
+          .get());
+  auto iterator = MakeParallelIterator(&fn, 16, /*cycle_length=*/2,
+                                       /*block_length=*/2,
+                                       /*prefetch_input_elements=*/2,
+                                       /*is_deterministic=*/true);
+  EXPECT_EQ(GetAll(iterator.get()), expected);
+}
+
+TEST_F(ParallelInterleaveDatasetTest, NonDeterministicReturnsEachValueOnce) {
+  RangeFunction fn(&host_);
+  auto iterator = MakeParallelIterator(&fn, 32, /*cycle_length=*/4,
+                                       /*block_length=*/2,
+                                       /*prefetch_input_elements=*/2,
+                                       /*is_deterministic=*/false);
+  auto values = GetAll(iterator.get());
+  std::sort(values.begin(), values.end());
+  EXPECT_EQ(values, AllValues(32));
+}
+
+TEST_F(ParallelInterleaveDatasetTest, SlowElementDoesNotStallOthers) {
+  // The values of the other elements in the cycle are returned while the
+  // first element is not available.
+  RangeFunction fn(&host_, /*slow_input=*/0, std::chrono::milliseconds(200));
+  auto iterator = MakeParallelIterator(&fn, 8, /*cycle_length=*/2,
+                                       /*block_length=*/1,
+                                       /*prefetch_input_elements=*/1,
+                                       /*is_deterministic=*/false);
+  auto values = GetAll(iterator.get());
+  ASSERT_FALSE(values.empty());
+  EXPECT_NE(values.front(), 0);
+  EXPECT_EQ(values.back(), 0);
+  std::sort(values.begin(), values.end());
+  EXPECT_EQ(values, AllValues(8));
+}
+
+TEST_F(ParallelInterleaveDatasetTest, PropagatesFunctionError) {
+  RangeFunction fn(&host_, /*slow_input=*/-1, std::chrono::milliseconds(0),
+                   /*error_input=*/2);
+  auto expected = AllValues(8);
+  expected.erase(std::remove_if(expected.begin(), expected.end(),
+                                [](int32_t value) { return value / 10 == 2; }),
+                 expected.end());
+  expected.insert(expected.begin(), kError);
+
+  for (bool is_deterministic : {true, false}) {
+    auto iterator = MakeParallelIterator(&fn, 8, /*cycle_length=*/2,
+                                         /*block_length=*/1,
+                                         /*prefetch_input_elements=*/2,
+                                         is_deterministic);
+    // The error is returned once in place of the values of its element, and
+    // the values of the other elements follow.
+    auto values = GetAll(iterator.get());
+    std::sort(values.begin(), values.end());
+    EXPECT_EQ(values, expected) << "is_deterministic=" << is_deterministic;
+  }
+}
+
+TEST_F(ParallelInterleaveDatasetTest, AutotunePrefetchInputElements) {
+  RangeFunction fn(&host_);
+  auto expected = GetAll(
+      MakeSequentialIterator(&fn, 32, /*cycle_length=*/2, /*block_length=*/2)
+          .get());
+  auto iterator = MakeParallelIterator(&fn, 32, /*cycle_length=*/2,
+                                       /*block_length=*/2,
+                                       /*prefetch_input_elements=*/kAutotune,
+                                       /*is_deterministic=*/true);
+  EXPECT_EQ(GetAll(iterator.get()), expected);
+}
+
+TEST_F(ParallelInterleaveDatasetTest, EmptyInput) {
+  RangeFunction fn(&host_);
+  auto iterator = MakeParallelIterator(&fn, 0, /*cycle_length=*/2,
+                                       /*block_length=*/1,
+                                       /*prefetch_input_elements=*/2,
+                                       /*is_deterministic=*/false);
+  EXPECT_TRUE(GetAll(iterator.get()).empty());
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tfrt
@@ -0,0 +1,202 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit tests for the parallel iterators of MapDataset.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../../lib/data/map_dataset.h"
+#include "dataset_test_util.h"
+#include "gtest/gtest.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/function.h"
+#include "tfrt/host_context/kernel_registry.h"
+#include "tfrt/host_context/timer_queue.h"
+
+namespace tfrt {
+namespace data {
+namespace {
+
+// A function that adds one to an int32_t after sleeping for `delay`. Element
+// 0 sleeps for `first_delay` instead. Records the largest number of
+// concurrent invocations.
+class AddOneFunction : public Function {
+ public:
+  AddOneFunction(HostContext* host, std::chrono::milliseconds delay,
+                 std::chrono::milliseconds first_delay)
+      : Function("add_one", FunctionKind::kNativeFunction,
+                 {host->GetKernelRegistry().GetType("i32")},
+                 {host->GetKernelRegistry().GetType("i32")}),
+        host_(host),
+        delay_(delay),
+        first_delay_(first_delay) {}
+
+  // Waits for the tasks that may still hold references to this function.
+  ~AddOneFunction() override { host_->Quiesce(); }
+
+  void Execute(const ExecutionContext& exec_ctx,
+               ArrayRef<AsyncValue*> arguments,
+               MutableArrayRef<RCReference<AsyncValue>> results) const final {
+    int in_flight = in_flight_.fetch_add(1) + 1;
+    int max_in_flight = max_in_flight_.load();
+    while (in_flight > max_in_flight &&
+           !max_in_flight_.compare_exchange_weak(max_in_flight, in_flight)) {
+    }
+
+    int32_t value = arguments[0]->get<int32_t>();
+    std::this_thread::sleep_for(value == 0 ? first_delay_ : delay_);
+    results[0] =
+        MakeAvailableAsyncValueRef<int32_t>(exec_ctx.host(), value + 1);
+    in_flight_.fetch_sub(1);
+  }
+
+  void AddRef() const final {}
+  void DropRef() const final {}
+
+  int max_in_flight() const { return max_in_flight_.load(); }
+
+ private:
+  HostContext* const host_;
+  const std::chrono::milliseconds delay_;
+  const std::chrono::milliseconds first_delay_;
+  mutable std::atomic<int> in_flight_{0};
+  mutable std::atomic<int> max_in_flight_{0};
+};
+
+// A function that adds one to an int32_t `delay` after it is called. The result
+// is computed by the timer thread, so the invocations do not occupy the worker
+// threads. Records the largest number of concurrent invocations.
+class TimerAddOneFunction : public Function {
+ public:
+  TimerAddOneFunction(HostContext* host, std::chrono::milliseconds delay)
+      : Function("timer_add_one", FunctionKind::kNativeFunction,
+                 {host->GetKernelRegistry().GetType("i32")},
+                 {host->GetKernelRegistry().GetType("i32")}),
+        host_(host),
+        delay_(delay) {}
+
+  // Waits for the tasks that may still hold references to this function.
+  ~TimerAddOneFunction() override { host_->Quiesce(); }
+
+  void Execute(const ExecutionContext& exec_ctx,
+               ArrayRef<AsyncValue*> arguments,
+               MutableArrayRef<RCReference<AsyncValue>> results) const final {
+    int in_flight = in_flight_.fetch_add(1) + 1;
+    int max_in_flight = max_in_flight_.load();
+    while (in_flight > max_in_flight &&
+           !max_in_flight_.compare_exchange_weak(max_in_flight, in_flight)) {
+    }
+
+    auto result = MakeUnconstructedAsyncValueRef<int32_t>(exec_ctx.host());
+    results[0] = result.CopyRCRef();
+    exec_ctx.host()->GetTimerQueue()->ScheduleTimer(
+        delay_, [this, result = std::move(result),
+                 value = arguments[0]->get<int32_t>()]() {
+          in_flight_.fetch_sub(1);
+          result.emplace(value + 1);
+        });
+  }
+
+  void AddRef() const final {}
+  void DropRef() const final {}
+
+  int max_in_flight() const { return max_in_flight_.load(); }
+
+ private:
+  HostContext* const host_;
+  const std::chrono::milliseconds delay_;
+  mutable std::atomic<int> in_flight_{0};
+  mutable std::atomic<int> max_in_flight_{0};
+};
+
+class ParallelMapDatasetTest : public DatasetTest<> {
+ protected:
+  RCReference<Iterator> MakeIterator(const Function* map_fn, int32_t size,
+                                     int64_t num_parallel_calls,
+                                     bool is_deterministic) {
+    auto map = TakeRef(host_.Construct<MapDataset>(
+        MakeRange(size), RCArray<AsyncValue>(ArrayRef<AsyncValue*>()),
+        FormRef(map_fn), num_parallel_calls, is_deterministic, &host_));
+    return map->MakeIterator(IteratorContext());
+  }
+};
+
+TEST_F(ParallelMapDatasetTest, DeterministicOrder) {
+  // The first element finishes last, but is still returned first.
+  AddOneFunction map_fn(&host_, std::chrono::milliseconds(1),
+                        std::chrono::milliseconds(20));
+  auto iterator = MakeIterator(&map_fn, 32, /*num_parallel_calls=*/4,
+                               /*is_deterministic=*/true);
+  EXPECT_EQ(GetAll(iterator.get()), Range(1, 33));
+}
+
+TEST_F(ParallelMapDatasetTest, BoundsInFlightCalls) {
+  // The calls sleep long enough for the next ones to start on other workers.
+  AddOneFunction map_fn(&host_, std::chrono::milliseconds(5),
+                        std::chrono::milliseconds(5));
+  auto iterator = MakeIterator(&map_fn, 32, /*num_parallel_calls=*/3,
+                               /*is_deterministic=*/true);
+  EXPECT_EQ(GetAll(iterator.get()), Range(1, 33));
+  EXPECT_GT(map_fn.max_in_flight(), 1);
+  EXPECT_LE(map_fn.max_in_flight(), 3);
+}
+
+TEST_F(ParallelMapDatasetTest, NonDeterministicBoundsInFlightCalls) {
+  AddOneFunction map_fn(&host_, std::chrono::milliseconds(2),
+                        std::chrono::milliseconds(2));
+  auto iterator = MakeIterator(&map_fn, 32, /*num_parallel_calls=*/2,
+                               /*is_deterministic=*/false);
+  auto values = GetAll(iterator.get());
+  EXPECT_EQ(values.size(), 32);
+  EXPECT_LE(map_fn.max_in_flight(), 2);
+}
+
+TEST_F(ParallelMapDatasetTest, NonDeterministicReturnsEachElementOnce) {
+  // The slow first element lets the later elements overtake it.
+  AddOneFunction map_fn(&host_, std::chrono::milliseconds(1),
+                        std::chrono::milliseconds(20));
+  auto iterator = MakeIterator(&map_fn, 64, /*num_parallel_calls=*/4,
+                               /*is_deterministic=*/false);
+  auto values = GetAll(iterator.get());
+  std::sort(values.begin(), values.end());
+  EXPECT_EQ(values, Range(1, 65));
+}
+
+TEST_F(ParallelMapDatasetTest, AutotuneGrowsStarvedParallelism) {
+  // The consumer always waits for the slow calls, so the autotuned number of
+  // calls in flight grows past its initial value, the number of workers.
+  TimerAddOneFunction map_fn(&host_, std::chrono::milliseconds(2));
+  auto iterator = MakeIterator(&map_fn, 1000, kAutotune,
+                               /*is_deterministic=*/true);
+  EXPECT_EQ(GetAll(iterator.get()), Range(1, 1001));
+  EXPECT_GT(map_fn.max_in_flight(), host_.GetNumWorkerThreads());
+}
+
+TEST_F(ParallelMapDatasetTest, EmptyInput) {
+  AddOneFunction map_fn(&host_, std::chrono::milliseconds(0),
+                        std::chrono::milliseconds(0));
+  auto iterator = MakeIterator(&map_fn, 0, /*num_parallel_calls=*/4,
+                               /*is_deterministic=*/true);
+  EXPECT_TRUE(GetAll(iterator.get()).empty());
+  EXPECT_EQ(map_fn.max_in_flight(), 0);
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tfrt
@@ -0,0 +1,72 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Multi-threaded benchmark of HostAllocator implementations for the small
+// allocations made on the BEF executor hot path.
+
+#include <cstddef>
+#include <memory>
+
+#include "benchmark/benchmark.h"
+#include "tfrt/host_context/host_allocator.h"
+
+namespace tfrt {
+namespace {
+
+// Allocation sizes in the range of AsyncValue, Chain and KernelFrame payloads.
+constexpr size_t kSizes[] = {16, 40, 64, 72, 96, 128, 200, 256};
+constexpr int kNumSizes = sizeof(kSizes) / sizeof(kSizes[0]);
+
+// Number of allocations each thread keeps alive between iterations, so that
+// frees do not always immediately follow their allocation.
+constexpr int kLiveAllocations = 64;
+
+template <std::unique_ptr<HostAllocator> (*create_allocator)()>
+void BM_AllocateDeallocate(benchmark::State& state) {
+  // The allocator is shared by all benchmark threads and all runs. It is never
+  // destroyed, as threads might still be running when another one returns.
+  static HostAllocator* allocator = create_allocator().release();
+
+  void* live[kLiveAllocations] = {};
+  size_t live_size[kLiveAllocations] = {};
+  int i = 0;
+  for (auto _ : state) {
+    int slot = i % kLiveAllocations;
+    if (live[slot]) allocator->DeallocateBytes(live[slot], live_size[slot]);
+    live_size[slot] = kSizes[i % kNumSizes];
+    live[slot] =
+        allocator->AllocateBytes(live_size[slot], alignof(std::max_align_t));
+    benchmark::DoNotOptimize(live[slot]);
+    ++i;
+  }
+
+  for (int slot = 0; slot < kLiveAllocations; ++slot) {
+    if (live[slot]) allocator->DeallocateBytes(live[slot], live_size[slot]);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+std::unique_ptr<HostAllocator> CreateDefaultThreadCachingAllocator() {
+  return CreateThreadCachingAllocator();
+}
+
+BENCHMARK_TEMPLATE(BM_AllocateDeallocate, CreateMallocAllocator)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_AllocateDeallocate, CreateDefaultThreadCachingAllocator)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace tfrt
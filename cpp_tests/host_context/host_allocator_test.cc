@@ -18,7 +18,11 @@
 
 #include "tfrt/host_context/host_allocator.h"
 
+#include <atomic>
 #include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -53,6 +57,133 @@ TEST_F(HostAllocatorTest, AllocateDeallocate) {
   allocator_->Deallocate<uint64_t>(entries, kTestAllocateEntryCount);
 }
 
+TEST(ThreadCachingAllocatorTest, AllocateDeallocateBytesWithAlignment) {
+  auto allocator = CreateThreadCachingAllocator();
+  for (size_t size : {1, 16, 40, 72, 200, 512, 4096}) {
+    for (size_t alignment : {1, 8, 16, 32, 64, 128, 256, 512}) {
+      void* buffer = allocator->AllocateBytes(size, alignment);
+      ASSERT_NE(nullptr, buffer);
+      EXPECT_EQ(reinterpret_cast<std::uintptr_t>(buffer) % alignment, 0);
+      memset(buffer, 0, size);
+      allocator->DeallocateBytes(buffer, size);
+    }
+  }
+}
+
+TEST(ThreadCachingAllocatorTest, CrossThreadDeallocate) {
+  auto allocator = CreateThreadCachingAllocator();
+
+  constexpr int kNumEntries = 10000;
+  std::vector<int64_t*> entries(kNumEntries);
+  std::thread producer([&] {
+    for (int i = 0; i < kNumEntries; ++i) {
+      entries[i] = allocator->Allocate<int64_t>();
+      *entries[i] = i;
+    }
+  });
+  producer.join();
+
+  std::thread consumer([&] {
+    for (int i = 0; i < kNumEntries; ++i) {
+      EXPECT_EQ(*entries[i], i);
+      allocator->Deallocate(entries[i]);
+    }
+  });
+  consumer.join();
+}
+
+// Counts the bytes allocated and not deallocated yet.
+class CountingAllocator : public HostAllocator {
+ public:
+  explicit CountingAllocator(std::atomic<int64_t>* bytes_in_use)
+      : bytes_in_use_(bytes_in_use) {}
+
+  void* AllocateBytes(size_t size, size_t alignment) override {
+    *bytes_in_use_ += size;
+    return allocator_->AllocateBytes(size, alignment);
+  }
+
+  void DeallocateBytes(void* ptr, size_t size) override {
+    *bytes_in_use_ -= size;
+    allocator_->DeallocateBytes(ptr, size);
+  }
+
+ private:
+  std::unique_ptr<HostAllocator> allocator_{CreateMallocAllocator()};
+  std::atomic<int64_t>* bytes_in_use_;
+};
+
+TEST(ThreadCachingAllocatorTest, ThreadExitReleasesSlabs) {
+  std::atomic<int64_t> bytes_in_use{0};
+  auto allocator = CreateThreadCachingAllocator(
+      std::make_unique<CountingAllocator>(&bytes_in_use));
+
+  constexpr int kNumEntries = 100000;
+  std::vector<int64_t*> entries(kNumEntries);
+  std::thread([&] {
+    for (auto& entry : entries) entry = allocator->Allocate<int64_t>();
+  }).join();
+  EXPECT_GT(bytes_in_use.load(), kNumEntries * sizeof(int64_t));
+
+  std::thread([&] {
+    for (auto* entry : entries) allocator->Deallocate(entry);
+  }).join();
+  // Only the slab that is being carved is kept.
+  EXPECT_LE(bytes_in_use.load(), 64 * 1024);
+}
+
+class ArenaAllocatorTest : public ::testing::Test {
+ protected:
+  std::unique_ptr<HostAllocator> allocator_{CreateMallocAllocator()};
+  ArenaAllocator arena_{allocator_.get(), /*block_size=*/4096};
+};
+
+TEST_F(ArenaAllocatorTest, AllocateDeallocateBytesWithAlignment) {
+  for (size_t alignment : {1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024}) {
+    void* buffer = arena_.AllocateBytes(24, alignment);
+    ASSERT_NE(nullptr, buffer);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(buffer) % alignment, 0);
+    memset(buffer, 0, 24);
+    arena_.DeallocateBytes(buffer, 24);
+  }
+}
+
+TEST_F(ArenaAllocatorTest, ReuseFreedChunks) {
+  void* first = arena_.AllocateBytes(40, 8);
+  arena_.DeallocateBytes(first, 40);
+
+  // 40 and 48 bytes are in the same size class.
+  void* second = arena_.AllocateBytes(48, 8);
+  EXPECT_EQ(first, second);
+
+  auto stats = arena_.GetStats();
+  EXPECT_EQ(stats.num_allocations, 2);
+  EXPECT_EQ(stats.bytes_allocated, 88);
+  EXPECT_EQ(stats.num_reused_allocations, 1);
+  EXPECT_EQ(stats.bytes_reserved, 4096);
+}
+
+TEST_F(ArenaAllocatorTest, LargeAllocation) {
+  uint64_t* entries = arena_.Allocate<uint64_t>(1024);
+  for (int idx = 0; idx < 1024; ++idx) entries[idx] = idx;
+  EXPECT_EQ(arena_.GetStats().bytes_reserved, 1024 * sizeof(uint64_t));
+
+  // Large allocations are returned to the underlying allocator right away.
+  arena_.Deallocate<uint64_t>(entries, 1024);
+  auto stats = arena_.GetStats();
+  EXPECT_EQ(stats.bytes_reserved, 0);
+  EXPECT_EQ(stats.peak_bytes_reserved, 1024 * sizeof(uint64_t));
+}
+
+TEST_F(ArenaAllocatorTest, ManyBlocks) {
+  for (int i = 0; i < 1000; ++i) {
+    auto* value = arena_.Allocate<int64_t>();
+    *value = i;
+  }
+  EXPECT_EQ(arena_.GetStats().num_allocations, 1000);
+  EXPECT_GT(arena_.GetStats().bytes_reserved, 4096);
+}
+
 // Tests for HostArray class.
 constexpr size_t kTestArraySize = 16;
 class HostArrayTest : public ::testing::Test {
@@ -18,7 +18,9 @@
 
 #include "tfrt/host_context/parallel_for.h"
 
+#include <atomic>
 #include <chrono>
+#include <memory>
 #include <thread>
 #include <utility>
 
@@ -45,6 +47,14 @@ static std::unique_ptr<HostContext> CreateTestHostContext(int num_threads) {
       CreateMultiThreadedWorkQueue(num_threads, num_threads));
 }
 
+// Waits until all worker threads are parked or spinning, so that the cost
+// model sees all of them as idle.
+static void WaitForIdleWorkers(HostContext* host) {
+  ConcurrentWorkQueue& work_queue = host->work_queue();
+  while (work_queue.GetNumBusyWorkerThreads() > 0)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
 static ExecutionContext CreateTestExecutionContext(HostContext* host) {
   Expected<RCReference<RequestContext>> request_ctx =
       RequestContextBuilder(host, /*resource_context=*/nullptr).build();
@@ -102,6 +112,99 @@ TEST(ParallelForTest, MinBlockSize) {
   ASSERT_EQ(ranges, expected);
 }
 
+TEST(ParallelForTest, CheapCostSingleBlock) {
+  auto host = CreateTestHostContext(4);
+  ParallelFor pfor(CreateTestExecutionContext(host.get()));
+
+  ParallelFor::ElementCost cost;
+  cost.bytes_loaded = 4;
+  cost.bytes_stored = 4;
+  cost.compute_cycles = 1;
+
+  std::vector<Range> ranges;
+  AsyncValueRef<Chain> done =
+      pfor.Execute(100, BlockSizes::Cost(cost), [&](size_t begin, size_t end) {
+        ranges.push_back({begin, end});
+      });
+
+  // A single block is executed in the caller thread.
+  ASSERT_TRUE(done.IsAvailable());
+  const std::vector<Range> expected = {{0, 100}};
+  ASSERT_EQ(ranges, expected);
+}
+
+TEST(ParallelForTest, ExpensiveCostMultipleBlocks) {
+  auto host = CreateTestHostContext(4);
+  WaitForIdleWorkers(host.get());
+  ParallelFor pfor(CreateTestExecutionContext(host.get()));
+
+  ParallelFor::ElementCost cost;
+  cost.compute_cycles = 1000000;
+
+  latch barrier(1);
+  mutex mu;
+  std::vector<Range> ranges;
+
+  AsyncValueRef<Chain> done =
+      pfor.Execute(100, BlockSizes::Cost(cost), [&](size_t begin, size_t end) {
+        mutex_lock lock(mu);
+        ranges.push_back({begin, end});
+      });
+  done.AndThen([&]() { barrier.count_down(); });
+
+  barrier.wait();
+
+  // Blocks must cover the whole range without gaps or overlaps.
+  std::sort(ranges.begin(), ranges.end());
+  ASSERT_GT(ranges.size(), 1);
+  size_t next = 0;
+  for (const Range& range : ranges) {
+    ASSERT_EQ(range.first, next);
+    ASSERT_GT(range.second, range.first);
+    next = range.second;
+  }
+  ASSERT_EQ(next, 100);
+}
+
+TEST(ParallelForTest, SaturatedNestedParallelForRunsInline) {
+  auto host = CreateTestHostContext(4);
+  auto exec_ctx = CreateTestExecutionContext(host.get());
+
+  // Occupy all worker threads, and launch a nested parallel for from each.
+  latch all_running(4);
+  latch all_done(4);
+  std::atomic<int32_t> num_inline{0};
+
+  for (int i = 0; i < 4; ++i) {
+    EnqueueWork(exec_ctx, [&]() {
+      all_running.count_down();
+      all_running.wait();
+
+      const std::thread::id caller = std::this_thread::get_id();
+      auto num_blocks = std::make_shared<std::atomic<int32_t>>(0);
+      auto num_in_caller = std::make_shared<std::atomic<int32_t>>(0);
+
+      AsyncValueRef<Chain> done = ParallelFor(exec_ctx).Execute(
+          10, BlockSizes::Fixed(1),
+          [caller, num_blocks, num_in_caller](size_t begin, size_t end) {
+            ++*num_blocks;
+            if (std::this_thread::get_id() == caller) ++*num_in_caller;
+          });
+
+      // All blocks were executed in the caller before Execute returned.
+      if (done.IsAvailable() && *num_blocks == 10 && *num_in_caller == 10)
+        ++num_inline;
+
+      // Keep all worker threads busy until every nested parallel for is done.
+      all_done.count_down();
+      all_done.wait();
+    });
+  }
+
+  all_done.wait();
+  ASSERT_EQ(num_inline.load(), 4);
+}
+
 TEST(ParallelForTest, BlockTasksCompletion) {
   auto host = CreateTestHostContext(4);
   ParallelFor pfor(CreateTestExecutionContext(host.get()));
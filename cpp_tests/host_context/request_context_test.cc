@@ -60,5 +60,32 @@ TEST(RequestContextTest, ContextData) {
   EXPECT_EQ(expected_request_context.get()->GetDataIfExists<int>(), nullptr);
 }
 
+TEST(RequestContextTest, ArenaAllocator) {
+  auto host = CreateTestHostContext();
+  ResourceContext resource_context;
+
+  auto default_request_context =
+      RequestContextBuilder(host.get(), &resource_context).build();
+  ASSERT_FALSE(!default_request_context);
+  EXPECT_EQ(default_request_context.get()->allocator(), host->allocator());
+  EXPECT_EQ(default_request_context.get()->arena_allocator(), nullptr);
+
+  auto arena_request_context =
+      RequestContextBuilder(host.get(), &resource_context)
+          .enable_arena_allocator()
+          .build();
+  ASSERT_FALSE(!arena_request_context);
+  ArenaAllocator* arena = arena_request_context.get()->arena_allocator();
+  ASSERT_NE(arena, nullptr);
+
+  ExecutionContext exec_ctx(std::move(arena_request_context.get()));
+  EXPECT_EQ(exec_ctx.allocator(), arena);
+
+  auto* value = exec_ctx.allocator()->Allocate<int64_t>();
+  exec_ctx.allocator()->Deallocate(value);
+  EXPECT_EQ(arena->GetStats().num_allocations, 1);
+  EXPECT_EQ(arena->GetStats().bytes_allocated, sizeof(int64_t));
+}
+
 }  // namespace
 }  // namespace tfrt
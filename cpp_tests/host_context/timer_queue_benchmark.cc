@@ -0,0 +1,73 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Multi-threaded benchmark of TimerQueue schedule and cancel operations with a
+// million outstanding request deadlines.
+
+#include <chrono>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "tfrt/host_context/timer_queue.h"
+
+namespace tfrt {
+namespace {
+
+using namespace std::chrono_literals;  // NOLINT
+
+constexpr int kOutstandingDeadlines = 1000000;
+
+// Returns a timer queue with a million deadlines far enough in the future to
+// stay outstanding for the whole benchmark. The queue is shared by all
+// benchmark threads and all runs, and is never destroyed.
+TimerQueue* GetTimerQueueWithDeadlines() {
+  static TimerQueue* timer_queue = [] {
+    auto* timer_queue = new TimerQueue;
+    for (int i = 0; i < kOutstandingDeadlines; ++i) {
+      // Spread the deadlines over an hour, like request deadlines.
+      timer_queue->ScheduleTimer(1h + i * 3600ms / kOutstandingDeadlines,
+                                 []() {});
+    }
+    return timer_queue;
+  }();
+  return timer_queue;
+}
+
+// Schedules a request deadline and cancels it when the request completes, the
+// pattern of RequestDeadlineTracker.
+void BM_ScheduleAndCancel(benchmark::State& state) {
+  TimerQueue* timer_queue = GetTimerQueueWithDeadlines();
+
+  // Keep a few deadlines live at a time, so that cancellations do not always
+  // immediately follow their schedule.
+  std::vector<TimerQueue::TimerHandle> live(64);
+  int i = 0;
+  for (auto _ : state) {
+    auto& timer = live[i++ % live.size()];
+    if (timer) timer_queue->CancelTimer(timer);
+    timer = timer_queue->ScheduleTimer(10s, []() {});
+  }
+
+  for (auto& timer : live) {
+    if (timer) timer_queue->CancelTimer(timer);
+  }
+  state.counters["outstanding"] = benchmark::Counter(
+      timer_queue->num_pending_timers(), benchmark::Counter::kAvgThreads);
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ScheduleAndCancel)->ThreadRange(1, 16)->UseRealTime();
+
+}  // namespace
+}  // namespace tfrt
@@ -21,8 +21,11 @@
 #include <chrono>
 #include <ctime>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
+#include "tfrt/support/mutex.h"
 
 namespace tfrt {
 namespace {
@@ -93,5 +96,36 @@ TEST(TimerQueueTest, TimerQueueTimerCancelled) {
   ASSERT_FALSE(expired_2);
 }
 
+// This test checks that cancelled timers are removed from the queue, and that
+// timers with the same deadline added from many threads all expire.
+TEST(TimerQueueTest, TimerQueueManyTimers) {
+  TimerQueue::Options options;
+  options.tick = 10ms;
+  options.num_shards = 4;
+  TimerQueue tq(options);
+
+  std::atomic<int> num_expired{0};
+  std::vector<TimerQueue::TimerHandle> cancelled;
+  std::vector<std::thread> threads;
+  mutex mu;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < 1000; ++i) {
+        tq.ScheduleTimer(100ms, [&]() { num_expired++; });
+        auto timer = tq.ScheduleTimer(1h, [&]() { num_expired++; });
+        mutex_lock lock(mu);
+        cancelled.push_back(std::move(timer));
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (auto& timer : cancelled) tq.CancelTimer(timer);
+  ASSERT_LE(tq.num_pending_timers(), 8000);
+
+  std::this_thread::sleep_for(1s);
+  ASSERT_EQ(num_expired, 8000);
+  ASSERT_EQ(tq.num_pending_timers(), 0);
+}
+
 }  // namespace
 }  // namespace tfrt
@@ -0,0 +1,79 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit test for memory mapped files of the default file system.
+
+#include <fstream>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "tfrt/io/file_system.h"
+
+namespace tfrt {
+namespace io {
+namespace {
+
+std::string WriteTempFile(const std::string& name,
+                          const std::string& contents) {
+  std::string path = ::testing::TempDir() + "/" + name;
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << contents;
+  return path;
+}
+
+#ifndef _WIN32
+TEST(MemoryMappedFileTest, MapsContents) {
+  std::string path = WriteTempFile("mapped_file", "hello mmap");
+  auto* file_system = FileSystemRegistry::Default()->Lookup("");
+  ASSERT_NE(file_system, nullptr);
+
+  RCReference<MemoryMappedFile> file;
+  ASSERT_FALSE(file_system->NewMemoryMappedFile(path, &file));
+  ASSERT_TRUE(file);
+  EXPECT_EQ(file->data(), "hello mmap");
+
+  // Views stay valid as long as a reference to the mapping is held.
+  RCReference<MemoryMappedFile> copy = file;
+  string_view data = file->data();
+  file.reset();
+  EXPECT_EQ(data, "hello mmap");
+  EXPECT_EQ(copy->NumRef(), 1);
+}
+
+TEST(MemoryMappedFileTest, EmptyFile) {
+  std::string path = WriteTempFile("empty_mapped_file", "");
+  auto* file_system = FileSystemRegistry::Default()->Lookup("");
+  ASSERT_NE(file_system, nullptr);
+
+  RCReference<MemoryMappedFile> file;
+  ASSERT_FALSE(file_system->NewMemoryMappedFile(path, &file));
+  EXPECT_TRUE(file->data().empty());
+}
+
+TEST(MemoryMappedFileTest, MissingFile) {
+  auto* file_system = FileSystemRegistry::Default()->Lookup("");
+  ASSERT_NE(file_system, nullptr);
+
+  RCReference<MemoryMappedFile> file;
+  auto error = file_system->NewMemoryMappedFile(
+      ::testing::TempDir() + "/does_not_exist", &file);
+  EXPECT_TRUE(static_cast<bool>(error));
+  llvm::consumeError(std::move(error));
+  EXPECT_FALSE(file);
+}
+#endif  // _WIN32
+
+}  // namespace
+}  // namespace io
+}  // namespace tfrt
@@ -0,0 +1,209 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit tests for the memory mapped mode of TFRecordDataset.
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../../lib/data/memory_dataset.h"
+#include "../../lib/data/tf_record_dataset.h"
+#include "gtest/gtest.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/host_context/kernel_registry.h"
+#include "tfrt/support/crc32c.h"
+#include "tfrt/utils/kernel_runner.h"
+
+namespace tfrt {
+namespace data {
+namespace {
+
+void AppendFixed(uint64_t value, size_t size, std::string* out) {
+  for (size_t i = 0; i < size; ++i) out->push_back((value >> (8 * i)) & 0xff);
+}
+
+// Returns `data` encoded as a TFRecord.
+std::string EncodeRecord(const std::string& data) {
+  std::string length;
+  AppendFixed(data.size(), sizeof(uint64_t), &length);
+  std::string record = length;
+  AppendFixed(crc32c::Mask(crc32c::Value(length.data(), length.size())),
+              sizeof(uint32_t), &record);
+  record += data;
+  AppendFixed(crc32c::Mask(crc32c::Value(data.data(), data.size())),
+              sizeof(uint32_t), &record);
+  return record;
+}
+
+std::string WriteTempFile(const std::string& name,
+                          const std::string& contents) {
+  std::string path = ::testing::TempDir() + "/" + name;
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << contents;
+  return path;
+}
+
+class MmapTFRecordDatasetTest : public ::testing::Test {
+ protected:
+  MmapTFRecordDatasetTest()
+      : host_([](const DecodedDiagnostic&) {}, CreateMallocAllocator(),
+              CreateSingleThreadedWorkQueue()),
+        exec_ctx_(*RequestContextBuilder(&host_, nullptr).build()) {}
+
+  RCReference<Iterator> MakeIterator(const std::string& path,
+                                     bool use_mmap = true) {
+    auto dataset = TakeRef(host_.Construct<TFRecordDataset>(
+        path, /*buffer_size=*/0, /*max_prefetch_num=*/4,
+        /*prefetch_threshold=*/1, /*autotune_prefetch=*/false, use_mmap,
+        &host_));
+    return dataset->MakeIterator(IteratorContext());
+  }
+
+  // Returns the next element of `iterator` once it is available.
+  IterationResult GetNext(Iterator* iterator) {
+    auto result = iterator->GetNext(exec_ctx_);
+    SmallVector<RCReference<AsyncValue>, 4> values;
+    for (AsyncValue* value : result.AsyncValues())
+      values.push_back(FormRef(value));
+    host_.Await(values);
+    return result;
+  }
+
+  HostContext host_;
+  ExecutionContext exec_ctx_;
+};
+
+#ifndef _WIN32
+TEST_F(MmapTFRecordDatasetTest, ReadsValidRecords) {
+  std::vector<std::string> records = {"first", "", "third record"};
+  std::string contents;
+  for (const auto& record : records) contents += EncodeRecord(record);
+  auto iterator = MakeIterator(WriteTempFile("valid.tfrecord", contents));
+
+  for (const auto& expected : records) {
+    auto result = GetNext(iterator.get());
+    ASSERT_FALSE(result.eof.IsError()) << result.eof.GetError().message;
+    ASSERT_FALSE(result.eof.get());
+    const auto& record = result.values[0]->get<TFRecord>();
+    EXPECT_EQ(record.data, expected);
+    // The record is a view into the mapping, not a copy.
+    string_view mapping = record.file->data();
+    EXPECT_GE(record.data.data(), mapping.data());
+    EXPECT_LE(record.data.data() + record.data.size(),
+              mapping.data() + mapping.size());
+  }
+  auto result = GetNext(iterator.get());
+  ASSERT_FALSE(result.eof.IsError());
+  EXPECT_TRUE(result.eof.get());
+}
+
+TEST_F(MmapTFRecordDatasetTest, RecordOutlivesIterator) {
+  auto iterator = MakeIterator(
+      WriteTempFile("outlives.tfrecord", EncodeRecord("kept alive")));
+  auto result = GetNext(iterator.get());
+  ASSERT_FALSE(result.eof.IsError());
+  iterator.reset();
+  EXPECT_EQ(result.values[0]->get<TFRecord>().data, "kept alive");
+}
+
+TEST_F(MmapTFRecordDatasetTest, RejectsCrcMismatch) {
+  std::string corrupted = EncodeRecord("corrupted");
+  // Flip a byte of the data, after the 12 byte header.
+  corrupted[14] ^= 0x1;
+  auto iterator = MakeIterator(WriteTempFile(
+      "crc_mismatch.tfrecord", EncodeRecord("valid") + corrupted));
+
+  auto result = GetNext(iterator.get());
+  ASSERT_FALSE(result.eof.IsError());
+  EXPECT_EQ(result.values[0]->get<TFRecord>().data, "valid");
+
+  result = GetNext(iterator.get());
+  ASSERT_TRUE(result.eof.IsError());
+  EXPECT_NE(result.eof.GetError().message.find("data corruption"),
+            std::string::npos);
+}
+
+TEST_F(MmapTFRecordDatasetTest, RejectsTruncatedFinalRecord) {
+  std::string truncated = EncodeRecord("truncated");
+  truncated.resize(truncated.size() - 3);
+  auto iterator = MakeIterator(WriteTempFile(
+      "truncated.tfrecord", EncodeRecord("valid") + truncated));
+
+  auto result = GetNext(iterator.get());
+  ASSERT_FALSE(result.eof.IsError());
+  EXPECT_EQ(result.values[0]->get<TFRecord>().data, "valid");
+
+  result = GetNext(iterator.get());
+  ASSERT_TRUE(result.eof.IsError());
+  EXPECT_NE(result.eof.GetError().message.find("truncated record"),
+            std::string::npos);
+}
+
+TEST_F(MmapTFRecordDatasetTest, PartialHeaderIsEndOfFile) {
+  std::string path = WriteTempFile("partial_header.tfrecord",
+                                   EncodeRecord("valid") + "short");
+
+  // Both reading modes ignore a trailing partial header.
+  for (bool use_mmap : {true, false}) {
+    auto iterator = MakeIterator(path, use_mmap);
+
+    auto result = GetNext(iterator.get());
+    ASSERT_FALSE(result.eof.IsError());
+    ASSERT_FALSE(result.eof.get());
+
+    result = GetNext(iterator.get());
+    ASSERT_FALSE(result.eof.IsError()) << result.eof.GetError().message;
+    EXPECT_TRUE(result.eof.get());
+  }
+}
+TEST_F(MmapTFRecordDatasetTest, MemoryDatasetReplaysRecords) {
+  auto input = TakeRef(host_.Construct<TFRecordDataset>(
+      WriteTempFile("memory.tfrecord", EncodeRecord("a") + EncodeRecord("b")),
+      /*buffer_size=*/0, /*max_prefetch_num=*/4, /*prefetch_threshold=*/1,
+      /*autotune_prefetch=*/false, /*use_mmap=*/true, &host_));
+  auto dataset = TakeRef(
+      host_.Construct<MemoryDataset<TFRecord>>(std::move(input), &host_));
+  auto iterator = dataset->MakeIterator(IteratorContext());
+
+  // The records are read from the file once and then replayed from memory.
+  for (const char* expected : {"a", "b", "a", "b", "a"}) {
+    auto result = GetNext(iterator.get());
+    ASSERT_FALSE(result.eof.IsError()) << result.eof.GetError().message;
+    ASSERT_FALSE(result.eof.get());
+    EXPECT_EQ(result.values[0]->get<TFRecord>().data, expected);
+  }
+}
+
+TEST_F(MmapTFRecordDatasetTest, TFRecordToString) {
+  RegisterStaticKernels(host_.GetMutableRegistry());
+  auto iterator = MakeIterator(
+      WriteTempFile("to_string.tfrecord", EncodeRecord("copied")));
+  auto result = GetNext(iterator.get());
+  ASSERT_FALSE(result.eof.IsError());
+
+  KernelRunner runner("tfrt_data.tf_record_to_string", &host_);
+  runner.SetArgs(result.values[0]->get<TFRecord>());
+  EXPECT_EQ(runner.RunAndGetResult<std::string>(), "copied");
+}
+#endif  // _WIN32
+
+}  // namespace
+}  // namespace data
+}  // namespace tfrt
@@ -0,0 +1,106 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit test for DefaultMetricsRegistry.
+
+#include "tfrt/metrics/default_metrics_registry.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace tfrt {
+namespace metrics {
+namespace {
+
+using ::testing::HasSubstr;
+
+std::string GetPrometheusText(const DefaultMetricsRegistry& registry) {
+  std::string text;
+  llvm::raw_string_ostream os(text);
+  registry.WritePrometheusText(os);
+  return os.str();
+}
+
+TEST(DefaultMetricsRegistryTest, Gauges) {
+  DefaultMetricsRegistry registry;
+  registry.NewStringGauge("/tensorflow/runtime/version")->Set("V\"1\"");
+  registry.NewIntGauge("/test/bytes")->Set(42);
+
+  auto text = GetPrometheusText(registry);
+  EXPECT_THAT(text, HasSubstr("# TYPE tensorflow_runtime_version gauge\n"
+                              "tensorflow_runtime_version{value=\"V\\\"1\\\"\"}"
+                              " 1\n"));
+  EXPECT_THAT(text, HasSubstr("# TYPE test_bytes gauge\ntest_bytes 42\n"));
+}
+
+TEST(DefaultMetricsRegistryTest, GaugeCallback) {
+  DefaultMetricsRegistry registry;
+  int64_t value = 1;
+  registry.NewIntGaugeCallback("/test/callback", [&value] { return value; });
+  value = 7;
+
+  EXPECT_THAT(GetPrometheusText(registry),
+              HasSubstr("# TYPE test_callback gauge\ntest_callback 7\n"));
+}
+
+TEST(DefaultMetricsRegistryTest, CounterIsShardedByThread) {
+  DefaultMetricsRegistry registry;
+  auto* counter = registry.NewCounter("/test/counter");
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([counter] {
+      for (int j = 0; j < 1000; ++j) counter->Increment();
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  counter->IncrementBy(5);
+
+  EXPECT_THAT(GetPrometheusText(registry),
+              HasSubstr("# TYPE test_counter counter\ntest_counter 8005\n"));
+}
+
+TEST(DefaultMetricsRegistryTest, ReturnsExistingMetric) {
+  DefaultMetricsRegistry registry;
+  EXPECT_EQ(registry.NewCounter("/test/counter"),
+            registry.NewCounter("/test/counter"));
+}
+
+TEST(DefaultMetricsRegistryTest, Histogram) {
+  DefaultMetricsRegistry registry;
+  auto* histogram = registry.NewHistogram(
+      "/test/latency", Buckets::Exponential(/*scale=*/1, /*growth_factor=*/10,
+                                            /*bucket_count=*/3));
+  for (double value : {0.5, 1.0, 5.0, 50.0, 100.0, 500.0})
+    histogram->Record(value);
+
+  // The bucket bounds are inclusive.
+  EXPECT_THAT(GetPrometheusText(registry),
+              HasSubstr("# TYPE test_latency histogram\n"
+                        "test_latency_bucket{le=\"1\"} 2\n"
+                        "test_latency_bucket{le=\"10\"} 3\n"
+                        "test_latency_bucket{le=\"100\"} 5\n"
+                        "test_latency_bucket{le=\"+Inf\"} 6\n"
+                        "test_latency_sum 656.5\n"
+                        "test_latency_count 6\n"));
+}
+
+}  // namespace
+}  // namespace metrics
+}  // namespace tfrt
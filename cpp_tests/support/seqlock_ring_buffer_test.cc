@@ -0,0 +1,89 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for tfrt::SeqlockRingBuffer.
+
+#include "tfrt/support/seqlock_ring_buffer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace tfrt {
+namespace {
+
+struct Event {
+  uint64_t index;
+  uint64_t twice_index;
+};
+
+std::vector<uint64_t> Indices(const SeqlockRingBuffer<Event>& buffer) {
+  std::vector<Event> events;
+  buffer.Collect(&events);
+  std::vector<uint64_t> indices;
+  for (const Event& event : events) indices.push_back(event.index);
+  return indices;
+}
+
+TEST(SeqlockRingBufferTest, KeepsMostRecentEvents) {
+  // The capacity is rounded up to 4.
+  SeqlockRingBuffer<Event> buffer(3);
+  EXPECT_TRUE(Indices(buffer).empty());
+
+  for (uint64_t i = 0; i < 3; ++i) buffer.Append({i, 2 * i});
+  EXPECT_EQ(Indices(buffer), std::vector<uint64_t>({0, 1, 2}));
+  EXPECT_EQ(buffer.num_overwritten(), 0u);
+
+  for (uint64_t i = 3; i < 6; ++i) buffer.Append({i, 2 * i});
+  EXPECT_EQ(Indices(buffer), std::vector<uint64_t>({2, 3, 4, 5}));
+  EXPECT_EQ(buffer.num_overwritten(), 2u);
+}
+
+TEST(SeqlockRingBufferTest, Clear) {
+  SeqlockRingBuffer<Event> buffer(4);
+  buffer.Append({0, 0});
+  buffer.Append({1, 2});
+  buffer.Clear();
+  EXPECT_TRUE(Indices(buffer).empty());
+
+  buffer.Append({2, 4});
+  EXPECT_EQ(Indices(buffer), std::vector<uint64_t>({2}));
+}
+
+TEST(SeqlockRingBufferTest, ReadersNeverSeeTornEvents) {
+  SeqlockRingBuffer<Event> buffer(16);
+  std::atomic<bool> done{false};
+
+  std::thread producer([&] {
+    for (uint64_t i = 0; i < 100000; ++i) buffer.Append({i, 2 * i});
+    done = true;
+  });
+
+  std::vector<Event> events;
+  while (!done) {
+    events.clear();
+    buffer.Collect(&events);
+    for (size_t i = 0; i < events.size(); ++i) {
+      EXPECT_EQ(events[i].twice_index, 2 * events[i].index);
+      if (i > 0) EXPECT_LT(events[i - 1].index, events[i].index);
+    }
+  }
+  producer.join();
+}
+
+}  // namespace
+}  // namespace tfrt
@@ -0,0 +1,46 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for tfrt::ShardedCounter.
+
+#include "tfrt/support/sharded_counter.h"
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace tfrt {
+namespace {
+
+TEST(ShardedCounterTest, SumsDeltasFromAllThreads) {
+  ShardedCounter counter;
+  EXPECT_EQ(counter.Sum(), 0);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 32; ++i) {
+    threads.emplace_back([&counter] {
+      for (int j = 0; j < 1000; ++j) {
+        counter.Add(3);
+        counter.Add(-1);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  EXPECT_EQ(counter.Sum(), 32 * 1000 * 2);
+}
+
+}  // namespace
+}  // namespace tfrt
@@ -0,0 +1,113 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit test for the Chrome trace event tracing sink.
+
+#include "tfrt/tracing/chrome_tracing_sink.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "llvm/Support/raw_ostream.h"
+#include "tfrt/tracing/tracing.h"
+
+namespace tfrt {
+namespace tracing {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+std::string GetChromeTrace() {
+  std::string trace;
+  llvm::raw_string_ostream os(trace);
+  WriteChromeTrace(os);
+  return os.str();
+}
+
+TEST(ChromeTracingSinkTest, WritesScopesAndEvents) {
+  if (internal::kMaxTracingLevel < TracingLevel::Default)
+    GTEST_SKIP() << "Tracing is disabled";
+
+  ClearChromeTrace();
+  {
+    TracingRequester tracing;
+    TFRT_TRACE_SCOPE(Default, "outer \"scope\"");
+    TFRT_TRACE_EVENT(Default, "event");
+    std::thread([] { TFRT_TRACE_SCOPE(Default, "other thread"); }).join();
+  }
+  TFRT_TRACE_EVENT(Default, "not recorded");
+
+  auto trace = GetChromeTrace();
+  EXPECT_THAT(trace, HasSubstr("\"traceEvents\":["));
+  EXPECT_THAT(trace, HasSubstr("\"ph\":\"B\""));
+  EXPECT_THAT(trace, HasSubstr("\"ph\":\"E\""));
+  EXPECT_THAT(trace, HasSubstr("\"name\":\"outer \\\"scope\\\"\""));
+  EXPECT_THAT(trace, HasSubstr("\"name\":\"event\",\"s\":\"t\""));
+  EXPECT_THAT(trace, HasSubstr("\"name\":\"other thread\""));
+  EXPECT_THAT(trace, Not(HasSubstr("not recorded")));
+
+  ClearChromeTrace();
+  EXPECT_THAT(GetChromeTrace(), Not(HasSubstr("\"ph\":")));
+}
+
+TEST(ChromeTracingSinkTest, KeepsMostRecentEvents) {
+  if (internal::kMaxTracingLevel < TracingLevel::Default)
+    GTEST_SKIP() << "Tracing is disabled";
+
+  ClearChromeTrace();
+  {
+    TracingRequester tracing;
+    TFRT_TRACE_SCOPE(Default, "first");
+    for (int i = 0; i < 100000; ++i) TFRT_TRACE_EVENT(Default, "filler");
+    TFRT_TRACE_EVENT(Default, "last");
+  }
+
+  auto trace = GetChromeTrace();
+  EXPECT_THAT(trace, Not(HasSubstr("\"first\"")));
+  EXPECT_THAT(trace, HasSubstr("\"last\""));
+  // The end of the overwritten "first" scope is dropped.
+  EXPECT_THAT(trace, Not(HasSubstr("\"ph\":\"E\"")));
+}
+
+TEST(ChromeTracingSinkTest, WritesTraceWhileRecording) {
+  if (internal::kMaxTracingLevel < TracingLevel::Default)
+    GTEST_SKIP() << "Tracing is disabled";
+
+  ClearChromeTrace();
+  TracingRequester tracing;
+  std::atomic<bool> done{false};
+  std::atomic<bool> started{false};
+  std::thread thread([&] {
+    while (!done.load()) {
+      TFRT_TRACE_EVENT(Default, "concurrent");
+      started.store(true);
+    }
+  });
+  // Make sure that at least one event is recorded, even on a single core.
+  while (!started.load()) std::this_thread::yield();
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_THAT(GetChromeTrace(), HasSubstr("\"traceEvents\":["));
+  }
+  done.store(true);
+  thread.join();
+  EXPECT_THAT(GetChromeTrace(), HasSubstr("\"name\":\"concurrent\""));
+}
+
+}  // namespace
+}  // namespace tracing
+}  // namespace tfrt
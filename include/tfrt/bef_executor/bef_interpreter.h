@@ -21,6 +21,8 @@
 
 #include <memory>
 
+#include "llvm/ADT/Optional.h"
+#include "tfrt/bef_executor/sync_memory_planner.h"
 #include "tfrt/support/forward_decls.h"
 
 namespace tfrt {
@@ -35,6 +37,10 @@ class BEFInterpreterImpl;
 /// kernels. Multiple interpreters can be active at one time, e.g. due to
 /// concurrent control flow constructs.
 //
+// The buffers allocated by the kernels through SyncKernelFrame::AllocateBuffer
+// are placed in an arena that is planned by the first execution and reused by
+// the following executions of the same BEFInterpreter, see SyncMemoryPlanner.
+//
 // BEFInterpreter is thread-compatible.
 class BEFInterpreter final {
  public:
@@ -46,6 +52,11 @@ class BEFInterpreter final {
   Error Execute(const ExecutionContext& exec_ctx, ArrayRef<Value*> arguments,
                 ArrayRef<Value*> results);
 
+  // Returns the statistics of the memory plan, or None if the buffers are not
+  // planned, i.e. before the first successful execution or if the function
+  // does not have static shapes.
+  Optional<SyncMemoryPlanStats> GetMemoryPlanStats() const;
+
  private:
   std::unique_ptr<BEFInterpreterImpl> impl_;
 };
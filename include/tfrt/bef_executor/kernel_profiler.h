@@ -0,0 +1,159 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Per-kernel profiler for the BEF executor
+//
+// This file declares KernelProfiler, which collects per-kernel timing
+// information from BEF function executions and summarizes it per function.
+
+#ifndef TFRT_BEF_EXECUTOR_KERNEL_PROFILER_H_
+#define TFRT_BEF_EXECUTOR_KERNEL_PROFILER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "llvm/Support/raw_ostream.h"
+#include "tfrt/host_context/location.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/seqlock_ring_buffer.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+
+class Function;
+
+// A single kernel execution recorded by the KernelProfiler.
+struct KernelProfileEvent {
+  // The function the kernel belongs to.
+  const Function* function;
+  // The location of the kernel in the source program.
+  Location location;
+  // Identifies one execution of `function`.
+  uint64_t invocation_id;
+  // The kernel index in `function`.
+  uint32_t kernel_id;
+  // The kernel whose result made this kernel ready, or the arguments pseudo
+  // kernel (kernel_id 0).
+  uint32_t producer_id;
+  // Timestamps in nanoseconds when the kernel became ready, and when it started
+  // and finished. For asynchronous kernels, `end_ns` is when the kernel
+  // function returned, not when its results became available.
+  int64_t ready_ns;
+  int64_t start_ns;
+  int64_t end_ns;
+  // The index of the thread that ran the kernel.
+  uint32_t thread_index;
+  // True if the kernel ran on the thread that made it ready.
+  bool ran_inline;
+};
+
+// KernelProfiler records the execution of every kernel of the BEF functions
+// executed with an ExecutionContext that has this profiler set. Events are
+// appended to preallocated per-thread ring buffers without locks, which keep
+// the most recent events, so the profiler is cheap enough to be left enabled
+// in long running jobs. The events can be read while they are recorded.
+//
+// Example:
+//
+//   KernelProfiler profiler;
+//   exec_ctx.set_kernel_profiler(&profiler);
+//   function->Execute(exec_ctx, arguments, results);
+//   host->Await(results);
+//   host->Quiesce();
+//   profiler.PrintReport(tfrt::outs());
+class KernelProfiler {
+ public:
+  // Information about when and by whom a kernel was made ready. The BEF
+  // executor keeps one per kernel while profiling.
+  struct ReadyInfo {
+    int64_t ready_ns = 0;
+    uint32_t producer_id = 0;
+    uint32_t thread_index = 0;
+  };
+
+  // `max_events_per_thread` is the size of the ring buffer of each thread,
+  // rounded up to a power of two. The buffer is allocated when the thread
+  // records its first event. Once it is full, new events overwrite the oldest.
+  explicit KernelProfiler(size_t max_events_per_thread = 1 << 16);
+  ~KernelProfiler();
+
+  // Returns a unique id for a new function execution.
+  uint64_t NewInvocationId() {
+    return next_invocation_id_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Returns a monotonic timestamp in nanoseconds.
+  static int64_t NowNs();
+
+  // Returns a small integer that identifies the calling thread.
+  static uint32_t CurrentThreadIndex();
+
+  static ReadyInfo MakeReadyInfo(uint32_t producer_id) {
+    return ReadyInfo{NowNs(), producer_id, CurrentThreadIndex()};
+  }
+
+  // Record a kernel execution into the buffer of the calling thread. This only
+  // takes a lock for the first event of a thread, and when the thread recorded
+  // its previous event into another profiler.
+  void Record(const KernelProfileEvent& event);
+
+  // Return the events currently in the buffers. This can be called while other
+  // threads record events. Events overwritten during the copy are skipped.
+  std::vector<KernelProfileEvent> GetEvents() const;
+
+  // Return the number of events overwritten because a thread buffer was full.
+  int64_t num_dropped_events() const;
+
+  // Print a per-function report of the recorded events: the kernels with the
+  // largest total run time, the critical path of the slowest execution, and
+  // the average number of kernels running in parallel over time.
+  void PrintReport(llvm::raw_ostream& os, int num_top_kernels = 10) const;
+
+  // Write the mean run time of the kernels in `events`, aggregated by kernel
+  // location, in the format read by the -tfrt-apply-cost-profile pass:
+  //
+  //   # <mean_ns> <count> <location>
+  //   1250 8 path/to/program.mlir:12:3
+  //
+  // Events without a location are skipped.
+  static void WriteCostProfile(ArrayRef<KernelProfileEvent> events,
+                               llvm::raw_ostream& os);
+
+ private:
+  using ThreadBuffer = SeqlockRingBuffer<KernelProfileEvent>;
+
+  // Returns the buffer of the calling thread.
+  ThreadBuffer* GetThreadBuffer();
+
+  const size_t max_events_per_thread_;
+  // Identifies the profiler in the thread_local cache of GetThreadBuffer().
+  // Unlike its address, it is not reused by a later profiler.
+  const uint64_t id_;
+  std::atomic<uint64_t> next_invocation_id_{0};
+
+  mutable mutex mu_;
+  std::unordered_map<std::thread::id, std::unique_ptr<ThreadBuffer>> buffers_
+      TFRT_GUARDED_BY(mu_);
+};
+
+}  // namespace tfrt
+
+#endif  // TFRT_BEF_EXECUTOR_KERNEL_PROFILER_H_
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Memory planner for synchronous BEF functions
+//
+// This file declares SyncMemoryPlanner, which places the buffers allocated by
+// the kernels of a synchronous BEF function in a single arena.
+
+#ifndef TFRT_BEF_EXECUTOR_SYNC_MEMORY_PLANNER_H_
+#define TFRT_BEF_EXECUTOR_SYNC_MEMORY_PLANNER_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/SmallVector.h"
+#include "tfrt/host_context/host_buffer.h"
+#include "tfrt/host_context/sync_kernel_frame.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/ref_count.h"
+
+namespace tfrt {
+
+class HostAllocator;
+
+// Statistics of the memory plan of a synchronous BEF function, in bytes.
+struct SyncMemoryPlanStats {
+  // Number of buffers allocated by one execution of the function.
+  int64_t num_buffers = 0;
+  // Number of these buffers that are placed in the arena.
+  int64_t num_planned_buffers = 0;
+  // Total size of the buffers allocated by one execution.
+  int64_t total_bytes = 0;
+  // Maximum total size of the buffers that are live at the same time.
+  int64_t peak_bytes = 0;
+  // Size of the arena holding the planned buffers.
+  int64_t planned_bytes = 0;
+};
+
+// SyncMemoryPlanner places the buffers allocated by the kernels of a
+// synchronous BEF function (see SyncKernelFrame::AllocateBuffer) in a single
+// arena that is reused across executions.
+//
+// The first execution records the size, alignment and lifetime of each buffer,
+// where the lifetime is the range of kernels between the allocation and the
+// release of the last reference to the buffer. Buffers whose lifetimes do not
+// overlap are then assigned overlapping offsets in the arena. Buffers that are
+// still referenced after the execution, e.g. function results, are not
+// planned.
+//
+// Later executions serve the n-th allocation with a slice of the arena if it
+// has the recorded size and alignment. As soon as an execution allocates a
+// different sequence of buffers, i.e. the function does not have static
+// shapes, the plan is dropped and all buffers are allocated individually.
+//
+// The arena is only reused if no slice of the previous execution is still
+// referenced, otherwise a new arena is allocated.
+//
+// SyncMemoryPlanner is thread-compatible.
+class SyncMemoryPlanner final : public SyncBufferAllocator {
+ public:
+  SyncMemoryPlanner() = default;
+  SyncMemoryPlanner(const SyncMemoryPlanner&) = delete;
+  SyncMemoryPlanner& operator=(const SyncMemoryPlanner&) = delete;
+
+  // Starts an execution. Buffers are allocated with `allocator` until the
+  // matching EndExecution().
+  void BeginExecution(HostAllocator* allocator);
+
+  // Must be called after each kernel of the execution, once the registers
+  // retired by the kernel have been released.
+  void EndKernel() {
+    if (state_ == State::kRecording) RecordReleasedBuffers();
+    ++kernel_index_;
+  }
+
+  // Ends the execution. The plan is computed at the end of the first
+  // successful execution.
+  void EndExecution(bool success);
+
+  RCReference<HostBuffer> AllocateBuffer(size_t size,
+                                         size_t alignment) override;
+
+  // Returns true if the buffers of the next execution are placed in the arena.
+  bool HasPlan() const { return state_ == State::kPlanned; }
+
+  // Returns the statistics of the memory plan. Only valid if HasPlan().
+  const SyncMemoryPlanStats& stats() const { return stats_; }
+
+ private:
+  enum class State {
+    // Record the buffers allocated by the execution.
+    kRecording,
+    // Place the buffers in the arena.
+    kPlanned,
+    // Allocate all buffers individually.
+    kDisabled,
+  };
+
+  struct BufferInfo {
+    size_t size;
+    size_t alignment;
+    // The first and the last kernel using the buffer, `last_kernel` is -1 if
+    // the buffer outlives the execution.
+    int first_kernel;
+    int last_kernel;
+    // Offset of the buffer in the arena, only valid for planned buffers.
+    size_t offset;
+  };
+
+  void RecordReleasedBuffers();
+  void ComputePlan();
+
+  RCReference<HostBuffer> AllocateIndividually(size_t size, size_t alignment);
+
+  State state_ = State::kRecording;
+  HostAllocator* allocator_ = nullptr;
+
+  // The kernel being executed and the number of buffers it allocated so far.
+  int kernel_index_ = 0;
+  size_t buffer_index_ = 0;
+  // Set if the execution did not allocate the planned sequence of buffers.
+  bool mismatch_ = false;
+
+  std::vector<BufferInfo> buffers_;
+  // The buffers of the recording execution that are still referenced by the
+  // function, with their index in `buffers_`.
+  llvm::SmallVector<std::pair<size_t, RCReference<HostBuffer>>, 16>
+      live_buffers_;
+
+  RCReference<HostBuffer> arena_;
+  size_t arena_alignment_ = 1;
+  SyncMemoryPlanStats stats_;
+};
+
+}  // namespace tfrt
+
+#endif  // TFRT_BEF_EXECUTOR_SYNC_MEMORY_PLANNER_H_
@@ -28,6 +28,7 @@
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
 #include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/kernel_scheduling.h"
 #include "tfrt/support/forward_decls.h"
 
 namespace tfrt {
@@ -45,6 +46,9 @@ enum class HostAllocatorType {
   // Allocator wrapped around profiled malloc and exit(1) on detecting memory
   // leak.
   kLeakCheckMalloc,
+
+  // Allocator with per-thread caches of size-classed chunks.
+  kThreadCachingMalloc,
 };
 
 struct RunBefConfig {
@@ -56,7 +60,17 @@ struct RunBefConfig {
   std::string test_init_function;
   std::string work_queue_type;
   tfrt::HostAllocatorType host_allocator_type;
+  // Scheduling policy of the ready kernels of async BEF functions.
+  KernelScheduling kernel_scheduling = KernelScheduling::kStreamTask;
   bool print_error_code = false;
+  // Print a per-kernel profile of each async BEF function after it completes.
+  bool profile_kernels = false;
+  // Run each sync BEF function a second time with the buffers planned by the
+  // first run, and print the memory plan after it completes.
+  bool print_memory_plan = false;
+  // If not empty, profile the kernels of all async BEF functions and write
+  // their mean run times to this file, see KernelProfiler::WriteCostProfile.
+  std::string kernel_cost_profile;
 };
 
 // Run the BEF program with default execution context.
@@ -0,0 +1,37 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares the factory of FuseCwiseOpsPass, which fuses chains of
+// coefficient wise Tensorflow ops executed by the core runtime into a single
+// tf._FusedCwise op.
+
+#ifndef TFRT_COMPILER_FUSE_CWISE_OPS_PASS_H_
+#define TFRT_COMPILER_FUSE_CWISE_OPS_PASS_H_
+
+#include <memory>
+
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Pass/Pass.h"
+
+namespace tfrt {
+namespace compiler {
+
+std::unique_ptr<mlir::OperationPass<mlir::FuncOp>> CreateFuseCwiseOpsPass();
+
+}  // namespace compiler
+}  // namespace tfrt
+
+#endif  // TFRT_COMPILER_FUSE_CWISE_OPS_PASS_H_
@@ -0,0 +1,47 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares the data types supported by the tf._FusedCwise op. They
+// are shared by the tfrt-fuse-cwise-ops pass, which only fuses ops of these
+// types, and the kernels, which dispatch on them.
+
+#ifndef TFRT_COMPILER_FUSED_CWISE_DTYPES_H_
+#define TFRT_COMPILER_FUSED_CWISE_DTYPES_H_
+
+#include "tfrt/dtype/dtype.h"
+
+namespace tfrt {
+
+// A compile time list of data types.
+template <DType... dtypes>
+struct DTypeList {
+  static bool Contains(DType dtype) {
+    bool contains = false;
+    for (DType element : {dtypes...}) contains |= element == dtype;
+    return contains;
+  }
+
+  // Instantiates `Template` with the data types of the list, e.g. to get a
+  // `internal::GetTypeDispatch` for them.
+  template <template <DType...> class Template>
+  using Apply = Template<dtypes...>;
+};
+
+using FusedCwiseDTypes = DTypeList<DType::F32, DType::F64>;
+
+}  // namespace tfrt
+
+#endif  // TFRT_COMPILER_FUSED_CWISE_DTYPES_H_
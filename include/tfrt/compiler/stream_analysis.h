@@ -26,6 +26,11 @@
 // worth doing so. Note that dependent streams can still be merged regardless of
 // the cost. It is set through the module attribute `tfrt.cost_threshold`.
 //
+// Operation Cost: The cost of an operation is taken from its integer
+// `_tfrt_cost` attribute if present, eg. a cost measured by the kernel profiler
+// and attached by the -tfrt-apply-cost-profile pass. Otherwise it is taken from
+// CostFunctionInterface, or defaults to the cost threshold.
+//
 // The algorithm can be summarized as follows:
 //
 // 1. Build a naive stream tree where each stream contains only one operation:
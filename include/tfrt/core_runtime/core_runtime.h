@@ -103,6 +103,13 @@ class CoreRuntime final {
   // directly, or an error if it cannot find the op in the op registry.
   Expected<CoreRuntimeOp> MakeOp(string_view op_name, OpHandler* op_handler);
 
+  // [Experimental]
+  // Similar to MakeOp(), but the op is made only once for each `op_name` and
+  // `op_handler` pair, and then served from the op dispatch cache. The returned
+  // CoreRuntimeOp is owned by this CoreRuntime.
+  Expected<const CoreRuntimeOp*> GetOrMakeOp(string_view op_name,
+                                             OpHandler* op_handler);
+
   // [Experimental]
   // Construct and return a CoreRuntimeOp (a callable) from a Function. To
   // handle side effects, the first argument must be an input chain, and the
@@ -48,7 +48,7 @@ void SetUpOpFuncAttrs(AggregateAttr op_func_attr_array, OpAttrs *op_attrs);
 // ExecuteOp. The `op_chain` is the input/output parameter for sequencing op
 // execution. `op_chain` can be nullptr, which means it need not be sequenced.
 // `op_func_attr_array` is an optional array that contains function attributes.
-void ExecuteOpImpl(CoreRuntimeOp op, ArrayRef<AsyncValue *> args,
+void ExecuteOpImpl(const CoreRuntimeOp &op, ArrayRef<AsyncValue *> args,
                    AsyncValueRef<Chain> *op_chain,
                    MutableArrayRef<RCReference<AsyncValue>> results,
                    AggregateAttr op_attr_array,
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares OpMetadataCache, which memoizes the results of op metadata
+// functions.
+
+#ifndef TFRT_CORE_RUNTIME_OP_METADATA_CACHE_H_
+#define TFRT_CORE_RUNTIME_OP_METADATA_CACHE_H_
+
+#include <vector>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "tfrt/core_runtime/op_metadata_function.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/tensor/tensor_metadata.h"
+
+namespace tfrt {
+
+class OpAttrsRef;
+
+// OpMetadataCache maps (metadata function, op attributes, argument metadata)
+// to the result metadata computed by the metadata function. Metadata functions
+// are pure functions of these inputs, so ops that are executed repeatedly with
+// the same attributes and argument shapes can skip running them.
+//
+// The cache is direct mapped with a fixed number of entries: inserting an entry
+// evicts the previous entry with the same hash slot. It is not thread safe, use
+// GetPerThread() to get a cache owned by the caller thread.
+class OpMetadataCache {
+ public:
+  static constexpr size_t kNumEntries = 256;
+
+  // The serialized inputs of a metadata function execution.
+  class Key {
+   public:
+    size_t hash() const { return hash_; }
+
+    // Returns false if the inputs could not be serialized (e.g. an attribute
+    // of unknown size), such executions are never cached.
+    bool IsValid() const { return valid_; }
+
+    friend bool operator==(const Key& lhs, const Key& rhs) {
+      return lhs.hash_ == rhs.hash_ && lhs.bytes_.str() == rhs.bytes_.str();
+    }
+
+   private:
+    friend class OpMetadataCache;
+
+    bool valid_ = false;
+    size_t hash_ = 0;
+    llvm::SmallString<128> bytes_;
+  };
+
+  OpMetadataCache() : entries_(kNumEntries) {}
+
+  static Key MakeKey(OpMetadataFn metadata_fn, const OpAttrsRef& attrs,
+                     ArrayRef<TensorMetadata> arguments, size_t num_results);
+
+  // Copies the cached result metadata for `key` into `results` and returns
+  // true, or returns false if `key` is not in the cache.
+  bool Lookup(const Key& key, MutableArrayRef<TensorMetadata> results) const;
+
+  void Insert(Key key, ArrayRef<TensorMetadata> results);
+
+  // Returns the cache owned by the caller thread.
+  static OpMetadataCache* GetPerThread();
+
+ private:
+  struct Entry {
+    Key key;
+    SmallVector<TensorMetadata, 4> results;
+  };
+
+  std::vector<Entry> entries_;
+};
+
+}  // namespace tfrt
+
+#endif  // TFRT_CORE_RUNTIME_OP_METADATA_CACHE_H_
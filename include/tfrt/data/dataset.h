@@ -121,6 +121,12 @@ void DestroyImpl(SubClass* ptr, HostAllocator* allocator) {
 
 bool IsConcreteAndEmpty(const IterationResult& result);
 
+// Returns true if `result` and all of its values are available.
+bool IsAvailable(const IterationResult& result);
+
+// Returns true if `result` is available and is not the end of iteration.
+bool IsAvailableAndNotEof(const IterationResult& result);
+
 template <typename... T, size_t... I>
 static void AllocateTupleResult(
     MutableArrayRef<RCReference<AsyncValue>> results, HostContext* host,
@@ -143,6 +149,13 @@ class Iterator : public ReferenceCounted<Iterator> {
 
   virtual IterationResult GetNext(const ExecutionContext& exec_ctx) = 0;
 
+  // Appends the next `count` elements to `results`, with the same semantics as
+  // calling GetNext() `count` times. Iterators should override this method if
+  // they can amortize the per-element overhead over a batch of elements, e.g.
+  // by sharing the `eof` value of elements known to be valid.
+  virtual void GetNextBatch(const ExecutionContext& exec_ctx, size_t count,
+                            SmallVectorImpl<IterationResult>* results);
+
  protected:
   // For access to Destroy().
   friend class ReferenceCounted<Iterator>;
@@ -25,6 +25,7 @@
 #include <functional>
 #include <memory>
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Compiler.h"
 #include "tfrt/host_context/task_function.h"
@@ -97,6 +98,16 @@ class ConcurrentWorkQueue {
     AddTask(std::move(work));
   }
 
+  // Enqueue a batch of non-blocking tasks. Thread-safe. The tasks are moved
+  // out of `work`.
+  //
+  // Implementations may amortize the cost of waking up the worker threads over
+  // the whole batch. The default implementation adds the tasks one by one.
+  virtual void AddTasks(const ExecutionContext& exec_ctx,
+                        MutableArrayRef<TaskFunction> work) {
+    for (TaskFunction& task : work) AddTask(exec_ctx, std::move(task));
+  }
+
   // Enqueue a blocking task. Thread-safe.
   //
   // If `allow_queuing` is false, implementation must guarantee that work will
@@ -137,6 +148,17 @@ class ConcurrentWorkQueue {
   // Returns true if the caller thread is one of the worker threads managed by
   // this work queue. Returns true only for threads executing compute tasks.
   virtual bool IsInWorkerThread() const = 0;
+
+  // Returns the index in [0, GetParallelismLevel()) of the calling worker
+  // thread, or -1 if the caller is not a worker thread of this work queue.
+  // Work queues that do not number their worker threads always return -1.
+  virtual int GetWorkerThreadIndex() const { return -1; }
+
+  // Returns an estimate of the number of worker threads that are currently
+  // executing tasks. Can be used together with GetParallelismLevel() to decide
+  // if it is worth splitting work into parallel tasks. Work queues that do not
+  // track thread occupancy report all worker threads as idle.
+  virtual int GetNumBusyWorkerThreads() const { return 0; }
 };
 
 // Create a thread pool that only uses the host donor thread, involving no
@@ -158,6 +180,24 @@ std::unique_ptr<ConcurrentWorkQueue> CreateSingleThreadedWorkQueue();
 std::unique_ptr<ConcurrentWorkQueue> CreateMultiThreadedWorkQueue(
     int num_threads, int num_blocking_threads);
 
+// Create a multi-threaded work queue like CreateMultiThreadedWorkQueue, but
+// with the non-blocking threads partitioned into groups that are pinned to the
+// CPUs of one NUMA node each. Idle threads steal tasks from threads of their
+// own group before stealing across groups, and tasks submitted with a
+// RequestOptions::numa_node preference are enqueued into that group.
+//
+// num_groups: Number of thread groups. If 0, one group per NUMA node of the
+// host is used. Otherwise the CPUs of the host are split evenly into
+// `num_groups` groups.
+// pin_to_single_cpu: If true, each thread is pinned to one CPU of its group,
+// round-robin. Otherwise the threads can run on all the CPUs of their group.
+//
+// Requires `num_threads` > 0, `num_blocking_threads` > 0 and
+// `num_groups` >= 0.
+std::unique_ptr<ConcurrentWorkQueue> CreateNumaAwareMultiThreadedWorkQueue(
+    int num_threads, int num_blocking_threads, int num_groups = 0,
+    bool pin_to_single_cpu = true);
+
 // A factory function for creating ConcurrentWorkQueue objects. The factory
 // function defines the semantics of the argument string.
 // TODO(pgavin): Consider using a configuration object or other data structure
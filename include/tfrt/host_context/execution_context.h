@@ -19,6 +19,8 @@
 #ifndef TFRT_HOST_CONTEXT_EXECUTION_CONTEXT_H_
 #define TFRT_HOST_CONTEXT_EXECUTION_CONTEXT_H_
 
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/kernel_scheduling.h"
 #include "tfrt/host_context/location.h"
 #include "tfrt/host_context/resource_context.h"
 #include "tfrt/support/map_by_type.h"
@@ -29,6 +31,18 @@ namespace tfrt {
 class HostContext;
 class ErrorAsyncValue;
 class ConcurrentWorkQueue;
+class KernelProfiler;
+
+struct RequestOptions {
+  using RequestPriority = int;
+
+  RequestPriority priority = 0;
+
+  // NUMA node that the non-blocking tasks of this request should preferably
+  // run on, or -1 for no preference. Only used by the work queues that
+  // partition their threads by NUMA node.
+  int numa_node = -1;
+};
 
 // A request refers to either a BEFFunction execution or an op execution.
 // RequestContext holds per request information, such as the cancellation status
@@ -49,6 +63,15 @@ class RequestContext : public ReferenceCounted<RequestContext> {
   void Cancel();
   HostContext* host() const { return host_; }
   ResourceContext* resource_context() const { return resource_context_; }
+  const RequestOptions& request_options() const { return request_options_; }
+
+  // Return the allocator for memory that does not outlive this request, e.g.
+  // the BEF executor state. This is the request arena if it is enabled, and
+  // the HostContext allocator otherwise.
+  HostAllocator* allocator() const { return allocator_; }
+
+  // Return the request arena, or nullptr if it is not enabled.
+  ArenaAllocator* arena_allocator() const { return arena_allocator_.get(); }
 
   // If the request has been canceled, return an ErrorAsyncValue for
   // the cancellation. Otherwise, return nullptr.
@@ -82,14 +105,17 @@ class RequestContext : public ReferenceCounted<RequestContext> {
   friend class RequestContextBuilder;
 
   RequestContext(HostContext* host, ResourceContext* resource_context,
-                 ContextData ctx_data, int64_t id)
-      : id_{id},
-        host_{host},
-        resource_context_{resource_context},
-        context_data_{std::move(ctx_data)} {}
+                 ContextData ctx_data, int64_t id,
+                 RequestOptions request_options,
+                 std::unique_ptr<ArenaAllocator> arena_allocator);
 
   int64_t id_;
+  RequestOptions request_options_;
   HostContext* const host_ = nullptr;
+  // The request arena is destroyed together with the RequestContext, i.e. after
+  // all the executions holding a reference to this request are done.
+  std::unique_ptr<ArenaAllocator> arena_allocator_;
+  HostAllocator* allocator_ = nullptr;
   // Both ResourceContext and ContextData manages data used during the request
   // execution. ResourceContext is more flexible than ContextData at the cost of
   // performance. ResourceContext stores the data keyed by a string name. It
@@ -104,12 +130,6 @@ class RequestContext : public ReferenceCounted<RequestContext> {
   std::atomic<ErrorAsyncValue*> cancel_value_{nullptr};
 };
 
-struct RequestOptions {
-  using RequestPriority = int;
-
-  RequestPriority priority = 0;
-};
-
 // A builder class for RequestContext.
 // Sample usage:
 // auto request_context = RequestContextBuilder(host, resource_context)
@@ -132,6 +152,21 @@ class RequestContextBuilder {
     return std::move(*this);
   }
 
+  // Allocate the BEF executor state and other request-scoped memory from an
+  // arena with blocks of `arena_block_size` bytes. The arena is released when
+  // the RequestContext is destroyed.
+  RequestContextBuilder& enable_arena_allocator(
+      size_t arena_block_size = ArenaAllocator::kDefaultBlockSize) & {
+    arena_block_size_ = arena_block_size;
+    return *this;
+  }
+
+  RequestContextBuilder&& enable_arena_allocator(
+      size_t arena_block_size = ArenaAllocator::kDefaultBlockSize) && {
+    arena_block_size_ = arena_block_size;
+    return std::move(*this);
+  }
+
   int64_t id() const { return id_; }
   HostContext* host() const { return host_; }
   ResourceContext* resource_context() const { return resource_context_; }
@@ -150,6 +185,8 @@ class RequestContextBuilder {
   RequestOptions request_options_;
   ResourceContext* resource_context_ = nullptr;
   RequestContext::ContextData context_data_;
+  // The block size of the request arena, or 0 if the arena is not enabled.
+  size_t arena_block_size_ = 0;
 };
 
 // ExecutionContext holds the context information for kernel and op execution,
@@ -186,8 +223,28 @@ class ExecutionContext {
   // Return the work queue to use for dispatching async tasks.
   ConcurrentWorkQueue& work_queue() const { return *work_queue_; }
 
+  // Set the scheduling policy for ready kernels in BEF functions.
+  void set_kernel_scheduling(KernelScheduling kernel_scheduling) {
+    kernel_scheduling_ = kernel_scheduling;
+  }
+
+  // Return the scheduling policy for ready kernels in BEF functions.
+  KernelScheduling kernel_scheduling() const { return kernel_scheduling_; }
+
+  // Set the profiler that records the kernels executed by BEF functions, or
+  // nullptr to disable profiling.
+  void set_kernel_profiler(KernelProfiler* kernel_profiler) {
+    kernel_profiler_ = kernel_profiler;
+  }
+
+  // Return the kernel profiler, or nullptr if profiling is disabled.
+  KernelProfiler* kernel_profiler() const { return kernel_profiler_; }
+
   RequestContext* request_ctx() const { return request_ctx_.get(); }
 
+  // Return the allocator for request-scoped memory.
+  HostAllocator* allocator() const { return request_ctx_->allocator(); }
+
   ResourceContext* resource_context() const {
     return request_ctx_->resource_context();
   }
@@ -197,6 +254,9 @@ class ExecutionContext {
   // If set, this work queue will be used for running async tasks in the
   // execution. Otherwise, the work queue in HostContext is used.
   ConcurrentWorkQueue* work_queue_ = nullptr;
+  // Defaults to the kernel scheduling policy of the HostContext.
+  KernelScheduling kernel_scheduling_;
+  KernelProfiler* kernel_profiler_ = nullptr;
   Location location_;
 };
 
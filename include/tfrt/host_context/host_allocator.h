@@ -21,10 +21,16 @@
 #ifndef TFRT_HOST_CONTEXT_HOST_ALLOCATOR_H_
 #define TFRT_HOST_CONTEXT_HOST_ALLOCATOR_H_
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 #include "llvm/ADT/ArrayRef.h"
 #include "tfrt/support/forward_decls.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/sharded_counter.h"
+#include "tfrt/support/thread_annotations.h"
 
 namespace tfrt {
 
@@ -74,9 +80,88 @@ class HostAllocator {
 // Create an allocator that just calls malloc/free.
 std::unique_ptr<HostAllocator> CreateMallocAllocator();
 
+// Create an allocator that serves small allocations, e.g. AsyncValues, Chains
+// and kernel frames, from per-thread caches of size-classed chunks, and larger
+// ones with malloc. `num_threads` is the expected number of threads using the
+// allocator. Cached chunks are returned to a shared pool periodically and when
+// their thread exits, and slabs of chunks that are all free are returned to
+// malloc. All memory is released when the allocator is destroyed.
+std::unique_ptr<HostAllocator> CreateThreadCachingAllocator(
+    size_t num_threads = 128);
+
+// Same as above, but obtains slabs and large allocations from `allocator`.
+std::unique_ptr<HostAllocator> CreateThreadCachingAllocator(
+    std::unique_ptr<HostAllocator> allocator, size_t num_threads = 128);
+
 // Create an allocator of fixed size for testing.
 std::unique_ptr<HostAllocator> CreateFixedSizeAllocator(size_t capacity = 1024);
 
+// Allocation statistics of an arena allocator.
+struct ArenaAllocatorStats {
+  // Total number of allocations served by the arena.
+  int64_t num_allocations = 0;
+  // Total number of bytes requested from the arena.
+  int64_t bytes_allocated = 0;
+  // Number of allocations served from the size-class free lists.
+  int64_t num_reused_allocations = 0;
+  // Number of bytes currently obtained from the underlying allocator.
+  int64_t bytes_reserved = 0;
+  // The largest value of bytes_reserved so far.
+  int64_t peak_bytes_reserved = 0;
+};
+
+// A bump-pointer arena allocator for memory that lives as long as one request.
+// Memory is obtained from the underlying allocator in blocks and is returned to
+// it only when the arena is destroyed. Small chunks released early are kept in
+// size-class free lists and reused by later allocations of the same size
+// class. Allocations larger than half of a block bypass the arena. This class
+// is thread-safe.
+class ArenaAllocator : public HostAllocator {
+ public:
+  static constexpr size_t kDefaultBlockSize = 16 * 1024;
+
+  explicit ArenaAllocator(HostAllocator* allocator,
+                          size_t block_size = kDefaultBlockSize);
+  ~ArenaAllocator() override;
+
+  void* AllocateBytes(size_t size, size_t alignment) override;
+  void DeallocateBytes(void* ptr, size_t size) override;
+
+  ArenaAllocatorStats GetStats() const;
+
+ private:
+  // Chunks up to kMaxSizeClassBytes are rounded up to a multiple of
+  // kMinAlignment and recycled through free lists.
+  static constexpr size_t kMinAlignment = 16;
+  static constexpr size_t kMaxSizeClassBytes = 512;
+  static constexpr size_t kNumSizeClasses = kMaxSizeClassBytes / kMinAlignment;
+
+  struct FreeChunk {
+    FreeChunk* next;
+  };
+
+  bool IsLargeAllocation(size_t size) const { return size > block_size_ / 2; }
+
+  void UpdatePeakBytesReserved() TFRT_REQUIRES(mu_) {
+    stats_.peak_bytes_reserved =
+        std::max(stats_.peak_bytes_reserved, stats_.bytes_reserved);
+  }
+
+  HostAllocator* const allocator_;
+  const size_t block_size_;
+  // Bytes reserved by all arenas, exported as a metric.
+  ShardedCounter* const bytes_reserved_;
+
+  mutable mutex mu_;
+  // The current block and the bump pointer within it.
+  char* cursor_ TFRT_GUARDED_BY(mu_) = nullptr;
+  char* limit_ TFRT_GUARDED_BY(mu_) = nullptr;
+  // All blocks obtained from the underlying allocator.
+  std::vector<void*> blocks_ TFRT_GUARDED_BY(mu_);
+  FreeChunk* free_lists_[kNumSizeClasses] TFRT_GUARDED_BY(mu_) = {};
+  ArenaAllocatorStats stats_ TFRT_GUARDED_BY(mu_);
+};
+
 // An RAII-based abstraction that manages an array of objects via HostAllocator.
 template <typename ObjectT>
 class HostArray {
@@ -26,8 +26,10 @@
 #include "llvm/Support/Compiler.h"
 #include "tfrt/host_context/async_value_ref.h"
 #include "tfrt/host_context/device.h"
+#include "tfrt/host_context/execution_context.h"
 #include "tfrt/host_context/host_context_ptr.h"
 #include "tfrt/host_context/kernel_registry.h"
+#include "tfrt/host_context/kernel_scheduling.h"
 #include "tfrt/host_context/timer_queue.h"
 
 namespace tfrt {
@@ -141,6 +143,10 @@ class HostContext {
   // by this context. Returns true only for threads executing non-blocking work.
   bool IsInWorkerThread() const;
 
+  // Returns the index in [0, GetNumWorkerThreads()) of the calling work queue
+  // thread, or -1 if the caller is not a worker thread of this context.
+  int GetWorkerThreadIndex() const;
+
   //===--------------------------------------------------------------------===//
   // Shared context
   //===--------------------------------------------------------------------===//
@@ -168,6 +174,14 @@ class HostContext {
 
   ConcurrentWorkQueue& work_queue() const { return *work_queue_; }
 
+  // Set the default scheduling policy for ready kernels in BEF functions. It
+  // can be overridden per execution through ExecutionContext.
+  void set_kernel_scheduling(KernelScheduling kernel_scheduling) {
+    kernel_scheduling_ = kernel_scheduling;
+  }
+
+  KernelScheduling kernel_scheduling() const { return kernel_scheduling_; }
+
   //===--------------------------------------------------------------------===//
   // TimerQueue
   //===--------------------------------------------------------------------===//
@@ -199,6 +213,7 @@ class HostContext {
   std::function<void(const DecodedDiagnostic&)> diag_handler_;
   std::unique_ptr<HostAllocator> allocator_;
   std::unique_ptr<ConcurrentWorkQueue> work_queue_;
+  KernelScheduling kernel_scheduling_ = KernelScheduling::kStreamTask;
 
   std::unique_ptr<SharedContextManager> shared_context_mgr_;
   TimerQueue timer_queue_;
@@ -0,0 +1,42 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Scheduling policy of the BEF executor
+//
+// This file declares KernelScheduling, the policy the BEF executor uses to
+// schedule ready kernels. The default policy is part of the HostContext
+// configuration and can be overridden per ExecutionContext.
+
+#ifndef TFRT_HOST_CONTEXT_KERNEL_SCHEDULING_H_
+#define TFRT_HOST_CONTEXT_KERNEL_SCHEDULING_H_
+
+namespace tfrt {
+
+// Scheduling policy used by the BEF executor for ready kernels that are
+// assigned to a different stream than the one being executed on the current
+// thread. Stream ids are computed at compile time by the stream analysis.
+enum class KernelScheduling {
+  // Group the ready kernels by stream id and enqueue one task per group to the
+  // work queue.
+  kStreamTask,
+  // Push the ready kernels, grouped into stream runs, to a lock-free list of
+  // the current worker thread. Workers take whole stream runs from their own
+  // list first and steal from the lists of other workers when it is empty, so
+  // enqueueing a kernel does not allocate.
+  kWorkStealing,
+};
+
+}  // namespace tfrt
+
+#endif  // TFRT_HOST_CONTEXT_KERNEL_SCHEDULING_H_
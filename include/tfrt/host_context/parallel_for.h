@@ -22,6 +22,7 @@
 #include <cstddef>
 
 #include "llvm/ADT/FunctionExtras.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
 #include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/host_context/chain.h"
@@ -39,6 +40,19 @@ class ParallelFor {
   explicit ParallelFor(ExecutionContext exec_ctx)
       : exec_ctx_(std::move(exec_ctx)) {}
 
+  //===--------------------------------------------------------------------===//
+  // Cost of processing a single element of a range (similar to the Eigen
+  // TensorOpCost).
+  //===--------------------------------------------------------------------===//
+  struct ElementCost {
+    double bytes_loaded = 0;
+    double bytes_stored = 0;
+    double compute_cycles = 0;
+
+    // Returns the total cost in CPU cycles.
+    double Cycles() const;
+  };
+
   //===--------------------------------------------------------------------===//
   // BlockSizes configures how a range is split into parallely executed blocks.
   //===--------------------------------------------------------------------===//
@@ -48,22 +62,31 @@ class ParallelFor {
     static BlockSizes Fixed(size_t n);
     // Splits range into a block sizes not smaller than `min`.
     static BlockSizes Min(size_t min);
+    // Splits range into blocks based on the cost of processing a single
+    // element: cheap ranges are not split at all, and expensive ranges are
+    // split between the worker threads that are currently idle.
+    static BlockSizes Cost(ElementCost cost);
 
    private:
     friend class ParallelFor;
 
     explicit BlockSizes(llvm::unique_function<size_t(size_t)> impl)
         : impl_(std::move(impl)) {}
+    explicit BlockSizes(ElementCost cost) : cost_(cost) {}
 
-    // Returns a parallel block size for a range of `total_size` and the
-    // specified number of worker threads.
-    size_t GetBlockSize(size_t num_worker_threads, size_t total_size) const;
+    // Returns a parallel block size for a range of `total_size`, the specified
+    // number of worker threads, and the number of them that are busy.
+    size_t GetBlockSize(size_t num_worker_threads, size_t num_busy_threads,
+                        size_t total_size) const;
 
     // Block sizes computation internally represented as a function from the
     // parallel for parameters to the block size. This is an internal detail,
     // a contract between ParallelFor and BlockSizes. Users of ParallelFor
     // must rely only on public static methods to choose block sizes policy.
     mutable llvm::unique_function<size_t(size_t)> impl_;
+
+    // If set, the block size is computed by the cost model instead.
+    llvm::Optional<ElementCost> cost_;
   };
 
   //===--------------------------------------------------------------------===//
@@ -75,6 +98,9 @@ class ParallelFor {
   // `on_done` callback will be called. Uses `block_sizes` to compute the
   // parallel block size.
   //
+  // If the caller is a worker thread and all worker threads are busy (e.g. a
+  // nested parallel for), all blocks are executed in the caller thread.
+  //
   // Example:
   //
   //   AsyncValueRef<Chain> chain = ... allocate chain value ...
@@ -29,6 +29,7 @@
 #include "llvm/ADT/SmallVector.h"
 #include "tfrt/host_context/attribute_utils.h"
 #include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/host_buffer.h"
 #include "tfrt/host_context/host_context.h"
 #include "tfrt/host_context/location.h"
 #include "tfrt/host_context/value.h"
@@ -37,6 +38,18 @@
 
 namespace tfrt {
 
+// SyncBufferAllocator allocates the buffers of the tensors produced by
+// synchronous kernels. The kernel caller can provide one to place these buffers
+// according to a memory plan, see SyncKernelFrame::AllocateBuffer().
+class SyncBufferAllocator {
+ public:
+  virtual ~SyncBufferAllocator() = default;
+
+  // Returns a null RCReference on allocation failure.
+  virtual RCReference<HostBuffer> AllocateBuffer(size_t size,
+                                                 size_t alignment) = 0;
+};
+
 // SyncKernelFrame captures the states associated with a kernel invocation,
 // including the input arguments, attributes, result values, and the execution
 // context. SyncKernelFrame is constructed by the kernel caller (currently only
@@ -132,6 +145,17 @@ class SyncKernelFrame {
   // This should only be called once.
   Error TakeError() { return std::move(error_); }
 
+  // Allocate an uninitialized buffer for a result of the kernel. The buffer is
+  // placed by the SyncBufferAllocator of the kernel caller if there is one, and
+  // allocated with the HostContext allocator otherwise. This returns a null
+  // RCReference on allocation failure.
+  RCReference<HostBuffer> AllocateBuffer(size_t size, size_t alignment) const {
+    if (buffer_allocator_ != nullptr)
+      return buffer_allocator_->AllocateBuffer(size, alignment);
+    return HostBuffer::CreateUninitialized(size, alignment,
+                                           GetHostContext()->allocator());
+  }
+
  protected:
   // `exec_ctx` must out-live the SyncKernelFrame object, as SyncKernelFrame
   // only keeps a reference to `exec_ctx`.
@@ -147,6 +171,7 @@ class SyncKernelFrame {
   const ArrayRef<Value*> registers_;
 
   const ExecutionContext& exec_ctx_;
+  SyncBufferAllocator* buffer_allocator_ = nullptr;
   Error error_ = Error::success();
 };
 
@@ -177,6 +202,10 @@ class SyncKernelFrameBuilder : public SyncKernelFrame {
   void SetResults(ArrayRef<uint32_t> result_indices) {
     result_indices_ = result_indices;
   }
+  // `buffer_allocator` must out-live the SyncKernelFrameBuilder object.
+  void SetBufferAllocator(SyncBufferAllocator* buffer_allocator) {
+    buffer_allocator_ = buffer_allocator;
+  }
 };
 
 // Implementation details
@@ -16,20 +16,30 @@
 
 // Timer Queue
 //
-// This file declares TimerQueue, a priority queue to keep track of pending
-// timers. The queue is keyed by timer deadline (the sooner it expires, the
-// higher the priority). On timer expiration, it calls the associated callback.
+// This file declares TimerQueue, a queue to keep track of pending timers. On
+// timer expiration, it calls the associated callback.
+//
+// Timers are kept in hierarchical timing wheels, so adding and cancelling a
+// timer takes constant time. The wheels are sharded by the thread that adds
+// the timer, to reduce lock contention when many threads add timers. Deadlines
+// are rounded up to a multiple of a configurable tick, so a timer never expires
+// early, but may expire up to one tick late.
 
 #ifndef TFRT_HOST_CONTEXT_TIMER_QUEUE_H_
 #define TFRT_HOST_CONTEXT_TIMER_QUEUE_H_
 
+#include <array>
+#include <atomic>
 #include <chrono>
-#include <queue>
+#include <cstdint>
+#include <memory>
 #include <thread>
+#include <vector>
 
 #include "llvm/ADT/FunctionExtras.h"
 #include "tfrt/support/mutex.h"
 #include "tfrt/support/ref_count.h"
+#include "tfrt/support/thread_annotations.h"
 
 namespace tfrt {
 
@@ -45,8 +55,19 @@ class TimerQueue {
  public:
   using TimerHandle = RCReference<TimerEntry>;
 
+  struct Options {
+    // Granularity of the timer deadlines. A coarser tick makes the timer
+    // thread wake up less often, e.g. for request deadlines.
+    TimeDuration tick = std::chrono::milliseconds(1);
+
+    // Number of independently locked timing wheels. If 0, one shard per
+    // hardware thread is used.
+    int num_shards = 0;
+  };
+
   // On creation, starts the timer thread for TimerQueue monitoring.
-  TimerQueue();
+  TimerQueue() : TimerQueue(Options()) {}
+  explicit TimerQueue(Options options);
   // On destruction, cancel every timer in the queue.
   ~TimerQueue();
 
@@ -58,7 +79,14 @@ class TimerQueue {
 
   void CancelTimer(const TimerHandle& timer_handle);
 
+  // Returns the number of timers that are neither expired nor cancelled.
+  int64_t num_pending_timers() const {
+    return num_timers_.load(std::memory_order_relaxed);
+  }
+
  private:
+  struct Shard;
+
   // A reference counted timer, which has a deadline and a callback function.
   class TimerEntry : public ReferenceCounted<TimerEntry> {
    public:
@@ -71,34 +99,88 @@ class TimerQueue {
       return MakeRef<TimerEntry>(deadline, std::move(timer_callback));
     }
 
-    struct TimerEntryCompare {
-      bool operator()(const RCReference<TimerEntry>& a,
-                      const RCReference<TimerEntry>& b) const {
-        return a->deadline_ > b->deadline_;
-      }
-    };
-
    private:
     friend class TimerQueue;
     TimePoint deadline_;
     TimerCallback timer_callback_;
     std::atomic<bool> cancelled_{false};
+
+    // The tick at which the timer expires, and the wheel level and slot it is
+    // in.
+    uint64_t expiry_tick_ = 0;
+    int level_ = 0;
+    int slot_ = 0;
+    // The shard that owns the timer, never changes after scheduling.
+    Shard* shard_ = nullptr;
+    // Intrusive list of the timers in one wheel slot, guarded by the shard
+    // mutex. `pprev_` is null if the timer is not in a wheel. A timer in a
+    // wheel holds a reference to itself.
+    TimerEntry* next_ = nullptr;
+    TimerEntry** pprev_ = nullptr;
   };
+
+  // Hierarchical timing wheels: level `l` has kSlots slots of kSlots^l ticks
+  // each, so the wheels cover kSlots^kLevels ticks ahead. Timers further in the
+  // future are parked in the last slot and re-inserted when it cascades.
+  static constexpr int kLevelBits = 8;
+  static constexpr int kSlots = 1 << kLevelBits;
+  static constexpr int kLevels = 4;
+  static constexpr int kSlotWords = kSlots / 64;
+
+  struct Shard {
+    mutex mu;
+    // All timers with expiry ticks up to `current_tick` have expired.
+    uint64_t current_tick TFRT_GUARDED_BY(mu) = 0;
+    int64_t num_timers TFRT_GUARDED_BY(mu) = 0;
+    std::array<int64_t, kLevels> level_sizes TFRT_GUARDED_BY(mu) = {};
+    std::array<std::array<TimerEntry*, kSlots>, kLevels> wheels
+        TFRT_GUARDED_BY(mu) = {};
+    // Bitmap of the non-empty slots of the level 0 wheel.
+    std::array<uint64_t, kSlotWords> level0_occupied TFRT_GUARDED_BY(mu) = {};
+  };
+
   // Timer thread. If a timeout goes off, it calls the callback.
   void TimerThreadRun();
 
-  // Obtain the top timer (timer with the closest deadline) from the queue.
-  // Returns NULL if no active (not cancelled) timer found.
-  TimerEntry* getTopTimer();
+  // Returns the tick of `time`, rounded up.
+  uint64_t ToTick(TimePoint time) const;
+
+  // Expires all timers of `shard` up to tick `tick`, and runs their callbacks.
+  void AdvanceShard(Shard* shard, uint64_t tick);
+
+  // Returns the first non-empty slot of the level 0 wheel at or after `slot`,
+  // wrapping around, or -1 if the wheel is empty.
+  static int NextOccupiedSlot(const Shard& shard, int slot)
+      TFRT_REQUIRES(shard.mu);
+  // Returns the next tick at which the timer thread has to advance `shard`.
+  static uint64_t NextEventTick(const Shard& shard) TFRT_REQUIRES(shard.mu);
+  // Returns the next tick at which the timer thread has to advance any shard.
+  uint64_t NextEventTick() const;
+
+  // Links the timer into the wheel slot for its expiry tick.
+  static void Insert(Shard* shard, TimerEntry* timer) TFRT_REQUIRES(shard->mu);
+  // Unlinks the timer from its wheel slot.
+  static void Unlink(TimerEntry* timer);
+  // Re-inserts all timers from the slot `slot` of the wheel `level` into lower
+  // levels.
+  static void Cascade(Shard* shard, int level, int slot)
+      TFRT_REQUIRES(shard->mu);
+
+  const TimeDuration tick_;
+  const TimePoint start_;
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<int64_t> num_timers_{0};
+
+  // The tick the timer thread sleeps until. Threads adding a timer that
+  // expires earlier wake it up.
+  std::atomic<uint64_t> next_wakeup_tick_{0};
 
   mutable mutex mu_;
   condition_variable cv_;
+  bool woken_ TFRT_GUARDED_BY(mu_) = false;
   std::thread timer_thread_;
   std::atomic<bool> stop_{false};
-  std::priority_queue<RCReference<TimerEntry>,
-                      std::vector<RCReference<TimerEntry>>,
-                      TimerEntry::TimerEntryCompare>
-      timers_ TFRT_GUARDED_BY(mu_);
 };
 
 }  // namespace tfrt
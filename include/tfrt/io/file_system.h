@@ -21,7 +21,9 @@
 
 #include "llvm/ADT/StringMap.h"
 #include "tfrt/support/error_util.h"
+#include "tfrt/support/forward_decls.h"
 #include "tfrt/support/mutex.h"
+#include "tfrt/support/ref_count.h"
 #include "tfrt/support/thread_annotations.h"
 
 namespace tfrt {
@@ -53,6 +55,19 @@ class RandomAccessFile {
                                       size_t offset) const = 0;
 };
 
+// An interface to the read-only contents of a file that have been mapped into
+// memory. The mapping stays valid until the last reference is dropped, so views
+// into data() can be handed out as long as they hold a reference to this file.
+class MemoryMappedFile : public ReferenceCounted<MemoryMappedFile> {
+ public:
+  explicit MemoryMappedFile() {}
+
+  virtual ~MemoryMappedFile() {}
+
+  // Returns the contents of the whole file.
+  virtual string_view data() const = 0;
+};
+
 // An interface that declares operations to manage files in a file system.
 class FileSystem {
  public:
@@ -68,6 +83,18 @@ class FileSystem {
   virtual llvm::Error NewRandomAccessFile(
       const std::string& path, std::unique_ptr<RandomAccessFile>* file) = 0;
 
+  // Maps the file at the given `path` into memory for reading.
+  //
+  // On success, stores a reference to the mapped file in `file` and returns
+  // llvm::Error::success(). Otherwise, stores NULL in `file` and returns the
+  // error. The default implementation returns an error, in which case callers
+  // should fall back to NewRandomAccessFile().
+  virtual llvm::Error NewMemoryMappedFile(const std::string& path,
+                                          RCReference<MemoryMappedFile>* file) {
+    file->reset();
+    return MakeStringError("memory mapped files are not supported");
+  }
+
   // Returns the priority of this file system. The file system with the highest
   // priority will be used if multiple file systems have been registered for the
   // same scheme.
@@ -33,6 +33,186 @@ inline void AddTFRTVersionMetric() {
   (void)version_metric;
 }
 
+// Built-in runtime metrics. They are created on first use, so they are only
+// exported if the metrics registry is registered before that.
+
+// Latency of BEF kernel executions in microseconds. The BEF executor samples a
+// fraction of the kernel executions to keep the overhead low.
+inline Histogram* GetKernelLatencyHistogram() {
+  static auto* histogram =
+      NewHistogram("/tensorflow/runtime/bef_executor/kernel_latency_us",
+                   Buckets::Exponential(/*scale=*/1, /*growth_factor=*/2,
+                                        /*bucket_count=*/24));
+  return histogram;
+}
+
+// Number of tasks in the worker queue a non-blocking task is added to,
+// including the added task. Only a random sample of the added tasks is
+// recorded.
+inline Histogram* GetWorkQueueDepthHistogram() {
+  static auto* histogram =
+      NewHistogram("/tensorflow/runtime/work_queue/depth",
+                   Buckets::Exponential(/*scale=*/1, /*growth_factor=*/2,
+                                        /*bucket_count=*/12));
+  return histogram;
+}
+
+// Number of tasks pushed into the overflow list of a full work queue.
+inline Counter* GetWorkQueueOverflowCounter() {
+  static auto* counter = NewCounter("/tensorflow/runtime/work_queue/overflows");
+  return counter;
+}
+
+// Number of work queue spin loops that found a task before parking the thread.
+inline Counter* GetWorkQueueSpinHitsCounter() {
+  static auto* counter = NewCounter("/tensorflow/runtime/work_queue/spin_hits");
+  return counter;
+}
+
+// Number of times a work queue thread parked waiting for new tasks.
+inline Counter* GetWorkQueueParksCounter() {
+  static auto* counter = NewCounter("/tensorflow/runtime/work_queue/parks");
+  return counter;
+}
+
+// Number of parked work queue threads woken up by new tasks.
+inline Counter* GetWorkQueueWakeupsCounter() {
+  static auto* counter = NewCounter("/tensorflow/runtime/work_queue/wakeups");
+  return counter;
+}
+
+// Time to compile a cpurt kernel in milliseconds.
+inline Histogram* GetCpurtCompileTimeHistogram() {
+  static auto* histogram =
+      NewHistogram("/tensorflow/runtime/cpurt/compile_time_ms",
+                   Buckets::Exponential(/*scale=*/1, /*growth_factor=*/2,
+                                        /*bucket_count=*/16));
+  return histogram;
+}
+
+// Number of cpurt specialized executable lookups that found a cached
+// executable.
+inline Counter* GetCpurtSpecializationCacheHitsCounter() {
+  static auto* counter =
+      NewCounter("/tensorflow/runtime/cpurt/specialization_cache/hits");
+  return counter;
+}
+
+// Number of cpurt specialized executable lookups that required a compilation.
+inline Counter* GetCpurtSpecializationCacheMissesCounter() {
+  static auto* counter =
+      NewCounter("/tensorflow/runtime/cpurt/specialization_cache/misses");
+  return counter;
+}
+
+// Number of cpurt specialized executables evicted from the bounded cache.
+inline Counter* GetCpurtSpecializationCacheEvictionsCounter() {
+  static auto* counter =
+      NewCounter("/tensorflow/runtime/cpurt/specialization_cache/evictions");
+  return counter;
+}
+
+// Number of bytes currently allocated by the users of each kind of
+// HostAllocator. Allocators are often stacked (e.g. an arena on top of a
+// thread-caching allocator on top of malloc), so each kind is reported
+// separately rather than summed.
+inline ShardedCounter* GetMallocAllocatorBytesInUse() {
+  static auto* counter =
+      NewShardedGauge("/tensorflow/runtime/host_allocator/malloc/bytes_in_use");
+  return counter;
+}
+
+inline ShardedCounter* GetThreadCachingAllocatorBytesInUse() {
+  static auto* counter = NewShardedGauge(
+      "/tensorflow/runtime/host_allocator/thread_caching/bytes_in_use");
+  return counter;
+}
+
+inline ShardedCounter* GetProfiledAllocatorBytesInUse() {
+  static auto* counter = NewShardedGauge(
+      "/tensorflow/runtime/host_allocator/profiled/bytes_in_use");
+  return counter;
+}
+
+// Number of bytes that all arena allocators currently obtained from their
+// underlying allocators.
+inline ShardedCounter* GetArenaAllocatorBytesReserved() {
+  static auto* counter = NewShardedGauge(
+      "/tensorflow/runtime/host_allocator/arena/bytes_reserved");
+  return counter;
+}
+
+// Number of bytes requested from the arena allocator of a request, recorded
+// when the request finishes.
+inline Histogram* GetRequestArenaBytesAllocatedHistogram() {
+  static auto* histogram =
+      NewHistogram("/tensorflow/runtime/request_arena/bytes_allocated",
+                   Buckets::Exponential(/*scale=*/1024, /*growth_factor=*/2,
+                                        /*bucket_count=*/20));
+  return histogram;
+}
+
+// Largest number of bytes the arena allocator of a request held at once,
+// recorded when the request finishes. Compared with the bytes allocated, this
+// shows how much of the arena blocks is wasted.
+inline Histogram* GetRequestArenaPeakBytesReservedHistogram() {
+  static auto* histogram =
+      NewHistogram("/tensorflow/runtime/request_arena/peak_bytes_reserved",
+                   Buckets::Exponential(/*scale=*/1024, /*growth_factor=*/2,
+                                        /*bucket_count=*/20));
+  return histogram;
+}
+
+// Number of CoreRuntime op lookups served from the op dispatch cache.
+inline Counter* GetOpDispatchCacheHitsCounter() {
+  static auto* counter =
+      NewCounter("/tensorflow/runtime/core_runtime/op_cache/hits");
+  return counter;
+}
+
+// Number of CoreRuntime op lookups that had to make a new op.
+inline Counter* GetOpDispatchCacheMissesCounter() {
+  static auto* counter =
+      NewCounter("/tensorflow/runtime/core_runtime/op_cache/misses");
+  return counter;
+}
+
+// Number of op metadata function executions served from the metadata cache.
+inline Counter* GetOpMetadataCacheHitsCounter() {
+  static auto* counter =
+      NewCounter("/tensorflow/runtime/core_runtime/metadata_cache/hits");
+  return counter;
+}
+
+// Number of op metadata function executions not found in the metadata cache.
+inline Counter* GetOpMetadataCacheMissesCounter() {
+  static auto* counter =
+      NewCounter("/tensorflow/runtime/core_runtime/metadata_cache/misses");
+  return counter;
+}
+
+// Number of CPU op outputs that reuse the buffer of an input.
+inline Counter* GetCpuForwardedBuffersCounter() {
+  static auto* counter =
+      NewCounter("/tensorflow/runtime/cpu/buffer_forwarding/forwarded");
+  return counter;
+}
+
+// Number of bytes CPU ops did not allocate because an input was forwarded.
+inline Counter* GetCpuForwardedBytesCounter() {
+  static auto* counter =
+      NewCounter("/tensorflow/runtime/cpu/buffer_forwarding/forwarded_bytes");
+  return counter;
+}
+
+// Number of CPU op outputs that could have reused the buffer of an input, but
+// had to be allocated because no input was compatible or uniquely owned.
+inline Counter* GetCpuAllocatedBuffersCounter() {
+  static auto* counter =
+      NewCounter("/tensorflow/runtime/cpu/buffer_forwarding/allocated");
+  return counter;
+}
+
 }  // namespace metrics
 }  // namespace tfrt
 
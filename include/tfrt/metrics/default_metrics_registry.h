@@ -0,0 +1,85 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares DefaultMetricsRegistry, an in-process MetricsRegistry
+// implementation that can render its metrics in the Prometheus text format.
+
+#ifndef TFRT_METRICS_DEFAULT_METRICS_REGISTRY_H_
+#define TFRT_METRICS_DEFAULT_METRICS_REGISTRY_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "llvm/Support/raw_ostream.h"
+#include "tfrt/metrics/metrics_registry.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace metrics {
+
+// DefaultMetricsRegistry keeps all metric values in memory. Counters and
+// histograms are sharded by thread, so recording a value only touches atomics
+// that are unlikely to be shared with other threads and never takes a lock.
+// Creating a metric with the name of an existing metric of the same kind
+// returns the existing metric.
+//
+// Example:
+//
+//   auto* registry = RegisterDefaultMetricsRegistry();
+//   ...
+//   registry->WritePrometheusText(tfrt::outs());
+class DefaultMetricsRegistry : public MetricsRegistry {
+ public:
+  // The base class of the metrics owned by the registry.
+  class Metric;
+
+  DefaultMetricsRegistry();
+  ~DefaultMetricsRegistry() override;
+
+  Gauge<std::string>* NewStringGauge(std::string name) override;
+  Gauge<int64_t>* NewIntGauge(std::string name) override;
+  // If a metric named `name` already exists, `callback` is ignored.
+  void NewIntGaugeCallback(std::string name,
+                           std::function<int64_t()> callback) override;
+  Counter* NewCounter(std::string name) override;
+  Histogram* NewHistogram(std::string name, const Buckets& buckets) override;
+
+  // Writes a snapshot of all metrics in the Prometheus text exposition format.
+  // Metric names are converted to valid Prometheus names, e.g.
+  // "/tensorflow/runtime/version" becomes "tensorflow_runtime_version".
+  void WritePrometheusText(raw_ostream& os) const;
+
+ private:
+  template <typename T, typename... Args>
+  T* GetOrCreate(std::string name, Args&&... args);
+
+  mutable mutex mu_;
+  // Metrics sorted by their Prometheus name.
+  std::map<std::string, std::unique_ptr<Metric>> metrics_ TFRT_GUARDED_BY(mu_);
+};
+
+// Creates a DefaultMetricsRegistry and registers it as the global metrics
+// registry. This must be called before any metric is created, and at most once.
+DefaultMetricsRegistry* RegisterDefaultMetricsRegistry();
+
+}  // namespace metrics
+}  // namespace tfrt
+
+#endif  // TFRT_METRICS_DEFAULT_METRICS_REGISTRY_H_
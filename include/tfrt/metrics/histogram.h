@@ -20,6 +20,7 @@
 #define TFRT_METRICS_HISTOGRAM_H_
 
 #include <cassert>
+#include <cmath>
 #include <vector>
 
 namespace tfrt {
@@ -40,6 +41,20 @@ class Buckets {
     return Buckets(std::move(bounds));
   }
 
+  // Returns a Buckets whose `bucket_count` lower bounds (except for the
+  // underflow bucket) are `scale * growth_factor^i` for i in [0, bucket_count).
+  //
+  // REQUIRES: scale > 0, growth_factor > 1 and bucket_count > 0.
+  static Buckets Exponential(double scale, double growth_factor,
+                             int bucket_count) {
+    assert(scale > 0 && growth_factor > 1 && bucket_count > 0);
+    std::vector<double> bounds;
+    bounds.reserve(bucket_count);
+    for (int i = 0; i < bucket_count; ++i)
+      bounds.push_back(scale * std::pow(growth_factor, i));
+    return Buckets(std::move(bounds));
+  }
+
   const std::vector<double>& explicit_bounds() const { return bounds_; }
 
  private:
@@ -19,10 +19,14 @@
 #ifndef TFRT_METRICS_METRICS_H_
 #define TFRT_METRICS_METRICS_H_
 
+#include <cstdint>
+#include <functional>
 #include <string>
 
+#include "counter.h"
 #include "gauge.h"
 #include "histogram.h"
+#include "tfrt/support/sharded_counter.h"
 
 namespace tfrt {
 namespace metrics {
@@ -37,6 +41,24 @@ Gauge<T>* NewGauge(std::string name);
 template <>
 Gauge<std::string>* NewGauge(std::string name);
 
+template <>
+Gauge<int64_t>* NewGauge(std::string name);
+
+// Registers a gauge whose value is computed by `callback` when the metrics are
+// exported. `callback` must be thread-safe and must not create metrics.
+void NewGaugeCallback(std::string name, std::function<int64_t()> callback);
+
+// Returns a counter that is exported as a gauge of its sum. Unlike setting a
+// Gauge, updating it is cheap enough for the hot paths of many threads, and
+// the exported value never lags behind the updates.
+ShardedCounter* NewShardedGauge(std::string name);
+
+//===----------------------------------------------------------------------===//
+// Methods to create Counter metrics
+//===----------------------------------------------------------------------===//
+
+Counter* NewCounter(std::string name);
+
 //===----------------------------------------------------------------------===//
 // Methods to create Histogram metrics
 //===----------------------------------------------------------------------===//
@@ -19,8 +19,11 @@
 #ifndef TFRT_METRICS_METRICS_REGISTRY_H_
 #define TFRT_METRICS_METRICS_REGISTRY_H_
 
+#include <cstdint>
+#include <functional>
 #include <string>
 
+#include "counter.h"
 #include "gauge.h"
 #include "histogram.h"
 
@@ -34,6 +37,17 @@ class MetricsRegistry {
   virtual Gauge<std::string>* NewStringGauge(std::string name) = 0;
 
   virtual Histogram* NewHistogram(std::string name, const Buckets& buckets) = 0;
+
+  // Registries that do not support these metric types can return nullptr, in
+  // which case the recorded values are discarded.
+  virtual Gauge<int64_t>* NewIntGauge(std::string name) { return nullptr; }
+
+  virtual Counter* NewCounter(std::string name) { return nullptr; }
+
+  // Registers an int64_t gauge whose value is computed by `callback` each time
+  // the metrics are exported. Registries that do not support it can ignore it.
+  virtual void NewIntGaugeCallback(std::string name,
+                                   std::function<int64_t()> callback) {}
 };
 
 namespace internal {
@@ -45,6 +59,12 @@ extern MetricsRegistry* kMetricsRegistry;
 // time.
 void RegisterMetricsRegistry(MetricsRegistry* metrics_registry);
 
+// Returns true if a metrics registry is registered, i.e. if the recorded
+// metrics are exported. Hot paths can skip measuring discarded metrics.
+inline bool IsMetricsRegistryRegistered() {
+  return internal::kMetricsRegistry != nullptr;
+}
+
 }  // namespace metrics
 }  // namespace tfrt
 
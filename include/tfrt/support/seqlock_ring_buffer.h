@@ -0,0 +1,116 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Ring buffer that one thread appends to while other threads read it.
+
+#ifndef TFRT_SUPPORT_SEQLOCK_RING_BUFFER_H_
+#define TFRT_SUPPORT_SEQLOCK_RING_BUFFER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "llvm/Support/MathExtras.h"
+
+namespace tfrt {
+
+// Single-producer ring buffer of fixed size events, which keeps the most recent
+// events and overwrites the oldest ones. Each slot is guarded by a seqlock: the
+// producer makes the sequence number of the slot odd while it writes the event,
+// and the readers copy the event with relaxed atomic loads and only keep it if
+// the sequence number did not change. Appending never blocks or allocates.
+template <typename T>
+class SeqlockRingBuffer {
+  static_assert(std::is_trivially_copyable<T>::value &&
+                    sizeof(T) % sizeof(uint64_t) == 0,
+                "Events are copied as uint64_t words");
+
+ public:
+  // The capacity is rounded up to a power of two.
+  explicit SeqlockRingBuffer(size_t capacity)
+      : mask_(llvm::PowerOf2Ceil(std::max<size_t>(capacity, 1)) - 1),
+        slots_(new Slot[mask_ + 1]) {}
+
+  // Must only be called by the producer thread.
+  void Append(const T& event) {
+    uint64_t words[kWordsPerEvent];
+    std::memcpy(words, &event, sizeof(event));
+
+    uint64_t index = head_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[index & mask_];
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWordsPerEvent; ++i)
+      slot.words[i].store(words[i], std::memory_order_relaxed);
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+    head_.store(index + 1, std::memory_order_release);
+  }
+
+  // Appends the events that are currently in the buffer to `events`, oldest
+  // first. Events which the producer overwrites meanwhile are dropped.
+  void Collect(std::vector<T>* events) const {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t begin = std::max(FirstKept(head), tail_.load());
+    for (uint64_t index = begin; index < head; ++index) {
+      const Slot& slot = slots_[index & mask_];
+      uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+      if (sequence != 2 * index + 2) continue;
+      uint64_t words[kWordsPerEvent];
+      for (size_t i = 0; i < kWordsPerEvent; ++i)
+        words[i] = slot.words[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) != sequence) continue;
+      events->emplace_back();
+      std::memcpy(&events->back(), words, sizeof(T));
+    }
+  }
+
+  // Drops the events appended so far from later Collect() calls.
+  void Clear() { tail_.store(head_.load(std::memory_order_acquire)); }
+
+  // Returns the number of events that were overwritten by newer ones.
+  uint64_t num_overwritten() const {
+    return FirstKept(head_.load(std::memory_order_relaxed));
+  }
+
+ private:
+  static constexpr size_t kWordsPerEvent = sizeof(T) / sizeof(uint64_t);
+
+  struct Slot {
+    // 2 * index + 1 while the event of `index` is written, and 2 * index + 2
+    // once it is complete.
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<uint64_t> words[kWordsPerEvent];
+  };
+
+  // Returns the index of the oldest event that is not overwritten.
+  uint64_t FirstKept(uint64_t head) const {
+    return head > mask_ ? head - mask_ - 1 : 0;
+  }
+
+  const uint64_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+  // Number of events appended so far.
+  std::atomic<uint64_t> head_{0};
+  // Number of events appended before the last Clear().
+  std::atomic<uint64_t> tail_{0};
+};
+
+}  // namespace tfrt
+
+#endif  // TFRT_SUPPORT_SEQLOCK_RING_BUFFER_H_
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Integer counter that is cheap to update from many threads concurrently.
+
+#ifndef TFRT_SUPPORT_SHARDED_COUNTER_H_
+#define TFRT_SUPPORT_SHARDED_COUNTER_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace tfrt {
+
+// A ShardedCounter keeps a sum of int64_t deltas, which can be negative. Each
+// thread adds to one of a fixed number of shards that live on their own cache
+// lines, so concurrent updates rarely contend. Reading the value sums all the
+// shards, which is much slower than an update.
+class ShardedCounter {
+ public:
+  void Add(int64_t delta) {
+    shards_[ShardIndex()].value.fetch_add(delta, std::memory_order_relaxed);
+  }
+
+  // Returns the sum of the deltas added so far. Deltas added concurrently may
+  // or may not be included.
+  int64_t Sum() const {
+    int64_t sum = 0;
+    for (const Shard& shard : shards_)
+      sum += shard.value.load(std::memory_order_relaxed);
+    return sum;
+  }
+
+  static constexpr int kNumShards = 16;
+
+  // Returns the shard of the calling thread. Other per-thread sharded state can
+  // use it to share the shard assignment of the counters.
+  static int ShardIndex() {
+    static std::atomic<int> next_shard_index{0};
+    static thread_local int shard_index =
+        next_shard_index.fetch_add(1, std::memory_order_relaxed) % kNumShards;
+    return shard_index;
+  }
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic<int64_t> value{0};
+  };
+
+  Shard shards_[kNumShards];
+};
+
+}  // namespace tfrt
+
+#endif  // TFRT_SUPPORT_SHARDED_COUNTER_H_
@@ -44,6 +44,9 @@ class DenseHostTensor final : public HostTensor,
   DenseHostTensor(DenseHostTensor&& other) = default;
   DenseHostTensor& operator=(DenseHostTensor&& other) = default;
 
+  // Return the alignment of the body of a DenseHostTensor of `dtype`.
+  static size_t GetBufferAlignment(DType dtype);
+
   // Allocate a DenseHostTensor with an uninitialized body.  This returns None
   // on allocation failure.
   static llvm::Optional<DenseHostTensor> CreateUninitialized(
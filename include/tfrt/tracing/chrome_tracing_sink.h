@@ -0,0 +1,55 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Chrome trace event tracing sink
+//
+// This file declares the functions to retrieve the activities recorded by the
+// Chrome tracing sink. Linking the `chrome_tracing_sink` target registers the
+// sink.
+//
+// Activities are recorded into fixed-size per-thread ring buffers without
+// locking. When a buffer is full, the oldest activities of that thread are
+// overwritten. The recorded activities can be serialized at any time in the
+// Chrome trace event JSON format, which can be loaded in chrome://tracing or
+// https://ui.perfetto.dev.
+//
+// If the TFRT_CHROME_TRACE_FILE environment variable is set, the trace is also
+// written to that file whenever tracing is disabled.
+
+#ifndef TFRT_TRACING_CHROME_TRACING_SINK_H_
+#define TFRT_TRACING_CHROME_TRACING_SINK_H_
+
+#include "llvm/Support/Error.h"
+#include "llvm/Support/raw_ostream.h"
+#include "tfrt/support/forward_decls.h"
+
+namespace tfrt {
+namespace tracing {
+
+// Writes the activities recorded so far as Chrome trace event JSON. Activities
+// may still be recorded concurrently; those are either included or skipped.
+void WriteChromeTrace(raw_ostream& os);
+
+// Writes the activities recorded so far to the file at `path`.
+Error WriteChromeTraceToFile(string_view path);
+
+// Discards all activities recorded so far.
+void ClearChromeTrace();
+
+}  // namespace tracing
+}  // namespace tfrt
+
+#endif  // TFRT_TRACING_CHROME_TRACING_SINK_H_
@@ -97,6 +97,9 @@ class KernelRunner {
     return results_[index]->get<T>();
   }
 
+  // Returns the result at `index`, which is an error if the kernel failed.
+  AsyncValue* GetAsyncValueAt(int index) { return results_[index].get(); }
+
   template <typename T, typename... Args>
   KernelRunner& AddRequestContextData(Args&&... args) {
     assert(!req_ctx_ &&
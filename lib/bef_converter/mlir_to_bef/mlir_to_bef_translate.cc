@@ -19,8 +19,10 @@
 // line and converts it to a bef file at specified location.
 #include "llvm/Support/CommandLine.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "mlir/Pass/PassManager.h"
 #include "tfrt/bef/bef_buffer.h"
 #include "tfrt/bef_converter/mlir_to_bef.h"
+#include "tfrt/compiler/fuse_cwise_ops_pass.h"
 
 static llvm::cl::opt<bool> disable_optional_sections(  // NOLINT
     "disable-optional-sections",
@@ -28,10 +30,22 @@ static llvm::cl::opt<bool> disable_optional_sections(  // NOLINT
                    "types and attribute names."),
     llvm::cl::init(false));
 
+static llvm::cl::opt<bool> fuse_cwise_ops(  // NOLINT
+    "fuse-cwise-ops",
+    llvm::cl::desc("Fuse chains of coefficient wise corert.executeop ops into "
+                   "tf._FusedCwise ops before the conversion."),
+    llvm::cl::init(false));
+
 namespace tfrt {
 
 mlir::LogicalResult MLIRToBEFTranslate(mlir::ModuleOp module,
                                        llvm::raw_ostream& output) {
+  if (fuse_cwise_ops) {
+    mlir::PassManager pm(module.getContext());
+    pm.addNestedPass<mlir::FuncOp>(compiler::CreateFuseCwiseOpsPass());
+    if (mlir::failed(pm.run(module))) return mlir::failure();
+  }
+
   BefBuffer bef_file =
       tfrt::ConvertMLIRToBEF(module, disable_optional_sections);
   if (bef_file.empty()) return mlir::failure();
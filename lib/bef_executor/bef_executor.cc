@@ -16,6 +16,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
 
@@ -24,11 +25,16 @@
 #include "llvm/ADT/SmallVector.h"
 #include "tfrt/bef/bef_encoding.h"
 #include "tfrt/bef/bef_reader.h"
+#include "tfrt/bef_executor/kernel_profiler.h"
 #include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/host_context/async_value.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
 #include "tfrt/host_context/host_context.h"
 #include "tfrt/host_context/kernel_frame.h"
+#include "tfrt/host_context/kernel_scheduling.h"
 #include "tfrt/host_context/location.h"
+#include "tfrt/metrics/common_metrics.h"
+#include "tfrt/metrics/metrics_registry.h"
 #include "tfrt/support/forward_decls.h"
 #include "tfrt/support/ref_count.h"
 #include "tfrt/tracing/tracing.h"
@@ -87,6 +93,14 @@ llvm::ArrayRef<unsigned> GetNextUsedBys(const BEFKernel& kernel,
   return used_bys;
 }
 
+// Returns true for one in kKernelLatencySamplingPeriod kernel executions on the
+// calling thread, which are timed for the kernel latency metric.
+constexpr uint32_t kKernelLatencySamplingPeriod = 64;
+LLVM_ATTRIBUTE_ALWAYS_INLINE bool SampleKernelLatency() {
+  static thread_local uint32_t num_kernels = 0;
+  return ++num_kernels % kKernelLatencySamplingPeriod == 0;
+}
+
 // ReadyKernelQueue is used for managing ready-to-run kernels in one sequential
 // path.
 class ReadyKernelQueue {
@@ -144,6 +158,8 @@ class ReadyKernelQueue {
       assert(ready_count.load() > 0);
       if (ready_count.load(std::memory_order_acquire) == 1 ||
           ready_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        if (!ready_infos_.empty())
+          ready_infos_[kernel_id] = KernelProfiler::MakeReadyInfo(producer_id_);
         if (kernel_info.stream_id == stream_id_) {
           inline_kernel_ids_.push_back(kernel_id);
         } else {
@@ -167,9 +183,27 @@ class ReadyKernelQueue {
   // The stream id for this sequence.
   int stream_id() const { return stream_id_; }
 
+  // Reuse this empty queue for a sequence with `stream_id`.
+  void set_stream_id(int stream_id) {
+    assert(inline_kernel_ids_.empty() && outline_kernel_ids_.empty());
+    stream_id_ = stream_id;
+  }
+
+  // Record when and by which kernel each kernel becomes ready into
+  // `ready_infos`. Only used when kernel profiling is enabled.
+  void set_ready_infos(MutableArrayRef<KernelProfiler::ReadyInfo> ready_infos) {
+    ready_infos_ = ready_infos;
+  }
+
+  // The kernel whose results are being processed.
+  unsigned producer_id() const { return producer_id_; }
+  void set_producer_id(unsigned producer_id) { producer_id_ = producer_id; }
+
  private:
   int stream_id_;
   MutableArrayRef<BEFFileImpl::KernelInfo> kernel_array_;
+  MutableArrayRef<KernelProfiler::ReadyInfo> ready_infos_;
+  unsigned producer_id_ = 0;
 
   std::vector<unsigned> inline_kernel_ids_;
   std::vector<unsigned> outline_kernel_ids_;
@@ -187,12 +221,15 @@ class BEFExecutor final : public ReferenceCounted<BEFExecutor> {
                       MutableArrayRef<RCReference<AsyncValue>> results);
 
   /// When the last reference to the BEFExecutor is dropped, we deallocate
-  /// ourself.  The memory for this class is managed through the HostAllocator
-  /// managed by the HostContext.
+  /// ourself.  The memory for this class is managed through the request-scoped
+  /// HostAllocator of the ExecutionContext.
   void Destroy() {
-    auto host = this->GetHost();
+    // Keep the request alive until we are deallocated, as the allocator might
+    // be the request arena.
+    RCReference<RequestContext> request_ctx = FormRef(exec_ctx_.request_ctx());
+    HostAllocator* allocator = exec_ctx_.allocator();
     this->~BEFExecutor();
-    host->Deallocate<BEFExecutor>(this);
+    allocator->Deallocate<BEFExecutor>(this);
   }
 
  private:
@@ -231,6 +268,39 @@ class BEFExecutor final : public ReferenceCounted<BEFExecutor> {
   // executed in a dfferent thread in parallel.
   void EnqueueReadyKernels(std::vector<unsigned>& kernel_ids);
 
+  // A list of stealable ready kernels, encoded as kernel id + 1 (0 means the
+  // list is empty). Kernels are only ever removed by exchanging the whole
+  // list, so the list does not suffer from ABA. Lists are padded to a cache
+  // line so that workers pushing to their own lists do not contend.
+  struct alignas(64) StealableList {
+    std::atomic<unsigned> head{0};
+  };
+
+  // Returns the list of stealable ready kernels of the calling thread.
+  StealableList& ThisThreadStealableList();
+
+  // Push `kernel_ids` to the calling thread's list of stealable ready kernels,
+  // and make sure there are enough stealer tasks in the work queue to process
+  // them. Used with KernelScheduling::kWorkStealing.
+  void PushStealableKernels(std::vector<unsigned>& kernel_ids);
+
+  // Push the kernels linked from `first` to `last` to `list`.
+  void PushStealableList(StealableList& list, unsigned first, unsigned last);
+
+  // Enqueue stealer tasks so that there are up to `num_runs` pending ones, but
+  // no more than the number of worker threads.
+  void SignalStealers(int num_runs);
+
+  // Take one stream run into `ready_kernel_queue`, from the calling thread's
+  // list of stealable ready kernels if it is not empty, or else from the list
+  // of another thread. Kernels of other streams are pushed to the calling
+  // thread's list. Returns false if all lists are empty.
+  bool StealStreamRun(ReadyKernelQueue& ready_kernel_queue);
+
+  // The body of a stealer task: keep stealing and processing stream runs until
+  // all lists of stealable ready kernels are empty.
+  void RunStealer();
+
   HostContext* GetHost() const { return exec_ctx_.host(); }
   BEFFileImpl* BefFile() const { return bef_file_.get(); }
 
@@ -244,6 +314,11 @@ class BEFExecutor final : public ReferenceCounted<BEFExecutor> {
     return function_info_.kernel_infos.mutable_array();
   }
 
+  // Create a ReadyKernelQueue for `stream_id`, which records ready times if
+  // kernel profiling is enabled.
+  ReadyKernelQueue MakeReadyKernelQueue(int stream_id,
+                                        std::vector<unsigned> kernel_ids = {});
+
   void DebugPrintError(const BEFKernel& kernel, unsigned kernel_id,
                        AsyncValue* result);
 
@@ -256,6 +331,24 @@ class BEFExecutor final : public ReferenceCounted<BEFExecutor> {
   /// Decoded BEFFunction
   BEFFileImpl::FunctionInfo function_info_;
 
+  /// The lists of stealable ready kernels, one per worker thread plus one
+  /// for the other threads. Only set up with KernelScheduling::kWorkStealing.
+  HostArray<StealableList> stealable_lists_;
+
+  /// The number of stealer tasks that are enqueued but not started yet.
+  std::atomic<int> pending_stealers_{0};
+
+  /// Kernel profiling state, only set up if the ExecutionContext has a
+  /// KernelProfiler. `ready_infos_` is indexed by kernel id.
+  KernelProfiler* kernel_profiler_ = nullptr;
+  const Function* function_ = nullptr;
+  uint64_t invocation_id_ = 0;
+  HostArray<KernelProfiler::ReadyInfo> ready_infos_;
+
+  /// True if a sample of the kernel executions is timed for the kernel latency
+  /// metric. Only set if the metrics are exported.
+  bool sample_kernel_latency_ = false;
+
   RCReference<BEFFileImpl> bef_file_;
 };
 
@@ -303,9 +396,11 @@ LLVM_ATTRIBUTE_ALWAYS_INLINE void BEFExecutor::ProcessUsedBysAndSetRegister(
   // content. This is fine because the underlying BEF file is supposed to be
   // alive when the BEF executor is alive.
   auto* result_ptr = result.get();
-  result_ptr->AndThen([this, stream_id = ready_kernel_queue.stream_id(), users,
+  result_ptr->AndThen([this, stream_id = ready_kernel_queue.stream_id(),
+                       producer_id = ready_kernel_queue.producer_id(), users,
                        result_register, result = std::move(result)]() mutable {
-    ReadyKernelQueue ready_kernel_queue(stream_id, kernel_infos());
+    ReadyKernelQueue ready_kernel_queue = MakeReadyKernelQueue(stream_id);
+    ready_kernel_queue.set_producer_id(producer_id);
 
     // SetRegisterValue() must be done before
     // DecrementReadyCountAndEnqueue() because as soon as we decrement a
@@ -447,9 +542,33 @@ void BEFExecutor::ProcessReadyKernel(unsigned kernel_id,
     // so that we don't have extra bookkeeping in bef executor.
     TFRT_TRACE_SCOPE(Debug, BefFile()->GetKernelName(kernel.kernel_code()));
 
-    // kernel_fn should populate results in kernel_frame with pointers to
-    // AsyncValue before it returns.
-    kernel_fn(kernel_frame);
+    if (LLVM_UNLIKELY(kernel_profiler_ != nullptr)) {
+      const auto& ready_info = ready_infos_[kernel_id];
+      KernelProfileEvent event;
+      event.function = function_;
+      event.location = kernel_frame->GetLocation();
+      event.invocation_id = invocation_id_;
+      event.kernel_id = kernel_id;
+      event.producer_id = ready_info.producer_id;
+      event.ready_ns = ready_info.ready_ns;
+      event.thread_index = KernelProfiler::CurrentThreadIndex();
+      event.ran_inline = event.thread_index == ready_info.thread_index;
+      event.start_ns = KernelProfiler::NowNs();
+      kernel_fn(kernel_frame);
+      event.end_ns = KernelProfiler::NowNs();
+      kernel_profiler_->Record(event);
+    } else if (LLVM_UNLIKELY(sample_kernel_latency_) &&
+               LLVM_UNLIKELY(SampleKernelLatency())) {
+      auto start = std::chrono::steady_clock::now();
+      kernel_fn(kernel_frame);
+      std::chrono::duration<double, std::micro> latency =
+          std::chrono::steady_clock::now() - start;
+      metrics::GetKernelLatencyHistogram()->Record(latency.count());
+    } else {
+      // kernel_fn should populate results in kernel_frame with pointers to
+      // AsyncValue before it returns.
+      kernel_fn(kernel_frame);
+    }
   } else {
     // Otherwise, automatically propagate errors to the result values.
     for (size_t i = 0, e = kernel_frame->GetNumResults(); i != e; ++i) {
@@ -470,6 +589,7 @@ void BEFExecutor::ProcessReadyKernel(unsigned kernel_id,
   // Move entry offset to start of all used_bys.
   entry_offset += results.size();
 
+  ready_kernel_queue.set_producer_id(kernel_id);
   for (int result_number = 0; result_number < results.size(); ++result_number) {
     auto& result_register = register_array[results[result_number]];
 
@@ -502,6 +622,11 @@ void BEFExecutor::ProcessReadyKernel(unsigned kernel_id,
 // executed in a dfferent thread in parallel.
 LLVM_ATTRIBUTE_NOINLINE void BEFExecutor::EnqueueReadyKernels(
     std::vector<unsigned>& kernel_ids) {
+  if (exec_ctx_.kernel_scheduling() == KernelScheduling::kWorkStealing) {
+    PushStealableKernels(kernel_ids);
+    return;
+  }
+
   auto kernel_array = kernel_infos();
 
   // Sort the kernels by streams to group them.
@@ -512,7 +637,9 @@ LLVM_ATTRIBUTE_NOINLINE void BEFExecutor::EnqueueReadyKernels(
         return kernel_array[x_id].stream_id < kernel_array[y_id].stream_id;
       });
 
-  // For each stream group, we enqueue the kernels to the work queue.
+  // For each stream group, we enqueue the kernels to the work queue. The tasks
+  // are added as one batch to wake up the worker threads only once.
+  llvm::SmallVector<TaskFunction, 4> tasks;
   for (auto iter = kernel_ids.begin(); iter != kernel_ids.end();) {
     int stream_id = kernel_array[*iter].stream_id;
     auto jter = iter++;
@@ -523,20 +650,131 @@ LLVM_ATTRIBUTE_NOINLINE void BEFExecutor::EnqueueReadyKernels(
 
     std::vector<unsigned> stream_kernel_ids(jter, iter);
     AddRef();
-    EnqueueWork(
-        exec_ctx_,
+    tasks.emplace_back(
         [this, stream_id, kernel_ids = std::move(stream_kernel_ids)]() mutable {
-          ReadyKernelQueue ready_kernel_queue(stream_id, kernel_infos(),
-                                              std::move(kernel_ids));
+          TFRT_TRACE_SCOPE(Verbose, "BEFExecutor stream task");
+          ReadyKernelQueue ready_kernel_queue =
+              MakeReadyKernelQueue(stream_id, std::move(kernel_ids));
           ProcessReadyKernels(ready_kernel_queue);
           DropRef();
         });
   }
+  exec_ctx_.work_queue().AddTasks(exec_ctx_, tasks);
 
   // Clear the kernel_ids as they are enqueued.
   kernel_ids.clear();
 }
 
+BEFExecutor::StealableList& BEFExecutor::ThisThreadStealableList() {
+  // Threads outside the worker pool, e.g. blocking threads and the thread that
+  // started the execution, share the last list. The lists are safe to use from
+  // any number of threads.
+  int index = GetHost()->GetWorkerThreadIndex();
+  int num_workers = stealable_lists_.size() - 1;
+  if (index < 0 || index >= num_workers) return stealable_lists_[num_workers];
+  return stealable_lists_[index];
+}
+
+void BEFExecutor::PushStealableKernels(std::vector<unsigned>& kernel_ids) {
+  auto kernel_array = kernel_infos();
+
+  // Count the stream runs so that we know how many workers can make progress
+  // on these kernels in parallel.
+  std::sort(
+      kernel_ids.begin(), kernel_ids.end(), [&](unsigned x_id, unsigned y_id) {
+        return kernel_array[x_id].stream_id < kernel_array[y_id].stream_id;
+      });
+  int num_runs = 1;
+  for (size_t i = 1; i < kernel_ids.size(); ++i) {
+    if (kernel_array[kernel_ids[i]].stream_id !=
+        kernel_array[kernel_ids[i - 1]].stream_id)
+      ++num_runs;
+  }
+
+  for (size_t i = 0; i + 1 < kernel_ids.size(); ++i)
+    kernel_array[kernel_ids[i]].next_stealable = kernel_ids[i + 1] + 1;
+  PushStealableList(ThisThreadStealableList(), kernel_ids.front(),
+                    kernel_ids.back());
+  kernel_ids.clear();
+
+  SignalStealers(num_runs);
+}
+
+void BEFExecutor::PushStealableList(StealableList& list, unsigned first,
+                                    unsigned last) {
+  auto kernel_array = kernel_infos();
+  unsigned head = list.head.load(std::memory_order_relaxed);
+  do {
+    kernel_array[last].next_stealable = head;
+  } while (!list.head.compare_exchange_weak(
+      head, first + 1, std::memory_order_seq_cst, std::memory_order_relaxed));
+}
+
+void BEFExecutor::SignalStealers(int num_runs) {
+  // A pending stealer decrements `pending_stealers_` before it scans the
+  // lists, so if we observe a pending stealer after the push above, it is
+  // guaranteed to see the pushed kernels. Otherwise we enqueue a new one.
+  int max_stealers = std::min(num_runs, GetHost()->GetNumWorkerThreads());
+  max_stealers = std::max(max_stealers, 1);
+  for (int i = pending_stealers_.load(std::memory_order_seq_cst);
+       i < max_stealers; ++i) {
+    pending_stealers_.fetch_add(1, std::memory_order_relaxed);
+    AddRef();
+    EnqueueWork(exec_ctx_, [this]() {
+      RunStealer();
+      DropRef();
+    });
+  }
+}
+
+bool BEFExecutor::StealStreamRun(ReadyKernelQueue& ready_kernel_queue) {
+  // Prefer the calling thread's own list, which holds the kernels it made
+  // ready most recently, for cache locality.
+  StealableList& own_list = ThisThreadStealableList();
+  unsigned head = own_list.head.exchange(0, std::memory_order_seq_cst);
+  for (size_t i = 0, e = stealable_lists_.size(); head == 0 && i != e; ++i)
+    head = stealable_lists_[i].head.exchange(0, std::memory_order_seq_cst);
+  if (head == 0) return false;
+
+  auto kernel_array = kernel_infos();
+  unsigned stream_id = kernel_array[head - 1].stream_id;
+  ready_kernel_queue.set_stream_id(stream_id);
+
+  // Keep the kernels of the first stream, and relink the others into a list
+  // that is pushed to the calling thread's list for other workers to steal.
+  unsigned rest_first = 0, rest_last = 0;
+  while (head != 0) {
+    unsigned kernel_id = head - 1;
+    head = kernel_array[kernel_id].next_stealable;
+    if (kernel_array[kernel_id].stream_id == stream_id) {
+      ready_kernel_queue.inline_kernel_ids().push_back(kernel_id);
+      continue;
+    }
+    if (rest_last == 0) {
+      rest_first = kernel_id + 1;
+    } else {
+      kernel_array[rest_last - 1].next_stealable = kernel_id + 1;
+    }
+    rest_last = kernel_id + 1;
+  }
+
+  if (rest_first != 0) {
+    PushStealableList(own_list, rest_first - 1, rest_last - 1);
+    SignalStealers(/*num_runs=*/1);
+  }
+  return true;
+}
+
+void BEFExecutor::RunStealer() {
+  TFRT_TRACE_SCOPE(Verbose, "BEFExecutor stealer task");
+  pending_stealers_.fetch_sub(1, std::memory_order_seq_cst);
+
+  ReadyKernelQueue ready_kernel_queue = MakeReadyKernelQueue(/*stream_id=*/0);
+  while (StealStreamRun(ready_kernel_queue)) {
+    ProcessReadyKernels(ready_kernel_queue);
+  }
+}
+
 // Iteratively process ready kernels in `ready_kernel_queue` and inserts ready
 // users back for next round of processing, until there are no more ready
 // kernels.
@@ -585,6 +823,15 @@ BEFExecutor::BEFExecutor(ExecutionContext exec_ctx, BEFFileImpl* bef_file)
 
 BEFExecutor::~BEFExecutor() {}
 
+ReadyKernelQueue BEFExecutor::MakeReadyKernelQueue(
+    int stream_id, std::vector<unsigned> kernel_ids) {
+  ReadyKernelQueue ready_kernel_queue(stream_id, kernel_infos(),
+                                      std::move(kernel_ids));
+  if (LLVM_UNLIKELY(kernel_profiler_ != nullptr))
+    ready_kernel_queue.set_ready_infos(ready_infos_.mutable_array());
+  return ready_kernel_queue;
+}
+
 void BEFExecutor::Execute(ArrayRef<AsyncValue*> arguments) {
   // Each KernelInfo::arguments_not_ready to the number of arguments (or one for
   // kernels with no arguments). This means that as we walk the list to drop the
@@ -596,8 +843,8 @@ void BEFExecutor::Execute(ArrayRef<AsyncValue*> arguments) {
   // (very cache friendly), and results in all the atomics staying in that
   // cores' cache, if these benefits outweigh the latency improvement from
   // launching these kernels in different threads.
-  ReadyKernelQueue ready_kernel_queue(kernel_infos()[kPseudoKernelId].stream_id,
-                                      kernel_infos());
+  ReadyKernelQueue ready_kernel_queue =
+      MakeReadyKernelQueue(kernel_infos()[kPseudoKernelId].stream_id);
 
   // The first kernel (kernel_id == 0) is a pseudo kernel that provides the
   // arguments, which gets special handling.
@@ -621,18 +868,42 @@ void BEFExecutor::Execute(ExecutionContext exec_ctx, const BEFFunction& fn,
   assert(results.size() == fn.result_types().size() &&
          "incorrect number of results passed to function call");
 
-  HostContext* host = exec_ctx.host();
-  auto* exec_ptr = host->Allocate<BEFExecutor>();
+  // The executor state is allocated from the request-scoped allocator.
+  HostAllocator* allocator = exec_ctx.allocator();
+  auto* exec_ptr = allocator->Allocate<BEFExecutor>();
   auto* exec = new (exec_ptr) BEFExecutor(std::move(exec_ctx), bef_file);
 
-  size_t location_offset;
-  SmallVector<size_t, 4> result_regs;
-  bool success = bef_file->ReadFunction(fn.function_offset(), fn.result_types(),
-                                        &location_offset, &exec->function_info_,
-                                        &result_regs, host->allocator());
-  if (!success) return;
+  // Only the mutable executor state is initialized here. The register and
+  // kernel tables are decoded once when the BEF file is loaded.
+  const BEFFunctionPlan& plan = fn.plan();
+  BEFFileImpl::InitFunctionInfo(plan, &exec->function_info_, allocator);
+  ArrayRef<uint32_t> result_regs = plan.result_regs;
   assert(result_regs.size() == fn.result_types().size());
 
+  exec->sample_kernel_latency_ = metrics::IsMetricsRegistryRegistered();
+
+  // Set up the per-kernel ready times if kernel profiling is enabled. The
+  // arguments pseudo kernel becomes ready when the execution starts.
+  if (KernelProfiler* kernel_profiler = exec->exec_ctx_.kernel_profiler()) {
+    exec->kernel_profiler_ = kernel_profiler;
+    exec->function_ = &fn;
+    exec->invocation_id_ = kernel_profiler->NewInvocationId();
+    size_t num_kernels = exec->kernel_infos().size();
+    exec->ready_infos_ =
+        HostArray<KernelProfiler::ReadyInfo>(num_kernels, allocator);
+    for (auto& ready_info : exec->ready_infos_.mutable_array())
+      new (&ready_info) KernelProfiler::ReadyInfo();
+    exec->ready_infos_[kPseudoKernelId] =
+        KernelProfiler::MakeReadyInfo(kPseudoKernelId);
+  }
+
+  if (exec->exec_ctx_.kernel_scheduling() == KernelScheduling::kWorkStealing) {
+    size_t num_lists = exec->GetHost()->GetNumWorkerThreads() + 1;
+    exec->stealable_lists_ = HostArray<StealableList>(num_lists, allocator);
+    for (auto& list : exec->stealable_lists_.mutable_array())
+      new (&list) StealableList();
+  }
+
   MutableArrayRef<BEFFileImpl::RegisterInfo> register_array =
       exec->register_infos();
 
@@ -173,27 +173,19 @@ bool BEFFileReader::DiagnoseUnknownKernel(size_t kernel_idx,
   // The unknown kernel must be referenced by some function in the program,
   // and each kernel record has location info.  Scan through to see if we can
   // figure out where the reference is coming from.
-  SmallVector<size_t, 4> result_regs;
-
   for (const auto& function_index : function_indices) {
     if (function_index.kind == FunctionKind::kNativeFunction) continue;
 
-    BEFFileImpl::FunctionInfo function_info;
-
-    result_regs.clear();
-    size_t location_offset;
-    bool success = bef_file_->ReadFunction(
-        function_index.function_offset, function_index.results,
-        &location_offset, &function_info, &result_regs, host_allocator);
+    BEFFunctionPlan plan;
+    bool success = bef_file_->ReadFunction(function_index.function_offset,
+                                           function_index.results, &plan);
     if (!success) continue;
 
     // Decode all of the kernels to see if any refers to our unknown kernel.
-    MutableArrayRef<BEFFileImpl::KernelInfo> kernel_infos_array =
-        function_info.kernel_infos.mutable_array();
-    for (const auto& kernel_info : kernel_infos_array) {
-      assert(kernel_info.offset % kKernelEntryAlignment == 0);
-      BEFKernel kernel(function_info.kernels.data() +
-                       kernel_info.offset / kKernelEntryAlignment);
+    for (const auto& kernel_entry : plan.kernel_entries) {
+      assert(kernel_entry.offset % kKernelEntryAlignment == 0);
+      BEFKernel kernel(plan.kernels.data() +
+                       kernel_entry.offset / kKernelEntryAlignment);
 
       // Okay, we decoded the kernel.  See if this is referring to the
       // current kernel_idx.  If so, we can use its location.  We know that the
@@ -385,6 +377,9 @@ bool BEFFileReader::ReadFunctionIndexSection() {
         auto bef_function = std::make_unique<BEFFunction>(
             name, function_index.arguments, function_index.results,
             function_index.function_offset, bef_file_);
+        // Decode the register and kernel tables once at load time, so that
+        // executions of this function do not need to read them again.
+        if (!bef_function->Init()) return false;
         bef_file_->functions_.push_back(std::move(bef_function));
         break;
       }
@@ -489,10 +484,7 @@ void BEFFileImpl::EmitFormatError(string_view message) {
 // reporting error via EmitFormatError to make the API more natural.
 bool BEFFileImpl::ReadFunction(size_t function_offset,
                                ArrayRef<TypeName> results,
-                               size_t* location_offset,
-                               FunctionInfo* function_info,
-                               SmallVectorImpl<size_t>* result_regs,
-                               HostAllocator* host_allocator) {
+                               BEFFunctionPlan* plan) {
   auto format_error = [&]() -> bool {
     EmitFormatError("invalid Function section in BEF file");
     return false;
@@ -504,57 +496,75 @@ bool BEFFileImpl::ReadFunction(size_t function_offset,
 
   // First we have the location info and register info table.
   size_t num_registers;
-  if (!reader.ReadVbrInt(location_offset) || !reader.ReadVbrInt(&num_registers))
+  if (!reader.ReadVbrInt(&plan->location_offset) ||
+      !reader.ReadVbrInt(&num_registers))
     return format_error();
 
-  function_info->register_infos.resize(num_registers, host_allocator);
-  auto* register_info_ptr =
-      function_info->register_infos.mutable_array().data();
-  unsigned register_idx = 0;
-  while (num_registers--) {
+  plan->register_user_counts.reserve(num_registers);
+  for (size_t reg_index = 0; reg_index < num_registers; ++reg_index) {
     size_t user_count;
     if (!reader.ReadVbrInt(&user_count)) return format_error();
-    new (register_info_ptr + register_idx) RegisterInfo(user_count);
-    ++register_idx;
+    plan->register_user_counts.push_back(user_count);
   }
 
   // Next we have the kernel index table.
   size_t num_kernels;
   if (!reader.ReadVbrInt(&num_kernels)) return format_error();
 
-  function_info->kernel_infos.resize(num_kernels, host_allocator);
-  auto* kernel_info_ptr = function_info->kernel_infos.mutable_array().data();
-  unsigned kernel_idx = 0;
-  while (num_kernels--) {
+  plan->kernel_entries.reserve(num_kernels);
+  for (size_t kernel_index = 0; kernel_index < num_kernels; ++kernel_index) {
     size_t offset, num_operands, stream_id;
     if (!reader.ReadVbrInt(&offset) || !reader.ReadVbrInt(&num_operands) ||
         !reader.ReadVbrInt(&stream_id))
       return format_error();
-    new (kernel_info_ptr + kernel_idx)
-        KernelInfo(offset, stream_id, num_operands);
-    ++kernel_idx;
+    plan->kernel_entries.push_back(
+        {static_cast<uint32_t>(offset), static_cast<uint32_t>(stream_id),
+         static_cast<uint32_t>(num_operands)});
   }
 
   // Read the result registers.
-  result_regs->reserve(results.size());
+  plan->result_regs.reserve(results.size());
   for (unsigned i = 0, e = results.size(); i != e; ++i) {
     size_t result_reg;
     if (!reader.ReadVbrInt(&result_reg) || result_reg >= num_registers)
       return format_error();
-    result_regs->push_back(result_reg);
+    plan->result_regs.push_back(result_reg);
   }
 
   // Kernels are aligned to kKernelEntryAlignment.
   if (!reader.ReadAlignment(kKernelEntryAlignment)) return format_error();
 
   // We found the start of our kernel section.
-  function_info->kernels = llvm::makeArrayRef(
+  plan->kernels = llvm::makeArrayRef(
       reinterpret_cast<const uint32_t*>(reader.file().begin()),
       reader.file().size() / kKernelEntryAlignment);
 
   return true;
 }
 
+void BEFFileImpl::InitFunctionInfo(const BEFFunctionPlan& plan,
+                                   FunctionInfo* function_info,
+                                   HostAllocator* host_allocator) {
+  function_info->kernels = plan.kernels;
+
+  size_t num_registers = plan.register_user_counts.size();
+  function_info->register_infos.resize(num_registers, host_allocator);
+  auto* register_info_ptr =
+      function_info->register_infos.mutable_array().data();
+  for (size_t i = 0; i < num_registers; ++i) {
+    new (register_info_ptr + i) RegisterInfo(plan.register_user_counts[i]);
+  }
+
+  size_t num_kernels = plan.kernel_entries.size();
+  function_info->kernel_infos.resize(num_kernels, host_allocator);
+  auto* kernel_info_ptr = function_info->kernel_infos.mutable_array().data();
+  for (size_t i = 0; i < num_kernels; ++i) {
+    const auto& entry = plan.kernel_entries[i];
+    new (kernel_info_ptr + i)
+        KernelInfo(entry.offset, entry.stream_id, entry.num_operands);
+  }
+}
+
 // Given an offset into locations_section_, decode it and return
 // a DecodedDiagnostic.
 DecodedLocation BEFFileImpl::DecodeLocation(size_t location_position_offset) {
@@ -598,6 +608,11 @@ const Function* BEFFile::GetFunction(string_view function_name) const {
   return impl->functions_[it->second].get();
 }
 
+bool BEFFunction::Init() {
+  assert(plan_.kernels.empty());
+  return bef_file_->ReadFunction(function_offset_, result_types(), &plan_);
+}
+
 Expected<std::unique_ptr<SyncBEFFunction>> SyncBEFFunction::Create(
     string_view name, ArrayRef<TypeName> arguments, ArrayRef<TypeName> results,
     size_t function_offset, BEFFileImpl* bef_file) {
@@ -98,6 +98,33 @@ class BEFInfoArray {
   HostArray<InfoT> host_array_;
 };
 
+// Pre-decoded, immutable register and kernel tables of a BEFFunction. This is
+// built once when the BEF file is loaded, so that each execution of the
+// function only needs to copy the small mutable state (ready counts and
+// register values) instead of decoding the VBR-encoded tables again.
+struct BEFFunctionPlan {
+  // When decoding the kernel table for a function, we get the offset of each
+  // kernel, the stream it is assigned to and the number of operands it has.
+  struct KernelEntry {
+    uint32_t offset;
+    uint32_t stream_id;
+    uint32_t num_operands;
+  };
+
+  // The offset of the function location in the LocationPositions section.
+  size_t location_offset = 0;
+  // This ArrayRef contains kernel entries of all kernels of this function.
+  ArrayRef<uint32_t> kernels;
+  // This is an array of the user counts of all registers in this function,
+  // indexed by their register number.
+  SmallVector<uint32_t, 16> register_user_counts;
+  // This is an array of descriptors for all of the kernels in this function,
+  // indexed by the kernel number.
+  SmallVector<KernelEntry, 8> kernel_entries;
+  // This is an array of register index for the result registers.
+  SmallVector<uint32_t, 4> result_regs;
+};
+
 // This class implements Function for BEF files.
 class BEFFunction : public Function {
  public:
@@ -110,11 +137,20 @@ class BEFFunction : public Function {
   BEFFunction(BEFFunction&& other)
       : Function(std::move(other)),
         function_offset_(other.function_offset_),
-        bef_file_(other.bef_file_) {}
+        bef_file_(other.bef_file_),
+        plan_(std::move(other.plan_)) {}
 
   size_t function_offset() const { return function_offset_; }
   BEFFileImpl* bef_file() const { return bef_file_; }
 
+  // Return the pre-decoded register and kernel tables of this function.
+  const BEFFunctionPlan& plan() const { return plan_; }
+
+  // Decode the register and kernel tables of this function into plan(). This
+  // must be called once before the function is executed. On error, an error is
+  // emitted through the BEF file and false is returned.
+  bool Init();
+
   void Execute(const ExecutionContext& exec_ctx,
                ArrayRef<AsyncValue*> arguments,
                MutableArrayRef<RCReference<AsyncValue>> results) const override;
@@ -131,6 +167,9 @@ class BEFFunction : public Function {
 
   size_t function_offset_;
   BEFFileImpl* bef_file_;
+
+ private:
+  BEFFunctionPlan plan_;
 };
 
 // This class implements SyncFunction for BEF files.
@@ -254,6 +293,10 @@ class BEFFileImpl : public BEFFile {
     unsigned offset;
     unsigned stream_id;
     std::atomic<int> arguments_not_ready;
+    // The next kernel in one of the executor's lists of stealable ready
+    // kernels, encoded as kernel id + 1 (0 terminates the list). Only used
+    // with KernelScheduling::kWorkStealing.
+    unsigned next_stealable = 0;
 
     // We initialize the ready list to at least 1 so that kernels with no
     // operands can be triggered by the pseudo kernel.
@@ -281,22 +324,22 @@ class BEFFileImpl : public BEFFile {
     KernelInfoArray kernel_infos;
   };
 
-  // Decode the specified BEFFunction into the FunctionInfo. `host_allocator` is
-  // used for the heap-allocated buffer that backs info arrays in FunctionInfo.
+  // Decode the specified BEFFunction into `plan`.
   //
   // On error, an error is emitted and false is returned.
   //
-  // ReadFunction is invoked for every BEFFunction execution. We can consider
-  // caching the kernel and register information in the BEFFunction object to
-  // avoid repeadly reading the same information from the BEF file. However, in
-  // the current implementation, we couple BEFExecutor states, e.g. AsyncValue
-  // for RegisterInfo, with the function reading. Caching kernel and register
-  // information would require us to avoid such coupling which can adversely
-  // affect the performance.
+  // ReadFunction is invoked once per BEFFunction when the BEF file is loaded.
+  // The BEFExecutor states, e.g. AsyncValue for RegisterInfo, are initialized
+  // from the decoded plan for every execution by InitFunctionInfo() below.
   bool ReadFunction(size_t function_offset, ArrayRef<TypeName> results,
-                    size_t* location_offset, FunctionInfo* function_info,
-                    SmallVectorImpl<size_t>* result_regs,
-                    HostAllocator* host_allocator);
+                    BEFFunctionPlan* plan);
+
+  // Initialize the mutable executor state in `function_info` from the
+  // pre-decoded `plan`. `host_allocator` is used for the heap-allocated buffer
+  // that backs info arrays in FunctionInfo.
+  static void InitFunctionInfo(const BEFFunctionPlan& plan,
+                               FunctionInfo* function_info,
+                               HostAllocator* host_allocator);
 
   // Given an offset into the LocationPositions section, decode it and return
   // a DecodedDiagnostic.
@@ -27,6 +27,7 @@
 #include "llvm/ADT/SmallVector.h"
 #include "tfrt/bef/bef_encoding.h"
 #include "tfrt/bef/bef_reader.h"
+#include "tfrt/bef_executor/sync_memory_planner.h"
 #include "tfrt/host_context/host_context.h"
 #include "tfrt/host_context/location.h"
 #include "tfrt/host_context/sync_kernel_frame.h"
@@ -42,12 +43,19 @@ namespace tfrt {
 class BEFInterpreterImpl final {
  public:
   // `func` must out-live the BEFInterpreter object, as BEFInterpreter only
-  // keeps a reference to `func`.
-  explicit BEFInterpreterImpl(const Function& func);
+  // keeps a reference to `func`. If `enable_memory_planning` is true, the
+  // buffers allocated by the kernels are placed in an arena that is planned by
+  // the first execution and reused by the following ones.
+  explicit BEFInterpreterImpl(const Function& func,
+                              bool enable_memory_planning = false);
 
   Error Execute(const ExecutionContext& exec_ctx, ArrayRef<Value*> arguments,
                 ArrayRef<Value*> results);
 
+  const SyncMemoryPlanner* memory_planner() const {
+    return memory_planner_.get();
+  }
+
  private:
   struct KernelEntry {
     SyncKernelImplementation kernel_fn;
@@ -82,6 +90,10 @@ class BEFInterpreterImpl final {
   SmallVector<Value*, 16> retired_register_pool_;
   // Attributes used in all kernels.
   SmallVector<const void*, 16> attribute_pool_;
+
+  // Places the buffers allocated by the kernels, or nullptr if memory planning
+  // is disabled.
+  std::unique_ptr<SyncMemoryPlanner> memory_planner_;
 };
 
 //===----------------------------------------------------------------------===//
@@ -90,7 +102,8 @@ class BEFInterpreterImpl final {
 
 BEFInterpreter::BEFInterpreter(const Function& func)
     : impl_{std::make_unique<BEFInterpreterImpl>(
-          static_cast<const SyncBEFFunction&>(func))} {}
+          static_cast<const SyncBEFFunction&>(func),
+          /*enable_memory_planning=*/true)} {}
 
 BEFInterpreter::~BEFInterpreter() {}
 
@@ -100,7 +113,14 @@ Error BEFInterpreter::Execute(const ExecutionContext& exec_ctx,
   return impl_->Execute(exec_ctx, arguments, results);
 }
 
-BEFInterpreterImpl::BEFInterpreterImpl(const Function& func)
+Optional<SyncMemoryPlanStats> BEFInterpreter::GetMemoryPlanStats() const {
+  const SyncMemoryPlanner* memory_planner = impl_->memory_planner();
+  if (!memory_planner->HasPlan()) return llvm::None;
+  return memory_planner->stats();
+}
+
+BEFInterpreterImpl::BEFInterpreterImpl(const Function& func,
+                                       bool enable_memory_planning)
     : func_{static_cast<const SyncBEFFunction&>(func)} {
   assert(func.function_kind() == FunctionKind::kSyncBEFFunction);
   auto register_infos = func_.register_infos();
@@ -131,6 +151,9 @@ BEFInterpreterImpl::BEFInterpreterImpl(const Function& func)
   }
 
   SetupKernelEntries();
+
+  if (enable_memory_planning)
+    memory_planner_ = std::make_unique<SyncMemoryPlanner>();
 }
 
 void BEFInterpreterImpl::SetupKernelEntries() {
@@ -247,6 +270,11 @@ Error BEFInterpreterImpl::Execute(const ExecutionContext& exec_ctx,
   SetupRegisters(arguments, results);
 
   SyncKernelFrameBuilder kernel_frame(registers_, exec_ctx);
+  if (memory_planner_) {
+    memory_planner_->BeginExecution(exec_ctx.host()->allocator());
+    kernel_frame.SetBufferAllocator(memory_planner_.get());
+  }
+
   // Walk through each kernel entry and invoke each kernel sequentially.
   for (auto& kernel_entry : kernel_entries_) {
     BEFKernel kernel(kernel_entry.kernel_start);
@@ -264,12 +292,17 @@ Error BEFInterpreterImpl::Execute(const ExecutionContext& exec_ctx,
       value->reset();
     }
 
+    if (memory_planner_) memory_planner_->EndKernel();
+
     // Check for error.
     if (auto error = kernel_frame.TakeError()) {
+      if (memory_planner_) memory_planner_->EndExecution(/*success=*/false);
       return error;
     }
   }
 
+  if (memory_planner_) memory_planner_->EndExecution(/*success=*/true);
+
 #ifndef NDEBUG
   // In debug mode, reset all the argument and result registers to make
   // debugging easier.
@@ -0,0 +1,288 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements the per-kernel profiler for the BEF executor.
+
+#include "tfrt/bef_executor/kernel_profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/Format.h"
+#include "tfrt/host_context/function.h"
+
+namespace tfrt {
+
+static uint64_t NewProfilerId() {
+  static std::atomic<uint64_t> next_id{1};
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+KernelProfiler::KernelProfiler(size_t max_events_per_thread)
+    : max_events_per_thread_(max_events_per_thread), id_(NewProfilerId()) {}
+
+KernelProfiler::~KernelProfiler() {}
+
+int64_t KernelProfiler::NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+uint32_t KernelProfiler::CurrentThreadIndex() {
+  static std::atomic<uint32_t> next_thread_index{0};
+  static thread_local uint32_t thread_index =
+      next_thread_index.fetch_add(1, std::memory_order_relaxed);
+  return thread_index;
+}
+
+KernelProfiler::ThreadBuffer* KernelProfiler::GetThreadBuffer() {
+  // The buffer of the profiler this thread recorded to last.
+  static thread_local uint64_t last_profiler_id = 0;
+  static thread_local ThreadBuffer* last_buffer = nullptr;
+  if (last_profiler_id == id_) return last_buffer;
+
+  // A thread that reuses the id of an exited thread continues its buffer,
+  // which keeps a single producer per buffer.
+  mutex_lock lock(mu_);
+  auto& buffer = buffers_[std::this_thread::get_id()];
+  if (!buffer) buffer = std::make_unique<ThreadBuffer>(max_events_per_thread_);
+  last_profiler_id = id_;
+  last_buffer = buffer.get();
+  return last_buffer;
+}
+
+void KernelProfiler::Record(const KernelProfileEvent& event) {
+  GetThreadBuffer()->Append(event);
+}
+
+std::vector<KernelProfileEvent> KernelProfiler::GetEvents() const {
+  std::vector<KernelProfileEvent> events;
+  mutex_lock lock(mu_);
+  for (const auto& kv : buffers_) kv.second->Collect(&events);
+  return events;
+}
+
+int64_t KernelProfiler::num_dropped_events() const {
+  int64_t num_dropped = 0;
+  mutex_lock lock(mu_);
+  for (const auto& kv : buffers_) num_dropped += kv.second->num_overwritten();
+  return num_dropped;
+}
+
+namespace {
+
+void PrintKernel(llvm::raw_ostream& os, const KernelProfileEvent& event) {
+  os << "kernel " << event.kernel_id << " ";
+  if (auto debug_info = event.location.GetDebugInfo()) {
+    os << debug_info->info;
+  } else {
+    os << event.location.Decode();
+  }
+}
+
+double ToUs(int64_t ns) { return static_cast<double>(ns) / 1000.0; }
+
+struct KernelStats {
+  const KernelProfileEvent* sample = nullptr;
+  int64_t count = 0;
+  int64_t num_inline = 0;
+  int64_t total_run_ns = 0;
+  int64_t total_queue_ns = 0;
+};
+
+void PrintTopKernels(llvm::raw_ostream& os,
+                     ArrayRef<const KernelProfileEvent*> events,
+                     int num_top_kernels) {
+  llvm::DenseMap<uint32_t, KernelStats> stats_by_kernel;
+  for (const auto* event : events) {
+    auto& stats = stats_by_kernel[event->kernel_id];
+    stats.sample = event;
+    ++stats.count;
+    if (event->ran_inline) ++stats.num_inline;
+    stats.total_run_ns += event->end_ns - event->start_ns;
+    stats.total_queue_ns += event->start_ns - event->ready_ns;
+  }
+
+  std::vector<const KernelStats*> sorted;
+  sorted.reserve(stats_by_kernel.size());
+  for (const auto& kv : stats_by_kernel) sorted.push_back(&kv.second);
+  std::sort(sorted.begin(), sorted.end(), [](const auto* x, const auto* y) {
+    return x->total_run_ns > y->total_run_ns;
+  });
+
+  os << "  Top kernels by total run time:\n";
+  for (int i = 0, e = std::min<int>(num_top_kernels, sorted.size()); i < e;
+       ++i) {
+    const auto& stats = *sorted[i];
+    os << "    " << llvm::format("%12.3f", ToUs(stats.total_run_ns))
+       << " us total, " << stats.count << " runs, "
+       << llvm::format("%.3f", ToUs(stats.total_queue_ns / stats.count))
+       << " us avg queueing, " << stats.num_inline << " inline: ";
+    PrintKernel(os, *stats.sample);
+    os << "\n";
+  }
+}
+
+void PrintCriticalPath(llvm::raw_ostream& os,
+                       ArrayRef<const KernelProfileEvent*> events) {
+  // Group events by invocation and find the slowest invocation.
+  std::map<uint64_t, std::vector<const KernelProfileEvent*>> invocations;
+  for (const auto* event : events)
+    invocations[event->invocation_id].push_back(event);
+
+  const std::vector<const KernelProfileEvent*>* slowest = nullptr;
+  int64_t slowest_duration = -1;
+  for (const auto& kv : invocations) {
+    int64_t begin = kv.second.front()->ready_ns, end = 0;
+    for (const auto* event : kv.second) {
+      begin = std::min(begin, event->ready_ns);
+      end = std::max(end, event->end_ns);
+    }
+    if (end - begin > slowest_duration) {
+      slowest_duration = end - begin;
+      slowest = &kv.second;
+    }
+  }
+  if (!slowest) return;
+
+  // Walk back from the last finished kernel through the kernels that made
+  // each kernel ready.
+  llvm::DenseMap<uint32_t, const KernelProfileEvent*> by_kernel_id;
+  const KernelProfileEvent* last = nullptr;
+  for (const auto* event : *slowest) {
+    by_kernel_id[event->kernel_id] = event;
+    if (!last || event->end_ns > last->end_ns) last = event;
+  }
+
+  std::vector<const KernelProfileEvent*> path;
+  for (const auto* event = last; event != nullptr;) {
+    path.push_back(event);
+    if (event->producer_id == 0 || event->producer_id == event->kernel_id)
+      break;
+    auto it = by_kernel_id.find(event->producer_id);
+    event = it == by_kernel_id.end() ? nullptr : it->second;
+  }
+  std::reverse(path.begin(), path.end());
+
+  os << "  Critical path of the slowest execution ("
+     << llvm::format("%.3f", ToUs(slowest_duration)) << " us, "
+     << slowest->size() << " kernels):\n";
+  for (const auto* event : path) {
+    os << "    " << llvm::format("%12.3f", ToUs(event->end_ns - event->start_ns))
+       << " us run, "
+       << llvm::format("%.3f", ToUs(event->start_ns - event->ready_ns))
+       << " us queueing, thread " << event->thread_index << ": ";
+    PrintKernel(os, *event);
+    os << "\n";
+  }
+}
+
+void PrintParallelism(llvm::raw_ostream& os,
+                      ArrayRef<const KernelProfileEvent*> events) {
+  constexpr int kNumBuckets = 10;
+
+  int64_t begin = events.front()->start_ns, end = events.front()->end_ns;
+  for (const auto* event : events) {
+    begin = std::min(begin, event->start_ns);
+    end = std::max(end, event->end_ns);
+  }
+  int64_t bucket_ns = std::max<int64_t>(1, (end - begin) / kNumBuckets + 1);
+
+  // Sum up the run time of all kernels overlapping each bucket.
+  int64_t busy_ns[kNumBuckets] = {};
+  for (const auto* event : events) {
+    for (int64_t t = event->start_ns; t < event->end_ns;) {
+      int bucket = (t - begin) / bucket_ns;
+      int64_t bucket_end = begin + (bucket + 1) * bucket_ns;
+      int64_t overlap_end = std::min(bucket_end, event->end_ns);
+      busy_ns[bucket] += overlap_end - t;
+      t = overlap_end;
+    }
+  }
+
+  os << "  Average parallelism over time (" << llvm::format("%.3f", ToUs(bucket_ns))
+     << " us buckets):";
+  for (int i = 0; i < kNumBuckets; ++i) {
+    os << " "
+       << llvm::format("%.2f", static_cast<double>(busy_ns[i]) / bucket_ns);
+  }
+  os << "\n";
+}
+
+}  // namespace
+
+void KernelProfiler::PrintReport(llvm::raw_ostream& os,
+                                 int num_top_kernels) const {
+  auto events = GetEvents();
+
+  // Group the events by function, in the order of their first execution.
+  std::vector<const Function*> functions;
+  llvm::DenseMap<const Function*, std::vector<const KernelProfileEvent*>>
+      events_by_function;
+  std::sort(events.begin(), events.end(), [](const auto& x, const auto& y) {
+    return x.start_ns < y.start_ns;
+  });
+  for (const auto& event : events) {
+    auto& function_events = events_by_function[event.function];
+    if (function_events.empty()) functions.push_back(event.function);
+    function_events.push_back(&event);
+  }
+
+  os << "Kernel profile: " << events.size() << " kernel executions";
+  if (int64_t num_dropped = num_dropped_events())
+    os << " (" << num_dropped << " dropped)";
+  os << "\n";
+
+  for (const auto* function : functions) {
+    const auto& function_events = events_by_function[function];
+    os << "Function '" << function->name() << "':\n";
+    PrintTopKernels(os, function_events, num_top_kernels);
+    PrintCriticalPath(os, function_events);
+    PrintParallelism(os, function_events);
+  }
+  os.flush();
+}
+
+void KernelProfiler::WriteCostProfile(ArrayRef<KernelProfileEvent> events,
+                                      llvm::raw_ostream& os) {
+  struct CostStats {
+    int64_t count = 0;
+    int64_t total_run_ns = 0;
+  };
+  // Kernels are sorted by location to make the profile stable.
+  std::map<std::string, CostStats> stats_by_location;
+  for (const auto& event : events) {
+    if (!event.location) continue;
+    std::string location;
+    llvm::raw_string_ostream location_os(location);
+    location_os << event.location.Decode();
+    auto& stats = stats_by_location[location_os.str()];
+    ++stats.count;
+    stats.total_run_ns += event.end_ns - event.start_ns;
+  }
+
+  os << "# <mean_ns> <count> <location>\n";
+  for (const auto& kv : stats_by_location) {
+    os << kv.second.total_run_ns / kv.second.count << " " << kv.second.count
+       << " " << kv.first << "\n";
+  }
+  os.flush();
+}
+
+}  // namespace tfrt
@@ -0,0 +1,180 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements the memory planner for synchronous BEF functions.
+
+#include "tfrt/bef_executor/sync_memory_planner.h"
+
+#include <algorithm>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/MathExtras.h"
+
+namespace tfrt {
+
+void SyncMemoryPlanner::BeginExecution(HostAllocator* allocator) {
+  allocator_ = allocator;
+  kernel_index_ = 0;
+  buffer_index_ = 0;
+  mismatch_ = false;
+
+  switch (state_) {
+    case State::kRecording:
+      buffers_.clear();
+      live_buffers_.clear();
+      break;
+    case State::kPlanned:
+      // Slices of the previous execution that are still referenced, e.g. by a
+      // kernel that unexpectedly kept a buffer, must not be overwritten.
+      if (stats_.planned_bytes > 0 && (!arena_ || !arena_->IsUnique())) {
+        arena_ = HostBuffer::CreateUninitialized(stats_.planned_bytes,
+                                                 arena_alignment_, allocator);
+      }
+      break;
+    case State::kDisabled:
+      break;
+  }
+}
+
+void SyncMemoryPlanner::EndExecution(bool success) {
+  switch (state_) {
+    case State::kRecording:
+      // The remaining buffers outlive the execution and are not planned.
+      live_buffers_.clear();
+      if (success) {
+        ComputePlan();
+        state_ = State::kPlanned;
+      }
+      break;
+    case State::kPlanned:
+      if (mismatch_ || (success && buffer_index_ != buffers_.size())) {
+        state_ = State::kDisabled;
+        buffers_.clear();
+        arena_.reset();
+      }
+      break;
+    case State::kDisabled:
+      break;
+  }
+  allocator_ = nullptr;
+}
+
+RCReference<HostBuffer> SyncMemoryPlanner::AllocateBuffer(size_t size,
+                                                          size_t alignment) {
+  switch (state_) {
+    case State::kRecording: {
+      auto buffer = AllocateIndividually(size, alignment);
+      if (!buffer) return buffer;
+      live_buffers_.emplace_back(buffers_.size(), buffer);
+      buffers_.push_back(BufferInfo{size, alignment, kernel_index_,
+                                    /*last_kernel=*/-1, /*offset=*/0});
+      return buffer;
+    }
+    case State::kPlanned: {
+      size_t index = buffer_index_++;
+      if (index >= buffers_.size() || buffers_[index].size != size ||
+          buffers_[index].alignment != alignment) {
+        mismatch_ = true;
+      }
+      if (mismatch_ || buffers_[index].last_kernel < 0 || !arena_)
+        return AllocateIndividually(size, alignment);
+      return HostBuffer::CreateFromExternal(arena_, buffers_[index].offset,
+                                            size);
+    }
+    case State::kDisabled:
+      break;
+  }
+  return AllocateIndividually(size, alignment);
+}
+
+RCReference<HostBuffer> SyncMemoryPlanner::AllocateIndividually(
+    size_t size, size_t alignment) {
+  assert(allocator_ && "AllocateBuffer() called outside of an execution");
+  return HostBuffer::CreateUninitialized(size, alignment, allocator_);
+}
+
+void SyncMemoryPlanner::RecordReleasedBuffers() {
+  // The planner holds the last reference to buffers released by the function.
+  llvm::erase_if(live_buffers_,
+                 [this](const std::pair<size_t, RCReference<HostBuffer>>& it) {
+                   if (!it.second->IsUnique()) return false;
+                   buffers_[it.first].last_kernel = kernel_index_;
+                   return true;
+                 });
+}
+
+void SyncMemoryPlanner::ComputePlan() {
+  stats_ = SyncMemoryPlanStats();
+  stats_.num_buffers = buffers_.size();
+  arena_alignment_ = 1;
+  arena_.reset();
+
+  // Compute the peak memory usage from the number of bytes allocated and
+  // released at each kernel.
+  const int num_kernels = kernel_index_;
+  std::vector<int64_t> live_bytes_delta(num_kernels + 1);
+  for (const BufferInfo& buffer : buffers_) {
+    int last_kernel =
+        buffer.last_kernel < 0 ? num_kernels - 1 : buffer.last_kernel;
+    live_bytes_delta[buffer.first_kernel] += buffer.size;
+    live_bytes_delta[last_kernel + 1] -= buffer.size;
+    stats_.total_bytes += buffer.size;
+  }
+  int64_t live_bytes = 0;
+  for (int64_t delta : live_bytes_delta) {
+    live_bytes += delta;
+    stats_.peak_bytes = std::max(stats_.peak_bytes, live_bytes);
+  }
+
+  // Assign offsets to the largest buffers first, placing each buffer at the
+  // lowest offset that does not overlap with an already placed buffer whose
+  // lifetime overlaps with its own.
+  llvm::SmallVector<size_t, 16> order;
+  for (size_t i = 0; i < buffers_.size(); ++i) {
+    if (buffers_[i].last_kernel >= 0) order.push_back(i);
+  }
+  std::stable_sort(order.begin(), order.end(), [this](size_t lhs, size_t rhs) {
+    return buffers_[lhs].size > buffers_[rhs].size;
+  });
+
+  llvm::SmallVector<std::pair<size_t, size_t>, 16> conflicts;
+  for (size_t i = 0; i < order.size(); ++i) {
+    BufferInfo& buffer = buffers_[order[i]];
+
+    conflicts.clear();
+    for (size_t j = 0; j < i; ++j) {
+      const BufferInfo& placed = buffers_[order[j]];
+      if (placed.first_kernel > buffer.last_kernel ||
+          buffer.first_kernel > placed.last_kernel)
+        continue;
+      conflicts.emplace_back(placed.offset, placed.offset + placed.size);
+    }
+    llvm::sort(conflicts);
+
+    size_t offset = 0;
+    for (const auto& range : conflicts) {
+      if (offset + buffer.size <= range.first) break;
+      offset = std::max<size_t>(offset,
+                                llvm::alignTo(range.second, buffer.alignment));
+    }
+
+    buffer.offset = offset;
+    stats_.planned_bytes =
+        std::max<int64_t>(stats_.planned_bytes, offset + buffer.size);
+    arena_alignment_ = std::max(arena_alignment_, buffer.alignment);
+  }
+  stats_.num_planned_buffers = order.size();
+}
+
+}  // namespace tfrt
@@ -20,11 +20,13 @@
 
 #include <cstdint>
 #include <limits>
+#include <vector>
 
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/ScopeExit.h"
 #include "llvm/Support/DynamicLibrary.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
 #include "llvm_derived/Support/raw_ostream.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/Diagnostics.h"
@@ -33,6 +35,8 @@
 #include "mlir/Support/FileUtilities.h"
 #include "tfrt/bef/bef_buffer.h"
 #include "tfrt/bef_executor/bef_file.h"
+#include "tfrt/bef_executor/bef_interpreter.h"
+#include "tfrt/bef_executor/kernel_profiler.h"
 #include "tfrt/core_runtime/core_runtime.h"
 #include "tfrt/core_runtime/tensor_handle.h"
 #include "tfrt/host_context/async_value.h"
@@ -56,7 +60,8 @@ static void RunBefFunction(
     HostContext* host, const Function& function,
     const std::function<llvm::Expected<ExecutionContext>(
         HostContext*, ResourceContext*)>& create_execution_context,
-    bool print_error_code);
+    bool print_error_code, bool profile_kernels, bool print_memory_plan,
+    std::vector<KernelProfileEvent>* cost_profile_events);
 
 int RunBefExecutor(const RunBefConfig& run_config) {
   return RunBefExecutor(
@@ -129,6 +134,10 @@ int RunBefExecutor(
       host_allocator = CreateMallocAllocator();
       host_allocator = CreateLeakCheckAllocator(std::move(host_allocator));
       tfrt::outs() << "Choosing memory leak check allocator.\n";
+      break;
+    case HostAllocatorType::kThreadCachingMalloc:
+      host_allocator = CreateThreadCachingAllocator();
+      tfrt::outs() << "Choosing thread caching allocator.\n";
   }
   tfrt::outs().flush();
 
@@ -183,6 +192,7 @@ int RunBefExecutor(
   }
 
   auto* host = core_rt.get()->GetHostContext();
+  host->set_kernel_scheduling(run_config.kernel_scheduling);
 
   // If there are any libraries specified, load them and see if they have a
   // kernel registration function.
@@ -234,17 +244,39 @@ int RunBefExecutor(
   // Run the init function first if exists.
   auto test_init_function = bef->GetFunction(run_config.test_init_function);
 
+  // Kernel executions of all functions, collected if a kernel cost profile is
+  // requested.
+  std::vector<KernelProfileEvent> cost_profile_events;
+  auto* cost_profile_events_ptr =
+      run_config.kernel_cost_profile.empty() ? nullptr : &cost_profile_events;
+
   if (test_init_function) {
     RunBefFunction(host, *test_init_function, create_execution_context,
-                   run_config.print_error_code);
+                   run_config.print_error_code, run_config.profile_kernels,
+                   run_config.print_memory_plan, cost_profile_events_ptr);
   }
 
   // Loop over each of the functions, running each as a standalone testcase.
   for (auto* fn : function_list) {
     if (fn != test_init_function) {
       RunBefFunction(host, *fn, create_execution_context,
-                     run_config.print_error_code);
+                     run_config.print_error_code, run_config.profile_kernels,
+                     run_config.print_memory_plan, cost_profile_events_ptr);
+    }
+  }
+
+  // Write the cost profile while `bef` is alive, as the kernel locations are
+  // decoded from it.
+  if (cost_profile_events_ptr) {
+    std::error_code error;
+    llvm::raw_fd_ostream os(run_config.kernel_cost_profile, error);
+    if (error) {
+      llvm::errs() << run_config.program_name << ": couldn't open "
+                   << run_config.kernel_cost_profile << ": " << error.message()
+                   << "\n";
+      return 1;
     }
+    KernelProfiler::WriteCostProfile(cost_profile_events, os);
   }
 
   bef.reset();
@@ -272,10 +304,26 @@ static void PrintResult(const TypeName& type_name, const ValueType& result) {
   }
 }
 
-static void RunSyncBefFunctionHelper(const ExecutionContext& exec_ctx,
-                                     const Function& function) {
-  TFRT_TRACE_SCOPE(Default, StrCat("Function: ", function.name()));
+static void PrintMemoryPlan(const Function& function,
+                            const BEFInterpreter& interpreter) {
+  auto stats = interpreter.GetMemoryPlanStats();
+  if (!stats) {
+    tfrt::outs() << "'" << function.name() << "' has no memory plan\n";
+  } else {
+    tfrt::outs() << "'" << function.name() << "' memory plan: "
+                 << stats->num_planned_buffers << " of " << stats->num_buffers
+                 << " buffers planned, total " << stats->total_bytes
+                 << " bytes, peak " << stats->peak_bytes << " bytes, planned "
+                 << stats->planned_bytes << " bytes\n";
+  }
+  tfrt::outs().flush();
+}
 
+// Runs `function` and prints its results. If `interpreter` is not null, the
+// function is run with it instead of a new BEFInterpreter.
+static void RunSyncBefFunctionOnce(const ExecutionContext& exec_ctx,
+                                   const Function& function,
+                                   BEFInterpreter* interpreter) {
   llvm::SmallVector<Value, 4> results;
   results.resize(function.result_types().size());
 
@@ -284,8 +332,11 @@ static void RunSyncBefFunctionHelper(const ExecutionContext& exec_ctx,
     result_ptrs.emplace_back(&value);
   }
 
-  auto error =
-      ExecuteSyncBEFFunction(function, exec_ctx, /*arguments=*/{}, result_ptrs);
+  Error error =
+      interpreter
+          ? interpreter->Execute(exec_ctx, /*arguments=*/{}, result_ptrs)
+          : ExecuteSyncBEFFunction(function, exec_ctx, /*arguments=*/{},
+                                   result_ptrs);
 
   // Go ahead and print out the function results that we know about.
   if (error) {
@@ -312,6 +363,27 @@ static void RunSyncBefFunctionHelper(const ExecutionContext& exec_ctx,
   }
 }
 
+static void RunSyncBefFunctionHelper(const ExecutionContext& exec_ctx,
+                                     const Function& function,
+                                     bool print_memory_plan) {
+  TFRT_TRACE_SCOPE(Default, StrCat("Function: ", function.name()));
+
+  if (!print_memory_plan) {
+    RunSyncBefFunctionOnce(exec_ctx, function, /*interpreter=*/nullptr);
+    return;
+  }
+
+  // The first run of a BEFInterpreter plans the buffers, and the second run
+  // places them in the planned arena.
+  BEFInterpreter interpreter(function);
+  RunSyncBefFunctionOnce(exec_ctx, function, &interpreter);
+  tfrt::outs() << "--- Rerunning '" << function.name()
+               << "' with its memory plan\n";
+  tfrt::outs().flush();
+  RunSyncBefFunctionOnce(exec_ctx, function, &interpreter);
+  PrintMemoryPlan(function, interpreter);
+}
+
 static void RunAsyncBefFunctionHelper(const ExecutionContext& exec_ctx,
                                       const Function& function,
                                       bool print_error_code) {
@@ -365,7 +437,8 @@ static void RunBefFunction(
     HostContext* host, const Function& function,
     const std::function<llvm::Expected<ExecutionContext>(
         HostContext*, ResourceContext*)>& create_execution_context,
-    bool print_error_code) {
+    bool print_error_code, bool profile_kernels, bool print_memory_plan,
+    std::vector<KernelProfileEvent>* cost_profile_events) {
   // If the function takes arguments, then we can't run it from this driver.
   if (!function.argument_types().empty()) {
     tfrt::outs() << "--- Not running '" << function.name()
@@ -401,7 +474,17 @@ static void RunBefFunction(
       abort();
     }
     if (function.function_kind() == FunctionKind::kSyncBEFFunction) {
-      RunSyncBefFunctionHelper(exec_ctx.get(), function);
+      RunSyncBefFunctionHelper(exec_ctx.get(), function, print_memory_plan);
+    } else if (profile_kernels || cost_profile_events) {
+      KernelProfiler kernel_profiler;
+      exec_ctx->set_kernel_profiler(&kernel_profiler);
+      RunAsyncBefFunctionHelper(exec_ctx.get(), function, print_error_code);
+      if (profile_kernels) kernel_profiler.PrintReport(tfrt::outs());
+      if (cost_profile_events) {
+        auto events = kernel_profiler.GetEvents();
+        cost_profile_events->insert(cost_profile_events->end(), events.begin(),
+                                    events.end());
+      }
     } else {
       RunAsyncBefFunctionHelper(exec_ctx.get(), function, print_error_code);
     }
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This implements ApplyCostProfilePass, which attaches the kernel costs
+// measured by the BEF executor (see `bef_executor --kernel_cost_profile`) to
+// the operations as `_tfrt_cost` attributes, so that StreamAnalysis uses them
+// instead of the static cost estimates.
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <tuple>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Location.h"
+#include "mlir/Pass/Pass.h"
+
+namespace tfrt {
+namespace compiler {
+namespace {
+
+// Appends the string the BEF executor uses for `loc` when it is nested in
+// another location. This mirrors BefLocationToStr() in bef_location.cc.
+void PrintNestedLocation(mlir::Location loc, llvm::raw_ostream& os) {
+  if (auto file_loc = loc.dyn_cast<mlir::FileLineColLoc>()) {
+    os << file_loc.getFilename().getValue() << ";" << file_loc.getLine() << ";"
+       << file_loc.getColumn();
+  } else if (auto name_loc = loc.dyn_cast<mlir::NameLoc>()) {
+    bool has_child = !name_loc.getChildLoc().isa<mlir::UnknownLoc>();
+    if (has_child) {
+      PrintNestedLocation(name_loc.getChildLoc(), os);
+      os << "(";
+    }
+    os << name_loc.getName().getValue();
+    if (has_child) os << ")";
+  } else if (auto call_loc = loc.dyn_cast<mlir::CallSiteLoc>()) {
+    PrintNestedLocation(call_loc.getCallee(), os);
+    os << "<-";
+    PrintNestedLocation(call_loc.getCaller(), os);
+  } else if (auto fused_loc = loc.dyn_cast<mlir::FusedLoc>()) {
+    llvm::interleave(
+        fused_loc.getLocations(),
+        [&](mlir::Location child) { PrintNestedLocation(child, os); },
+        [&] { os << ","; });
+  } else {
+    os << "(unknown)";
+  }
+}
+
+// Returns the key of `loc` in a kernel cost profile, ie. the location of the
+// kernel as decoded and printed by the BEF executor.
+std::string GetProfileKey(mlir::Location loc) {
+  std::string key;
+  llvm::raw_string_ostream os(key);
+  if (auto file_loc = loc.dyn_cast<mlir::FileLineColLoc>()) {
+    os << file_loc.getFilename().getValue() << ":" << file_loc.getLine() << ":"
+       << file_loc.getColumn();
+  } else {
+    PrintNestedLocation(loc, os);
+  }
+  return os.str();
+}
+
+class ApplyCostProfilePass
+    : public mlir::PassWrapper<ApplyCostProfilePass,
+                               mlir::OperationPass<mlir::ModuleOp>> {
+ public:
+  ApplyCostProfilePass() = default;
+  ApplyCostProfilePass(const ApplyCostProfilePass&) {}
+
+  llvm::StringRef getArgument() const final {
+    return "tfrt-apply-cost-profile";
+  }
+
+  llvm::StringRef getDescription() const final {
+    return "Attach the kernel costs of a BEF executor profile as _tfrt_cost "
+           "attributes";
+  }
+
+  void runOnOperation() override {
+    auto module = getOperation();
+
+    auto buffer = llvm::MemoryBuffer::getFile(profile_);
+    if (!buffer) {
+      module.emitError("cannot read kernel cost profile '")
+          << profile_ << "': " << buffer.getError().message();
+      return signalPassFailure();
+    }
+
+    // Parse the profile. Each line has the mean run time in nanoseconds, the
+    // number of runs and the kernel location, lines starting with '#' are
+    // comments.
+    llvm::StringMap<double> mean_ns_by_location;
+    llvm::SmallVector<llvm::StringRef, 16> lines;
+    (*buffer)->getBuffer().split(lines, '\n', /*MaxSplit=*/-1,
+                                 /*KeepEmpty=*/false);
+    for (llvm::StringRef line : lines) {
+      line = line.trim();
+      if (line.empty() || line.startswith("#")) continue;
+
+      llvm::StringRef mean_ns, rest, location;
+      std::tie(mean_ns, rest) = line.split(' ');
+      // Skip the number of runs.
+      location = rest.ltrim().split(' ').second.ltrim();
+
+      double mean_ns_value;
+      if (mean_ns.getAsDouble(mean_ns_value) || location.empty()) {
+        module.emitError("invalid kernel cost profile line: '") << line << "'";
+        return signalPassFailure();
+      }
+      mean_ns_by_location[location] = mean_ns_value;
+    }
+
+    if (ns_per_cost_ <= 0) {
+      module.emitError("ns-per-cost must be positive");
+      return signalPassFailure();
+    }
+
+    mlir::Builder builder(&getContext());
+    module.walk([&](mlir::Operation* op) {
+      auto it = mean_ns_by_location.find(GetProfileKey(op->getLoc()));
+      if (it == mean_ns_by_location.end()) return;
+      int64_t cost = std::max<int64_t>(
+          1, static_cast<int64_t>(std::round(it->second / ns_per_cost_)));
+      op->setAttr("_tfrt_cost", builder.getI64IntegerAttr(cost));
+    });
+  }
+
+ private:
+  Option<std::string> profile_{
+      *this, "profile",
+      llvm::cl::desc("Kernel cost profile written by bef_executor "
+                     "--kernel_cost_profile")};
+  Option<int64_t> ns_per_cost_{
+      *this, "ns-per-cost",
+      llvm::cl::desc("Nanoseconds of measured run time per unit of cost"),
+      llvm::cl::init(1000)};
+};
+
+static mlir::PassRegistration<ApplyCostProfilePass> apply_cost_profile;
+
+}  // namespace
+}  // namespace compiler
+}  // namespace tfrt
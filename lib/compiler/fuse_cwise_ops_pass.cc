@@ -0,0 +1,239 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This implements FuseCwiseOpsPass, which fuses chains of coefficient wise
+// Tensorflow ops executed by the core runtime into a single tf._FusedCwise op.
+
+#include "tfrt/compiler/fuse_cwise_ops_pass.h"
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Pass/Pass.h"
+#include "tfrt/compiler/fused_cwise_dtypes.h"
+#include "tfrt/core_runtime/opdefs/core_runtime.h"
+#include "tfrt/dtype/dtype.h"
+
+namespace tfrt {
+namespace compiler {
+namespace {
+
+enum class CwiseKind { kNone, kUnary, kBinary, kCommutative };
+
+// Returns the kind of the coefficient wise op supported by tf._FusedCwise.
+CwiseKind GetCwiseKind(llvm::StringRef op_name) {
+  return llvm::StringSwitch<CwiseKind>(op_name)
+      .Case("tf.AddV2", CwiseKind::kCommutative)
+      .Case("tf.Mul", CwiseKind::kCommutative)
+      .Case("tf.Sub", CwiseKind::kBinary)
+      .Case("tf.RealDiv", CwiseKind::kBinary)
+      .Case("tf.BiasAdd", CwiseKind::kBinary)
+      .Case("tf.Relu", CwiseKind::kUnary)
+      .Case("tf.Log", CwiseKind::kUnary)
+      .Case("tf.Log1p", CwiseKind::kUnary)
+      .Case("tf.Rsqrt", CwiseKind::kUnary)
+      .Case("tf.Sigmoid", CwiseKind::kUnary)
+      .Default(CwiseKind::kNone);
+}
+
+// Returns the DType of the element type `type`, or DType::Invalid if it has
+// none.
+DType GetDType(mlir::Type type) {
+  if (type.isF16()) return DType::F16;
+  if (type.isBF16()) return DType::BF16;
+  if (type.isF32()) return DType::F32;
+  if (type.isF64()) return DType::F64;
+  if (type.isInteger(1)) return DType::I1;
+  if (auto int_type = type.dyn_cast<mlir::IntegerType>()) {
+    bool is_unsigned = int_type.isUnsigned();
+    switch (int_type.getWidth()) {
+      case 8:
+        return is_unsigned ? DType::UI8 : DType::I8;
+      case 16:
+        return is_unsigned ? DType::UI16 : DType::I16;
+      case 32:
+        return is_unsigned ? DType::UI32 : DType::I32;
+      case 64:
+        return is_unsigned ? DType::UI64 : DType::I64;
+    }
+  }
+  return DType::Invalid;
+}
+
+// Returns the dtype attribute of a coefficient wise op that can be fused, or a
+// null attribute otherwise. The op must have an explicit `T` attribute with one
+// of the FusedCwiseDTypes.
+mlir::Attribute GetFusibleDType(corert::ExecuteOp op) {
+  if (GetCwiseKind(op.op_name()) == CwiseKind::kNone) return {};
+  if (op.results().size() != 1) return {};
+  if (!op.op_func_attrs().empty()) return {};
+
+  llvm::SmallVector<std::pair<llvm::StringRef, mlir::Attribute>, 4> attrs;
+  op.getOpAttrs(&attrs);
+
+  mlir::Attribute dtype;
+  for (const auto& attr : attrs) {
+    if (attr.first == "T") {
+      dtype = attr.second;
+    } else if (attr.first == "data_format") {
+      auto data_format = attr.second.dyn_cast<mlir::StringAttr>();
+      if (!data_format || data_format.getValue() != "NHWC") return {};
+    } else {
+      return {};
+    }
+  }
+
+  auto type_attr = dtype.dyn_cast_or_null<mlir::TypeAttr>();
+  if (!type_attr ||
+      !FusedCwiseDTypes::Contains(GetDType(type_attr.getValue())))
+    return {};
+  return dtype;
+}
+
+// A chain of coefficient wise ops, where each op uses the result of the
+// previous op and nothing else uses the intermediate results.
+struct CwiseChain {
+  llvm::SmallVector<corert::ExecuteOp, 4> ops;
+  mlir::Value input;
+  llvm::SmallVector<mlir::Value, 4> fusion_inputs;
+};
+
+// Returns the operand of the binary `op` that is not `value`, or a null value
+// if `op` can't take `value` as its left operand.
+mlir::Value GetFusionInput(corert::ExecuteOp op, mlir::Value value) {
+  auto operands = op.operands();
+  if (operands.size() != 2 || operands[0] == operands[1]) return {};
+  if (operands[0] == value) return operands[1];
+  if (operands[1] == value &&
+      GetCwiseKind(op.op_name()) == CwiseKind::kCommutative)
+    return operands[0];
+  return {};
+}
+
+CwiseChain GetCwiseChain(corert::ExecuteOp head, mlir::Attribute dtype) {
+  CwiseChain chain;
+  chain.ops.push_back(head);
+
+  auto operands = head.operands();
+  if (GetCwiseKind(head.op_name()) == CwiseKind::kUnary) {
+    if (operands.size() != 1) return {};
+    chain.input = operands[0];
+  } else {
+    if (operands.size() != 2 || operands[0] == operands[1]) return {};
+    chain.input = operands[0];
+    chain.fusion_inputs.push_back(operands[1]);
+  }
+
+  while (true) {
+    mlir::Value value = chain.ops.back().results()[0];
+    if (!value.hasOneUse()) break;
+
+    auto next = llvm::dyn_cast<corert::ExecuteOp>(*value.getUsers().begin());
+    if (!next || next->getBlock() != head->getBlock() ||
+        next.op_handler() != head.op_handler() ||
+        GetFusibleDType(next) != dtype)
+      break;
+
+    if (GetCwiseKind(next.op_name()) == CwiseKind::kUnary) {
+      if (next.operands().size() != 1) break;
+    } else {
+      mlir::Value fusion_input = GetFusionInput(next, value);
+      if (!fusion_input) break;
+      chain.fusion_inputs.push_back(fusion_input);
+    }
+    chain.ops.push_back(next);
+  }
+
+  return chain;
+}
+
+class FuseCwiseOpsPass
+    : public mlir::PassWrapper<FuseCwiseOpsPass,
+                               mlir::OperationPass<mlir::FuncOp>> {
+ public:
+  llvm::StringRef getArgument() const final { return "tfrt-fuse-cwise-ops"; }
+
+  llvm::StringRef getDescription() const final {
+    return "Fuses chains of coefficient wise corert.executeop ops into "
+           "tf._FusedCwise ops";
+  }
+
+  void runOnOperation() override {
+    llvm::SmallVector<CwiseChain, 4> chains;
+    llvm::SmallPtrSet<mlir::Operation*, 16> fused;
+
+    getOperation().walk([&](corert::ExecuteOp op) {
+      if (fused.count(op.getOperation())) return;
+
+      mlir::Attribute dtype = GetFusibleDType(op);
+      if (!dtype) return;
+
+      CwiseChain chain = GetCwiseChain(op, dtype);
+      if (chain.ops.size() < 2) return;
+
+      for (corert::ExecuteOp chain_op : chain.ops)
+        fused.insert(chain_op.getOperation());
+      chains.push_back(std::move(chain));
+    });
+
+    for (CwiseChain& chain : chains) Fuse(chain);
+  }
+
+ private:
+  // Replaces the ops of the `chain` with a single tf._FusedCwise op placed at
+  // the last op of the chain, where all the inputs are available.
+  void Fuse(const CwiseChain& chain) {
+    corert::ExecuteOp last = chain.ops.back();
+    mlir::OpBuilder builder(last);
+
+    llvm::SmallVector<mlir::Attribute, 4> fused_ops;
+    for (corert::ExecuteOp op : chain.ops) {
+      // Drop the "tf." prefix.
+      fused_ops.push_back(builder.getStringAttr(op.op_name().drop_front(3)));
+    }
+
+    llvm::SmallVector<mlir::Value, 4> operands;
+    operands.push_back(chain.input);
+    operands.append(chain.fusion_inputs.begin(), chain.fusion_inputs.end());
+
+    std::pair<llvm::StringRef, mlir::Attribute> op_attrs[] = {
+        {"T", GetFusibleDType(last)},
+        {"fused_ops", builder.getArrayAttr(fused_ops)}};
+
+    auto fused_op = builder.create<corert::ExecuteOp>(
+        builder.getFusedLoc(llvm::to_vector<4>(llvm::map_range(
+            chain.ops, [](corert::ExecuteOp op) { return op.getLoc(); }))),
+        last.results().getTypes(), last.op_handler(), operands, op_attrs,
+        /*op_func_attrs=*/llvm::None, "tf._FusedCwise");
+
+    last.results()[0].replaceAllUsesWith(fused_op.results()[0]);
+    for (corert::ExecuteOp op : llvm::reverse(chain.ops)) op.erase();
+  }
+};
+
+static mlir::PassRegistration<FuseCwiseOpsPass> fuse_cwise_ops;
+
+}  // namespace
+
+std::unique_ptr<mlir::OperationPass<mlir::FuncOp>> CreateFuseCwiseOpsPass() {
+  return std::make_unique<FuseCwiseOpsPass>();
+}
+
+}  // namespace compiler
+}  // namespace tfrt
@@ -27,6 +27,7 @@ namespace compiler {
 namespace {
 
 constexpr mlir::Operation* kRootOperation = nullptr;
+constexpr llvm::StringLiteral kCostAttrName = "_tfrt_cost";
 
 mlir::Attribute GetOptionAttribute(mlir::Block& block,
                                    llvm::StringRef attr_name) {
@@ -89,6 +90,12 @@ int64_t StreamAnalysis::GetOperationCost(mlir::Operation* op) const {
   // A few TFRT kernels are guaranteed to be cheap.
   if (llvm::isa<ReturnOp, MergeChainsOp>(op)) return 1;
 
+  // Prefer a measured cost, eg. one attached by -tfrt-apply-cost-profile from
+  // a kernel profile, over the static cost function.
+  if (auto attr = op->getAttrOfType<mlir::IntegerAttr>(kCostAttrName)) {
+    return std::max<int64_t>(1, attr.getInt());
+  }
+
   // Check if operations defines a cost function.
   if (auto cost_function = mlir::dyn_cast<CostFunctionInterface>(op)) {
     int64_t cost = cost_function.cost();
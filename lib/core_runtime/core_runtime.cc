@@ -16,8 +16,12 @@
 
 #include "tfrt/core_runtime/core_runtime.h"
 
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <string>
 
+#include "llvm/ADT/Hashing.h"
 #include "tfrt/core_runtime/core_runtime_op.h"
 #include "tfrt/core_runtime/op_handler.h"
 #include "tfrt/core_runtime/op_invocation.h"
@@ -32,6 +36,7 @@
 #include "tfrt/host_context/kernel_registry.h"
 #include "tfrt/host_context/location.h"
 #include "tfrt/host_context/shared_context.h"
+#include "tfrt/metrics/common_metrics.h"
 #include "tfrt/support/error_util.h"
 #include "tfrt/support/logging.h"
 #include "tfrt/support/mutex.h"
@@ -69,6 +74,30 @@ class OpHandlerRegistry {
   std::vector<std::unique_ptr<OpHandler>> all_op_handlers_;
 };
 
+// An entry of the per-thread op dispatch cache. Entries are keyed on the id of
+// the CoreRuntime rather than its address, so that a CoreRuntime allocated at
+// the address of a destroyed one never sees its ops.
+struct ThreadOpCacheEntry {
+  uint64_t runtime_id = 0;
+  OpHandler* op_handler = nullptr;
+  bool traced = false;
+  std::string op_name;
+  const CoreRuntimeOp* op = nullptr;
+};
+
+// Returns the entry of the caller thread's direct mapped op dispatch cache for
+// the given key. The entry may hold a different key.
+ThreadOpCacheEntry& GetThreadOpCacheEntry(uint64_t runtime_id,
+                                          OpHandler* op_handler, bool traced,
+                                          string_view op_name) {
+  static constexpr size_t kNumEntries = 64;
+  static thread_local std::array<ThreadOpCacheEntry, kNumEntries> cache;
+  size_t hash = llvm::hash_combine(runtime_id, op_handler, traced, op_name);
+  return cache[hash % kNumEntries];
+}
+
+std::atomic<uint64_t> next_runtime_id{1};
+
 }  // namespace
 
 OpHandler::~OpHandler() {}
@@ -101,6 +130,12 @@ class CoreRuntime::Impl {
     op_handler_registry_.AddOpHandlerChain(name, op_handler);
   }
 
+  // Returns the cached op for `op_name` on `op_handler`, or calls `make_op` and
+  // caches the op it returns. Traced and untraced ops are cached separately.
+  Expected<const CoreRuntimeOp*> GetOrMakeOp(
+      string_view op_name, OpHandler* op_handler, bool traced,
+      llvm::function_ref<Expected<CoreRuntimeOp>()> make_op);
+
  private:
   friend class CoreRuntime;
 
@@ -112,8 +147,67 @@ class CoreRuntime::Impl {
   HostContext context_;
 
   OpHandlerRegistry op_handler_registry_;
+
+  // Unique id of this CoreRuntime for the per-thread op dispatch caches.
+  const uint64_t id_ = next_runtime_id.fetch_add(1, std::memory_order_relaxed);
+
+  // Op dispatch cache. Ops are never evicted, because the number of distinct
+  // ops is small, and the CoreRuntimeOp's must stay alive while they are used.
+  // Ops are looked up in the caller thread's cache first, so that cache hits
+  // normally don't take `op_cache_mu_`.
+  using OpCache = llvm::DenseMap<OpHandler*, llvm::StringMap<CoreRuntimeOp>>;
+  mutex op_cache_mu_;
+  OpCache op_cache_ TFRT_GUARDED_BY(op_cache_mu_);
+  OpCache traced_op_cache_ TFRT_GUARDED_BY(op_cache_mu_);
 };
 
+Expected<const CoreRuntimeOp*> CoreRuntime::Impl::GetOrMakeOp(
+    string_view op_name, OpHandler* op_handler, bool traced,
+    llvm::function_ref<Expected<CoreRuntimeOp>()> make_op) {
+  ThreadOpCacheEntry& entry =
+      GetThreadOpCacheEntry(id_, op_handler, traced, op_name);
+  if (entry.runtime_id == id_ && entry.op_handler == op_handler &&
+      entry.traced == traced && entry.op_name == op_name) {
+    metrics::GetOpDispatchCacheHitsCounter()->Increment();
+    return entry.op;
+  }
+
+  auto fill_entry = [&](const CoreRuntimeOp* op) {
+    entry.runtime_id = id_;
+    entry.op_handler = op_handler;
+    entry.traced = traced;
+    entry.op_name.assign(op_name.begin(), op_name.end());
+    entry.op = op;
+    return op;
+  };
+
+  {
+    mutex_lock lock(op_cache_mu_);
+    OpCache& op_cache = traced ? traced_op_cache_ : op_cache_;
+    auto ops = op_cache.find(op_handler);
+    if (ops != op_cache.end()) {
+      auto op = ops->second.find(op_name);
+      if (op != ops->second.end()) {
+        metrics::GetOpDispatchCacheHitsCounter()->Increment();
+        return fill_entry(&op->second);
+      }
+    }
+  }
+  metrics::GetOpDispatchCacheMissesCounter()->Increment();
+
+  // Make the op without holding the lock, ops that are not found in the op
+  // handler are not cached.
+  auto op = make_op();
+  if (!op) return op.takeError();
+
+  // StringMap entries are never moved, so the op address is stable. If another
+  // thread made the same op concurrently, its op is returned instead.
+  mutex_lock lock(op_cache_mu_);
+  OpCache& op_cache = traced ? traced_op_cache_ : op_cache_;
+  auto inserted = op_cache[op_handler].try_emplace(op_name, std::move(*op));
+  return fill_entry(&inserted.first->second);
+}
+
 void CoreRuntime::Impl::Execute(const ExecutionContext& exec_ctx,
                                 string_view op_name, OpHandler* op_handler,
                                 MutableArrayRef<TensorHandle> arguments,
@@ -121,11 +215,13 @@ void CoreRuntime::Impl::Execute(const ExecutionContext& exec_ctx,
                                 MutableArrayRef<TensorHandle> results,
                                 AsyncValueRef<Chain>* chain) {
   // Ask the op_handler to execute the op.  If successful, we're done.
-  auto op_handle = op_handler->MakeOp(op_name);
+  auto op_handle = GetOrMakeOp(op_name, op_handler, /*traced=*/false,
+                               [&] { return op_handler->MakeOp(op_name); });
   if (op_handle) {
-    op_handle.get()(exec_ctx, arguments, attrs, results, chain);
+    (**op_handle)(exec_ctx, arguments, attrs, results, chain);
     return;
   }
+  llvm::consumeError(op_handle.takeError());
 
   // Otherwise, we fail with an 'unknown op' error.
   auto err =
@@ -237,6 +333,14 @@ Expected<CoreRuntimeOp> CoreRuntime::MakeOp(string_view op_name,
       is_fallback, std::move(device), op->GetTensorType());
 }
 
+Expected<const CoreRuntimeOp*> CoreRuntime::GetOrMakeOp(string_view op_name,
+                                                        OpHandler* op_handler) {
+  // MakeOp() wraps the op into a tracing scope if tracing is enabled.
+  const bool traced = tracing::IsTracingEnabled(tracing::TracingLevel::Default);
+  return impl_->GetOrMakeOp(op_name, op_handler, traced,
+                            [&] { return MakeOp(op_name, op_handler); });
+}
+
 Expected<CoreRuntimeOp> CoreRuntime::MakeCompositeOp(const Function* fn) {
   for (auto iter : llvm::enumerate(fn->argument_types().drop_front())) {
     size_t i = iter.index();
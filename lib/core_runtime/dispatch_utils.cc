@@ -17,8 +17,10 @@
 
 #include "tfrt/core_runtime/dispatch_utils.h"
 
+#include "tfrt/core_runtime/op_metadata_cache.h"
 #include "tfrt/host_context/host_context.h"
 #include "tfrt/host_context/location.h"
+#include "tfrt/metrics/common_metrics.h"
 
 namespace tfrt {
 namespace internal {
@@ -68,6 +70,17 @@ MDFunctionExecResult ExecuteMetadataFunction(
   // Okay, the shapes are available as we expect, get the result metadata.
   result_mds.resize(invocation.results.size());
 
+  // Ops are often executed repeatedly with the same attributes and argument
+  // shapes, reuse the result metadata of the previous execution if possible.
+  OpMetadataCache* cache = OpMetadataCache::GetPerThread();
+  OpMetadataCache::Key key = OpMetadataCache::MakeKey(
+      metadata_fn, invocation.attrs, argument_mds, result_mds.size());
+  if (cache->Lookup(key, result_mds)) {
+    metrics::GetOpMetadataCacheHitsCounter()->Increment();
+    return MDFunctionExecResult::kSuccess;
+  }
+  metrics::GetOpMetadataCacheMissesCounter()->Increment();
+
   // TODO(tfrt-devs): Remove this tracing tag when finished debugging
   // dispatch performance.
   TFRT_TRACE_SCOPE(Verbose, "RunMetadataFunction");
@@ -78,6 +91,8 @@ MDFunctionExecResult ExecuteMetadataFunction(
     return MDFunctionExecResult::kError;
   }
 
+  // Only successful executions are cached, so that errors are always emitted.
+  cache->Insert(std::move(key), result_mds);
   return MDFunctionExecResult::kSuccess;
 }
 
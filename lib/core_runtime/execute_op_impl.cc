@@ -144,7 +144,7 @@ void AsyncWaitForResultsFromTensorHandles(
   }
 }
 
-void ExecuteOpImpl(CoreRuntimeOp op, ArrayRef<AsyncValue *> args,
+void ExecuteOpImpl(const CoreRuntimeOp &op, ArrayRef<AsyncValue *> args,
                    AsyncValueRef<Chain> *op_chain,
                    MutableArrayRef<RCReference<AsyncValue>> results,
                    AggregateAttr op_attr_array,
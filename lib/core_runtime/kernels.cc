@@ -211,14 +211,14 @@ static llvm::Expected<TensorHandle> CreateDenseTensor(
   return TensorHandle(host->GetHostDeviceRef(), metadata, std::move(dht));
 }
 
-static llvm::Expected<CoreRuntimeOp> GetCoreRuntimeOp(
+static llvm::Expected<const CoreRuntimeOp *> GetCoreRuntimeOp(
     string_view op_name, OpHandler *op_handler,
     const ExecutionContext &exec_ctx) {
   auto *host = exec_ctx.host();
   auto *core_rt = CoreRuntime::GetFromHostContext(host);
   if (!core_rt) return MakeStringError("no CoreRuntime available");
 
-  return core_rt->MakeOp(op_name, op_handler);
+  return core_rt->GetOrMakeOp(op_name, op_handler);
 }
 
 // ExecuteOp executes the `op_name` operation on the `op_handler`.
@@ -234,7 +234,7 @@ static void ExecuteOp(Argument<OpHandler *> op_handler, RemainingArguments args,
   for (int b = 0, e = results.size(); b < e; ++b)
     results.AllocateAt<TensorHandle>(b);
 
-  ExecuteOpImpl(std::move(expected_op.get()), args.values(),
+  ExecuteOpImpl(**expected_op, args.values(),
                 /*op_chain=*/nullptr, results.values(), op_attr_array,
                 op_func_attr_array, exec_ctx);
 }
@@ -258,7 +258,7 @@ static void ExecuteOpSeq(Argument<OpHandler *> op_handler,
     results.AllocateAt<TensorHandle>(b);
 
   auto op_chain = in_op_chain.ValueRef();
-  ExecuteOpImpl(std::move(expected_op.get()), args.values(), &op_chain,
+  ExecuteOpImpl(**expected_op, args.values(), &op_chain,
                 results.values(), op_attr_array, op_func_attr_array, exec_ctx);
   out_op_chain.Set(std::move(op_chain));
 }
@@ -273,7 +273,7 @@ static Error ExecuteOpSync(SyncArgument<OpHandler *> op_handler,
       GetCoreRuntimeOp(op_name.GetValue(), op_handler.get(), exec_ctx);
 
   if (!expected_op) return MakeStringError(expected_op.takeError());
-  ExecuteOpImplSync(expected_op.get(), args,
+  ExecuteOpImplSync(**expected_op, args,
                     /*op_chain=*/nullptr, frame, op_attr_array, exec_ctx);
   return Error::success();
 }
@@ -293,7 +293,7 @@ static void ExecuteCoreRuntimeOp(Argument<CoreRuntimeOp> op,
   for (int b = 0, e = results.size(); b < e; ++b)
     results.AllocateAt<TensorHandle>(b);
 
-  ExecuteOpImpl(std::move(op.get()), args.values(),
+  ExecuteOpImpl(op.get(), args.values(),
                 /*op_chain=*/nullptr, results.values(), op_attrs, op_func_attrs,
                 exec_ctx);
 }
@@ -0,0 +1,145 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements OpMetadataCache.
+
+#include "tfrt/core_runtime/op_metadata_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#include "llvm/ADT/STLExtras.h"
+#include "tfrt/core_runtime/op_attrs.h"
+
+namespace tfrt {
+
+// Folds `word` into `hash`. This is cheaper than llvm::hash_combine, which
+// matters because a key is hashed on every op execution.
+static uint64_t MixHash(uint64_t hash, uint64_t word) {
+  hash = (hash ^ word) * 0x9e3779b97f4a7c15ull;
+  return hash ^ (hash >> 29);
+}
+
+// Appends `data` to the key bytes and folds it into the key hash, so that the
+// hash doesn't need another pass over the bytes.
+static void AppendBytes(SmallVectorImpl<char>* bytes, uint64_t* hash,
+                        const void* data, size_t size) {
+  const char* begin = static_cast<const char*>(data);
+  bytes->append(begin, begin + size);
+  *hash = MixHash(*hash, size);
+  for (size_t offset = 0; offset < size; offset += sizeof(uint64_t)) {
+    uint64_t word = 0;
+    std::memcpy(&word, begin + offset,
+                std::min(sizeof(uint64_t), size - offset));
+    *hash = MixHash(*hash, word);
+  }
+}
+
+template <typename T>
+static void AppendBytes(SmallVectorImpl<char>* bytes, uint64_t* hash,
+                        const T& value) {
+  static_assert(std::is_trivially_copyable<T>::value &&
+                    sizeof(T) <= sizeof(uint64_t),
+                "Only small scalars are hashed as a word");
+  const char* begin = reinterpret_cast<const char*>(&value);
+  bytes->append(begin, begin + sizeof(T));
+  uint64_t word = 0;
+  std::memcpy(&word, &value, sizeof(T));
+  *hash = MixHash(*hash, word);
+}
+
+static int CompareAttrNames(const OpAttrsRawEntry* const* lhs,
+                            const OpAttrsRawEntry* const* rhs) {
+  return std::strcmp((*lhs)->name, (*rhs)->name);
+}
+
+OpMetadataCache::Key OpMetadataCache::MakeKey(
+    OpMetadataFn metadata_fn, const OpAttrsRef& attrs,
+    ArrayRef<TensorMetadata> arguments, size_t num_results) {
+  Key key;
+  key.valid_ = true;
+  SmallVectorImpl<char>& bytes = key.bytes_;
+  uint64_t hash = 0;
+
+  AppendBytes(&bytes, &hash, metadata_fn);
+  AppendBytes(&bytes, &hash, num_results);
+
+  // Attributes are iterated in a non-deterministic order, sort them by name.
+  // Frozen attributes, e.g. the attributes of ops executed from BEF, are
+  // already sorted, so check that first.
+  SmallVector<const OpAttrsRawEntry*, 8> entries;
+  attrs.IterateEntries(
+      [&](const OpAttrsRawEntry& entry) { entries.push_back(&entry); });
+  for (size_t i = 1; i < entries.size(); ++i) {
+    if (CompareAttrNames(&entries[i - 1], &entries[i]) > 0) {
+      llvm::array_pod_sort(entries.begin(), entries.end(), CompareAttrNames);
+      break;
+    }
+  }
+
+  for (const OpAttrsRawEntry* entry : entries) {
+    AppendBytes(&bytes, &hash, entry->name, std::strlen(entry->name) + 1);
+    AppendBytes(&bytes, &hash, entry->type);
+    AppendBytes(&bytes, &hash, entry->element_count);
+    if (entry->element_count == 0) continue;
+
+    const void* data = entry->GetData();
+    if (data == nullptr) {
+      key.valid_ = false;
+      return key;
+    }
+    const size_t type_size = GetHostSizeAndAlignment(data, entry->type).first;
+    AppendBytes(&bytes, &hash, data, type_size * entry->element_count);
+  }
+
+  SmallVector<Index, 4> dims;
+  for (const TensorMetadata& md : arguments) {
+    AppendBytes(&bytes, &hash, md.dtype);
+    dims.clear();
+    md.shape.GetDimensions(&dims);
+    AppendBytes(&bytes, &hash, dims.size());
+    for (Index dim : dims) AppendBytes(&bytes, &hash, dim);
+  }
+
+  key.hash_ = hash;
+  return key;
+}
+
+bool OpMetadataCache::Lookup(const Key& key,
+                             MutableArrayRef<TensorMetadata> results) const {
+  if (!key.IsValid()) return false;
+
+  const Entry& entry = entries_[key.hash() % kNumEntries];
+  if (!(entry.key == key)) return false;
+
+  assert(entry.results.size() == results.size());
+  std::copy(entry.results.begin(), entry.results.end(), results.begin());
+  return true;
+}
+
+void OpMetadataCache::Insert(Key key, ArrayRef<TensorMetadata> results) {
+  if (!key.IsValid()) return;
+
+  Entry& entry = entries_[key.hash() % kNumEntries];
+  entry.key = std::move(key);
+  entry.results.assign(results.begin(), results.end());
+}
+
+OpMetadataCache* OpMetadataCache::GetPerThread() {
+  static thread_local OpMetadataCache cache;
+  return &cache;
+}
+
+}  // namespace tfrt
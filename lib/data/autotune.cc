@@ -0,0 +1,230 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file implements AutotuneController and AutotuneKnob, which adjust the
+// buffer sizes and the parallelism of data pipeline iterators at runtime.
+
+#include "autotune.h"
+
+#include <algorithm>
+#include <string>
+
+#include "llvm/ADT/SmallVector.h"
+#include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+
+namespace tfrt {
+namespace data {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Size of an element whose size is unknown, e.g. an intermediate iterator.
+constexpr size_t kDefaultElementBytes = 4 * 1024;
+
+// Knobs check whether the controller is due to tune every this many GetNext()
+// calls, to keep reading the clock off the common path. Must be a power of 2.
+constexpr int64_t kTuneCheckPeriod = 64;
+
+// Knobs with fewer GetNext() calls since the last round are not tuned.
+constexpr int64_t kMinSamples = 16;
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             Clock::now().time_since_epoch())
+      .count();
+}
+
+// Returns the size of the values of `result` that have a known size, or 0 if
+// `result` is not a concrete element.
+size_t EstimateBytes(const IterationResult& result) {
+  if (!result.eof.IsConcrete() || result.eof.get()) return 0;
+  size_t bytes = 0;
+  for (const auto& value : result.values) {
+    if (!value->IsConcrete()) continue;
+    if (value->IsType<DenseHostTensor>()) {
+      bytes += value->get<DenseHostTensor>().DataSizeInBytes();
+    } else if (value->IsType<std::string>()) {
+      bytes += value->get<std::string>().size();
+    }
+  }
+  return bytes;
+}
+
+}  // namespace
+
+//===----------------------------------------------------------------------===//
+// AutotuneKnob methods
+//===----------------------------------------------------------------------===//
+AutotuneKnob::AutotuneKnob(AutotuneController* controller,
+                           int64_t initial_value, int64_t min_value,
+                           int64_t max_value)
+    : controller_(controller),
+      min_value_(min_value),
+      max_value_(std::max(min_value, max_value)),
+      value_(std::min(std::max(initial_value, min_value_), max_value_)) {}
+
+void AutotuneKnob::RecordGetNext(const IterationResult& result,
+                                 bool producer_idle) {
+  // Iterators such as the parallel map return an available eof while the
+  // values are still being computed, so the consumer waits for all of them.
+  if (internal::IsAvailable(result)) {
+    RecordElementBytes(EstimateBytes(result));
+  } else {
+    num_consumer_waits_.fetch_add(1, std::memory_order_relaxed);
+    RunWhenReady(result.AsyncValues(), [knob = FormRef(this),
+                                        result = result.CopyRef(),
+                                        start = Clock::now()] {
+      knob->RecordConsumerWait(Clock::now() - start);
+      knob->RecordElementBytes(EstimateBytes(result));
+    });
+  }
+  RecordGetNextEnd(producer_idle);
+}
+
+void AutotuneKnob::RecordGetNext(AsyncValue* element, bool producer_idle) {
+  if (!element->IsAvailable()) {
+    num_consumer_waits_.fetch_add(1, std::memory_order_relaxed);
+    element->AndThen([knob = FormRef(this), start = Clock::now()] {
+      knob->RecordConsumerWait(Clock::now() - start);
+    });
+  }
+  RecordGetNextEnd(producer_idle);
+}
+
+void AutotuneKnob::RecordGetNextEnd(bool producer_idle) {
+  if (producer_idle) num_producer_idle_.fetch_add(1, std::memory_order_relaxed);
+
+  auto num_get_next = num_get_next_.fetch_add(1, std::memory_order_relaxed);
+  if ((num_get_next & (kTuneCheckPeriod - 1)) == 0) controller_->MaybeTune();
+}
+
+void AutotuneKnob::RecordConsumerWait(std::chrono::nanoseconds wait) {
+  consumer_wait_ns_.fetch_add(wait.count(), std::memory_order_relaxed);
+}
+
+void AutotuneKnob::RecordElementBytes(size_t bytes) {
+  if (bytes == 0) return;
+  // Races between concurrent updates only lose samples of the average.
+  size_t average = element_bytes_.load(std::memory_order_relaxed);
+  average = average == 0 ? bytes : average - average / 8 + bytes / 8;
+  element_bytes_.store(average, std::memory_order_relaxed);
+}
+
+size_t AutotuneKnob::ElementBytes() const {
+  size_t bytes = element_bytes_.load(std::memory_order_relaxed);
+  return bytes == 0 ? kDefaultElementBytes : bytes;
+}
+
+//===----------------------------------------------------------------------===//
+// AutotuneController methods
+//===----------------------------------------------------------------------===//
+AutotuneController::AutotuneController(HostContext* host)
+    : last_tune_ns_(NowNs()) {}
+
+AutotuneController& AutotuneController::Get(HostContext* host) {
+  return host->GetOrCreateSharedContext<AutotuneController>();
+}
+
+RCReference<AutotuneKnob> AutotuneController::MakeKnob(int64_t initial_value,
+                                                       int64_t min_value,
+                                                       int64_t max_value) {
+  auto knob =
+      TakeRef(new AutotuneKnob(this, initial_value, min_value, max_value));
+  mutex_lock lock(mu_);
+  knobs_.push_back(knob.CopyRef());
+  return knob;
+}
+
+void AutotuneController::MaybeTune() {
+  int64_t now = NowNs();
+  int64_t last = last_tune_ns_.load(std::memory_order_relaxed);
+  if (now - last < std::chrono::nanoseconds(kTuningInterval).count()) return;
+  // Only one of the callers that observe the end of the interval tunes.
+  if (!last_tune_ns_.compare_exchange_strong(last, now)) return;
+  Tune(std::chrono::nanoseconds(now - last));
+}
+
+void AutotuneController::Tune(std::chrono::nanoseconds elapsed) {
+  mutex_lock lock(mu_);
+
+  // Drop the knobs of the destroyed iterators.
+  knobs_.erase(std::remove_if(knobs_.begin(), knobs_.end(),
+                              [](const RCReference<AutotuneKnob>& knob) {
+                                return knob->IsUnique();
+                              }),
+               knobs_.end());
+
+  struct Candidate {
+    AutotuneKnob* knob;
+    int64_t consumer_wait_ns;
+  };
+  llvm::SmallVector<Candidate, 8> candidates;
+  size_t used_bytes = 0;
+
+  // Shrink the knobs whose producer is always ahead first, so that the memory
+  // they release can be given to the knobs whose consumer waits.
+  for (auto& knob : knobs_) {
+    int64_t value = knob->value();
+    if (knob->num_get_next_.load(std::memory_order_relaxed) >= kMinSamples) {
+      int64_t num_get_next = knob->num_get_next_.exchange(0);
+      int64_t num_consumer_waits = knob->num_consumer_waits_.exchange(0);
+      int64_t num_producer_idle = knob->num_producer_idle_.exchange(0);
+      int64_t consumer_wait_ns = knob->consumer_wait_ns_.exchange(0);
+
+      // Grow if more than 10% of the elements were not ready, and waiting for
+      // them took more than 1% of the time.
+      if (num_consumer_waits * 10 > num_get_next &&
+          consumer_wait_ns * 100 > elapsed.count() &&
+          value < knob->max_value()) {
+        candidates.push_back({knob.get(), consumer_wait_ns});
+      } else if (num_consumer_waits == 0 &&
+                 num_producer_idle * 10 >= num_get_next * 9 &&
+                 value > knob->min_value()) {
+        // Shrink in small steps, as a too small buffer is more expensive than
+        // a too large one.
+        value = std::max(knob->min_value(),
+                         value - std::max<int64_t>(1, value / 8));
+        knob->value_.store(value, std::memory_order_relaxed);
+      }
+    }
+    used_bytes += value * knob->ElementBytes();
+  }
+
+  // Give the memory budget to the knobs whose consumers waited the longest.
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate& a, const Candidate& b) {
+              return a.consumer_wait_ns > b.consumer_wait_ns;
+            });
+  const size_t budget = memory_budget();
+  for (const Candidate& candidate : candidates) {
+    if (used_bytes >= budget) break;
+    AutotuneKnob* knob = candidate.knob;
+    int64_t value = knob->value();
+    size_t element_bytes = knob->ElementBytes();
+    int64_t affordable = (budget - used_bytes) / element_bytes;
+    int64_t new_value = std::min({knob->max_value(), value * 2,
+                                  value + affordable});
+    new_value = std::max(new_value, value + std::min<int64_t>(1, affordable));
+    if (new_value <= value) continue;
+    knob->value_.store(new_value, std::memory_order_relaxed);
+    used_bytes += (new_value - value) * element_bytes;
+  }
+}
+
+}  // namespace data
+}  // namespace tfrt
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares AutotuneController and AutotuneKnob, which adjust the
+// buffer sizes and the parallelism of data pipeline iterators at runtime.
+
+#ifndef TFRT_LIB_DATA_AUTOTUNE_H_
+#define TFRT_LIB_DATA_AUTOTUNE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "tfrt/data/dataset.h"
+#include "tfrt/host_context/shared_context.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/ref_count.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace data {
+
+// Value of the prefetch_num, num_parallel_calls, cycle_length and
+// max_prefetch_num arguments of the data ops which requests the corresponding
+// buffer size or parallelism to be tuned at runtime.
+constexpr int64_t kAutotune = -1;
+
+class AutotuneController;
+
+// AutotuneKnob is a buffer size or a parallelism of a single iterator that is
+// tuned by the AutotuneController. The iterator reads the current value in
+// every GetNext() call, and reports how well the value worked:
+//
+//  - Consumer waits: GetNext() returned an element that was not available
+//    yet, ie. the consumer had to wait for the producer.
+//  - Producer idle: the buffer was full of available elements, ie. the
+//    producer had to wait for buffer space.
+//  - The size of the elements, to charge the buffer against the memory budget.
+//
+// All methods are thread-safe.
+class AutotuneKnob : public ReferenceCounted<AutotuneKnob> {
+ public:
+  AutotuneKnob(AutotuneController* controller, int64_t initial_value,
+               int64_t min_value, int64_t max_value);
+
+  int64_t value() const { return value_.load(std::memory_order_relaxed); }
+  int64_t min_value() const { return min_value_; }
+  int64_t max_value() const { return max_value_; }
+
+  // Records an element returned by GetNext(). If the element or any of its
+  // values is not available, records the time until all of them become
+  // available as consumer wait time.
+  // `producer_idle` is true if all buffered elements were already available.
+  void RecordGetNext(const IterationResult& result, bool producer_idle);
+
+  // Same as above, for iterators whose buffered elements are not
+  // IterationResults, e.g. intermediate iterators.
+  void RecordGetNext(AsyncValue* element, bool producer_idle);
+
+  void RecordConsumerWait(std::chrono::nanoseconds wait);
+
+  // Records the size in bytes of one buffered element.
+  void RecordElementBytes(size_t bytes);
+
+ private:
+  friend class AutotuneController;
+
+  // Records the producer idleness of a GetNext() call, and tunes the knobs if
+  // the controller is due.
+  void RecordGetNextEnd(bool producer_idle);
+
+  // Estimated size in bytes of one buffered element.
+  size_t ElementBytes() const;
+
+  AutotuneController* const controller_;
+  const int64_t min_value_;
+  const int64_t max_value_;
+  std::atomic<int64_t> value_;
+
+  // Statistics since the last time the controller tuned this knob.
+  std::atomic<int64_t> num_get_next_{0};
+  std::atomic<int64_t> num_consumer_waits_{0};
+  std::atomic<int64_t> num_producer_idle_{0};
+  std::atomic<int64_t> consumer_wait_ns_{0};
+
+  // Exponential moving average of the element size, 0 until the first size is
+  // recorded.
+  std::atomic<size_t> element_bytes_{0};
+};
+
+// AutotuneController owns the knobs of all autotuned iterators of a
+// HostContext. It periodically grows the knobs whose consumers wait for
+// elements, and shrinks the knobs whose producers are idle, while keeping the
+// total size of the buffers within a memory budget shared by all iterators.
+//
+// Tuning runs inline in the GetNext() calls that report to the knobs, so the
+// controller does not need a thread of its own.
+class AutotuneController : public SharedContext {
+ public:
+  // The default memory budget for the buffers of all autotuned iterators.
+  static constexpr size_t kDefaultMemoryBudget = 256 * 1024 * 1024;
+  // The interval between two rounds of tuning.
+  static constexpr std::chrono::milliseconds kTuningInterval{50};
+
+  explicit AutotuneController(HostContext* host);
+
+  // Returns the controller of `host`.
+  static AutotuneController& Get(HostContext* host);
+
+  // Creates a knob that is tuned by this controller between `min_value` and
+  // `max_value`.
+  RCReference<AutotuneKnob> MakeKnob(int64_t initial_value, int64_t min_value,
+                                     int64_t max_value);
+
+  size_t memory_budget() const {
+    return memory_budget_.load(std::memory_order_relaxed);
+  }
+  void set_memory_budget(size_t bytes) {
+    memory_budget_.store(bytes, std::memory_order_relaxed);
+  }
+
+  // Adjusts all knobs based on their statistics since the last round, which
+  // lasted `elapsed`. This is called by the knobs every kTuningInterval, and
+  // can be called directly by tests.
+  void Tune(std::chrono::nanoseconds elapsed);
+
+ private:
+  friend class AutotuneKnob;
+
+  // Calls Tune() if the last round was at least kTuningInterval ago.
+  void MaybeTune();
+
+  std::atomic<size_t> memory_budget_{kDefaultMemoryBudget};
+  std::atomic<int64_t> last_tune_ns_{0};
+
+  mutex mu_;
+  std::vector<RCReference<AutotuneKnob>> knobs_ TFRT_GUARDED_BY(mu_);
+};
+
+}  // namespace data
+}  // namespace tfrt
+
+#endif  // TFRT_LIB_DATA_AUTOTUNE_H_
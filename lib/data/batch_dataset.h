@@ -434,10 +434,8 @@ IterationResult BatchDatasetIterator<T...>::GetNext(
   HostContext* host = exec_ctx.host();
   SmallVector<IterationResult, 4> inputs;
   // Get up to batch_size values from the underlying iterator.
-  for (int i = 0; i < parent_dataset_->batch_size_; ++i) {
-    auto input = input_iterator_->GetNext(exec_ctx);
-    inputs.push_back(std::move(input));
-  }
+  input_iterator_->GetNextBatch(exec_ctx, parent_dataset_->batch_size_,
+                                &inputs);
 
   SmallVector<AsyncValueRef<TensorMetadata>, 4> metadata;
   if (parent_dataset_->same_input_metadata_) {
@@ -0,0 +1,768 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file implements CacheDataset class, which caches the elements of its
+// input dataset in memory or in a file.
+//
+// A cache file starts with a FileHeader, followed by the values of all
+// elements in order. Each value starts with a ValueHeader, followed by
+//  - for a DenseHostTensor: its dimensions, then its data, aligned to
+//    kTensorAlignment so that the tensor can be used in place,
+//  - for a std::string or a TFRecord: its bytes,
+//  - for a scalar: its value, in 8 bytes.
+// Every value is padded to a multiple of 8 bytes. The elements are appended
+// to a file with a unique temporary name as they become available, and the
+// number of elements is written to the FileHeader once the input reaches end.
+// The file is then renamed, so that a file at the cache path is always
+// complete.
+
+#include "cache_dataset.h"
+
+#include <cstddef>
+#include <cstring>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include "tf_record_dataset.h"
+#include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/host_context/host_buffer.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/tensor/btf.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+
+namespace tfrt {
+namespace data {
+namespace {
+
+constexpr char kMagic[8] = {'T', 'F', 'R', 'T', 'C', 'C', 'H', '2'};
+constexpr size_t kTensorAlignment = 64;
+
+struct FileHeader {
+  char magic[8];
+  // The number of values of each element.
+  uint64_t num_values;
+  uint64_t num_elements;
+};
+
+enum class ValueKind : uint8_t {
+  kDenseHostTensor = 0,
+  kString = 1,
+  kTFRecord = 2,
+  kInt32 = 3,
+  kInt64 = 4,
+  kFloat = 5,
+  kDouble = 6,
+  kBool = 7,
+};
+
+struct ValueHeader {
+  ValueKind kind;
+  // The btf::TensorDType of a DenseHostTensor.
+  uint8_t dtype;
+  uint8_t padding[6];
+  // The rank of a DenseHostTensor, or the number of bytes of a std::string or
+  // a TFRecord.
+  uint64_t size;
+};
+
+static_assert(sizeof(FileHeader) == 24, "FileHeader packed to the wrong size.");
+static_assert(sizeof(ValueHeader) == 16,
+              "ValueHeader packed to the wrong size.");
+
+// Returns true if `input` and `cached` have the same type, and the same dtype
+// if they are DenseHostTensors.
+bool IsSameType(const AsyncValue& input, const AsyncValue& cached) {
+  if (input.IsType<DenseHostTensor>()) {
+    return cached.IsType<DenseHostTensor>() &&
+           input.get<DenseHostTensor>().dtype() ==
+               cached.get<DenseHostTensor>().dtype();
+  }
+  return input.IsType<std::string>() == cached.IsType<std::string>() &&
+         input.IsType<TFRecord>() == cached.IsType<TFRecord>() &&
+         input.IsType<int32_t>() == cached.IsType<int32_t>() &&
+         input.IsType<int64_t>() == cached.IsType<int64_t>() &&
+         input.IsType<float>() == cached.IsType<float>() &&
+         input.IsType<double>() == cached.IsType<double>() &&
+         input.IsType<bool>() == cached.IsType<bool>();
+}
+
+}  // namespace
+
+// Writes the elements to a cache file under a unique temporary name, and
+// renames it to the cache path once it is complete. The temporary file is
+// removed if the writer is destroyed before.
+class CacheFileWriter {
+ public:
+  // Creates the temporary file next to `path`, and writes the FileHeader for
+  // elements with `num_values` values each.
+  static Expected<std::unique_ptr<CacheFileWriter>> Create(
+      const std::string& path, size_t num_values) {
+    int fd;
+    llvm::SmallString<128> temp_path;
+    if (auto error_code = llvm::sys::fs::createUniqueFile(
+            path + ".tmp-%%%%%%%%", fd, temp_path)) {
+      return MakeStringError("failed to create a temporary file for ", path,
+                             ": ", error_code.message());
+    }
+    std::unique_ptr<CacheFileWriter> writer(
+        new CacheFileWriter(fd, path, temp_path.str().str()));
+    FileHeader header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.num_values = num_values;
+    writer->Write(&header, sizeof(header));
+    return std::move(writer);
+  }
+
+  ~CacheFileWriter() {
+    if (is_committed_) return;
+    os_.close();
+    os_.clear_error();
+    llvm::sys::fs::remove(temp_path_);
+  }
+
+  Error WriteElement(const IterationResult& element) {
+    for (const auto& value : element.values) {
+      if (auto error = WriteValue(*value)) return error;
+    }
+    ++num_elements_;
+    return Error::success();
+  }
+
+  // Completes the file and renames it to the cache path.
+  Error Commit() {
+    os_.pwrite(reinterpret_cast<const char*>(&num_elements_),
+               sizeof(num_elements_), offsetof(FileHeader, num_elements));
+    os_.close();
+    if (os_.has_error()) {
+      return MakeStringError("failed to write ", temp_path_, ": ",
+                             os_.error().message());
+    }
+    if (auto error_code = llvm::sys::fs::rename(temp_path_, path_)) {
+      return MakeStringError("failed to rename ", temp_path_, " to ", path_,
+                             ": ", error_code.message());
+    }
+    is_committed_ = true;
+    return Error::success();
+  }
+
+ private:
+  CacheFileWriter(int fd, std::string path, std::string temp_path)
+      : os_(fd, /*shouldClose=*/true),
+        path_(std::move(path)),
+        temp_path_(std::move(temp_path)) {}
+
+  Error WriteValue(const AsyncValue& value) {
+    if (value.IsType<DenseHostTensor>()) {
+      return WriteTensor(value.get<DenseHostTensor>());
+    } else if (value.IsType<std::string>()) {
+      WriteBytes(ValueKind::kString, value.get<std::string>());
+    } else if (value.IsType<TFRecord>()) {
+      WriteBytes(ValueKind::kTFRecord, value.get<TFRecord>().data);
+    } else if (value.IsType<int32_t>()) {
+      WriteScalar(ValueKind::kInt32, value.get<int32_t>());
+    } else if (value.IsType<int64_t>()) {
+      WriteScalar(ValueKind::kInt64, value.get<int64_t>());
+    } else if (value.IsType<float>()) {
+      WriteScalar(ValueKind::kFloat, value.get<float>());
+    } else if (value.IsType<double>()) {
+      WriteScalar(ValueKind::kDouble, value.get<double>());
+    } else if (value.IsType<bool>()) {
+      WriteScalar(ValueKind::kBool, value.get<bool>());
+    } else {
+      return MakeStringError("cache file does not support the value type");
+    }
+    return Error::success();
+  }
+
+  Error WriteTensor(const DenseHostTensor& tensor) {
+    auto dtype = btf::ToTensorDType(tensor.dtype());
+    if (!dtype) return dtype.takeError();
+
+    SmallVector<Index, 4> dims;
+    tensor.shape().GetDimensions(&dims);
+    ValueHeader header = {};
+    header.kind = ValueKind::kDenseHostTensor;
+    header.dtype = static_cast<uint8_t>(*dtype);
+    header.size = dims.size();
+    Write(&header, sizeof(header));
+    Write(dims.data(), dims.size() * sizeof(Index));
+    Pad(kTensorAlignment);
+    Write(tensor.data(), tensor.DataSizeInBytes());
+    Pad(8);
+    return Error::success();
+  }
+
+  void WriteBytes(ValueKind kind, string_view bytes) {
+    ValueHeader header = {};
+    header.kind = kind;
+    header.size = bytes.size();
+    Write(&header, sizeof(header));
+    Write(bytes.data(), bytes.size());
+    Pad(8);
+  }
+
+  template <typename T>
+  void WriteScalar(ValueKind kind, T value) {
+    static_assert(sizeof(T) <= sizeof(uint64_t), "scalar is too large");
+    ValueHeader header = {};
+    header.kind = kind;
+    Write(&header, sizeof(header));
+    uint64_t bytes = 0;
+    std::memcpy(&bytes, &value, sizeof(T));
+    Write(&bytes, sizeof(bytes));
+  }
+
+  void Write(const void* data, size_t size) {
+    os_.write(static_cast<const char*>(data), size);
+    offset_ += size;
+  }
+
+  void Pad(size_t alignment) {
+    static constexpr char kZeros[kTensorAlignment] = {};
+    Write(kZeros, llvm::alignTo(offset_, alignment) - offset_);
+  }
+
+  llvm::raw_fd_ostream os_;
+  const std::string path_;
+  const std::string temp_path_;
+  // The offset of the next value in the file.
+  size_t offset_ = 0;
+  uint64_t num_elements_ = 0;
+  bool is_committed_ = false;
+};
+
+namespace {
+
+// The contents of a cache file that were read into memory, for file systems
+// that do not support memory mapped files.
+class CacheFileContents : public ::tfrt::io::MemoryMappedFile {
+ public:
+  explicit CacheFileContents(RCReference<HostBuffer> buffer)
+      : buffer_(std::move(buffer)) {}
+
+  string_view data() const override {
+    return string_view(static_cast<const char*>(buffer_->data()),
+                       buffer_->size());
+  }
+
+ private:
+  RCReference<HostBuffer> buffer_;
+};
+
+// Maps the cache file at `path` into memory, or reads it if the file system
+// does not support memory mapped files.
+Expected<RCReference<::tfrt::io::MemoryMappedFile>> OpenCacheFile(
+    const std::string& path, HostAllocator* allocator) {
+  auto* file_system = ::tfrt::io::FileSystemRegistry::Default()->Lookup("");
+  if (!file_system) {
+    return MakeStringError("No file system is found for the given scheme");
+  }
+
+  std::unique_ptr<::tfrt::io::RandomAccessFile> file;
+  if (auto error = file_system->NewRandomAccessFile(path, &file)) {
+    return std::move(error);
+  }
+  RCReference<::tfrt::io::MemoryMappedFile> mapped_file;
+  auto error = file_system->NewMemoryMappedFile(path, &mapped_file);
+  if (!error) return std::move(mapped_file);
+  llvm::consumeError(std::move(error));
+
+  std::string contents;
+  constexpr size_t kChunkSize = 1 << 20;
+  while (true) {
+    size_t offset = contents.size();
+    contents.resize(offset + kChunkSize);
+    auto count = file->Read(&contents[offset], kChunkSize, offset);
+    if (!count) return count.takeError();
+    contents.resize(offset + *count);
+    if (*count < kChunkSize) break;
+  }
+  // Copy the contents into an aligned buffer, so that tensors can be used in
+  // place.
+  auto buffer = HostBuffer::CreateUninitialized(contents.size(),
+                                                kTensorAlignment, allocator);
+  if (!buffer) return MakeStringError("failed to allocate ", contents.size());
+  std::memcpy(buffer->data(), contents.data(), contents.size());
+  return TakeRef(new CacheFileContents(std::move(buffer)));
+}
+
+// Reads the values of the element at `*offset` of the cache `file` into
+// `values`, and advances `*offset` to the next element.
+Error ReadCachedElement(const RCReference<::tfrt::io::MemoryMappedFile>& file,
+                        size_t num_values, size_t* offset, HostContext* host,
+                        SmallVectorImpl<RCReference<AsyncValue>>* values) {
+  string_view data = file->data();
+  // Returns the next `size` bytes of the file, or nullptr past its end.
+  auto read = [&](size_t size) -> const char* {
+    if (size > data.size() || *offset > data.size() - size) return nullptr;
+    const char* bytes = data.data() + *offset;
+    *offset += size;
+    return bytes;
+  };
+  auto corrupted = [&]() {
+    return MakeStringError("corrupted cache file at offset ", *offset);
+  };
+
+  for (size_t i = 0; i < num_values; ++i) {
+    const char* bytes = read(sizeof(ValueHeader));
+    if (!bytes) return corrupted();
+    ValueHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+
+    switch (header.kind) {
+      case ValueKind::kDenseHostTensor: {
+        if (header.dtype > static_cast<uint8_t>(btf::TensorDType::kUInt64) ||
+            header.size > data.size() / sizeof(Index))
+          return corrupted();
+        SmallVector<Index, 4> dims(header.size);
+        if (!(bytes = read(dims.size() * sizeof(Index)))) return corrupted();
+        std::memcpy(dims.data(), bytes, dims.size() * sizeof(Index));
+        *offset = llvm::alignTo(*offset, kTensorAlignment);
+
+        TensorMetadata metadata(
+            btf::ToDTypeKind(static_cast<btf::TensorDType>(header.dtype)),
+            dims);
+        size_t size = metadata.GetHostSizeInBytes();
+        if (!(bytes = read(size))) return corrupted();
+        // The buffer keeps the file alive. Buffers with a custom deallocator
+        // are never modified in place, which keeps the read-only mapping safe.
+        auto buffer = HostBuffer::CreateFromExternal(
+            const_cast<char*>(bytes), size,
+            [file = file.CopyRef()](void*, size_t) {});
+        values->push_back(MakeAvailableAsyncValueRef<DenseHostTensor>(
+                              host, metadata, std::move(buffer))
+                              .ReleaseRCRef());
+        break;
+      }
+      case ValueKind::kString:
+      case ValueKind::kTFRecord: {
+        if (!(bytes = read(header.size))) return corrupted();
+        if (header.kind == ValueKind::kString) {
+          values->push_back(
+              MakeAvailableAsyncValueRef<std::string>(host, bytes, header.size)
+                  .ReleaseRCRef());
+        } else {
+          values->push_back(
+              MakeAvailableAsyncValueRef<TFRecord>(
+                  host, file.CopyRef(), string_view(bytes, header.size))
+                  .ReleaseRCRef());
+        }
+        break;
+      }
+      case ValueKind::kInt32:
+      case ValueKind::kInt64:
+      case ValueKind::kFloat:
+      case ValueKind::kDouble:
+      case ValueKind::kBool: {
+        if (!(bytes = read(sizeof(uint64_t)))) return corrupted();
+        auto read_scalar = [&](auto value) {
+          std::memcpy(&value, bytes, sizeof(value));
+          values->push_back(
+              MakeAvailableAsyncValueRef<decltype(value)>(host, value)
+                  .ReleaseRCRef());
+        };
+        if (header.kind == ValueKind::kInt32) read_scalar(int32_t{});
+        if (header.kind == ValueKind::kInt64) read_scalar(int64_t{});
+        if (header.kind == ValueKind::kFloat) read_scalar(float{});
+        if (header.kind == ValueKind::kDouble) read_scalar(double{});
+        if (header.kind == ValueKind::kBool) read_scalar(bool{});
+        break;
+      }
+      default:
+        return corrupted();
+    }
+    *offset = llvm::alignTo(*offset, 8);
+  }
+  return Error::success();
+}
+
+}  // namespace
+
+//===----------------------------------------------------------------------===//
+// CacheDataset methods
+//===----------------------------------------------------------------------===//
+RCReference<Iterator> CacheDataset::MakeIterator(
+    const IteratorContext& context) {
+  mutex_lock lock(mu_);
+  MaybeLoadCacheFile();
+  if (is_complete_) {
+    if (path_.empty()) {
+      return TakeRef(host_->Construct<MemoryCacheIterator>(FormRef(this)));
+    }
+    // Until a pass over a cache file from an earlier run has checked it, the
+    // iterators read the input along with the file.
+    RCReference<Iterator> input_iterator;
+    if (!is_verified_) input_iterator = input_dataset_->MakeIterator(context);
+    return TakeRef(host_->Construct<FileCacheIterator>(
+        FormRef(this), std::move(input_iterator)));
+  }
+  bool is_writing = !is_writing_;
+  is_writing_ = true;
+  return TakeRef(host_->Construct<CacheDatasetIterator>(FormRef(this), context,
+                                                        is_writing));
+}
+
+void CacheDataset::MaybeLoadCacheFile() {
+  if (path_.empty() || checked_cache_file_) return;
+  checked_cache_file_ = true;
+  is_verified_ = false;
+
+  auto file = OpenCacheFile(path_, allocator_);
+  // There is no cache file yet.
+  if (!file) {
+    llvm::consumeError(file.takeError());
+    return;
+  }
+  string_view data = (*file)->data();
+  FileHeader header;
+  if (data.size() < sizeof(header)) return;
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) return;
+
+  num_values_ = header.num_values;
+  num_elements_ = header.num_elements;
+  cache_file_ = std::move(*file);
+  is_complete_ = true;
+}
+
+void CacheDataset::FinishWrite(std::vector<IterationResult> elements,
+                               size_t num_values) {
+  mutex_lock lock(mu_);
+  is_writing_ = false;
+  if (!path_.empty()) {
+    // Map the file that was just written. It holds the elements of the input.
+    checked_cache_file_ = false;
+    MaybeLoadCacheFile();
+    is_verified_ = true;
+    return;
+  }
+  num_values_ = num_values;
+  cached_elements_ = std::move(elements);
+  is_complete_ = true;
+}
+
+void CacheDataset::AbortWrite() {
+  mutex_lock lock(mu_);
+  is_writing_ = false;
+}
+
+void CacheDataset::MarkCacheFileVerified() {
+  mutex_lock lock(mu_);
+  is_verified_ = true;
+}
+
+//===----------------------------------------------------------------------===//
+// CacheDatasetIterator methods
+//===----------------------------------------------------------------------===//
+CacheDatasetIterator::CacheDatasetIterator(
+    RCReference<CacheDataset> parent_dataset, const IteratorContext& context,
+    bool is_writing)
+    : Iterator(),
+      parent_dataset_(std::move(parent_dataset)),
+      input_iterator_(parent_dataset_->input_dataset_->MakeIterator(context)),
+      is_writing_(is_writing),
+      is_write_done_(!is_writing) {}
+
+CacheDatasetIterator::~CacheDatasetIterator() {}
+
+IterationResult CacheDatasetIterator::GetNext(
+    const ExecutionContext& exec_ctx) {
+  auto input = input_iterator_->GetNext(exec_ctx);
+  auto result = input.CopyRef();
+  {
+    mutex_lock lock(mu_);
+    if (!is_writing_) return input;
+    PendingElement element{input.CopyRef(), {}};
+    // Most elements are known not to be the end when they are returned.
+    if (!input.eof.IsConcrete() || input.eof.get()) {
+      element.eof = MakeUnconstructedAsyncValueRef<bool>(exec_ctx.host());
+      result.eof = element.eof.CopyRef();
+    }
+    pending_elements_.push(std::move(element));
+  }
+  RunWhenReady(input.AsyncValues(),
+               [iterator = FormRef(this)] { iterator->MaybeWriteElements(); });
+  return result;
+}
+
+void CacheDatasetIterator::MaybeWriteElements() {
+  {
+    mutex_lock lock(mu_);
+    if (is_write_running_) return;
+    is_write_running_ = true;
+  }
+  // Elements cached in memory are only moved, and do not need to be written
+  // in the blocking work queue.
+  if (parent_dataset_->path_.empty()) {
+    WriteElements();
+    return;
+  }
+  bool enqueued = EnqueueBlockingWork(
+      parent_dataset_->host_,
+      [iterator = FormRef(this)] { iterator->WriteElements(); });
+  if (!enqueued) {
+    AbortWrite();
+    write_error_ = "failed to enqueue the cache file write";
+    WriteElements();
+  }
+}
+
+void CacheDatasetIterator::WriteElements() {
+  while (true) {
+    Optional<PendingElement> element;
+    {
+      mutex_lock lock(mu_);
+      // Elements are written in order, so stop at the first element that is
+      // not available. It calls MaybeWriteElements() once it is.
+      if (pending_elements_.empty() ||
+          !internal::IsAvailable(pending_elements_.front().input)) {
+        is_write_running_ = false;
+        return;
+      }
+      element.emplace(std::move(pending_elements_.front()));
+      pending_elements_.pop();
+    }
+    WriteElement(std::move(*element));
+  }
+}
+
+void CacheDatasetIterator::WriteElement(PendingElement element) {
+  const auto& input = element.input;
+  if (!is_write_done_) {
+    if (input.eof.IsError() || (!input.eof.get() &&
+                                llvm::any_of(input.values, [](const auto& v) {
+                                  return v->IsError();
+                                }))) {
+      // Do not cache errors.
+      AbortWrite();
+    } else if (input.eof.get()) {
+      if (auto error = FinishWrite(input.values.size())) {
+        write_error_ = StrCat(error);
+      }
+    } else if (parent_dataset_->path_.empty()) {
+      elements_.push_back(input.CopyRef());
+    } else {
+      if (!writer_) {
+        auto writer = CacheFileWriter::Create(parent_dataset_->path_,
+                                              input.values.size());
+        if (writer) {
+          writer_ = std::move(*writer);
+        } else {
+          write_error_ = StrCat(writer.takeError());
+        }
+      }
+      if (writer_) {
+        if (auto error = writer_->WriteElement(input)) {
+          write_error_ = StrCat(error);
+        }
+      }
+      if (!write_error_.empty()) AbortWrite();
+    }
+  }
+
+  if (!element.eof) return;
+  if (input.eof.IsError()) {
+    element.eof.SetError(input.eof.GetError());
+  } else if (input.eof.get() && !write_error_.empty()) {
+    element.eof.SetError(write_error_);
+  } else {
+    element.eof.emplace(input.eof.get());
+  }
+}
+
+Error CacheDatasetIterator::FinishWrite(size_t num_values) {
+  const auto& path = parent_dataset_->path_;
+  if (!path.empty()) {
+    // The input has no elements.
+    if (!writer_) {
+      auto writer = CacheFileWriter::Create(path, num_values);
+      if (!writer) {
+        AbortWrite();
+        return writer.takeError();
+      }
+      writer_ = std::move(*writer);
+    }
+    if (auto error = writer_->Commit()) {
+      AbortWrite();
+      return error;
+    }
+    writer_.reset();
+  }
+  {
+    mutex_lock lock(mu_);
+    is_writing_ = false;
+  }
+  is_write_done_ = true;
+  parent_dataset_->FinishWrite(std::move(elements_), num_values);
+  return Error::success();
+}
+
+void CacheDatasetIterator::AbortWrite() {
+  {
+    mutex_lock lock(mu_);
+    is_writing_ = false;
+  }
+  is_write_done_ = true;
+  elements_.clear();
+  // Removes the temporary cache file.
+  writer_.reset();
+  parent_dataset_->AbortWrite();
+}
+
+void CacheDatasetIterator::Destroy() {
+  // The input iterator has not reached end. All elements returned by GetNext()
+  // have been written, since writing them holds a reference to this iterator.
+  if (!is_write_done_) AbortWrite();
+  internal::DestroyImpl<CacheDatasetIterator>(this,
+                                              parent_dataset_->allocator_);
+}
+
+//===----------------------------------------------------------------------===//
+// MemoryCacheIterator methods
+//===----------------------------------------------------------------------===//
+IterationResult MemoryCacheIterator::GetNext(const ExecutionContext& exec_ctx) {
+  const auto& elements = parent_dataset_->cached_elements_;
+  if (next_index_ == elements.size()) {
+    return IterationResult::Eof(exec_ctx.host(), parent_dataset_->num_values_);
+  }
+  return elements[next_index_++].CopyRef();
+}
+
+//===----------------------------------------------------------------------===//
+// FileCacheIterator methods
+//===----------------------------------------------------------------------===//
+FileCacheIterator::FileCacheIterator(RCReference<CacheDataset> parent_dataset,
+                                     RCReference<Iterator> input_iterator)
+    : Iterator(),
+      parent_dataset_(std::move(parent_dataset)),
+      input_iterator_(std::move(input_iterator)),
+      offset_(sizeof(FileHeader)) {}
+
+IterationResult FileCacheIterator::GetNext(const ExecutionContext& exec_ctx) {
+  auto* host = exec_ctx.host();
+  const size_t index = next_index_;
+  IterationResult cached = ReadNext(host);
+  if (!input_iterator_) return cached;
+
+  IterationResult input = input_iterator_->GetNext(exec_ctx);
+  if (internal::IsAvailable(input))
+    return Verify(input, std::move(cached), index, host);
+
+  const size_t num_values = parent_dataset_->num_values_;
+  SmallVector<RCReference<AsyncValue>, 4> result_values;
+  result_values.resize(num_values);
+  for (size_t i = 0; i < num_values; ++i) {
+    result_values[i] = MakeIndirectAsyncValue(host);
+  }
+  auto result = IterationResult::Pending(
+      std::move(result_values), MakeUnconstructedAsyncValueRef<bool>(host));
+  auto input_values = input.AsyncValues();
+  auto verify = [iterator = FormRef(this), input = std::move(input),
+                 cached = std::move(cached), result = result.CopyRef(), index,
+                 host]() mutable {
+    auto verified = iterator->Verify(input, std::move(cached), index, host);
+    for (size_t i = 0; i < result.values.size(); ++i) {
+      auto* output_value = cast<IndirectAsyncValue>(result.values[i].get());
+      output_value->ForwardTo(std::move(verified.values[i]));
+    }
+    if (verified.eof.IsError()) {
+      result.eof.SetError(verified.eof.GetError());
+    } else {
+      result.eof.emplace(verified.eof.get());
+    }
+  };
+  RunWhenReady(input_values, std::move(verify));
+  return result;
+}
+
+IterationResult FileCacheIterator::ReadNext(HostContext* host) {
+  const auto& file = parent_dataset_->cache_file_;
+  const size_t num_values = parent_dataset_->num_values_;
+  if (next_index_ == parent_dataset_->num_elements_) {
+    return IterationResult::Eof(host, num_values);
+  }
+
+  SmallVector<RCReference<AsyncValue>, 4> values;
+  if (auto error =
+          ReadCachedElement(file, num_values, &offset_, host, &values)) {
+    // Do not read past a corrupted element.
+    next_index_ = parent_dataset_->num_elements_;
+    return IterationResult::Error(MakeErrorAsyncValueRef(host, StrCat(error)),
+                                  num_values);
+  }
+  ++next_index_;
+  return IterationResult::Values(std::move(values), host);
+}
+
+IterationResult FileCacheIterator::Verify(const IterationResult& input,
+                                          IterationResult cached, size_t index,
+                                          HostContext* host) {
+  const size_t num_values = parent_dataset_->num_values_;
+  if (cached.eof.IsError()) return cached;
+  if (input.eof.IsError()) {
+    return IterationResult::Error(input.eof.CopyRCRef(), num_values);
+  }
+
+  auto mismatch = [&](auto&&... details) {
+    return IterationResult::Error(
+        MakeErrorAsyncValueRef(
+            host, StrCat("cache file ", parent_dataset_->path_,
+                         " does not match the input dataset: ", details...)),
+        num_values);
+  };
+  const size_t num_elements = parent_dataset_->num_elements_;
+  if (input.eof.get() != cached.eof.get()) {
+    if (input.eof.get()) {
+      return mismatch("the input has ", index, " elements, the file has ",
+                      num_elements);
+    }
+    return mismatch("the input has more than ", num_elements,
+                    " elements, as many as the file");
+  }
+  if (cached.eof.get()) {
+    CountMatch();
+    return cached;
+  }
+
+  if (input.values.size() != num_values) {
+    return mismatch("the input has ", input.values.size(),
+                    " values per element, the file has ", num_values);
+  }
+  for (size_t i = 0; i < num_values; ++i) {
+    if (input.values[i]->IsError()) {
+      return IterationResult::Error(input.values[i], num_values);
+    }
+    if (!IsSameType(*input.values[i], *cached.values[i])) {
+      return mismatch("value ", i, " of element ", index,
+                      " has a different type");
+    }
+  }
+  CountMatch();
+  return cached;
+}
+
+void FileCacheIterator::CountMatch() {
+  // The file is verified once all elements and the end match the input.
+  size_t num_matches = num_matches_.fetch_add(1) + 1;
+  if (num_matches == parent_dataset_->num_elements_ + 1)
+    parent_dataset_->MarkCacheFileVerified();
+}
+
+}  // namespace data
+}  // namespace tfrt
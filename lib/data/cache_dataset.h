@@ -0,0 +1,267 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares CacheDataset class, which caches the elements of its
+// input dataset in memory or in a file.
+
+#ifndef TFRT_LIB_DATA_CACHE_DATASET_H_
+#define TFRT_LIB_DATA_CACHE_DATASET_H_
+
+#include <atomic>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "tfrt/data/dataset.h"
+#include "tfrt/io/file_system.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace data {
+
+class CacheDatasetIterator;
+class CacheFileWriter;
+class MemoryCacheIterator;
+class FileCacheIterator;
+
+// CacheDataset stores the elements of its input dataset during the first pass
+// over the input that reaches its end, and serves the following passes, e.g.
+// the following epochs of a RepeatDataset, from the cache.
+//
+// If `path` is empty, the elements are kept in memory and later passes return
+// the same values, without copying them. Consumers must therefore not modify
+// the values in place. Otherwise the elements are written to a file with a
+// unique temporary name as they become available, and the file is renamed to
+// `path` once the input reaches end. The file is memory mapped to read them
+// back: DenseHostTensor and TFRecord values point into the mapping and other
+// values are copied out of it.
+//
+// A cache file left at `path` by an earlier run is reused, but the first pass
+// over it also reads the input, and returns an error if the input has a
+// different number of elements or values of different types. The following
+// passes only read the file.
+//
+// Only one iterator writes the cache at a time, and iterators created while
+// it does read the input without caching it. If the writing iterator is
+// destroyed before the end of the input, or if the input produces an error,
+// the elements, or the temporary file, are discarded and the next iterator
+// writes the cache again.
+class CacheDataset : public Dataset {
+ public:
+  explicit CacheDataset(RCReference<Dataset> input_dataset, std::string path,
+                        HostContext* host)
+      : input_dataset_(std::move(input_dataset)),
+        path_(std::move(path)),
+        host_(host),
+        allocator_(host->allocator()) {}
+
+  // This class is not copyable or movable.
+  CacheDataset(const CacheDataset&) = delete;
+  CacheDataset& operator=(const CacheDataset&) = delete;
+
+  RCReference<Iterator> MakeIterator(const IteratorContext& context) override;
+
+ private:
+  // Allow iterator to rely on private data members of this dataset.
+  friend class CacheDatasetIterator;
+  friend class MemoryCacheIterator;
+  friend class FileCacheIterator;
+
+  void Destroy() override {
+    internal::DestroyImpl<CacheDataset>(this, allocator_);
+  }
+
+  // Completes the cache. If path_ is empty, `elements` are all elements of
+  // the input with `num_values` values each. Otherwise the cache file has
+  // been written to path_.
+  void FinishWrite(std::vector<IterationResult> elements, size_t num_values)
+      TFRT_EXCLUDES(mu_);
+
+  // Allows the next iterator to write the cache.
+  void AbortWrite() TFRT_EXCLUDES(mu_);
+
+  // Uses the file at path_ as the cache if it is a complete cache file.
+  void MaybeLoadCacheFile() TFRT_REQUIRES(mu_);
+
+  // Records that a pass over the cache file matched the input.
+  void MarkCacheFileVerified() TFRT_EXCLUDES(mu_);
+
+  RCReference<Dataset> input_dataset_;
+  const std::string path_;
+  HostContext* host_;
+  HostAllocator* allocator_;
+
+  mutex mu_;
+  // Whether an iterator is writing the cache.
+  bool is_writing_ TFRT_GUARDED_BY(mu_) = false;
+  bool is_complete_ TFRT_GUARDED_BY(mu_) = false;
+  bool checked_cache_file_ TFRT_GUARDED_BY(mu_) = false;
+  // Whether the cache file is known to hold the elements of the input, either
+  // because it was written from the input or because a pass over it matched.
+  bool is_verified_ TFRT_GUARDED_BY(mu_) = false;
+
+  // The fields below are set before is_complete_ becomes true, and are not
+  // modified afterwards.
+  size_t num_values_ = 0;
+  // The number of elements in the cache file if path_ is not empty.
+  size_t num_elements_ = 0;
+  // The cached elements if path_ is empty.
+  std::vector<IterationResult> cached_elements_;
+  // The contents of the cache file if path_ is not empty.
+  RCReference<::tfrt::io::MemoryMappedFile> cache_file_;
+};
+
+// This iterator returns the elements of the input iterator. If it writes the
+// cache, it also writes each element in order once it is available: in memory
+// if the path of the dataset is empty, and to the temporary cache file in the
+// blocking work queue otherwise. The end is only returned after the cache is
+// complete, so that the next pass is served from the cache.
+class CacheDatasetIterator : public Iterator {
+ public:
+  explicit CacheDatasetIterator(RCReference<CacheDataset> parent_dataset,
+                                const IteratorContext& context,
+                                bool is_writing);
+  ~CacheDatasetIterator() override;
+
+  // This class is not copyable or movable.
+  CacheDatasetIterator(const CacheDatasetIterator&) = delete;
+  CacheDatasetIterator& operator=(const CacheDatasetIterator&) = delete;
+
+  IterationResult GetNext(const ExecutionContext& exec_ctx) override;
+
+ private:
+  // An element returned by GetNext() that is not written yet.
+  struct PendingElement {
+    IterationResult input;
+    // The eof returned in place of the eof of `input`, if that was not known
+    // to be false. It is set once `input` is written.
+    AsyncValueRef<bool> eof;
+  };
+
+  void Destroy() override;
+
+  // Starts writing the pending elements, unless it is already running.
+  void MaybeWriteElements() TFRT_EXCLUDES(mu_);
+
+  // Writes the available pending elements in order.
+  void WriteElements() TFRT_EXCLUDES(mu_);
+
+  // Writes `element` to the cache and sets its eof.
+  void WriteElement(PendingElement element) TFRT_EXCLUDES(mu_);
+
+  // Completes the cache with the elements written so far, which have
+  // `num_values` values each.
+  Error FinishWrite(size_t num_values) TFRT_EXCLUDES(mu_);
+
+  // Discards the elements written so far, and lets the next iterator write
+  // the cache.
+  void AbortWrite() TFRT_EXCLUDES(mu_);
+
+  RCReference<CacheDataset> parent_dataset_;
+  RCReference<Iterator> input_iterator_;
+
+  mutex mu_;
+  // Whether this iterator still writes the cache.
+  bool is_writing_ TFRT_GUARDED_BY(mu_);
+  // The elements returned but not written yet, in order.
+  std::queue<PendingElement> pending_elements_ TFRT_GUARDED_BY(mu_);
+  // Whether WriteElements() is running or scheduled.
+  bool is_write_running_ TFRT_GUARDED_BY(mu_) = false;
+
+  // The fields below are only accessed by WriteElements().
+  // Whether the cache is complete or aborted.
+  bool is_write_done_ = false;
+  // The error to return at the end of the input if the cache file could not
+  // be written.
+  std::string write_error_;
+  // The elements written so far if the path of the dataset is empty.
+  std::vector<IterationResult> elements_;
+  // The temporary cache file if the path of the dataset is not empty. It is
+  // created with the first element.
+  std::unique_ptr<CacheFileWriter> writer_;
+};
+
+// This iterator returns the elements cached in memory.
+class MemoryCacheIterator : public Iterator {
+ public:
+  explicit MemoryCacheIterator(RCReference<CacheDataset> parent_dataset)
+      : Iterator(), parent_dataset_(std::move(parent_dataset)) {}
+
+  // This class is not copyable or movable.
+  MemoryCacheIterator(const MemoryCacheIterator&) = delete;
+  MemoryCacheIterator& operator=(const MemoryCacheIterator&) = delete;
+
+  IterationResult GetNext(const ExecutionContext& exec_ctx) override;
+
+ private:
+  void Destroy() override {
+    internal::DestroyImpl<MemoryCacheIterator>(this,
+                                               parent_dataset_->allocator_);
+  }
+
+  RCReference<CacheDataset> parent_dataset_;
+  // The index of the next element in the cache file.
+  size_t next_index_ = 0;
+};
+
+// This iterator reads the elements cached in a file.
+class FileCacheIterator : public Iterator {
+ public:
+  // If `input_iterator` is not null, the elements of the cache file are
+  // checked against its elements.
+  explicit FileCacheIterator(RCReference<CacheDataset> parent_dataset,
+                             RCReference<Iterator> input_iterator);
+
+  // This class is not copyable or movable.
+  FileCacheIterator(const FileCacheIterator&) = delete;
+  FileCacheIterator& operator=(const FileCacheIterator&) = delete;
+
+  IterationResult GetNext(const ExecutionContext& exec_ctx) override;
+
+ private:
+  void Destroy() override {
+    internal::DestroyImpl<FileCacheIterator>(this, parent_dataset_->allocator_);
+  }
+
+  // Returns the next element of the cache file.
+  IterationResult ReadNext(HostContext* host);
+
+  // Returns `cached`, the element at `index` of the cache file, if it has the
+  // same number and types of values as the available `input` element, or if
+  // both are the end. Returns an error otherwise.
+  IterationResult Verify(const IterationResult& input, IterationResult cached,
+                         size_t index, HostContext* host);
+
+  // Counts an element that matched the input.
+  void CountMatch();
+
+  RCReference<CacheDataset> parent_dataset_;
+  RCReference<Iterator> input_iterator_;
+  // The index of the next element in the cache file.
+  size_t next_index_ = 0;
+  // The offset of the next element in the cache file.
+  size_t offset_;
+  // The number of elements, including the end, that matched the input.
+  std::atomic<size_t> num_matches_{0};
+};
+
+}  // namespace data
+}  // namespace tfrt
+
+#endif  // TFRT_LIB_DATA_CACHE_DATASET_H_
@@ -14,7 +14,9 @@
 
 // This file implements data kernels.
 
+#include "autotune.h"
 #include "batch_dataset.h"
+#include "cache_dataset.h"
 #include "filter_dataset.h"
 #include "interleave_dataset.h"
 #include "log_dataset.h"
@@ -91,13 +93,27 @@ RCReference<RangeDataset> MakeRangeDataset(int64_t start, int64_t stop,
 // MapDataset
 //===----------------------------------------------------------------------===//
 
+// The optional attributes of map_dataset are sorted by name. The op verifier
+// only accepts is_deterministic together with num_parallel_calls, so a single
+// attribute is always num_parallel_calls.
 RCReference<MapDataset> MakeMapDataset(RCReference<Dataset>* dataset,
                                        RemainingArguments args,
                                        Attribute<Function> fn,
+                                       RemainingAttributes attributes,
                                        const ExecutionContext& exec_ctx) {
-  return TakeRef(exec_ctx.host()->Construct<MapDataset>(
+  bool is_deterministic = true;
+  int64_t num_parallel_calls = 1;
+  if (attributes.size() == 1) {
+    num_parallel_calls = attributes.Get<int64_t>(0).get();
+  } else if (attributes.size() == 2) {
+    is_deterministic = attributes.Get<bool>(0).get();
+    num_parallel_calls = attributes.Get<int64_t>(1).get();
+  }
+
+  HostContext* host = exec_ctx.host();
+  return TakeRef(host->Construct<MapDataset>(
       *dataset, RCArray<AsyncValue>(args.values()), FormRef(&fn.get()),
-      exec_ctx.host()));
+      num_parallel_calls, is_deterministic, host));
 }
 
 //===----------------------------------------------------------------------===//
@@ -129,19 +145,90 @@ RCReference<InterleaveDataset> MakeInterleaveDataset(
       exec_ctx.host()));
 }
 
+Expected<RCReference<InterleaveDataset>> MakeParallelInterleaveDataset(
+    RCReference<Dataset>* dataset, int64_t cycle_length, int64_t block_length,
+    int64_t buffer_output_elements, int64_t prefetch_input_elements,
+    Attribute<int64_t> arity, Attribute<Function> fn,
+    Attribute<bool> is_deterministic, const ExecutionContext& exec_ctx) {
+  assert(
+      fn->result_types().size() == 1 &&
+      "Interleave expects only one function output, which must be a dataset.");
+  if (cycle_length <= 0 && cycle_length != kAutotune) {
+    return MakeStringError(
+        "parallel_interleave_dataset: cycle_length must be positive or -1 to "
+        "autotune, got ",
+        cycle_length);
+  }
+  if (block_length <= 0) {
+    return MakeStringError(
+        "parallel_interleave_dataset: block_length must be positive, got ",
+        block_length);
+  }
+  if (buffer_output_elements <= 0) {
+    return MakeStringError(
+        "parallel_interleave_dataset: buffer_output_elements must be "
+        "positive, got ",
+        buffer_output_elements);
+  }
+  if (prefetch_input_elements < 0 && prefetch_input_elements != kAutotune) {
+    return MakeStringError(
+        "parallel_interleave_dataset: prefetch_input_elements must be "
+        "non-negative or -1 to autotune, got ",
+        prefetch_input_elements);
+  }
+
+  return TakeRef(exec_ctx.host()->Construct<InterleaveDataset>(
+      *dataset, cycle_length, block_length, buffer_output_elements,
+      prefetch_input_elements, is_deterministic.get(), FormRef(&fn.get()),
+      arity.get(), exec_ctx.host()));
+}
+
 //===----------------------------------------------------------------------===//
 // TFRecordDataset
 //===----------------------------------------------------------------------===//
 
+// Returns the optional max_prefetch_num attribute of the TFRecord dataset ops.
+static int64_t GetMaxPrefetchNum(RemainingAttributes attributes) {
+  if (attributes.size() == 0) return 80;
+  return attributes.Get<int64_t>(0).get();
+}
+
+static RCReference<TFRecordDataset> ConstructTFRecordDataset(
+    std::string path, int64_t buffer_size, int64_t max_prefetch_num,
+    bool use_mmap, const ExecutionContext& exec_ctx) {
+  // Prefetch again when a quarter of max_prefetch_num records are left, and
+  // start from the default of 80 records if it is autotuned.
+  bool autotune_prefetch = max_prefetch_num == kAutotune;
+  if (autotune_prefetch) max_prefetch_num = 80;
+  int64_t prefetch_threshold = max_prefetch_num / 4;
+  return TakeRef(exec_ctx.host()->Construct<TFRecordDataset>(
+      std::move(path), buffer_size, max_prefetch_num, prefetch_threshold,
+      autotune_prefetch, use_mmap, exec_ctx.host()));
+}
+
 RCReference<TFRecordDataset> MakeTFRecordDataset(
-    std::string path, const ExecutionContext& exec_ctx) {
+    std::string path, RemainingAttributes attributes,
+    const ExecutionContext& exec_ctx) {
   // Default buffer size to 256 KB.
   int64_t buffer_size = 256 * 1024;
-  int64_t max_prefetch_num = 80;
-  int64_t prefetch_threshold = 20;
-  return TakeRef(exec_ctx.host()->Construct<TFRecordDataset>(
-      std::move(path), buffer_size, max_prefetch_num, prefetch_threshold,
-      exec_ctx.host()));
+  return ConstructTFRecordDataset(std::move(path), buffer_size,
+                                  GetMaxPrefetchNum(attributes),
+                                  /*use_mmap=*/false, exec_ctx);
+}
+
+RCReference<TFRecordDataset> MakeMmapTFRecordDataset(
+    std::string path, RemainingAttributes attributes,
+    const ExecutionContext& exec_ctx) {
+  // Records are read straight from the mapping, so no buffer is needed.
+  return ConstructTFRecordDataset(std::move(path), /*buffer_size=*/0,
+                                  GetMaxPrefetchNum(attributes),
+                                  /*use_mmap=*/true, exec_ctx);
+}
+
+// Copies a record of tfrt_data.mmap_tf_record_dataset into a std::string, the
+// element type of tfrt_data.tf_record_dataset.
+static std::string TFRecordToString(Argument<TFRecord> record) {
+  return std::string(record->data);
 }
 
 //===----------------------------------------------------------------------===//
@@ -201,6 +288,18 @@ RCReference<BatchDataset<T...>> MakeBatchDataset(
       *dataset, batch_size, same_input_metadata.get(), host));
 }
 
+//===----------------------------------------------------------------------===//
+// CacheDataset
+//===----------------------------------------------------------------------===//
+
+RCReference<CacheDataset> MakeCacheDataset(RCReference<Dataset>* dataset,
+                                           std::string path,
+                                           const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  return TakeRef(
+      host->Construct<CacheDataset>(*dataset, std::move(path), host));
+}
+
 //===----------------------------------------------------------------------===//
 // PrefetchDataset
 //===----------------------------------------------------------------------===//
@@ -209,9 +308,6 @@ RCReference<PrefetchDataset> MakePrefetchDataset(
     RCReference<Dataset>* dataset, int64_t prefetch_num,
     Attribute<bool> is_deterministic, const ExecutionContext& exec_ctx) {
   HostContext* host = exec_ctx.host();
-  if (prefetch_num == -1) {
-    prefetch_num = host->GetNumWorkerThreads();
-  }
   return TakeRef(host->Construct<PrefetchDataset>(
       *dataset, prefetch_num, is_deterministic.get(), host));
 }
@@ -489,11 +585,17 @@ void RegisterDataKernels(KernelRegistry* registry) {
                       TFRT_KERNEL(MakeMemoryDataset<int64_t>));
   registry->AddKernel("tfrt_data.memory_dataset.str",
                       TFRT_KERNEL(MakeMemoryDataset<std::string>));
+  registry->AddKernel("tfrt_data.memory_dataset.tf_record",
+                      TFRT_KERNEL(MakeMemoryDataset<TFRecord>));
 
+  registry->AddKernel("tfrt_data.cache_dataset",
+                      TFRT_KERNEL(MakeCacheDataset));
   registry->AddKernel("tfrt_data.filter_dataset",
                       TFRT_KERNEL(MakeFilterDataset));
   registry->AddKernel("tfrt_data.interleave_dataset",
                       TFRT_KERNEL(MakeInterleaveDataset));
+  registry->AddKernel("tfrt_data.parallel_interleave_dataset",
+                      TFRT_KERNEL(MakeParallelInterleaveDataset));
   registry->AddKernel("tfrt_data.map_dataset", TFRT_KERNEL(MakeMapDataset));
   registry->AddKernel("tfrt_data.prefetch_dataset",
                       TFRT_KERNEL(MakePrefetchDataset));
@@ -502,6 +604,10 @@ void RegisterDataKernels(KernelRegistry* registry) {
   registry->AddKernel("tfrt_data.skip_dataset", TFRT_KERNEL(MakeSkipDataset));
   registry->AddKernel("tfrt_data.tf_record_dataset",
                       TFRT_KERNEL(MakeTFRecordDataset));
+  registry->AddKernel("tfrt_data.mmap_tf_record_dataset",
+                      TFRT_KERNEL(MakeMmapTFRecordDataset));
+  registry->AddKernel("tfrt_data.tf_record_to_string",
+                      TFRT_KERNEL(TFRecordToString));
   registry->AddKernel("tfrt_data.shuffle_dataset",
                       TFRT_KERNEL(MakeShuffleDataset));
   registry->AddKernel("tfrt_data.log_dataset", TFRT_KERNEL(MakeLogDataset));
@@ -24,6 +24,25 @@ bool IsConcreteAndEmpty(const IterationResult& result) {
   return result.eof.IsConcrete() && result.eof.get();
 }
 
+bool IsAvailable(const IterationResult& result) {
+  if (!result.eof.IsAvailable()) return false;
+  for (const auto& value : result.values) {
+    if (!value->IsAvailable()) return false;
+  }
+  return true;
+}
+
+bool IsAvailableAndNotEof(const IterationResult& result) {
+  return !IsConcreteAndEmpty(result) && IsAvailable(result);
+}
+
 }  // namespace internal
+
+void Iterator::GetNextBatch(const ExecutionContext& exec_ctx, size_t count,
+                            SmallVectorImpl<IterationResult>* results) {
+  results->reserve(results->size() + count);
+  for (size_t i = 0; i < count; ++i) results->push_back(GetNext(exec_ctx));
+}
+
 }  // namespace data
 }  // namespace tfrt
@@ -38,18 +38,20 @@ RCReference<Iterator> FilterDataset::MakeIterator(
 // FilterDatasetIterator methods
 //===----------------------------------------------------------------------===//
 
-IterationResult FilterDatasetIterator::GetNext(
-    const ExecutionContext& exec_ctx) {
-  auto* host = exec_ctx.host();
-
+IterationResult FilterDatasetIterator::MakePendingOutput(HostContext* host) {
   llvm::SmallVector<RCReference<AsyncValue>, 4> result_values;
   result_values.resize(parent_dataset_->arity_);
   for (size_t i = 0; i < parent_dataset_->arity_; ++i) {
     result_values[i] = MakeIndirectAsyncValue(host);
   }
   auto result_eof = MakeUnconstructedAsyncValueRef<bool>(host);
-  auto result =
-      IterationResult::Pending(std::move(result_values), std::move(result_eof));
+  return IterationResult::Pending(std::move(result_values),
+                                  std::move(result_eof));
+}
+
+IterationResult FilterDatasetIterator::GetNext(
+    const ExecutionContext& exec_ctx) {
+  auto result = MakePendingOutput(exec_ctx.host());
   {
     mutex_lock lock(mu_);
     output_buffer_.push(result.CopyRef());
@@ -58,6 +60,24 @@ IterationResult FilterDatasetIterator::GetNext(
   return result;
 }
 
+void FilterDatasetIterator::GetNextBatch(
+    const ExecutionContext& exec_ctx, size_t count,
+    SmallVectorImpl<IterationResult>* results) {
+  auto* host = exec_ctx.host();
+  results->reserve(results->size() + count);
+  const size_t first = results->size();
+  for (size_t i = 0; i < count; ++i)
+    results->push_back(MakePendingOutput(host));
+  // Enqueue the whole batch at once, so that the background task fetches the
+  // inputs for all of them in a single batch.
+  {
+    mutex_lock lock(mu_);
+    for (size_t i = first, e = results->size(); i < e; ++i)
+      output_buffer_.push((*results)[i].CopyRef());
+  }
+  MaybeScheduleBackgroundTask(exec_ctx, false, 0);
+}
+
 void FilterDatasetIterator::MaybeScheduleBackgroundTask(
     const ExecutionContext& exec_ctx, bool is_token_owner, int callback_count) {
   {
@@ -89,8 +109,10 @@ void FilterDatasetIterator::MaybeScheduleBackgroundTask(
                         input_and_predicate_buffer_.size() +
                         std::max(num_false_predicate_.load(), 0);
   const Function* filter_fn = parent_dataset_->filter_fn_.get();
-  for (int i = 0; i < input_fetch_num; i++) {
-    auto input = input_iterator_->GetNext(exec_ctx);
+  SmallVector<IterationResult, 16> inputs;
+  if (input_fetch_num > 0)
+    input_iterator_->GetNextBatch(exec_ctx, input_fetch_num, &inputs);
+  for (auto& input : inputs) {
     auto predicate_values =
         RunFunctionWhenReady(filter_fn, input.CopyRef().values, exec_ctx);
     assert(predicate_values.size() == 1);
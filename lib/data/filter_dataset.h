@@ -83,6 +83,9 @@ class FilterDatasetIterator : public Iterator {
 
   IterationResult GetNext(const ExecutionContext& exec_ctx) override;
 
+  void GetNextBatch(const ExecutionContext& exec_ctx, size_t count,
+                    SmallVectorImpl<IterationResult>* results) override;
+
  private:
   // This class is not copyable or movable.
   FilterDatasetIterator(const FilterDatasetIterator&) = delete;
@@ -107,6 +110,10 @@ class FilterDatasetIterator : public Iterator {
                                    bool is_token_owner, int callback_count)
       TFRT_EXCLUDES(mu_);
 
+  // Returns an unavailable output value, which is resolved by the background
+  // task when the next input satisfying the predicate is available.
+  IterationResult MakePendingOutput(HostContext* host);
+
   int OutputBufferSize() TFRT_EXCLUDES(mu_) {
     mutex_lock lock(mu_);
     return output_buffer_.size();
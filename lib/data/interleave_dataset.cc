@@ -21,6 +21,7 @@
 #include "interleave_dataset.h"
 
 #include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/host_context/chain.h"
 
 namespace tfrt {
 namespace data {
@@ -30,10 +31,21 @@ namespace data {
 //===----------------------------------------------------------------------===//
 RCReference<Iterator> InterleaveDataset::MakeIterator(
     const IteratorContext& context) {
+  if (buffer_output_elements_ > 0) {
+    return TakeRef(host_->Construct<ParallelInterleaveDatasetIterator>(
+        FormRef(this), context));
+  }
   return TakeRef(
       host_->Construct<InterleaveDatasetIterator>(FormRef(this), context));
 }
 
+RCReference<AutotuneKnob> InterleaveDataset::MakeAutotuneKnob() {
+  if (!autotune_prefetch_) return {};
+  return AutotuneController::Get(host_).MakeKnob(
+      /*initial_value=*/prefetch_iterator_num_, /*min_value=*/0,
+      /*max_value=*/2 * cycle_length_);
+}
+
 //===----------------------------------------------------------------------===//
 // InterleaveDatasetIterator methods
 //===----------------------------------------------------------------------===//
@@ -70,9 +82,10 @@ void InterleaveDatasetIterator::PreInitializeIntermediateIterators(
   if (is_input_iterator_eof_) return;
   auto* host = exec_ctx.host();
 
-  auto fetch_num = parent_dataset_->cycle_length_ +
-                   parent_dataset_->prefetch_iterator_num_ -
-                   num_open_iterators_;
+  // The number of prefetched iterators can shrink below the number of open
+  // iterators if it is autotuned.
+  int64_t fetch_num = parent_dataset_->cycle_length_ + PrefetchIteratorNum() -
+                      static_cast<int64_t>(num_open_iterators_);
   for (int i = 0; i < fetch_num; i++) {
     // Read value from the input iterator.
     auto input_value = input_iterator_->GetNext(exec_ctx);
@@ -138,6 +151,14 @@ AsyncValue* InterleaveDatasetIterator::FetchInputValues(
             (iterator_index_for_fetch_ + 1) % parent_dataset_->cycle_length_;
         continue;
       }
+      if (autotune_knob_) {
+        // The input is ahead of the cycle if even the last prefetched iterator
+        // is available.
+        autotune_knob_->RecordGetNext(
+            prefetched_iterators_.front().iterator.GetAsyncValue(),
+            /*producer_idle=*/prefetched_iterators_.back()
+                .iterator.IsAvailable());
+      }
       iterator_and_queues_[iterator_index_for_fetch_] =
           std::move(prefetched_iterators_.front());
       prefetched_iterators_.pop();
@@ -268,6 +289,15 @@ AsyncValue* InterleaveDatasetIterator::FillOutputValues(
       iterator_and_queue.is_open = false;
       num_open_iterators_--;
 
+      // The iterator can reach end before its block is fully fetched. Move
+      // the fetch to the next iterator as well, so that it keeps following
+      // the output.
+      if (iterator_index_for_fetch_ == iterator_index_for_output_ &&
+          iterator_and_queue.fetched_num_in_block > 0) {
+        iterator_and_queue.fetched_num_in_block = 0;
+        iterator_index_for_fetch_ =
+            (iterator_index_for_fetch_ + 1) % parent_dataset_->cycle_length_;
+      }
       iterator_index_for_output_ =
           (iterator_index_for_output_ + 1) % parent_dataset_->cycle_length_;
       break;
@@ -366,5 +396,346 @@ void InterleaveDatasetIterator::MaybeScheduleBackgroundTask(
   }
 }
 
+//===----------------------------------------------------------------------===//
+// ParallelInterleaveDatasetIterator methods
+//===----------------------------------------------------------------------===//
+
+// Forwards `result`, which is returned by an intermediate iterator, to
+// `placeholder`, which is a value in the buffer of its element.
+static void ForwardIterationResult(IterationResult result,
+                                   IterationResult* placeholder) {
+  assert(result.values.size() == placeholder->values.size());
+  for (size_t i = 0; i < placeholder->values.size(); ++i) {
+    auto* value = cast<IndirectAsyncValue>(placeholder->values[i].get());
+    value->ForwardTo(std::move(result.values[i]));
+  }
+  AsyncValue* eof = result.eof.GetAsyncValue();
+  eof->AndThen([src = std::move(result.eof),
+                dst = std::move(placeholder->eof)]() mutable {
+    if (src.IsError()) {
+      dst.SetError(src.GetError());
+    } else {
+      dst.emplace(src.get());
+    }
+  });
+}
+
+ParallelInterleaveDatasetIterator::ParallelInterleaveDatasetIterator(
+    RCReference<InterleaveDataset> parent_dataset,
+    const IteratorContext& context)
+    : Iterator(),
+      parent_dataset_(std::move(parent_dataset)),
+      input_iterator_(parent_dataset_->input_dataset_->MakeIterator(context)),
+      context_(context),
+      autotune_knob_(parent_dataset_->MakeAutotuneKnob()) {
+  for (int i = 0; i < parent_dataset_->cycle_length_; ++i) {
+    cycle_.push_back(CycleElement::Closed(parent_dataset_->host_));
+  }
+}
+
+IterationResult ParallelInterleaveDatasetIterator::GetNext(
+    const ExecutionContext& exec_ctx) {
+  auto* host = exec_ctx.host();
+
+  llvm::SmallVector<RCReference<AsyncValue>, 4> result_values;
+  result_values.resize(parent_dataset_->arity_);
+  for (size_t i = 0; i < parent_dataset_->arity_; ++i) {
+    result_values[i] = MakeIndirectAsyncValue(host);
+  }
+  auto result_eof = MakeUnconstructedAsyncValueRef<bool>(host);
+  auto result =
+      IterationResult::Pending(std::move(result_values), std::move(result_eof));
+  {
+    mutex_lock lock(mu_);
+    output_buffer_back_.push(result.CopyRef());
+  }
+
+  MaybeProcess(exec_ctx);
+  return result;
+}
+
+void ParallelInterleaveDatasetIterator::MaybeProcess(
+    const ExecutionContext& exec_ctx) {
+  {
+    mutex_lock lock(mu_);
+    if (token_owned_) {
+      process_again_ = true;
+      return;
+    }
+    token_owned_ = true;
+  }
+  while (true) {
+    Process(exec_ctx);
+    mutex_lock lock(mu_);
+    // A value that Process() waited for may have become available after
+    // Process() checked it, or GetNext() may have added a value to the
+    // output_buffer_back_.
+    if (!process_again_) {
+      token_owned_ = false;
+      return;
+    }
+    process_again_ = false;
+  }
+}
+
+void ParallelInterleaveDatasetIterator::Process(
+    const ExecutionContext& exec_ctx) {
+  // Open the elements of the first cycle.
+  for (size_t i = 0; i < cycle_.size(); ++i) {
+    if (!cycle_[i].is_open) ReplaceElement(i, exec_ctx);
+  }
+
+  if (parent_dataset_->is_deterministic_) {
+    FillOutputValuesInOrder(exec_ctx);
+  } else {
+    FillOutputValuesInAnyOrder(exec_ctx);
+  }
+
+  while (!is_input_iterator_eof_ &&
+         static_cast<int64_t>(future_elements_.size()) <
+             PrefetchInputElements()) {
+    future_elements_.push_back(OpenElement(exec_ctx));
+  }
+  for (auto& element : cycle_) FillBuffer(&element, exec_ctx);
+  for (auto& element : future_elements_) FillBuffer(&element, exec_ctx);
+}
+
+void ParallelInterleaveDatasetIterator::FillOutputValuesInOrder(
+    const ExecutionContext& exec_ctx) {
+  const int64_t cycle_length = parent_dataset_->cycle_length_;
+  while (OutputBufferSize() > 0 && HasMoreValues(exec_ctx)) {
+    auto& element = cycle_[output_index_];
+    Optional<IterationResult> value;
+    if (element.is_open && !TakeNextValue(&element, &value) &&
+        element.is_open) {
+      // Wait for the next value of this element.
+      return;
+    }
+    if (value) {
+      OutputValue(std::move(*value));
+      ++output_num_in_block_;
+    }
+    if (!element.is_open) {
+      ReplaceElement(output_index_, exec_ctx);
+    } else if (output_num_in_block_ < parent_dataset_->block_length_) {
+      continue;
+    }
+    // Move to the next element in the cycle at the end of a block, or if the
+    // current element has reached end.
+    output_num_in_block_ = 0;
+    output_index_ = (output_index_ + 1) % cycle_length;
+  }
+}
+
+void ParallelInterleaveDatasetIterator::FillOutputValuesInAnyOrder(
+    const ExecutionContext& exec_ctx) {
+  const int64_t cycle_length = parent_dataset_->cycle_length_;
+  while (OutputBufferSize() > 0 && HasMoreValues(exec_ctx)) {
+    // Look for a value starting from the element that is next in the cycle, so
+    // that no element is starved while others have values available.
+    bool made_progress = false;
+    for (int64_t i = 0; i < cycle_length; ++i) {
+      size_t index = (output_index_ + i) % cycle_length;
+      auto& element = cycle_[index];
+      if (!element.is_open) continue;
+      Optional<IterationResult> value;
+      if (TakeNextValue(&element, &value)) {
+        if (index != output_index_) {
+          output_index_ = index;
+          output_num_in_block_ = 0;
+        }
+        OutputValue(std::move(*value));
+        made_progress = true;
+        if (++output_num_in_block_ == parent_dataset_->block_length_) {
+          output_num_in_block_ = 0;
+          output_index_ = (output_index_ + 1) % cycle_length;
+        }
+      }
+      if (!element.is_open) {
+        ReplaceElement(index, exec_ctx);
+        made_progress = true;
+      }
+      if (made_progress) break;
+    }
+    // Wait for the next value of any element.
+    if (!made_progress) return;
+  }
+}
+
+bool ParallelInterleaveDatasetIterator::HasMoreValues(
+    const ExecutionContext& exec_ctx) {
+  if (!is_input_iterator_eof_ || num_open_elements_ > 0) return true;
+
+  auto error = MakeErrorAsyncValueRef(exec_ctx.host(), "iterator reached end");
+  for (auto output_buffer_size = OutputBufferSize(); output_buffer_size > 0;
+       --output_buffer_size) {
+    auto output = DequeueOutputBuffer();
+    for (auto& value : output.values) {
+      value->SetError(error->GetError());
+    }
+    output.eof.emplace(true);
+  }
+  return false;
+}
+
+bool ParallelInterleaveDatasetIterator::TakeNextValue(
+    CycleElement* element, Optional<IterationResult>* value) {
+  auto& input_value_eof = element->input_value.eof;
+  if (!input_value_eof.IsAvailable()) return false;
+  // The input_iterator_ has reached end. Errors from the input_iterator_ are
+  // propagated through the intermediate iterator.
+  if (!input_value_eof.IsError() && input_value_eof.get()) {
+    is_input_iterator_eof_ = true;
+    CloseElement(element);
+    return false;
+  }
+
+  auto& iterator = element->iterator;
+  if (!iterator.IsAvailable()) return false;
+  if (iterator.IsError()) {
+    value->emplace(IterationResult::Error(iterator.CopyRCRef(),
+                                          parent_dataset_->arity_));
+    CloseElement(element);
+    return true;
+  }
+
+  if (element->buffer.empty()) return false;
+  auto& next_value = element->buffer.front();
+  if (!next_value.eof.IsAvailable()) return false;
+  if (!next_value.eof.IsError() && next_value.eof.get()) {
+    CloseElement(element);
+    return false;
+  }
+  value->emplace(std::move(next_value));
+  element->buffer.pop();
+  return true;
+}
+
+void ParallelInterleaveDatasetIterator::OutputValue(IterationResult value) {
+  auto output = DequeueOutputBuffer();
+  if (value.eof.IsError()) {
+    output.eof.SetError(value.eof.GetError());
+    for (auto& output_value : output.values) {
+      output_value->SetError(value.eof.GetError());
+    }
+    return;
+  }
+  output.eof.emplace(false);
+  for (int i = 0; i < parent_dataset_->arity_; ++i) {
+    auto* output_value = cast<IndirectAsyncValue>(output.values[i].get());
+    output_value->ForwardTo(std::move(value.values[i]));
+  }
+}
+
+void ParallelInterleaveDatasetIterator::ReplaceElement(
+    size_t index, const ExecutionContext& exec_ctx) {
+  assert(!cycle_[index].is_open);
+  if (!future_elements_.empty()) {
+    if (autotune_knob_) {
+      // The input is ahead of the cycle if even the last element ahead of the
+      // cycle has its iterator.
+      autotune_knob_->RecordGetNext(
+          future_elements_.front().iterator.GetAsyncValue(),
+          /*producer_idle=*/future_elements_.back().iterator.IsAvailable());
+    }
+    cycle_[index] = std::move(future_elements_.front());
+    future_elements_.pop_front();
+  } else if (!is_input_iterator_eof_) {
+    cycle_[index] = OpenElement(exec_ctx);
+  }
+}
+
+ParallelInterleaveDatasetIterator::CycleElement
+ParallelInterleaveDatasetIterator::OpenElement(
+    const ExecutionContext& exec_ctx) {
+  // Read value from the input iterator.
+  auto input_value = input_iterator_->GetNext(exec_ctx);
+  // Construct dataset = func_(input_value).
+  SmallVector<AsyncValue*, 4> fn_args;
+  for (const auto& value : input_value.values) {
+    fn_args.push_back(value.get());
+  }
+  SmallVector<RCReference<AsyncValue>, 1> fn_results;
+  fn_results.resize(1);
+  parent_dataset_->func_->Execute(exec_ctx, fn_args, fn_results);
+
+  CycleElement element(std::move(input_value));
+  element.iterator =
+      MakeUnconstructedAsyncValueRef<RCReference<Iterator>>(exec_ctx.host());
+  element.is_open = true;
+  num_open_elements_++;
+  // Instantiate the intermediate iterator once the dataset is available.
+  auto* dataset = fn_results[0].get();
+  dataset->AndThen([dataset = std::move(fn_results[0]),
+                    iterator = element.iterator.CopyRef(),
+                    context = context_]() mutable {
+    if (dataset->IsError()) {
+      iterator.SetError(dataset->GetError());
+      return;
+    }
+    iterator.emplace(
+        dataset->template get<RCReference<Dataset>>()->MakeIterator(context));
+  });
+
+  ProcessWhenAvailable(element.input_value.eof.GetAsyncValue(), exec_ctx);
+  ProcessWhenAvailable(element.iterator.GetAsyncValue(), exec_ctx);
+  return element;
+}
+
+void ParallelInterleaveDatasetIterator::CloseElement(CycleElement* element) {
+  element->is_open = false;
+  element->buffer = {};
+  num_open_elements_--;
+}
+
+void ParallelInterleaveDatasetIterator::FillBuffer(
+    CycleElement* element, const ExecutionContext& exec_ctx) {
+  if (!element->is_open || !element->iterator.IsConcrete()) return;
+  if (element->fetch_done && !element->fetch_done.IsAvailable()) return;
+  auto& buffer = element->buffer;
+  // Do not fetch past the end of the iterator.
+  if (!buffer.empty() && buffer.back().eof.IsConcrete() &&
+      buffer.back().eof.get()) {
+    return;
+  }
+  int64_t fetch_num = parent_dataset_->buffer_output_elements_ -
+                      static_cast<int64_t>(buffer.size());
+  if (fetch_num <= 0) return;
+
+  auto* host = exec_ctx.host();
+  SmallVector<IterationResult, 4> placeholders;
+  placeholders.reserve(fetch_num);
+  for (int64_t i = 0; i < fetch_num; ++i) {
+    llvm::SmallVector<RCReference<AsyncValue>, 4> values;
+    values.resize(parent_dataset_->arity_);
+    for (auto& value : values) value = MakeIndirectAsyncValue(host);
+    placeholders.push_back(IterationResult::Pending(
+        std::move(values), MakeUnconstructedAsyncValueRef<bool>(host)));
+    buffer.push(placeholders.back().CopyRef());
+    ProcessWhenAvailable(buffer.back().eof.GetAsyncValue(), exec_ctx);
+  }
+  element->fetch_done = MakeUnconstructedAsyncValueRef<Chain>(host);
+  ProcessWhenAvailable(element->fetch_done.GetAsyncValue(), exec_ctx);
+
+  EnqueueWork(exec_ctx, [exec_ctx, iterator = element->iterator.get().CopyRef(),
+                         placeholders = std::move(placeholders),
+                         fetch_done = element->fetch_done.CopyRef()]() mutable {
+    SmallVector<IterationResult, 4> results;
+    iterator->GetNextBatch(exec_ctx, placeholders.size(), &results);
+    for (size_t i = 0; i < placeholders.size(); ++i) {
+      ForwardIterationResult(std::move(results[i]), &placeholders[i]);
+    }
+    fetch_done.emplace();
+  });
+}
+
+void ParallelInterleaveDatasetIterator::ProcessWhenAvailable(
+    AsyncValue* value, const ExecutionContext& exec_ctx) {
+  if (value->IsAvailable()) return;
+  value->AndThen([exec_ctx, iterator = FormRef(this)] {
+    iterator->MaybeProcess(exec_ctx);
+  });
+}
+
 }  // namespace data
 }  // namespace tfrt
@@ -21,9 +21,14 @@
 #ifndef TFRT_LIB_DATA_INTERLEAVE_DATASET_H_
 #define TFRT_LIB_DATA_INTERLEAVE_DATASET_H_
 
+#include <algorithm>
+#include <deque>
 #include <queue>
+#include <vector>
 
+#include "autotune.h"
 #include "tfrt/data/dataset.h"
+#include "tfrt/host_context/chain.h"
 #include "tfrt/host_context/function.h"
 #include "tfrt/support/forward_decls.h"
 #include "tfrt/support/mutex.h"
@@ -51,22 +56,60 @@ class InterleaveDatasetIterator;
 // returned Dataset objects, and cycle through them, producing `block_length`
 // consecutive elements from each iterator, and consuming the next input
 // element each time it reaches the end of an iterator.
+//
+// If `cycle_length` is kAutotune, it is set to the number of worker threads,
+// and the number of intermediate iterators that are initialized ahead of the
+// cycle is tuned at runtime by the AutotuneController. The cycle length itself
+// is not tuned since it determines the order of the elements.
+//
+// If `buffer_output_elements` is positive, the dataset interleaves in parallel:
+// every intermediate iterator in the cycle, and up to `prefetch_input_elements`
+// intermediate iterators ahead of the cycle, fetch up to
+// `buffer_output_elements` values into a buffer of their own in the work queue,
+// so that a slow intermediate iterator only delays its own values. If
+// `is_deterministic` is false, GetNext() returns the next value of whichever
+// intermediate iterator has one available first, instead of following the
+// cycle.
 class InterleaveDataset : public Dataset {
  public:
   explicit InterleaveDataset(RCReference<Dataset> input_dataset,
                              int64_t cycle_length, int64_t block_length,
                              RCReference<const Function> func, int64_t arity,
                              HostContext* host)
+      : InterleaveDataset(std::move(input_dataset), cycle_length, block_length,
+                          /*buffer_output_elements=*/0,
+                          /*prefetch_input_elements=*/
+                          cycle_length == kAutotune ? kAutotune : cycle_length,
+                          /*is_deterministic=*/true, std::move(func), arity,
+                          host) {}
+
+  // `prefetch_input_elements` can be kAutotune, in which case it starts from
+  // the cycle length.
+  explicit InterleaveDataset(RCReference<Dataset> input_dataset,
+                             int64_t cycle_length, int64_t block_length,
+                             int64_t buffer_output_elements,
+                             int64_t prefetch_input_elements,
+                             bool is_deterministic,
+                             RCReference<const Function> func, int64_t arity,
+                             HostContext* host)
       : input_dataset_(std::move(input_dataset)),
-        cycle_length_(cycle_length),
+        cycle_length_(cycle_length == kAutotune
+                          ? std::max(1, host->GetNumWorkerThreads())
+                          : cycle_length),
         block_length_(block_length),
-        prefetch_iterator_num_(cycle_length),
+        buffer_output_elements_(buffer_output_elements),
+        prefetch_iterator_num_(prefetch_input_elements == kAutotune
+                                   ? cycle_length_
+                                   : prefetch_input_elements),
+        autotune_prefetch_(prefetch_input_elements == kAutotune),
+        is_deterministic_(is_deterministic),
         arity_(arity),
         host_(host),
         allocator_(host->allocator()),
         func_(std::move(func)) {
     assert(cycle_length_ > 0);
     assert(block_length_ > 0);
+    assert(prefetch_iterator_num_ >= 0);
   }
 
   // This class is not copyable or movable.
@@ -78,18 +121,28 @@ class InterleaveDataset : public Dataset {
  private:
   // Allow iterator to rely on private data members of this dataset.
   friend class InterleaveDatasetIterator;
+  friend class ParallelInterleaveDatasetIterator;
 
   void Destroy() override {
     internal::DestroyImpl<InterleaveDataset>(this, allocator_);
   }
 
+  // Returns the knob that tunes the number of intermediate iterators an
+  // iterator initializes ahead of the cycle, or nullptr if it is not autotuned.
+  RCReference<AutotuneKnob> MakeAutotuneKnob();
+
   RCReference<Dataset> input_dataset_;
   const int64_t cycle_length_;
   const int64_t block_length_;
-  // Pre-initialize up to `cycle_length` intermediate iterators, in addition to
-  // initializing the intermediate iterators already requested by the current
-  // cycle.
+  // The size of the buffer of each intermediate iterator in parallel mode, or
+  // 0 if the dataset does not interleave in parallel.
+  const int64_t buffer_output_elements_;
+  // Pre-initialize up to `prefetch_iterator_num_` intermediate iterators, in
+  // addition to initializing the intermediate iterators already requested by
+  // the current cycle.
   const int64_t prefetch_iterator_num_;
+  const bool autotune_prefetch_;
+  const bool is_deterministic_;
   const int64_t arity_;
   HostContext* host_;
   HostAllocator* allocator_;
@@ -105,6 +158,7 @@ class InterleaveDatasetIterator : public Iterator {
         parent_dataset_(std::move(parent_dataset)),
         input_iterator_(parent_dataset_->input_dataset_->MakeIterator(context)),
         context_(context),
+        autotune_knob_(parent_dataset_->MakeAutotuneKnob()),
         token_owned_(false) {
     for (int i = 0; i < parent_dataset_->cycle_length_; ++i) {
       iterator_and_queues_.push_back(
@@ -181,7 +235,7 @@ class InterleaveDatasetIterator : public Iterator {
 
   // If the input iterator has not reached end, prefetch enough values from it
   // and transform those values into intermediate iterators until
-  // num_open_iterators_ == cycle_length_ + prefetch_iterator_num_.
+  // num_open_iterators_ == cycle_length_ + PrefetchIteratorNum().
   void PreInitializeIntermediateIterators(const ExecutionContext& exec_ctx)
       TFRT_EXCLUDES(mu_);
 
@@ -221,6 +275,13 @@ class InterleaveDatasetIterator : public Iterator {
   AsyncValue* FillOutputValues(const ExecutionContext& exec_ctx)
       TFRT_EXCLUDES(mu_);
 
+  // Returns the number of intermediate iterators to initialize ahead of the
+  // cycle.
+  int64_t PrefetchIteratorNum() const {
+    return autotune_knob_ ? autotune_knob_->value()
+                          : parent_dataset_->prefetch_iterator_num_;
+  }
+
   // Return the total number of values in the output buffers.
   int OutputBufferSize() TFRT_EXCLUDES(mu_) {
     mutex_lock lock(mu_);
@@ -244,6 +305,7 @@ class InterleaveDatasetIterator : public Iterator {
   RCReference<InterleaveDataset> parent_dataset_;
   RCReference<Iterator> input_iterator_;
   const IteratorContext context_;
+  RCReference<AutotuneKnob> autotune_knob_;
   bool is_input_iterator_eof_ = false;
 
   // List of intermediate iterators and their states. The positions of those
@@ -285,6 +347,163 @@ class InterleaveDatasetIterator : public Iterator {
   bool token_owned_ TFRT_GUARDED_BY(mu_);
 };
 
+// This iterator is used if the dataset interleaves in parallel. Each
+// intermediate iterator in the cycle or ahead of it fetches values into its
+// own buffer in the work queue as soon as the iterator is created and whenever
+// its buffer has room, regardless of the order in which the values are
+// returned.
+//
+// Like InterleaveDatasetIterator, the iterator returns unavailable values from
+// GetNext() and fills them in order in the thread that holds the token. A
+// thread that finds the token held asks the token owner to run again instead
+// of waiting for it, so every async value the iterator waits for is waited for
+// by a single callback.
+class ParallelInterleaveDatasetIterator : public Iterator {
+ public:
+  explicit ParallelInterleaveDatasetIterator(
+      RCReference<InterleaveDataset> parent_dataset,
+      const IteratorContext& context);
+
+  // This class is not copyable or movable.
+  ParallelInterleaveDatasetIterator(const ParallelInterleaveDatasetIterator&) =
+      delete;
+  ParallelInterleaveDatasetIterator& operator=(
+      const ParallelInterleaveDatasetIterator&) = delete;
+
+  IterationResult GetNext(const ExecutionContext& exec_ctx) override;
+
+ private:
+  // An intermediate iterator and the values fetched from it.
+  struct CycleElement {
+    explicit CycleElement(IterationResult r) : input_value(std::move(r)) {}
+
+    // Creates a CycleElement with is_open=false.
+    static CycleElement Closed(HostContext* host) {
+      return CycleElement(IterationResult::Eof(host, 0));
+    }
+
+    // The value from the input_iterator_ which is used to create the dataset.
+    IterationResult input_value;
+    // The intermediate iterator created from func_(input_value).
+    AsyncValueRef<RCReference<Iterator>> iterator;
+    // The values fetched from the iterator, in order. They are filled in by
+    // the fetch task that fetched them.
+    std::queue<IterationResult> buffer;
+    // Becomes available when the last fetch task of this element no longer
+    // uses the iterator. Fetch tasks of an element must not overlap since
+    // iterators are not thread-safe.
+    AsyncValueRef<Chain> fetch_done;
+    // Whether more values can be taken from this element.
+    bool is_open = false;
+  };
+
+  void Destroy() override {
+    internal::DestroyImpl<ParallelInterleaveDatasetIterator>(
+        this, parent_dataset_->allocator_);
+  }
+
+  // Runs Process() if no other thread holds the token. Otherwise makes the
+  // token owner run Process() again before it releases the token.
+  void MaybeProcess(const ExecutionContext& exec_ctx) TFRT_EXCLUDES(mu_);
+
+  // Fills as many values in the output_buffer_* as possible, then keeps the
+  // cycle, the elements ahead of it and their buffers full.
+  void Process(const ExecutionContext& exec_ctx) TFRT_EXCLUDES(mu_);
+
+  // Fills the values in the output_buffer_* in the order of the cycle.
+  void FillOutputValuesInOrder(const ExecutionContext& exec_ctx)
+      TFRT_EXCLUDES(mu_);
+
+  // Fills the values in the output_buffer_* with the first available values of
+  // any element in the cycle.
+  void FillOutputValuesInAnyOrder(const ExecutionContext& exec_ctx)
+      TFRT_EXCLUDES(mu_);
+
+  // Returns false if all elements have reached the end. In that case, marks
+  // all values in the output_buffer_* to be eof=true.
+  bool HasMoreValues(const ExecutionContext& exec_ctx) TFRT_EXCLUDES(mu_);
+
+  // Moves the next value of `element` to `value` and returns true if it is
+  // available. Closes `element` if it has no more values, or if its iterator
+  // could not be created. Like in InterleaveDatasetIterator, an error value
+  // from the iterator is returned as a value and leaves `element` open.
+  bool TakeNextValue(CycleElement* element, Optional<IterationResult>* value);
+
+  // Forwards `value` to the next value in the output_buffer_*.
+  void OutputValue(IterationResult value) TFRT_EXCLUDES(mu_);
+
+  // Replaces the closed element at `index` of the cycle with the next element
+  // ahead of the cycle, or with a new element if there is none.
+  void ReplaceElement(size_t index, const ExecutionContext& exec_ctx);
+
+  // Takes the next value from the input_iterator_ and creates an element with
+  // the intermediate iterator for it.
+  CycleElement OpenElement(const ExecutionContext& exec_ctx);
+
+  void CloseElement(CycleElement* element);
+
+  // Starts a fetch task that fills the buffer of `element`, unless its
+  // iterator is not available, its buffer is full, or it is still fetching.
+  void FillBuffer(CycleElement* element, const ExecutionContext& exec_ctx);
+
+  // Calls MaybeProcess() when `value` becomes available.
+  void ProcessWhenAvailable(AsyncValue* value,
+                            const ExecutionContext& exec_ctx);
+
+  // Returns the number of elements to keep ahead of the cycle.
+  int64_t PrefetchInputElements() const {
+    return autotune_knob_ ? autotune_knob_->value()
+                          : parent_dataset_->prefetch_iterator_num_;
+  }
+
+  int OutputBufferSize() TFRT_EXCLUDES(mu_) {
+    mutex_lock lock(mu_);
+    return output_buffer_back_.size() + output_buffer_front_.size();
+  }
+
+  IterationResult DequeueOutputBuffer() TFRT_EXCLUDES(mu_) {
+    if (output_buffer_front_.empty()) {
+      mutex_lock lock(mu_);
+      std::swap(output_buffer_front_, output_buffer_back_);
+    }
+    assert(!output_buffer_front_.empty());
+    auto value = std::move(output_buffer_front_.front());
+    output_buffer_front_.pop();
+    return value;
+  }
+
+  RCReference<InterleaveDataset> parent_dataset_;
+  RCReference<Iterator> input_iterator_;
+  const IteratorContext context_;
+  RCReference<AutotuneKnob> autotune_knob_;
+
+  // The fields below can only be accessed by the token owner.
+  bool is_input_iterator_eof_ = false;
+  // The elements in the cycle. Closed elements are only left in the cycle
+  // once the input_iterator_ has reached end.
+  std::vector<CycleElement> cycle_;
+  // The elements ahead of the cycle.
+  std::deque<CycleElement> future_elements_;
+  // Number of elements in cycle_ and future_elements_ whose is_open is true.
+  size_t num_open_elements_ = 0;
+  // cycle_[output_index_] contains the element to take the next value from.
+  size_t output_index_ = 0;
+  // The number of values taken from cycle_[output_index_] in the current
+  // block.
+  int64_t output_num_in_block_ = 0;
+
+  mutex mu_;
+  // A queue of unavailable IterationResult enqueued by the caller of GetNext().
+  std::queue<IterationResult> output_buffer_back_ TFRT_GUARDED_BY(mu_);
+  // A queue of unavailable IterationResult that are moved from
+  // output_buffer_back_. Only the token owner can access it.
+  std::queue<IterationResult> output_buffer_front_;
+  bool token_owned_ TFRT_GUARDED_BY(mu_) = false;
+  // Whether the token owner should run Process() again before it releases the
+  // token, because a value it may wait for has become available.
+  bool process_again_ TFRT_GUARDED_BY(mu_) = false;
+};
+
 }  // namespace data
 }  // namespace tfrt
 
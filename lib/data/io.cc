@@ -19,6 +19,8 @@
 
 #include "io.h"
 
+#include <cstdint>
+
 #include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/tracing/tracing.h"
 
@@ -34,7 +36,7 @@ IterationResult PrefetchingIterator::GetNext(const ExecutionContext& exec_ctx) {
     // values has dropped below the threshold.
     if (!token_owned_ && !reached_eof_ &&
         prefetch_buffer_.size() <
-            prefetch_threshold_ + output_buffer_.size() + 1) {
+            PrefetchThreshold() + output_buffer_.size() + 1) {
       auto task = [iterator = FormRef(this), exec_ctx]() {
         TFRT_TRACE_SCOPE(Default, "ReadIOSource");
         iterator->ReadIOSource(exec_ctx);
@@ -66,6 +68,12 @@ IterationResult PrefetchingIterator::GetNext(const ExecutionContext& exec_ctx) {
             exec_ctx.location().Decode());
         host->EmitError(input.eof.GetError());
       }
+      if (autotune_knob_) {
+        // The IO source is idle if there is no need to prefetch more values.
+        autotune_knob_->RecordGetNext(
+            input, /*producer_idle=*/reached_eof_ || prefetch_buffer_.size() >=
+                                                        PrefetchThreshold());
+      }
       return input;
     }
   }
@@ -78,6 +86,10 @@ IterationResult PrefetchingIterator::GetNext(const ExecutionContext& exec_ctx) {
   auto result_eof = MakeUnconstructedAsyncValueRef<bool>(host);
   auto result =
       IterationResult::Pending(std::move(result_values), std::move(result_eof));
+  // The caller has to wait for the IO source, either for the blocking task or
+  // for the read below.
+  if (autotune_knob_)
+    autotune_knob_->RecordGetNext(result, /*producer_idle=*/false);
   {
     mutex_lock lock(mu_);
     output_buffer_.push(result.CopyRef());
@@ -111,12 +123,15 @@ void PrefetchingIterator::ReadIOSource(const ExecutionContext& exec_ctx) {
       // The caller is the token owner, there are enough prefetched values and
       // there is no output value to update. Release the token and return.
       if (output_buffer_.empty() &&
-          (prefetch_buffer_.size() >= prefetch_threshold_ || reached_eof_)) {
+          (prefetch_buffer_.size() >= PrefetchThreshold() || reached_eof_)) {
         token_owned_ = false;
         return;
       }
-      fetch_num =
-          max_prefetch_num_ + output_buffer_.size() - prefetch_buffer_.size();
+      // The maximum number of prefetched values can shrink below the number
+      // of values already prefetched if it is autotuned.
+      fetch_num = static_cast<int64_t>(MaxPrefetchNum() +
+                                       output_buffer_.size()) -
+                  static_cast<int64_t>(prefetch_buffer_.size());
     }
     for (int32_t i = 0; i < fetch_num; ++i) {
       if (exec_ctx.IsCancelled()) return;
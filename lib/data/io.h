@@ -23,6 +23,7 @@
 #include <memory>
 #include <queue>
 
+#include "autotune.h"
 #include "tfrt/data/dataset.h"
 #include "tfrt/host_context/execution_context.h"
 #include "tfrt/support/forward_decls.h"
@@ -53,18 +54,24 @@ namespace io {
 // This is an internal implementation detail, and it is not exposed to the end
 // user as a dataset type.
 //
-// TODO(ezhulenev): Add flexible prefetching policy based not only on the number
-// of prefetched records, but also on the memory consumption.
+// If `autotune_knob` is not null, it tunes the maximum number of prefetched
+// values at runtime, starting from `max_prefetch_num`, and the prefetch
+// threshold is scaled with it. The AutotuneController charges the prefetched
+// values against the memory budget of all autotuned iterators.
 class PrefetchingIterator : public Iterator {
  public:
   explicit PrefetchingIterator(int64_t max_prefetch_num,
                                int64_t prefetch_threshold,
-                               const IteratorContext& context)
+                               const IteratorContext& context,
+                               RCReference<AutotuneKnob> autotune_knob = {})
       : Iterator(),
         max_prefetch_num_(max_prefetch_num),
         prefetch_threshold_(prefetch_threshold),
+        autotune_knob_(std::move(autotune_knob)),
         token_owned_(false),
-        reached_eof_(false) {}
+        reached_eof_(false) {
+    assert(!autotune_knob_ || max_prefetch_num_ > 0);
+  }
 
   // Gets the next element from a prefetch buffer, and may be enqueue an
   // asynchronous blocking task to fill up the buffer. If the prefetch buffer is
@@ -102,6 +109,18 @@ class PrefetchingIterator : public Iterator {
   // output_buffer_.
   void MaterializeOutputs(const ExecutionContext& exec_ctx);
 
+  // Returns the current maximum number of values to prefetch.
+  size_t MaxPrefetchNum() const {
+    return autotune_knob_ ? autotune_knob_->value() : max_prefetch_num_;
+  }
+
+  // Returns the current prefetch threshold.
+  size_t PrefetchThreshold() const {
+    return autotune_knob_ ? autotune_knob_->value() * prefetch_threshold_ /
+                                max_prefetch_num_
+                          : prefetch_threshold_;
+  }
+
   llvm::Optional<IterationResult> DequeueOutputBuffer() TFRT_EXCLUDES(mu_) {
     mutex_lock lock(mu_);
     if (output_buffer_.empty()) return llvm::None;
@@ -125,6 +144,9 @@ class PrefetchingIterator : public Iterator {
   // Schedule background blocking thread to prefetch from the underlying IO
   // source if the number of prefetched values dropped below this threadhold.
   const size_t prefetch_threshold_;
+  // If set, tunes max_prefetch_num_ and prefetch_threshold_ at runtime. Use
+  // MaxPrefetchNum() and PrefetchThreshold() to get their current values.
+  RCReference<AutotuneKnob> autotune_knob_;
 
   // This is a unique logical token for this iterator instance. It effectively
   // acts as a lock to ensure in-order delivery of results by guaranteeing that
@@ -19,14 +19,54 @@
 
 #include "map_dataset.h"
 
+#include <algorithm>
+
 namespace tfrt {
 namespace data {
 
+// The upper bound of an autotuned parallelism, per worker thread.
+static constexpr int64_t kMaxAutotuneParallelCallsPerThread = 4;
+
 //===----------------------------------------------------------------------===//
 // MapDataset methods
 //===----------------------------------------------------------------------===//
 RCReference<Iterator> MapDataset::MakeIterator(const IteratorContext& context) {
-  return TakeRef(host_->Construct<MapDatasetIterator>(FormRef(this), context));
+  if (num_parallel_calls_ != kAutotune && num_parallel_calls_ <= 1)
+    return TakeRef(
+        host_->Construct<MapDatasetIterator>(FormRef(this), context));
+  if (is_deterministic_)
+    return TakeRef(
+        host_->Construct<ParallelMapDatasetIterator>(FormRef(this), context));
+  return TakeRef(host_->Construct<NonDeterministicParallelMapDatasetIterator>(
+      FormRef(this), context));
+}
+
+RCReference<AutotuneKnob> MapDataset::MakeAutotuneKnob() {
+  if (num_parallel_calls_ != kAutotune) return {};
+  int64_t num_threads = std::max(1, host_->GetNumWorkerThreads());
+  return AutotuneController::Get(host_).MakeKnob(
+      /*initial_value=*/num_threads, /*min_value=*/1,
+      /*max_value=*/kMaxAutotuneParallelCallsPerThread * num_threads);
+}
+
+// Gets the next element from `input_iterator` and starts running `map_fn` on
+// it in the work queue. Returns the pending result of the function.
+static IterationResult StartParallelMap(Iterator* input_iterator,
+                                        const Function* map_fn,
+                                        ArrayRef<AsyncValue*> additional_fn_args,
+                                        const ExecutionContext& exec_ctx) {
+  auto input = input_iterator->GetNext(exec_ctx);
+  // Do not bother the work queue once the input is known to be exhausted.
+  if (input.eof.IsConcrete() && input.eof.get()) {
+    return IterationResult::Eof(exec_ctx.host(),
+                                map_fn->result_types().size());
+  }
+
+  SmallVector<RCReference<AsyncValue>, 4> arguments;
+  for (auto* value : additional_fn_args) arguments.push_back(FormRef(value));
+  for (auto& value : input.values) arguments.push_back(std::move(value));
+  auto result = RunFunctionInWorkQueue(map_fn, std::move(arguments), exec_ctx);
+  return IterationResult::Pending(std::move(result), std::move(input.eof));
 }
 
 //===----------------------------------------------------------------------===//
@@ -49,5 +89,94 @@ IterationResult MapDatasetIterator::GetNext(const ExecutionContext& exec_ctx) {
   return IterationResult::Pending(std::move(result), std::move(eof));
 }
 
+void MapDatasetIterator::GetNextBatch(
+    const ExecutionContext& exec_ctx, size_t count,
+    SmallVectorImpl<IterationResult>* results) {
+  SmallVector<IterationResult, 16> inputs;
+  input_iterator_->GetNextBatch(exec_ctx, count, &inputs);
+  const Function* map_fn = parent_dataset_->map_fn_.get();
+  auto additional_fn_args = parent_dataset_->additional_fn_args_.values();
+
+  results->reserve(results->size() + count);
+  Optional<IterationResult> eof;
+  for (auto& input : inputs) {
+    // Do not run the function once the input is known to be exhausted.
+    if (internal::IsConcreteAndEmpty(input)) {
+      if (!eof)
+        eof.emplace(IterationResult::Eof(exec_ctx.host(),
+                                         map_fn->result_types().size()));
+      results->push_back(eof->CopyRef());
+      continue;
+    }
+
+    SmallVector<RCReference<AsyncValue>, 4> arguments;
+    arguments.reserve(additional_fn_args.size() + input.values.size());
+    for (auto* value : additional_fn_args) arguments.push_back(FormRef(value));
+    for (auto& value : input.values) arguments.push_back(std::move(value));
+    auto result = RunFunctionWhenReady(map_fn, std::move(arguments), exec_ctx);
+    results->push_back(
+        IterationResult::Pending(std::move(result), std::move(input.eof)));
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// ParallelMapDatasetIterator methods
+//===----------------------------------------------------------------------===//
+IterationResult ParallelMapDatasetIterator::GetNext(
+    const ExecutionContext& exec_ctx) {
+  const Function* map_fn = parent_dataset_->map_fn_.get();
+  auto additional_fn_args = parent_dataset_->additional_fn_args_.values();
+  const int64_t num_parallel_calls =
+      parent_dataset_->NumParallelCalls(autotune_knob_.get());
+  while (static_cast<int64_t>(buffer_.size()) < num_parallel_calls) {
+    buffer_.push(StartParallelMap(input_iterator_.get(), map_fn,
+                                  additional_fn_args, exec_ctx));
+  }
+  auto result = std::move(buffer_.front());
+  buffer_.pop();
+  if (autotune_knob_) {
+    // The invocations are ahead of the consumer if even the last one in
+    // flight has finished.
+    autotune_knob_->RecordGetNext(
+        result,
+        /*producer_idle=*/!buffer_.empty() &&
+            internal::IsAvailable(buffer_.back()));
+  }
+  return result;
+}
+
+//===----------------------------------------------------------------------===//
+// NonDeterministicParallelMapDatasetIterator methods
+//===----------------------------------------------------------------------===//
+IterationResult NonDeterministicParallelMapDatasetIterator::GetNext(
+    const ExecutionContext& exec_ctx) {
+  const Function* map_fn = parent_dataset_->map_fn_.get();
+  auto additional_fn_args = parent_dataset_->additional_fn_args_.values();
+  const int64_t num_parallel_calls =
+      parent_dataset_->NumParallelCalls(autotune_knob_.get());
+  while (static_cast<int64_t>(buffer_.size()) < num_parallel_calls) {
+    buffer_.push_back(StartParallelMap(input_iterator_.get(), map_fn,
+                                       additional_fn_args, exec_ctx));
+  }
+  for (auto it = buffer_.begin(), e = buffer_.end(); it != e; ++it) {
+    if (internal::IsAvailableAndNotEof(*it)) {
+      auto value = std::move(*it);
+      buffer_.erase(it);
+      if (autotune_knob_) {
+        autotune_knob_->RecordGetNext(
+            value, /*producer_idle=*/!buffer_.empty() &&
+                       internal::IsAvailable(buffer_.back()));
+      }
+      return value;
+    }
+  }
+
+  auto result = std::move(buffer_.front());
+  buffer_.pop_front();
+  if (autotune_knob_)
+    autotune_knob_->RecordGetNext(result, /*producer_idle=*/false);
+  return result;
+}
+
 }  // namespace data
 }  // namespace tfrt
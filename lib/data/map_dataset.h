@@ -20,6 +20,10 @@
 #ifndef TFRT_LIB_DATA_MAP_DATASET_H_
 #define TFRT_LIB_DATA_MAP_DATASET_H_
 
+#include <list>
+#include <queue>
+
+#include "autotune.h"
 #include "tfrt/data/dataset.h"
 #include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/host_context/function.h"
@@ -32,16 +36,27 @@ class MapDatasetIterator;
 
 // MapDataset maps a user-defined function over the elements in its input
 // dataset.
+//
+// If `num_parallel_calls` is larger than 1, up to `num_parallel_calls`
+// invocations of the function are kept in flight in the work queue of the
+// HostContext. If `is_deterministic` is false, elements whose function has
+// finished may be returned before earlier elements whose function is still
+// running. If `num_parallel_calls` is kAutotune, the number of invocations in
+// flight is tuned at runtime by the AutotuneController.
 class MapDataset : public Dataset {
  public:
   explicit MapDataset(RCReference<Dataset> input_dataset,
                       RCArray<AsyncValue> additional_fn_args,
-                      RCReference<const Function> map_fn, HostContext* host)
+                      RCReference<const Function> map_fn,
+                      int64_t num_parallel_calls, bool is_deterministic,
+                      HostContext* host)
       : input_dataset_(std::move(input_dataset)),
         host_(host),
         allocator_(host->allocator()),
         additional_fn_args_(std::move(additional_fn_args)),
-        map_fn_(std::move(map_fn)) {}
+        map_fn_(std::move(map_fn)),
+        num_parallel_calls_(num_parallel_calls),
+        is_deterministic_(is_deterministic) {}
 
   // This class is not copyable or movable.
   MapDataset(const MapDataset&) = delete;
@@ -52,16 +67,29 @@ class MapDataset : public Dataset {
  private:
   // Allow iterator to rely on private data members of this dataset.
   friend class MapDatasetIterator;
+  friend class ParallelMapDatasetIterator;
+  friend class NonDeterministicParallelMapDatasetIterator;
 
   void Destroy() override {
     internal::DestroyImpl<MapDataset>(this, allocator_);
   }
 
+  // Returns the knob that tunes the parallelism of an iterator, or nullptr if
+  // the parallelism is not autotuned.
+  RCReference<AutotuneKnob> MakeAutotuneKnob();
+
+  // Returns the parallelism of an iterator with the given `autotune_knob`.
+  int64_t NumParallelCalls(const AutotuneKnob* autotune_knob) const {
+    return autotune_knob ? autotune_knob->value() : num_parallel_calls_;
+  }
+
   RCReference<Dataset> input_dataset_;
   HostContext* host_;
   HostAllocator* allocator_;
   RCArray<AsyncValue> additional_fn_args_;
   RCReference<const Function> map_fn_;
+  const int64_t num_parallel_calls_;
+  const bool is_deterministic_;
 };
 
 // If all AsyncValue's in `arguments` are available at the time this method is
@@ -125,6 +153,46 @@ inline llvm::SmallVector<RCReference<AsyncValue>, 4> RunFunctionWhenReady(
   return results_copy;
 }
 
+// Similar to RunFunctionWhenReady, except that the function is always executed
+// in the work queue of the HostContext once `arguments` are available, so that
+// invocations for different elements can run concurrently.
+inline llvm::SmallVector<RCReference<AsyncValue>, 4> RunFunctionInWorkQueue(
+    const Function* function,
+    llvm::SmallVector<RCReference<AsyncValue>, 4> arguments,
+    const ExecutionContext& exec_ctx) {
+  auto* host = exec_ctx.host();
+  auto num_results = function->result_types().size();
+  llvm::SmallVector<AsyncValue*, 4> argument_ptrs;
+  for (const auto& argument : arguments) argument_ptrs.push_back(argument.get());
+
+  llvm::SmallVector<RCReference<IndirectAsyncValue>, 4> results;
+  llvm::SmallVector<RCReference<AsyncValue>, 4> results_copy;
+  results.resize(num_results);
+  results_copy.resize(num_results);
+  for (size_t i = 0; i < num_results; ++i) {
+    results[i] = MakeIndirectAsyncValue(host);
+    results_copy[i] = results[i];
+  }
+
+  RunWhenReady(argument_ptrs, [function, arguments = std::move(arguments),
+                               results = std::move(results), argument_ptrs,
+                               exec_ctx]() mutable {
+    EnqueueWork(exec_ctx, [function, arguments = std::move(arguments),
+                           results = std::move(results), argument_ptrs,
+                           exec_ctx]() mutable {
+      auto num_results = function->result_types().size();
+      SmallVector<RCReference<AsyncValue>, 4> fn_results;
+      fn_results.resize(num_results);
+      function->Execute(exec_ctx, argument_ptrs, fn_results);
+      for (size_t i = 0; i < num_results; ++i) {
+        results[i]->ForwardTo(std::move(fn_results[i]));
+      }
+    });
+  });
+
+  return results_copy;
+}
+
 class MapDatasetIterator : public Iterator {
  public:
   explicit MapDatasetIterator(RCReference<MapDataset> parent_dataset,
@@ -136,6 +204,9 @@ class MapDatasetIterator : public Iterator {
 
   IterationResult GetNext(const ExecutionContext& exec_ctx) override;
 
+  void GetNextBatch(const ExecutionContext& exec_ctx, size_t count,
+                    SmallVectorImpl<IterationResult>* results) override;
+
  private:
   // This class is not copyable or movable.
   MapDatasetIterator(const MapDatasetIterator&) = delete;
@@ -150,6 +221,67 @@ class MapDatasetIterator : public Iterator {
   RCReference<Iterator> input_iterator_;
 };
 
+// This iterator keeps up to `num_parallel_calls` function invocations in flight
+// and returns values in a deterministic order.
+class ParallelMapDatasetIterator : public Iterator {
+ public:
+  explicit ParallelMapDatasetIterator(RCReference<MapDataset> parent_dataset,
+                                      const IteratorContext& context)
+      : Iterator(),
+        parent_dataset_(std::move(parent_dataset)),
+        input_iterator_(parent_dataset_->input_dataset_->MakeIterator(context)),
+        autotune_knob_(parent_dataset_->MakeAutotuneKnob()) {}
+
+  // This class is not copyable or movable.
+  ParallelMapDatasetIterator(const ParallelMapDatasetIterator&) = delete;
+  ParallelMapDatasetIterator& operator=(const ParallelMapDatasetIterator&) =
+      delete;
+
+  IterationResult GetNext(const ExecutionContext& exec_ctx) override;
+
+ private:
+  void Destroy() override {
+    internal::DestroyImpl<ParallelMapDatasetIterator>(
+        this, parent_dataset_->allocator_);
+  }
+
+  RCReference<MapDataset> parent_dataset_;
+  RCReference<Iterator> input_iterator_;
+  RCReference<AutotuneKnob> autotune_knob_;
+  std::queue<IterationResult> buffer_;
+};
+
+// This iterator keeps up to `num_parallel_calls` function invocations in flight
+// and might return values in a non-deterministic order.
+class NonDeterministicParallelMapDatasetIterator : public Iterator {
+ public:
+  explicit NonDeterministicParallelMapDatasetIterator(
+      RCReference<MapDataset> parent_dataset, const IteratorContext& context)
+      : Iterator(),
+        parent_dataset_(std::move(parent_dataset)),
+        input_iterator_(parent_dataset_->input_dataset_->MakeIterator(context)),
+        autotune_knob_(parent_dataset_->MakeAutotuneKnob()) {}
+
+  // This class is not copyable or movable.
+  NonDeterministicParallelMapDatasetIterator(
+      const NonDeterministicParallelMapDatasetIterator&) = delete;
+  NonDeterministicParallelMapDatasetIterator& operator=(
+      const NonDeterministicParallelMapDatasetIterator&) = delete;
+
+  IterationResult GetNext(const ExecutionContext& exec_ctx) override;
+
+ private:
+  void Destroy() override {
+    internal::DestroyImpl<NonDeterministicParallelMapDatasetIterator>(
+        this, parent_dataset_->allocator_);
+  }
+
+  RCReference<MapDataset> parent_dataset_;
+  RCReference<Iterator> input_iterator_;
+  RCReference<AutotuneKnob> autotune_knob_;
+  std::list<IterationResult> buffer_;
+};
+
 }  // namespace data
 }  // namespace tfrt
 
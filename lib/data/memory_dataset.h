@@ -19,7 +19,11 @@
 #ifndef TFRT_DATA_MEMORY_DATASET_H_
 #define TFRT_DATA_MEMORY_DATASET_H_
 
+#include <utility>
+#include <vector>
+
 #include "tfrt/data/dataset.h"
+#include "tfrt/host_context/async_dispatch.h"
 
 namespace tfrt {
 namespace data {
@@ -109,22 +113,42 @@ class MemoryDatasetIterator : public Iterator {
   IterationResult GetNext(const ExecutionContext& exec_ctx) override {
     HostContext* host = exec_ctx.host();
     if (!buffer_completed_) {
-      auto input = input_iterator_->GetNext(exec_ctx);
-      if (internal::IsConcreteAndEmpty(input) && buffer_.empty()) {
-        // EOF and buffer empty; forward EOF to caller.
-        return input;
-      }
-      if (!internal::IsConcreteAndEmpty(input)) {
-        // Cache is not completed and not EOF, store the value in the cache.
-        buffer_.push_back(std::move(input));
-        return CopyByValue(buffer_.back(), host);
-      }
-      // buffer is not empty and the input_iterator has reached end.
-      buffer_completed_ = true;
+      return AddToBuffer(input_iterator_->GetNext(exec_ctx), host);
     }
-    const int index = next_buffer_index_;
-    next_buffer_index_ = (next_buffer_index_ + 1) % buffer_.size();
-    return CopyByValue(buffer_[index], host);
+    return NextFromBuffer(host);
+  }
+
+  void GetNextBatch(const ExecutionContext& exec_ctx, size_t count,
+                    SmallVectorImpl<IterationResult>* results) override {
+    HostContext* host = exec_ctx.host();
+    results->reserve(results->size() + count);
+    size_t i = 0;
+    // Fill the buffer one element at a time, as the input iterator must not be
+    // asked for more elements once it has reached end.
+    for (; i < count && !buffer_completed_; ++i) {
+      results->push_back(AddToBuffer(input_iterator_->GetNext(exec_ctx), host));
+    }
+    if (i == count) return;
+
+    // Replay the buffered elements. Unlike NextFromBuffer(), the values of all
+    // elements are copied by a single callback.
+    SmallVector<AsyncValue*, 16> inputs;
+    std::vector<std::pair<IterationResult, RCArray<AsyncValue>>> copies;
+    copies.reserve(count - i);
+    for (; i < count; ++i) {
+      const IterationResult& input = buffer_[next_buffer_index_];
+      next_buffer_index_ = (next_buffer_index_ + 1) % buffer_.size();
+
+      auto values_copy = AllocateValues(host);
+      for (const auto& value : input.values) inputs.push_back(value.get());
+      copies.emplace_back(input.CopyRef(), RCArray<AsyncValue>(values_copy));
+      results->push_back(IterationResult::Pending(std::move(values_copy),
+                                                  input.eof.CopyRef()));
+    }
+    RunWhenReady(inputs, [copies = std::move(copies)]() {
+      for (const auto& copy : copies)
+        internal::CopyByValue<T...>(copy.first.values, copy.second.CopyRef());
+    });
   }
 
  private:
@@ -133,12 +157,41 @@ class MemoryDatasetIterator : public Iterator {
                                                  parent_dataset_->allocator_);
   }
 
+  // Stores `input` from the input iterator in the buffer and returns a copy of
+  // it. Once the input iterator has reached end, marks the buffer as completed
+  // and returns its first element instead.
+  IterationResult AddToBuffer(IterationResult input, HostContext* host) {
+    if (internal::IsConcreteAndEmpty(input) && buffer_.empty()) {
+      // EOF and buffer empty; forward EOF to caller.
+      return input;
+    }
+    if (!internal::IsConcreteAndEmpty(input)) {
+      // Cache is not completed and not EOF, store the value in the cache.
+      buffer_.push_back(std::move(input));
+      return CopyByValue(buffer_.back(), host);
+    }
+    // buffer is not empty and the input_iterator has reached end.
+    buffer_completed_ = true;
+    return NextFromBuffer(host);
+  }
+
+  IterationResult NextFromBuffer(HostContext* host) {
+    const int index = next_buffer_index_;
+    next_buffer_index_ = (next_buffer_index_ + 1) % buffer_.size();
+    return CopyByValue(buffer_[index], host);
+  }
+
+  SmallVector<RCReference<AsyncValue>, 4> AllocateValues(HostContext* host) {
+    SmallVector<RCReference<AsyncValue>, 4> values;
+    values.resize(sizeof...(T));
+    internal::AllocateTupleResult<T...>(
+        values, host, std::make_index_sequence<sizeof...(T)>{});
+    return values;
+  }
+
   IterationResult CopyByValue(const IterationResult& input, HostContext* host) {
     // Copy data by value so that the output result can be mutated.
-    SmallVector<RCReference<AsyncValue>, 4> values_copy;
-    values_copy.resize(sizeof...(T));
-    internal::AllocateTupleResult<T...>(
-        values_copy, host, std::make_index_sequence<sizeof...(T)>{});
+    auto values_copy = AllocateValues(host);
 
     RunWhenReady(
         input.values, [input = input.CopyRef(),
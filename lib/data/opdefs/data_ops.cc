@@ -204,6 +204,18 @@ static LogicalResult verify(EnumerateIteratorOp op) {
   return success();
 }
 
+//===----------------------------------------------------------------------===//
+// MapDatasetOp
+//===----------------------------------------------------------------------===//
+
+static LogicalResult verify(MapDatasetOp op) {
+  // The kernel tells the optional attributes apart by their number.
+  if (op.is_deterministicAttr() && !op.num_parallel_callsAttr())
+    return op.emitOpError(
+        "requires num_parallel_calls when is_deterministic is set");
+  return success();
+}
+
 //===----------------------------------------------------------------------===//
 // RangeDatasetOp
 //===----------------------------------------------------------------------===//
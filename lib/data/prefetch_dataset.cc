@@ -19,9 +19,14 @@
 // buffer.
 #include "prefetch_dataset.h"
 
+#include <algorithm>
+
 namespace tfrt {
 namespace data {
 
+// The upper bound of an autotuned buffer size, per worker thread.
+static constexpr int64_t kMaxAutotunePrefetchPerThread = 16;
+
 //===----------------------------------------------------------------------===//
 // PrefetchDataset methods
 //===----------------------------------------------------------------------===//
@@ -34,47 +39,64 @@ RCReference<Iterator> PrefetchDataset::MakeIterator(
       FormRef(this), context));
 }
 
+RCReference<AutotuneKnob> PrefetchDataset::MakeAutotuneKnob() {
+  if (prefetch_num_ != kAutotune) return {};
+  int64_t num_threads = std::max(1, host_->GetNumWorkerThreads());
+  return AutotuneController::Get(host_).MakeKnob(
+      /*initial_value=*/num_threads, /*min_value=*/1,
+      /*max_value=*/kMaxAutotunePrefetchPerThread * num_threads);
+}
+
 //===----------------------------------------------------------------------===//
 // PrefetchDatasetIterator methods
 //===----------------------------------------------------------------------===//
 IterationResult PrefetchDatasetIterator::GetNext(
     const ExecutionContext& exec_ctx) {
-  while (buffer_.size() < parent_dataset_->prefetch_num_ + 1) {
+  const int64_t prefetch_num =
+      parent_dataset_->PrefetchNum(autotune_knob_.get());
+  while (static_cast<int64_t>(buffer_.size()) < prefetch_num + 1) {
     buffer_.push(input_iterator_->GetNext(exec_ctx));
   }
   auto result = std::move(buffer_.front());
   buffer_.pop();
+  if (autotune_knob_) {
+    // The producer is ahead of the consumer if even the last element of the
+    // buffer is available.
+    autotune_knob_->RecordGetNext(
+        result,
+        /*producer_idle=*/!buffer_.empty() &&
+            internal::IsAvailable(buffer_.back()));
+  }
   return result;
 }
 
 //===----------------------------------------------------------------------===//
 // NonDeterministicPrefetchDatasetIterator methods
 //===----------------------------------------------------------------------===//
-
-static bool AvailableAndNotEof(const IterationResult& result) {
-  if (result.eof.IsConcrete() && result.eof.get()) return false;
-  if (!result.eof.IsAvailable()) return false;
-  for (auto& value : result.values) {
-    if (!value->IsAvailable()) return false;
-  }
-  return true;
-}
-
 IterationResult NonDeterministicPrefetchDatasetIterator::GetNext(
     const ExecutionContext& exec_ctx) {
-  while (buffer_.size() < parent_dataset_->prefetch_num_ + 1) {
+  const int64_t prefetch_num =
+      parent_dataset_->PrefetchNum(autotune_knob_.get());
+  while (static_cast<int64_t>(buffer_.size()) < prefetch_num + 1) {
     buffer_.push_back(input_iterator_->GetNext(exec_ctx));
   }
   for (auto it = buffer_.begin(), e = buffer_.end(); it != e; ++it) {
-    if (AvailableAndNotEof(*it)) {
+    if (internal::IsAvailableAndNotEof(*it)) {
       auto value = std::move(*it);
       buffer_.erase(it);
+      if (autotune_knob_) {
+        autotune_knob_->RecordGetNext(
+            value, /*producer_idle=*/!buffer_.empty() &&
+                       internal::IsAvailable(buffer_.back()));
+      }
       return value;
     }
   }
 
   auto result = std::move(buffer_.front());
   buffer_.pop_front();
+  if (autotune_knob_)
+    autotune_knob_->RecordGetNext(result, /*producer_idle=*/false);
   return result;
 }
 
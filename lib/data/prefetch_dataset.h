@@ -24,6 +24,7 @@
 #include <list>
 #include <queue>
 
+#include "autotune.h"
 #include "tfrt/data/dataset.h"
 #include "tfrt/support/forward_decls.h"
 
@@ -34,6 +35,9 @@ class PrefetchDatasetIterator;
 
 // PrefetchDataset class which wraps around another dataset instance and
 // prefetches elements from the underlying dataset in an internal buffer.
+//
+// If `prefetch_num` is kAutotune, the size of the buffer is tuned at runtime by
+// the AutotuneController, starting from the number of worker threads.
 class PrefetchDataset : public Dataset {
  public:
   explicit PrefetchDataset(RCReference<Dataset> input_dataset,
@@ -55,6 +59,15 @@ class PrefetchDataset : public Dataset {
   friend class PrefetchDatasetIterator;
   friend class NonDeterministicPrefetchDatasetIterator;
 
+  // Returns the knob that tunes the buffer size of an iterator, or nullptr if
+  // the buffer size is not autotuned.
+  RCReference<AutotuneKnob> MakeAutotuneKnob();
+
+  // Returns the buffer size of an iterator with the given `autotune_knob`.
+  int64_t PrefetchNum(const AutotuneKnob* autotune_knob) const {
+    return autotune_knob ? autotune_knob->value() : prefetch_num_;
+  }
+
   void Destroy() override {
     internal::DestroyImpl<PrefetchDataset>(this, host_->allocator());
   }
@@ -75,8 +88,8 @@ class PrefetchDatasetIterator : public Iterator {
                                    const IteratorContext& context)
       : Iterator(),
         parent_dataset_(std::move(parent_dataset)),
-        input_iterator_(
-            parent_dataset_->input_dataset_->MakeIterator(context)) {}
+        input_iterator_(parent_dataset_->input_dataset_->MakeIterator(context)),
+        autotune_knob_(parent_dataset_->MakeAutotuneKnob()) {}
 
   // This class is not copyable or movable.
   PrefetchDatasetIterator(const PrefetchDatasetIterator&) = delete;
@@ -92,6 +105,7 @@ class PrefetchDatasetIterator : public Iterator {
 
   RCReference<PrefetchDataset> parent_dataset_;
   RCReference<Iterator> input_iterator_;
+  RCReference<AutotuneKnob> autotune_knob_;
   std::queue<IterationResult> buffer_;
 };
 
@@ -103,8 +117,8 @@ class NonDeterministicPrefetchDatasetIterator : public Iterator {
       const IteratorContext& context)
       : Iterator(),
         parent_dataset_(std::move(parent_dataset)),
-        input_iterator_(
-            parent_dataset_->input_dataset_->MakeIterator(context)) {}
+        input_iterator_(parent_dataset_->input_dataset_->MakeIterator(context)),
+        autotune_knob_(parent_dataset_->MakeAutotuneKnob()) {}
 
   // This class is not copyable or movable.
   NonDeterministicPrefetchDatasetIterator(const PrefetchDatasetIterator&) =
@@ -122,6 +136,7 @@ class NonDeterministicPrefetchDatasetIterator : public Iterator {
 
   RCReference<PrefetchDataset> parent_dataset_;
   RCReference<Iterator> input_iterator_;
+  RCReference<AutotuneKnob> autotune_knob_;
   std::list<IterationResult> buffer_;
 };
 
@@ -19,6 +19,8 @@
 
 #include "range_dataset.h"
 
+#include <algorithm>
+
 namespace tfrt {
 namespace data {
 
@@ -55,6 +57,68 @@ IterationResult RangeDatasetIterator::GetNext(
   return IterationResult::Values(std::move(values), host);
 }
 
+size_t RangeDatasetIterator::NumRemaining(size_t max_count) const {
+  const int64_t step = dataset_->step_;
+  const int64_t stop = dataset_->stop_;
+  if ((step > 0 && next_ >= stop) || (step < 0 && next_ <= stop)) return 0;
+  // Round the distance to the stop value up to a multiple of the step.
+  const uint64_t distance =
+      step > 0 ? static_cast<uint64_t>(stop) - static_cast<uint64_t>(next_)
+               : static_cast<uint64_t>(next_) - static_cast<uint64_t>(stop);
+  const uint64_t abs_step =
+      step > 0 ? static_cast<uint64_t>(step) : -static_cast<uint64_t>(step);
+  return std::min<uint64_t>(max_count, (distance + abs_step - 1) / abs_step);
+}
+
+template <typename T>
+void RangeDatasetIterator::AppendValues(
+    size_t count, const AsyncValueRef<bool>& eof, HostContext* host,
+    SmallVectorImpl<IterationResult>* results) {
+  for (size_t i = 0; i < count; ++i) {
+    SmallVector<RCReference<AsyncValue>, 4> values;
+    values.push_back(
+        MakeAvailableAsyncValueRef<T>(host, static_cast<T>(next_)));
+    results->push_back(
+        IterationResult::Pending(std::move(values), eof.CopyRef()));
+    next_ += dataset_->step_;
+  }
+}
+
+void RangeDatasetIterator::GetNextBatch(
+    const ExecutionContext& exec_ctx, size_t count,
+    SmallVectorImpl<IterationResult>* results) {
+  HostContext* host = exec_ctx.host();
+  results->reserve(results->size() + count);
+
+  // All valid elements of the batch share the same eof value.
+  const size_t num_values = NumRemaining(count);
+  if (num_values > 0) {
+    auto eof = MakeAvailableAsyncValueRef<bool>(host, false);
+    switch (dataset_->element_type_) {
+#define DTYPE_NUMERIC(ENUM)                                             \
+  case DType::ENUM:                                                     \
+    AppendValues<TypeForDTypeKind<DType::ENUM>>(num_values, eof, host, \
+                                                results);               \
+    break;
+
+#include "tfrt/dtype/dtype.def"  // NOLINT
+#undef DTYPE_NUMERIC
+      default: {
+        auto error = IterationResult::Error(
+            MakeErrorAsyncValueRef(host, "Unsupported data type"), 1);
+        for (size_t i = 0; i < count; ++i) results->push_back(error.CopyRef());
+        return;
+      }
+    }
+  }
+
+  if (num_values < count) {
+    auto eof = IterationResult::Eof(host, 1);
+    for (size_t i = num_values; i < count; ++i)
+      results->push_back(eof.CopyRef());
+  }
+}
+
 //===----------------------------------------------------------------------===//
 // RangeDataset methods
 //===----------------------------------------------------------------------===//
@@ -74,7 +74,18 @@ class RangeDatasetIterator : public Iterator {
 
   IterationResult GetNext(const ExecutionContext& exec_ctx) override;
 
+  void GetNextBatch(const ExecutionContext& exec_ctx, size_t count,
+                    SmallVectorImpl<IterationResult>* results) override;
+
  private:
+  // Returns the number of remaining elements, but at most `max_count`.
+  size_t NumRemaining(size_t max_count) const;
+
+  template <typename T>
+  void AppendValues(size_t count, const AsyncValueRef<bool>& eof,
+                    HostContext* host,
+                    SmallVectorImpl<IterationResult>* results);
+
   void Destroy() override {
     internal::DestroyImpl<RangeDatasetIterator>(this, dataset_->allocator_);
   }
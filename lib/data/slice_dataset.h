@@ -20,6 +20,9 @@
 #ifndef TFRT_DATA_SLICE_DATASET_H_
 #define TFRT_DATA_SLICE_DATASET_H_
 
+#include <algorithm>
+#include <iterator>
+
 #include "tfrt/data/dataset.h"
 #include "tfrt/support/forward_decls.h"
 #include "tfrt/tensor/dense_host_tensor.h"
@@ -73,12 +76,37 @@ class SliceDatasetIterator : public Iterator {
       return IterationResult::Eof(host, 1);
     }
 
-    SmallVector<RCReference<AsyncValue>, 1> values;
-    values.push_back(MakeAvailableAsyncValueRef<T>(host, *iterator_));
+    SmallVector<RCReference<AsyncValue>, 4> values;
+    values.push_back(MakeValue(host));
     iterator_++;
     return IterationResult::Values(std::move(values), host);
   }
 
+  void GetNextBatch(const ExecutionContext& exec_ctx, size_t count,
+                    SmallVectorImpl<IterationResult>* results) override {
+    HostContext* host = exec_ctx.host();
+    results->reserve(results->size() + count);
+
+    // All valid elements of the batch share the same eof value.
+    const size_t num_values =
+        std::min<size_t>(count, std::distance(iterator_, end_));
+    if (num_values > 0) {
+      auto eof = MakeAvailableAsyncValueRef<bool>(host, false);
+      for (size_t i = 0; i < num_values; ++i, ++iterator_) {
+        SmallVector<RCReference<AsyncValue>, 4> values;
+        values.push_back(MakeValue(host));
+        results->push_back(
+            IterationResult::Pending(std::move(values), eof.CopyRef()));
+      }
+    }
+
+    if (num_values < count) {
+      auto eof = IterationResult::Eof(host, 1);
+      for (size_t i = num_values; i < count; ++i)
+        results->push_back(eof.CopyRef());
+    }
+  }
+
  private:
   // This class is not copyable or movable.
   SliceDatasetIterator(const SliceDatasetIterator&) = delete;
@@ -89,6 +117,11 @@ class SliceDatasetIterator : public Iterator {
                                                 parent_dataset_->allocator_);
   }
 
+  // Returns an available value with a copy of the current element.
+  RCReference<AsyncValue> MakeValue(HostContext* host) {
+    return MakeAvailableAsyncValueRef<T>(host, *iterator_);
+  }
+
   RCReference<SliceDataset<T>> parent_dataset_;
   typename std::vector<T>::iterator iterator_;
   typename std::vector<T>::iterator end_;
@@ -98,18 +131,10 @@ class SliceDatasetIterator : public Iterator {
 // not have copy constructor. This implementation passes DenseHostTensor by
 // reference.
 template <>
-inline IterationResult SliceDatasetIterator<DenseHostTensor>::GetNext(
-    const ExecutionContext& exec_ctx) {
-  HostContext* host = exec_ctx.host();
-  if (iterator_ == end_) {
-    return IterationResult::Eof(host, 1);
-  }
-
-  SmallVector<RCReference<AsyncValue>, 1> values;
-  values.push_back(
-      MakeAvailableAsyncValueRef<DenseHostTensor>(host, iterator_->CopyRef()));
-  iterator_++;
-  return IterationResult::Values(std::move(values), host);
+inline RCReference<AsyncValue> SliceDatasetIterator<DenseHostTensor>::MakeValue(
+    HostContext* host) {
+  return MakeAvailableAsyncValueRef<DenseHostTensor>(host,
+                                                     iterator_->CopyRef());
 }
 
 template <typename T>
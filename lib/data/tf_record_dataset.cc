@@ -27,6 +27,10 @@
 namespace tfrt {
 namespace data {
 
+// The bounds of the autotuned number of prefetched records.
+static constexpr int64_t kMinAutotunePrefetch = 4;
+static constexpr int64_t kMaxAutotunePrefetch = 4096;
+
 //===----------------------------------------------------------------------===//
 // Implementation for TFRecordDataset member functions
 //===----------------------------------------------------------------------===//
@@ -37,6 +41,13 @@ RCReference<Iterator> TFRecordDataset::MakeIterator(
       host_->Construct<TFRecordDatasetIterator>(FormRef(this), context));
 }
 
+RCReference<AutotuneKnob> TFRecordDataset::MakeAutotuneKnob() {
+  if (!autotune_prefetch_) return {};
+  return AutotuneController::Get(host_).MakeKnob(
+      /*initial_value=*/max_prefetch_num_, /*min_value=*/kMinAutotunePrefetch,
+      /*max_value=*/kMaxAutotunePrefetch);
+}
+
 //===----------------------------------------------------------------------===//
 // Implementation for TFRecordDatasetIterator member functions
 //===----------------------------------------------------------------------===//
@@ -48,10 +59,28 @@ IterationResult TFRecordDatasetIterator::GetNextElement(
     return IterationResult::Error(std::move(async_error), 1);
   }
 
+  if (parent_dataset_->use_mmap_) {
+    auto result = ReadMappedRecord();
+    if (!result) {
+      auto error = MakeErrorAsyncValueRef(host, StrCat(result.takeError()));
+      return IterationResult::Error(std::move(error), 1);
+    }
+    if (!result->hasValue()) {
+      return IterationResult::Eof(host, 1);
+    }
+
+    llvm::SmallVector<RCReference<AsyncValue>, 4> values;
+    values.push_back(
+        MakeAvailableAsyncValueRef<TFRecord>(host, mapped_file_, **result));
+    return IterationResult::Values(std::move(values), host);
+  }
+
   bool eof = false;
   auto result = ReadRecord(&eof);
 
   if (eof) {
+    // The result holds an "end of file" error.
+    if (!result) llvm::consumeError(result.takeError());
     return IterationResult::Eof(host, 1);
   }
   if (!result) {
@@ -116,12 +145,47 @@ llvm::Expected<std::string> TFRecordDatasetIterator::ReadRecord(bool* eof) {
   return body;
 }
 
+llvm::Expected<llvm::Optional<string_view>>
+TFRecordDatasetIterator::ReadMappedRecord() {
+  // Each record is laid out as
+  //   uint64 length, uint32 masked crc of length,
+  //   byte data[length], uint32 masked crc of data.
+  constexpr size_t kHeaderSize = sizeof(uint64_t) + sizeof(uint32_t);
+  const string_view contents = mapped_file_->data();
+  const size_t pos = mapped_offset_;
+  const size_t remaining = contents.size() - pos;
+
+  // Like ReadRecord, a partial header is treated as the end of file.
+  if (remaining < kHeaderSize) return llvm::None;
+
+  const char* header = contents.data() + pos;
+  if (crc32c::Unmask(DecodeFixed32(header + sizeof(uint64_t))) !=
+      crc32c::Value(header, sizeof(uint64_t))) {
+    return MakeStringError("data corruption at position ", pos);
+  }
+  const uint64_t length = DecodeFixed64(header);
+
+  if (remaining < kHeaderSize + sizeof(uint32_t) ||
+      length > remaining - kHeaderSize - sizeof(uint32_t)) {
+    return MakeStringError("truncated record at position ", pos);
+  }
+
+  const char* body = header + kHeaderSize;
+  if (crc32c::Unmask(DecodeFixed32(body + length)) !=
+      crc32c::Value(body, length)) {
+    return MakeStringError("data corruption at position ", pos);
+  }
+
+  mapped_offset_ += kHeaderSize + length + sizeof(uint32_t);
+  return {string_view(body, length)};
+}
+
 llvm::Error TFRecordDatasetIterator::MaybeInitializeStream() {
   if (initialization_error_) {
     return MakeStringError(initialization_error_);
   }
 
-  if (stream_) return llvm::Error::success();
+  if (stream_ || mapped_file_) return llvm::Error::success();
 
   auto* fs_registry = ::tfrt::io::FileSystemRegistry::Default();
   auto* file_system = fs_registry->Lookup("");
@@ -131,6 +195,16 @@ llvm::Error TFRecordDatasetIterator::MaybeInitializeStream() {
     return MakeStringError(initialization_error_);
   }
 
+  if (parent_dataset_->use_mmap_) {
+    auto error =
+        file_system->NewMemoryMappedFile(parent_dataset_->path_, &mapped_file_);
+    if (error) {
+      initialization_error_ = MakeStringError(error);
+      return error;
+    }
+    return llvm::Error::success();
+  }
+
   std::unique_ptr<::tfrt::io::RandomAccessFile> file;
   auto error = file_system->NewRandomAccessFile(parent_dataset_->path_, &file);
   if (error) {
@@ -22,27 +22,44 @@
 
 #include "io.h"
 #include "tfrt/data/dataset.h"
+#include "tfrt/io/file_system.h"
 #include "tfrt/io/input_stream.h"
 #include "tfrt/support/forward_decls.h"
 
 namespace tfrt {
 namespace data {
 
+// A record read from a memory mapped TFRecord file. The bytes are not copied
+// out of the mapping; `file` keeps the mapping alive while the record is used.
+// The tfrt_data.tf_record_to_string kernel copies the bytes into a std::string.
+struct TFRecord {
+  TFRecord(RCReference<::tfrt::io::MemoryMappedFile> file, string_view data)
+      : file(std::move(file)), data(data) {}
+
+  RCReference<::tfrt::io::MemoryMappedFile> file;
+  string_view data;
+};
+
 // TFRecordDataset reads TFRecord bytes from a file.
 //
-// TODO(rachelim): Consider using a custom data type to represent the
-// bytes read from a TFRecord file. This will make the code more type safe
-// and allow for future optimizations to use mmap instead of copying bytes
-// from the file onto the heap.
+// By default every record is read through an input stream and copied into a
+// std::string. If `use_mmap` is true, the file is memory mapped instead and the
+// elements are TFRecord views into the mapping.
+//
+// If `autotune_prefetch` is true, the number of prefetched records is tuned at
+// runtime by the AutotuneController, starting from `max_prefetch_num`.
 class TFRecordDataset : public Dataset {
  public:
   explicit TFRecordDataset(std::string path, int64_t buffer_size,
                            int64_t max_prefetch_num, int64_t prefetch_threshold,
+                           bool autotune_prefetch, bool use_mmap,
                            HostContext* host)
       : path_(std::move(path)),
         buffer_size_(buffer_size),
         max_prefetch_num_(max_prefetch_num),
         prefetch_threshold_(prefetch_threshold),
+        autotune_prefetch_(autotune_prefetch),
+        use_mmap_(use_mmap),
         host_(host),
         allocator_(host->allocator()) {
     assert(buffer_size_ >= 0);
@@ -61,10 +78,16 @@ class TFRecordDataset : public Dataset {
     internal::DestroyImpl<TFRecordDataset>(this, allocator_);
   }
 
+  // Returns the knob that tunes the number of records prefetched by an
+  // iterator, or nullptr if it is not autotuned.
+  RCReference<AutotuneKnob> MakeAutotuneKnob();
+
   const std::string path_;
   const int64_t buffer_size_;
   const int64_t max_prefetch_num_;
   const int64_t prefetch_threshold_;
+  const bool autotune_prefetch_;
+  const bool use_mmap_;
   HostContext* host_;
   HostAllocator* allocator_;
 };
@@ -74,7 +97,8 @@ class TFRecordDatasetIterator : public io::PrefetchingIterator {
   explicit TFRecordDatasetIterator(RCReference<TFRecordDataset> parent_dataset,
                                    const IteratorContext& context)
       : io::PrefetchingIterator(parent_dataset->max_prefetch_num_,
-                                parent_dataset->prefetch_threshold_, context),
+                                parent_dataset->prefetch_threshold_, context,
+                                parent_dataset->MakeAutotuneKnob()),
         parent_dataset_(std::move(parent_dataset)) {}
 
   // This class is not copyable or movable.
@@ -111,8 +135,16 @@ class TFRecordDatasetIterator : public io::PrefetchingIterator {
   // return value.
   llvm::Expected<std::string> ReadRecord(bool* eof);
 
+  // Same as ReadRecord, but returns a view into mapped_file_ and advances
+  // mapped_offset_ instead of reading from stream_. Returns llvm::None at the
+  // end of file, which includes a trailing partial header like ReadRecord.
+  llvm::Expected<llvm::Optional<string_view>> ReadMappedRecord();
+
   RCReference<TFRecordDataset> parent_dataset_;
   std::unique_ptr<::tfrt::io::InputStream> stream_;
+  // Only used if parent_dataset_->use_mmap_ is true.
+  RCReference<::tfrt::io::MemoryMappedFile> mapped_file_;
+  size_t mapped_offset_ = 0;
   llvm::Error initialization_error_ = llvm::Error::success();
 };
 
@@ -0,0 +1,122 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements the request-scoped ArenaAllocator.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "llvm/Support/MathExtras.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/metrics/common_metrics.h"
+
+namespace tfrt {
+
+ArenaAllocator::ArenaAllocator(HostAllocator* allocator, size_t block_size)
+    : allocator_(allocator),
+      block_size_(block_size),
+      bytes_reserved_(metrics::GetArenaAllocatorBytesReserved()) {
+  assert(allocator_);
+  assert(block_size_ >= 2 * kMaxSizeClassBytes);
+}
+
+ArenaAllocator::~ArenaAllocator() {
+  for (void* block : blocks_) allocator_->DeallocateBytes(block, block_size_);
+  // Also stops counting the large allocations that were never released.
+  bytes_reserved_->Add(-stats_.bytes_reserved);
+}
+
+void* ArenaAllocator::AllocateBytes(size_t size, size_t alignment) {
+  size = std::max<size_t>(size, 1);
+
+  if (IsLargeAllocation(size)) {
+    {
+      mutex_lock lock(mu_);
+      ++stats_.num_allocations;
+      stats_.bytes_allocated += size;
+      stats_.bytes_reserved += size;
+      UpdatePeakBytesReserved();
+    }
+    bytes_reserved_->Add(size);
+    return allocator_->AllocateBytes(size, alignment);
+  }
+
+  assert(alignment <= block_size_ / 2 && "alignment is too large for arena");
+  size_t rounded_size = llvm::alignTo(size, kMinAlignment);
+
+  mutex_lock lock(mu_);
+  ++stats_.num_allocations;
+  stats_.bytes_allocated += size;
+
+  // All chunks are at least kMinAlignment aligned, so a free chunk can be
+  // reused for any allocation that does not require a larger alignment.
+  if (rounded_size <= kMaxSizeClassBytes && alignment <= kMinAlignment) {
+    FreeChunk*& free_list = free_lists_[rounded_size / kMinAlignment - 1];
+    if (free_list) {
+      FreeChunk* chunk = free_list;
+      free_list = chunk->next;
+      ++stats_.num_reused_allocations;
+      return chunk;
+    }
+  }
+
+  alignment = std::max(alignment, kMinAlignment);
+  char* ptr = reinterpret_cast<char*>(
+      llvm::alignTo(reinterpret_cast<uintptr_t>(cursor_), alignment));
+  if (cursor_ == nullptr || ptr + rounded_size > limit_) {
+    // Start a new block. The remainder of the current block is wasted.
+    char* block = static_cast<char*>(
+        allocator_->AllocateBytes(block_size_, alignof(std::max_align_t)));
+    blocks_.push_back(block);
+    stats_.bytes_reserved += block_size_;
+    UpdatePeakBytesReserved();
+    bytes_reserved_->Add(block_size_);
+    limit_ = block + block_size_;
+    ptr = reinterpret_cast<char*>(
+        llvm::alignTo(reinterpret_cast<uintptr_t>(block), alignment));
+  }
+  cursor_ = ptr + rounded_size;
+  return ptr;
+}
+
+void ArenaAllocator::DeallocateBytes(void* ptr, size_t size) {
+  size = std::max<size_t>(size, 1);
+
+  if (IsLargeAllocation(size)) {
+    allocator_->DeallocateBytes(ptr, size);
+    bytes_reserved_->Add(-static_cast<int64_t>(size));
+    mutex_lock lock(mu_);
+    stats_.bytes_reserved -= size;
+    return;
+  }
+
+  // Chunks that do not fit any size class are reclaimed when the arena is
+  // destroyed.
+  size_t rounded_size = llvm::alignTo(size, kMinAlignment);
+  if (rounded_size > kMaxSizeClassBytes) return;
+
+  mutex_lock lock(mu_);
+  auto* chunk = static_cast<FreeChunk*>(ptr);
+  FreeChunk*& free_list = free_lists_[rounded_size / kMinAlignment - 1];
+  chunk->next = free_list;
+  free_list = chunk;
+}
+
+ArenaAllocatorStats ArenaAllocator::GetStats() const {
+  mutex_lock lock(mu_);
+  return stats_;
+}
+
+}  // namespace tfrt
@@ -20,13 +20,35 @@
 
 #include "tfrt/host_context/concurrent_work_queue.h"
 #include "tfrt/host_context/host_context.h"
+#include "tfrt/metrics/common_metrics.h"
 
 namespace tfrt {
 
+RequestContext::RequestContext(HostContext* host,
+                               ResourceContext* resource_context,
+                               ContextData ctx_data, int64_t id,
+                               RequestOptions request_options,
+                               std::unique_ptr<ArenaAllocator> arena_allocator)
+    : id_{id},
+      request_options_{std::move(request_options)},
+      host_{host},
+      arena_allocator_{std::move(arena_allocator)},
+      allocator_{arena_allocator_ ? arena_allocator_.get() : host->allocator()},
+      resource_context_{resource_context},
+      context_data_{std::move(ctx_data)} {}
+
 RequestContext::~RequestContext() {
   if (auto cancel_value = GetCancelAsyncValue()) {
     cancel_value->DropRef();
   }
+  // Report the arena usage of the request, to tune the arena block size.
+  if (arena_allocator_) {
+    ArenaAllocatorStats stats = arena_allocator_->GetStats();
+    metrics::GetRequestArenaBytesAllocatedHistogram()->Record(
+        stats.bytes_allocated);
+    metrics::GetRequestArenaPeakBytesReservedHistogram()->Record(
+        stats.peak_bytes_reserved);
+  }
 }
 
 void RequestContext::Cancel() {
@@ -46,14 +68,22 @@ void RequestContext::Cancel() {
 }
 
 Expected<RCReference<RequestContext>> RequestContextBuilder::build() && {
+  std::unique_ptr<ArenaAllocator> arena_allocator;
+  if (arena_block_size_ > 0) {
+    arena_allocator =
+        std::make_unique<ArenaAllocator>(host_->allocator(), arena_block_size_);
+  }
   return TakeRef(new RequestContext(host_, resource_context_,
-                                    std::move(context_data_), id_));
+                                    std::move(context_data_), id_,
+                                    std::move(request_options_),
+                                    std::move(arena_allocator)));
 };
 
 ExecutionContext::ExecutionContext(RCReference<RequestContext> req_ctx,
                                    Location location)
     : request_ctx_{std::move(req_ctx)},
       work_queue_(&host()->work_queue()),
+      kernel_scheduling_(host()->kernel_scheduling()),
       location_{location} {}
 
 }  // namespace tfrt
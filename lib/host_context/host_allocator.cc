@@ -23,18 +23,30 @@
 #include <cstdint>
 
 #include "llvm/Support/MathExtras.h"
+#include "tfrt/metrics/common_metrics.h"
 #include "tfrt/support/alloc.h"
 
 namespace tfrt {
 
 class MallocAllocator : public HostAllocator {
+ public:
+  MallocAllocator()
+      : bytes_in_use_(metrics::GetMallocAllocatorBytesInUse()) {}
+
   // Allocate the specified number of bytes with the specified alignment.
   void* AllocateBytes(size_t size, size_t alignment) override {
+    bytes_in_use_->Add(size);
     return AlignedAlloc(alignment, size);
   }
 
   // Deallocate the specified pointer that has the specified size.
-  void DeallocateBytes(void* ptr, size_t size) override { AlignedFree(ptr); }
+  void DeallocateBytes(void* ptr, size_t size) override {
+    bytes_in_use_->Add(-static_cast<int64_t>(size));
+    AlignedFree(ptr);
+  }
+
+ private:
+  ShardedCounter* const bytes_in_use_;
 };
 
 void HostAllocator::VtableAnchor() {}
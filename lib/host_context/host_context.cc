@@ -105,6 +105,10 @@ bool HostContext::IsInWorkerThread() const {
   return work_queue_->IsInWorkerThread();
 }
 
+int HostContext::GetWorkerThreadIndex() const {
+  return work_queue_->GetWorkerThreadIndex();
+}
+
 //===----------------------------------------------------------------------===//
 // SharedContext management
 //===----------------------------------------------------------------------===//
@@ -18,8 +18,12 @@
 
 #include "tfrt/host_context/parallel_for.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/host_context/chain.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
 #include "tfrt/host_context/host_context.h"
 
 namespace tfrt {
@@ -39,13 +43,58 @@ BlockSizes ParallelFor::BlockSizes::Min(size_t min) {
       [min](size_t block_size) { return std::max(min, block_size); });
 }
 
+BlockSizes ParallelFor::BlockSizes::Cost(ElementCost cost) {
+  return BlockSizes(cost);
+}
+
+// Cost model constants, the same as in the Eigen TensorCostModel.
+//
+// Cycles to load/store one byte (L1 bandwidth of 64 bytes per 11 cycles).
+static constexpr double kLoadCycles = 11.0 / 64;
+static constexpr double kStoreCycles = 11.0 / 64;
+// Cycles to start the first parallel task, and every additional one.
+static constexpr double kStartupCycles = 100000;
+static constexpr double kPerThreadCycles = 100000;
+// Cycles in a parallel task large enough to amortize its scheduling overhead.
+static constexpr double kTaskCycles = 40000;
+
+double ParallelFor::ElementCost::Cycles() const {
+  return bytes_loaded * kLoadCycles + bytes_stored * kStoreCycles +
+         compute_cycles;
+}
+
 size_t ParallelFor::BlockSizes::GetBlockSize(size_t num_worker_threads,
+                                             size_t num_busy_threads,
                                              size_t total_size) const {
   // Do not create too many small blocks.
   static constexpr size_t kMaxOversharding = 4;
+  assert(total_size > 0 && "Illegal total size");
+
+  if (cost_.hasValue()) {
+    const double element_cycles = std::max(cost_->Cycles(), 1e-3);
+    const double total_cycles = total_size * element_cycles;
+
+    // The number of threads worth using for the total cost, capped by the
+    // number of idle worker threads (plus the caller thread).
+    const size_t num_idle_threads =
+        num_worker_threads - std::min(num_busy_threads, num_worker_threads);
+    const double max_threads = static_cast<double>(num_idle_threads + 1);
+    const double num_threads = std::min(
+        max_threads, (total_cycles - kStartupCycles) / kPerThreadCycles + 0.9);
+    if (num_threads < 2) return total_size;
+
+    // Split the range between the threads with some oversharding for load
+    // balancing, but keep each block large enough to amortize its overhead.
+    const size_t num_blocks =
+        static_cast<size_t>(num_threads) * kMaxOversharding;
+    const size_t min_block_size =
+        static_cast<size_t>(std::ceil(kTaskCycles / element_cycles));
+    size_t block_size = std::max(min_block_size,
+                                 (total_size + num_blocks - 1) / num_blocks);
+    return std::max<size_t>(1, std::min(block_size, total_size));
+  }
 
   // Split input range to assign `kMaxOversharding` tasks to each worker thread.
-  assert(total_size > 0 && "Illegal total size");
   size_t block_size = total_size / (kMaxOversharding * num_worker_threads);
 
   // Compute final block sizes using implementation function if it is specified.
@@ -143,9 +192,13 @@ void ParallelFor::Execute(size_t total_size, const BlockSizes& block_sizes,
   // Immediately call `on_done` if nothing to execute.
   if (total_size == 0) return on_done();
 
+  ConcurrentWorkQueue& work_queue = exec_ctx_.work_queue();
+  const size_t num_worker_threads = work_queue.GetParallelismLevel();
+  const size_t num_busy_threads = work_queue.GetNumBusyWorkerThreads();
+
   // Compute a parallel block size for the non-empty range [0, total_size).
   const size_t block_size = block_sizes.GetBlockSize(
-      exec_ctx_.host()->GetNumWorkerThreads(), total_size);
+      num_worker_threads, num_busy_threads, total_size);
   assert(block_size > 0 && "Illegal block size");
   assert(block_size <= total_size && "Illegal block size");
 
@@ -156,6 +209,16 @@ void ParallelFor::Execute(size_t total_size, const BlockSizes& block_sizes,
     return;
   }
 
+  // If all worker threads are busy, and the caller is one of them (e.g. a
+  // nested parallel for), enqueued blocks would wait behind the already queued
+  // tasks. Execute all blocks in the caller thread instead.
+  if (num_busy_threads >= num_worker_threads && work_queue.IsInWorkerThread()) {
+    for (size_t begin = 0; begin < total_size; begin += block_size)
+      compute(begin, std::min(total_size, begin + block_size));
+    on_done();
+    return;
+  }
+
   // Allocate parallel for execution context on the heap.
   ParallelForExecutionContext* ctx = ParallelForExecutionContext::Allocate(
       exec_ctx_, total_size, block_size, std::move(compute),
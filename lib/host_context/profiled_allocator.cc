@@ -24,6 +24,7 @@
 #include <cstdint>
 
 #include "tfrt/host_context/host_allocator.h"
+#include "tfrt/metrics/common_metrics.h"
 
 namespace tfrt {
 
@@ -43,7 +44,8 @@ void AtomicUpdateMax(T const& value, std::atomic<T>* max_value) noexcept {
 class ProfiledAllocator : public HostAllocator {
  public:
   explicit ProfiledAllocator(std::unique_ptr<HostAllocator> allocator)
-      : allocator_(std::move(allocator)) {}
+      : allocator_(std::move(allocator)),
+        bytes_in_use_(metrics::GetProfiledAllocatorBytesInUse()) {}
 
   ~ProfiledAllocator() override {
     if (print_profile_) {
@@ -54,10 +56,11 @@ class ProfiledAllocator : public HostAllocator {
   void* AllocateBytes(size_t size, size_t alignment) override {
     ++curr_num_allocations_;
     ++cum_num_allocations_;
-    curr_num_bytes_allocated_.fetch_add(size);
+    int64_t num_bytes_allocated = curr_num_bytes_allocated_.fetch_add(size) +
+                                  static_cast<int64_t>(size);
     AtomicUpdateMax<int64_t>(curr_num_allocations_, &max_num_allocations_);
-    AtomicUpdateMax<int64_t>(curr_num_bytes_allocated_,
-                             &max_num_bytes_allocated_);
+    AtomicUpdateMax<int64_t>(num_bytes_allocated, &max_num_bytes_allocated_);
+    bytes_in_use_->Add(size);
 
     return allocator_->AllocateBytes(size, alignment);
   }
@@ -65,6 +68,7 @@ class ProfiledAllocator : public HostAllocator {
   void DeallocateBytes(void* ptr, size_t size) override {
     --curr_num_allocations_;
     curr_num_bytes_allocated_.fetch_sub(size);
+    bytes_in_use_->Add(-static_cast<int64_t>(size));
 
     allocator_->DeallocateBytes(ptr, size);
   }
@@ -94,6 +98,7 @@ class ProfiledAllocator : public HostAllocator {
 
  private:
   std::unique_ptr<HostAllocator> allocator_;
+  ShardedCounter* const bytes_in_use_;
 };
 
 class LeakCheckAllocator : public ProfiledAllocator {
@@ -17,6 +17,8 @@
 #include <string>
 #include <thread>
 
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
 #include "tfrt/host_context/concurrent_work_queue.h"
 #include "tfrt/support/logging.h"
 
@@ -93,10 +95,42 @@ std::unique_ptr<ConcurrentWorkQueue> MultiThreadedWorkQueueFactory(
   }
 }
 
+// Factory function for a multi-threaded thread pool with workers pinned to the
+// NUMA nodes of the host. The argument must be empty or "X,Y[,G[,P]]", where X
+// and Y are the number of nonblocking and blocking threads, G is the number of
+// thread groups (0 or unspecified means one group per NUMA node), and P is
+// "cpu" (the default) to pin each thread to one CPU of its group, or "node" to
+// pin the threads to all the CPUs of their group.
+std::unique_ptr<ConcurrentWorkQueue> NumaAwareMultiThreadedWorkQueueFactory(
+    string_view arg) {
+  int num_threads = std::thread::hardware_concurrency();
+  int num_blocking = kDefaultNumBlockingThreads;
+  int num_groups = 0;
+  bool pin_to_single_cpu = true;
+  if (!arg.empty()) {
+    llvm::SmallVector<string_view, 4> args;
+    arg.split(args, ',');
+    if (args.size() == 4) pin_to_single_cpu = args[3] == "cpu";
+    if (args.size() < 2 || args.size() > 4 ||
+        args[0].getAsInteger(10, num_threads) ||
+        args[1].getAsInteger(10, num_blocking) ||
+        (args.size() >= 3 && args[2].getAsInteger(10, num_groups)) ||
+        (args.size() == 4 && args[3] != "cpu" && args[3] != "node") ||
+        num_threads <= 0 || num_blocking <= 0 || num_groups < 0) {
+      TFRT_LOG(ERROR) << "Invalid argument for mstd_numa work queue: "
+                      << std::string(arg);
+      return nullptr;
+    }
+  }
+  return CreateNumaAwareMultiThreadedWorkQueue(num_threads, num_blocking,
+                                               num_groups, pin_to_single_cpu);
+}
+
 }  // namespace
 
 TFRT_WORK_QUEUE_FACTORY("s", SingleThreadedWorkQueueFactory);
 TFRT_WORK_QUEUE_FACTORY(
     "mstd", MultiThreadedWorkQueueFactory<MakeMultiThreadedWorkQueue>);
+TFRT_WORK_QUEUE_FACTORY("mstd_numa", NumaAwareMultiThreadedWorkQueueFactory);
 
 }  // namespace tfrt
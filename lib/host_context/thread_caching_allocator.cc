@@ -0,0 +1,441 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements a HostAllocator that serves small allocations from
+// per-thread caches of size-classed chunks.
+//
+// Each size class has a central free list shared by all threads, which is
+// refilled by carving chunks out of large slabs obtained from the underlying
+// allocator. Threads move chunks between their cache and the central free list
+// in batches, so the central lock is taken once per batch. A chunk freed on a
+// different thread than the one that allocated it is cached by the freeing
+// thread, and flows back to the central free list when that cache grows too
+// large, stays idle, or when the thread exits. Slabs whose chunks are all in
+// the central free list are periodically returned to the underlying allocator.
+//
+// Threads find their cache with a thread_local lookup, so the hot path takes no
+// lock regardless of the number of threads using the allocator.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/MathExtras.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/metrics/common_metrics.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace {
+
+// Size classes are chosen to fit the common AsyncValue, Chain and KernelFrame
+// payloads with little waste. Chunks of a size class are aligned to the largest
+// power of two dividing the class size.
+constexpr size_t kSizeClasses[] = {16, 32, 48, 64, 96, 128, 192, 256, 384, 512};
+constexpr int kNumSizeClasses = sizeof(kSizeClasses) / sizeof(kSizeClasses[0]);
+constexpr size_t kMaxSmallSize = 512;
+constexpr size_t kGranule = 16;
+
+// Slabs are aligned to their size, so that the slab of a chunk can be found
+// from its address, and all chunks carved out of a slab are naturally aligned
+// for their size class.
+constexpr size_t kSlabSize = 64 * 1024;
+
+// A thread caches at most kMaxCachedBytes of chunks per size class.
+constexpr size_t kMaxCachedBytes = 32 * 1024;
+
+// Every kTrimInterval operations on a thread cache, chunks that were not used
+// since the previous trim are returned to the central free lists.
+constexpr int kTrimInterval = 16 * 1024;
+
+struct FreeChunk {
+  FreeChunk* next;
+};
+
+size_t NaturalAlignment(size_t size) { return size & (~size + 1); }
+
+char* SlabOf(const void* chunk) {
+  return reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(chunk) &
+                                 ~(kSlabSize - 1));
+}
+
+struct ThreadCache {
+  struct List {
+    FreeChunk* head = nullptr;
+    int count = 0;
+    // The minimum of `count` since the previous trim.
+    int low_water = 0;
+  };
+
+  List lists[kNumSizeClasses];
+  int ops_until_trim = kTrimInterval;
+};
+
+class ThreadCachingAllocator;
+
+// Lets a thread that exits after its allocator was destroyed skip the flush of
+// its cache.
+struct AllocatorHandle {
+  mutex mu;
+  ThreadCachingAllocator* allocator TFRT_GUARDED_BY(mu);
+  // Cleared when the allocator is destroyed. Entries of the thread caches that
+  // refer to a destroyed allocator are pruned when this is false.
+  std::atomic<bool> is_alive{true};
+};
+
+// The caches of the current thread, one per allocator it used. They are
+// returned to their allocators when the thread exits.
+struct ThreadCaches {
+  struct Entry {
+    uint64_t allocator_id;
+    std::shared_ptr<AllocatorHandle> handle;
+    ThreadCache* cache;
+  };
+
+  ~ThreadCaches();
+
+  // The cache of the allocator used last, which avoids searching `entries`.
+  uint64_t last_allocator_id = 0;
+  ThreadCache* last_cache = nullptr;
+  std::vector<Entry> entries;
+};
+
+// Set once the ThreadCaches of the current thread are destroyed. Objects
+// destroyed later, e.g. static objects on the main thread, are then deallocated
+// without a thread cache.
+thread_local bool thread_caches_destroyed = false;
+
+ThreadCaches& GetThreadCaches() {
+  static thread_local ThreadCaches caches;
+  return caches;
+}
+
+class ThreadCachingAllocator : public HostAllocator {
+ public:
+  ThreadCachingAllocator(std::unique_ptr<HostAllocator> allocator,
+                         size_t num_threads)
+      : allocator_(std::move(allocator)),
+        bytes_in_use_(metrics::GetThreadCachingAllocatorBytesInUse()),
+        handle_(std::make_shared<AllocatorHandle>()) {
+    static std::atomic<uint64_t> next_id{1};
+    id_ = next_id.fetch_add(1, std::memory_order_relaxed);
+    handle_->allocator = this;
+    caches_.reserve(num_threads);
+
+    for (size_t granules = 0, cls = 0; granules <= kMaxSmallSize / kGranule;
+         ++granules) {
+      while (kSizeClasses[cls] < granules * kGranule) ++cls;
+      size_class_by_granules_[granules] = cls;
+    }
+  }
+
+  ~ThreadCachingAllocator() override {
+    {
+      // Waits for the exiting threads that are flushing their cache.
+      mutex_lock lock(handle_->mu);
+      handle_->allocator = nullptr;
+      handle_->is_alive.store(false, std::memory_order_relaxed);
+    }
+    for (auto& central : central_) {
+      mutex_lock lock(central.mu);
+      for (char* slab : central.slabs)
+        allocator_->DeallocateBytes(slab, kSlabSize);
+    }
+  }
+
+  void* AllocateBytes(size_t size, size_t alignment) override {
+    bytes_in_use_->Add(size);
+    int cls = SizeClass(size, alignment);
+    if (cls < 0) return allocator_->AllocateBytes(size, alignment);
+
+    if (ThreadCache* cache = LocalCache()) return AllocateChunk(cache, cls);
+    mutex_lock lock(exited_thread_cache_mu_);
+    return AllocateChunk(&exited_thread_cache_, cls);
+  }
+
+  void DeallocateBytes(void* ptr, size_t size) override {
+    // The chunk may belong to a larger size class than the one computed here,
+    // if it was allocated with a larger alignment. Reusing it for the smaller
+    // size class is safe, as it is also aligned enough for that class.
+    bytes_in_use_->Add(-static_cast<int64_t>(size));
+    int cls = SizeClass(size, /*alignment=*/1);
+    if (cls < 0) {
+      allocator_->DeallocateBytes(ptr, size);
+      return;
+    }
+
+    if (ThreadCache* cache = LocalCache()) {
+      DeallocateChunk(cache, cls, ptr);
+      return;
+    }
+    mutex_lock lock(exited_thread_cache_mu_);
+    DeallocateChunk(&exited_thread_cache_, cls, ptr);
+  }
+
+  // Returns all chunks of `cache`, which belonged to a thread that exited, to
+  // the central free lists, and keeps the cache for the next new thread.
+  void ReleaseCache(ThreadCache* cache) {
+    for (int cls = 0; cls < kNumSizeClasses; ++cls) {
+      ThreadCache::List& list = cache->lists[cls];
+      ReleaseToCentral(cls, &list, list.count);
+      ReleaseFreeSlabs(cls);
+    }
+    *cache = ThreadCache();
+    mutex_lock lock(caches_mu_);
+    free_caches_.push_back(cache);
+  }
+
+ private:
+  struct CentralList {
+    mutex mu;
+    FreeChunk* head TFRT_GUARDED_BY(mu) = nullptr;
+    // The number of chunks in the list.
+    int num_free TFRT_GUARDED_BY(mu) = 0;
+    // The unused part of the slab currently used for this size class.
+    char* cursor TFRT_GUARDED_BY(mu) = nullptr;
+    char* limit TFRT_GUARDED_BY(mu) = nullptr;
+    // The slabs carved into chunks of this size class.
+    std::vector<char*> slabs TFRT_GUARDED_BY(mu);
+  };
+
+  static int MaxCachedChunks(int cls) {
+    return std::max<int>(8, kMaxCachedBytes / kSizeClasses[cls]);
+  }
+
+  // Returns the smallest size class that fits `size` bytes with `alignment`,
+  // or -1 if the allocation should be served by the underlying allocator.
+  int SizeClass(size_t size, size_t alignment) const {
+    if (size > kMaxSmallSize) return -1;
+    int cls = size_class_by_granules_[(size + kGranule - 1) / kGranule];
+    if (alignment <= kGranule) return cls;
+
+    assert(alignment <= kMaxSmallSize &&
+           "alignment is too large for a small allocation");
+    for (; cls < kNumSizeClasses; ++cls) {
+      if (NaturalAlignment(kSizeClasses[cls]) >= alignment) return cls;
+    }
+    return -1;
+  }
+
+  void* AllocateChunk(ThreadCache* cache, int cls) {
+    ThreadCache::List& list = cache->lists[cls];
+    if (list.head == nullptr) FetchFromCentral(cls, &list);
+
+    FreeChunk* chunk = list.head;
+    list.head = chunk->next;
+    --list.count;
+    list.low_water = std::min(list.low_water, list.count);
+
+    MaybeTrim(cache);
+    return chunk;
+  }
+
+  void DeallocateChunk(ThreadCache* cache, int cls, void* ptr) {
+    ThreadCache::List& list = cache->lists[cls];
+    auto* chunk = static_cast<FreeChunk*>(ptr);
+    chunk->next = list.head;
+    list.head = chunk;
+    ++list.count;
+
+    if (list.count > MaxCachedChunks(cls))
+      ReleaseToCentral(cls, &list, list.count / 2);
+
+    MaybeTrim(cache);
+  }
+
+  // Returns the cache of the current thread, or nullptr if the thread is
+  // exiting and its caches were already released.
+  ThreadCache* LocalCache() {
+    if (thread_caches_destroyed) return nullptr;
+    ThreadCaches& caches = GetThreadCaches();
+    if (caches.last_allocator_id == id_) return caches.last_cache;
+    return LocalCacheSlow(&caches);
+  }
+
+  ThreadCache* LocalCacheSlow(ThreadCaches* caches) {
+    // Drop the entries of destroyed allocators, whose ids are never reused.
+    llvm::erase_if(caches->entries, [](const ThreadCaches::Entry& entry) {
+      return !entry.handle->is_alive.load(std::memory_order_relaxed);
+    });
+    auto it = llvm::find_if(caches->entries,
+                            [&](const ThreadCaches::Entry& entry) {
+                              return entry.allocator_id == id_;
+                            });
+    ThreadCache* cache;
+    if (it != caches->entries.end()) {
+      cache = it->cache;
+    } else {
+      // This is the first use of the allocator by this thread.
+      mutex_lock lock(caches_mu_);
+      if (free_caches_.empty()) {
+        caches_.push_back(std::make_unique<ThreadCache>());
+        cache = caches_.back().get();
+      } else {
+        cache = free_caches_.back();
+        free_caches_.pop_back();
+      }
+      caches->entries.push_back({id_, handle_, cache});
+    }
+    caches->last_allocator_id = id_;
+    caches->last_cache = cache;
+    return cache;
+  }
+
+  void FetchFromCentral(int cls, ThreadCache::List* list) {
+    int batch_size = MaxCachedChunks(cls) / 2;
+    size_t chunk_size = kSizeClasses[cls];
+    CentralList& central = central_[cls];
+
+    mutex_lock lock(central.mu);
+    while (list->count < batch_size) {
+      FreeChunk* chunk = central.head;
+      if (chunk != nullptr) {
+        central.head = chunk->next;
+        --central.num_free;
+      } else {
+        if (central.cursor == nullptr ||
+            central.cursor + chunk_size > central.limit) {
+          central.cursor = static_cast<char*>(
+              allocator_->AllocateBytes(kSlabSize, kSlabSize));
+          central.limit = central.cursor + kSlabSize;
+          central.slabs.push_back(central.cursor);
+        }
+        chunk = reinterpret_cast<FreeChunk*>(central.cursor);
+        central.cursor += chunk_size;
+      }
+      chunk->next = list->head;
+      list->head = chunk;
+      ++list->count;
+    }
+  }
+
+  void ReleaseToCentral(int cls, ThreadCache::List* list, int num_chunks) {
+    if (num_chunks == 0) return;
+
+    // Detach the first `num_chunks` chunks from the thread cache.
+    FreeChunk* first = list->head;
+    FreeChunk* last = first;
+    for (int i = 1; i < num_chunks; ++i) last = last->next;
+    list->head = last->next;
+    list->count -= num_chunks;
+    list->low_water = std::min(list->low_water, list->count);
+
+    CentralList& central = central_[cls];
+    mutex_lock lock(central.mu);
+    last->next = central.head;
+    central.head = first;
+    central.num_free += num_chunks;
+  }
+
+  // Returns the slabs of size class `cls` whose chunks are all in the central
+  // free list to the underlying allocator. The slab that is being carved is
+  // kept.
+  void ReleaseFreeSlabs(int cls) {
+    const int chunks_per_slab = kSlabSize / kSizeClasses[cls];
+    CentralList& central = central_[cls];
+    std::vector<char*> free_slabs;
+    {
+      mutex_lock lock(central.mu);
+      if (central.num_free < chunks_per_slab) return;
+
+      // The list may also hold chunks of larger size classes, see
+      // DeallocateBytes(). Their slabs are not in `central.slabs`.
+      llvm::DenseMap<char*, int> num_free_chunks;
+      for (FreeChunk* chunk = central.head; chunk; chunk = chunk->next)
+        ++num_free_chunks[SlabOf(chunk)];
+      char* current_slab = central.limit ? SlabOf(central.limit - 1) : nullptr;
+      llvm::erase_if(central.slabs, [&](char* slab) {
+        if (slab == current_slab ||
+            num_free_chunks.lookup(slab) != chunks_per_slab)
+          return false;
+        free_slabs.push_back(slab);
+        return true;
+      });
+      if (free_slabs.empty()) return;
+
+      llvm::DenseSet<char*> is_free_slab(free_slabs.begin(), free_slabs.end());
+      for (FreeChunk** next = &central.head; *next;) {
+        if (is_free_slab.count(SlabOf(*next))) {
+          *next = (*next)->next;
+          --central.num_free;
+        } else {
+          next = &(*next)->next;
+        }
+      }
+    }
+    for (char* slab : free_slabs) allocator_->DeallocateBytes(slab, kSlabSize);
+  }
+
+  void MaybeTrim(ThreadCache* cache) {
+    if (--cache->ops_until_trim > 0) return;
+    cache->ops_until_trim = kTrimInterval;
+
+    for (int cls = 0; cls < kNumSizeClasses; ++cls) {
+      ThreadCache::List& list = cache->lists[cls];
+      ReleaseToCentral(cls, &list, list.low_water / 2);
+      list.low_water = list.count;
+      ReleaseFreeSlabs(cls);
+    }
+  }
+
+  std::unique_ptr<HostAllocator> allocator_;
+  ShardedCounter* const bytes_in_use_;
+  // Identifies the allocator in ThreadCaches. Unlike its address, it is not
+  // reused by a later allocator.
+  uint64_t id_;
+  std::shared_ptr<AllocatorHandle> handle_;
+  int size_class_by_granules_[kMaxSmallSize / kGranule + 1];
+  CentralList central_[kNumSizeClasses];
+
+  mutex caches_mu_;
+  std::vector<std::unique_ptr<ThreadCache>> caches_ TFRT_GUARDED_BY(caches_mu_);
+  // The caches of the threads that exited.
+  std::vector<ThreadCache*> free_caches_ TFRT_GUARDED_BY(caches_mu_);
+
+  // The cache shared by the threads whose ThreadCaches were destroyed.
+  mutex exited_thread_cache_mu_;
+  ThreadCache exited_thread_cache_ TFRT_GUARDED_BY(exited_thread_cache_mu_);
+};
+
+ThreadCaches::~ThreadCaches() {
+  thread_caches_destroyed = true;
+  for (const Entry& entry : entries) {
+    mutex_lock lock(entry.handle->mu);
+    if (entry.handle->allocator)
+      entry.handle->allocator->ReleaseCache(entry.cache);
+  }
+}
+
+}  // namespace
+
+std::unique_ptr<HostAllocator> CreateThreadCachingAllocator(
+    size_t num_threads) {
+  return std::make_unique<ThreadCachingAllocator>(CreateMallocAllocator(),
+                                                  num_threads);
+}
+
+std::unique_ptr<HostAllocator> CreateThreadCachingAllocator(
+    std::unique_ptr<HostAllocator> allocator, size_t num_threads) {
+  return std::make_unique<ThreadCachingAllocator>(std::move(allocator),
+                                                  num_threads);
+}
+
+}  // namespace tfrt
@@ -18,77 +18,256 @@
 
 #include "tfrt/host_context/timer_queue.h"
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/MathExtras.h"
+
 namespace tfrt {
 
-TimerQueue::TimerQueue() {
+TimerQueue::TimerQueue(Options options)
+    : tick_(options.tick), start_(Clock::now()) {
+  assert(tick_.count() > 0 && "Timer tick must be positive");
+  int num_shards = options.num_shards > 0
+                       ? options.num_shards
+                       : std::max(1u, std::thread::hardware_concurrency());
+  for (int i = 0; i < num_shards; ++i)
+    shards_.push_back(std::make_unique<Shard>());
+
   // Start the timer thread.
   // TODO(tfrt-devs): use alternative to std::thread in google-internal build.
   timer_thread_ = std::thread([this]() { TimerThreadRun(); });
 }
 
 TimerQueue::~TimerQueue() {
-  mu_.lock();
-  // Cancel every timer in the queue.
-  while (!timers_.empty()) {
-    timers_.pop();
+  {
+    mutex_lock lock(mu_);
+    stop_.store(true, std::memory_order_release);
+    woken_ = true;
+    // Notify the timer thread we are done.
+    cv_.notify_one();
   }
-  stop_.store(true, std::memory_order_release);
-  // Notify the timer thread we are done cleaning up.
-  cv_.notify_one();
-  mu_.unlock();
   assert(timer_thread_.joinable());
   timer_thread_.join();
+
+  // Cancel every timer in the queue.
+  for (auto& shard : shards_) {
+    mutex_lock lock(shard->mu);
+    for (auto& wheel : shard->wheels) {
+      for (TimerEntry*& head : wheel) {
+        while (TimerEntry* timer = head) {
+          Unlink(timer);
+          timer->DropRef();
+        }
+      }
+    }
+  }
 }
 
-void TimerQueue::TimerThreadRun() {
-  mutex_lock lock(mu_);
-  while (!stop_.load(std::memory_order_acquire)) {
-    const TimerEntry* top_entry = getTopTimer();
-    if (!top_entry) {
-      cv_.wait(lock);
-    } else {
-      // Wait till the timer expires.
-      cv_.wait_until(lock, top_entry->deadline_);
+uint64_t TimerQueue::ToTick(TimePoint time) const {
+  if (time <= start_) return 0;
+  // Round up, so that timers never expire before their deadline.
+  return ((time - start_) + tick_ - TimeDuration(1)) / tick_;
+}
+
+void TimerQueue::Insert(Shard* shard, TimerEntry* timer) {
+  const uint64_t now = shard->current_tick;
+  // Already expired timers expire at the next tick.
+  uint64_t expiry = std::max(timer->expiry_tick_, now + 1);
+
+  // Find the lowest level that covers the delta, and clamp the timers that are
+  // too far in the future to the end of the last level.
+  int level = 0;
+  while (level < kLevels - 1 &&
+         expiry - now >= (uint64_t{1} << (kLevelBits * (level + 1))))
+    ++level;
+  const uint64_t max_delta = (uint64_t{1} << (kLevelBits * kLevels)) - 1;
+  if (expiry - now > max_delta) expiry = now + max_delta;
+
+  const int slot = (expiry >> (kLevelBits * level)) & (kSlots - 1);
+  TimerEntry*& head = shard->wheels[level][slot];
+  timer->next_ = head;
+  if (head) head->pprev_ = &timer->next_;
+  head = timer;
+  timer->pprev_ = &head;
+  timer->level_ = level;
+  timer->slot_ = slot;
+  ++shard->level_sizes[level];
+  if (level == 0) shard->level0_occupied[slot / 64] |= uint64_t{1} << slot % 64;
+}
+
+void TimerQueue::Unlink(TimerEntry* timer) {
+  assert(timer->pprev_ && "Timer is not in a wheel");
+  *timer->pprev_ = timer->next_;
+  if (timer->next_) timer->next_->pprev_ = timer->pprev_;
+  timer->next_ = nullptr;
+  timer->pprev_ = nullptr;
+  Shard* shard = timer->shard_;
+  --shard->level_sizes[timer->level_];
+  if (timer->level_ == 0 && !shard->wheels[0][timer->slot_]) {
+    shard->level0_occupied[timer->slot_ / 64] &=
+        ~(uint64_t{1} << timer->slot_ % 64);
+  }
+}
+
+void TimerQueue::Cascade(Shard* shard, int level, int slot) {
+  TimerEntry* timer = shard->wheels[level][slot];
+  shard->wheels[level][slot] = nullptr;
+  while (timer) {
+    TimerEntry* next = timer->next_;
+    timer->next_ = nullptr;
+    timer->pprev_ = nullptr;
+    --shard->level_sizes[level];
+    Insert(shard, timer);
+    timer = next;
+  }
+}
+
+int TimerQueue::NextOccupiedSlot(const Shard& shard, int slot) {
+  int word = slot / 64;
+  uint64_t bits = shard.level0_occupied[word] & (~uint64_t{0} << slot % 64);
+  // The last iteration revisits the first word for the slots before `slot`.
+  for (int i = 0; i <= kSlotWords; ++i) {
+    if (bits) return word * 64 + llvm::countTrailingZeros(bits);
+    word = (word + 1) % kSlotWords;
+    bits = shard.level0_occupied[word];
+  }
+  return -1;
+}
+
+uint64_t TimerQueue::NextEventTick(const Shard& shard) {
+  uint64_t next_tick = std::numeric_limits<uint64_t>::max();
+  if (shard.num_timers == 0) return next_tick;
+
+  // Level 0 timers expire within the next kSlots ticks, so the distance to
+  // the first non-empty slot is the distance to the next expiry.
+  if (shard.level_sizes[0] > 0) {
+    const int first = (shard.current_tick + 1) & (kSlots - 1);
+    const int slot = NextOccupiedSlot(shard, first);
+    assert(slot >= 0 && "Level 0 wheel has timers but no occupied slots");
+    next_tick = shard.current_tick + 1 + ((slot - first) & (kSlots - 1));
+  }
+
+  // Timers in the higher levels don't expire before the next cascade of the
+  // level 1 wheel.
+  if (shard.num_timers > shard.level_sizes[0]) {
+    next_tick = std::min(
+        next_tick, ((shard.current_tick >> kLevelBits) + 1) << kLevelBits);
+  }
+  return next_tick;
+}
+
+void TimerQueue::AdvanceShard(Shard* shard, uint64_t tick) {
+  llvm::SmallVector<TimerEntry*, 8> expired;
+  {
+    mutex_lock lock(shard->mu);
+    if (shard->num_timers == 0) {
+      shard->current_tick = std::max(shard->current_tick, tick);
+      return;
     }
-    while (!timers_.empty() && timers_.top()->deadline_ <= Clock::now()) {
-      const auto top_entry = timers_.top();
-      timers_.pop();
-      mu_.unlock();
-      // If timer is not cancelled, run the callback.
-      if (!top_entry->cancelled_) {
-        top_entry->timer_callback_();
+
+    while (shard->current_tick < tick) {
+      // Skip the ticks without any expiring timer or cascade.
+      uint64_t next = NextEventTick(*shard);
+      if (next > tick) {
+        shard->current_tick = tick;
+        break;
+      }
+      shard->current_tick = next - 1;
+
+      const uint64_t now = ++shard->current_tick;
+      // Cascade the timers from the higher level wheels that reached the
+      // beginning of a slot.
+      for (int level = 1; level < kLevels; ++level) {
+        if (now & ((uint64_t{1} << (kLevelBits * level)) - 1)) break;
+        Cascade(shard, level, (now >> (kLevelBits * level)) & (kSlots - 1));
+      }
+
+      TimerEntry*& head = shard->wheels[0][now & (kSlots - 1)];
+      while (TimerEntry* timer = head) {
+        Unlink(timer);
+        --shard->num_timers;
+        expired.push_back(timer);
       }
-      mu_.lock();
     }
   }
+
+  if (expired.empty()) return;
+  num_timers_.fetch_sub(expired.size(), std::memory_order_relaxed);
+  for (TimerEntry* timer : expired) {
+    // If timer is not cancelled, run the callback.
+    if (!timer->cancelled_.load(std::memory_order_acquire))
+      timer->timer_callback_();
+    timer->DropRef();
+  }
+}
+
+uint64_t TimerQueue::NextEventTick() const {
+  uint64_t next_tick = std::numeric_limits<uint64_t>::max();
+  for (auto& shard : shards_) {
+    mutex_lock lock(shard->mu);
+    next_tick = std::min(next_tick, NextEventTick(*shard));
+  }
+  return next_tick;
 }
 
-TimerQueue::TimerEntry* TimerQueue::getTopTimer() TFRT_REQUIRES(mu_) {
-  while (!timers_.empty()) {
-    if (timers_.top()->cancelled_) {
-      // Timer is cancelled, discard.
-      timers_.pop();
-    } else {
-      return timers_.top().get();
+void TimerQueue::TimerThreadRun() {
+  while (!stop_.load(std::memory_order_acquire)) {
+    // Ticks up to the current time (rounded down) have passed.
+    TimeDuration elapsed = Clock::now() - start_;
+    const uint64_t now = elapsed.count() > 0 ? elapsed / tick_ : 0;
+    for (auto& shard : shards_) AdvanceShard(shard.get(), now);
+
+    // A timer added concurrently is either seen by the second scan, or sees
+    // the published wakeup tick and wakes up the timer thread.
+    uint64_t next_tick = NextEventTick();
+    next_wakeup_tick_.store(next_tick);
+    next_tick = std::min(next_tick, NextEventTick());
+
+    mutex_lock lock(mu_);
+    while (!woken_ && !stop_.load(std::memory_order_acquire)) {
+      if (next_tick == std::numeric_limits<uint64_t>::max()) {
+        cv_.wait(lock);
+      } else {
+        TimePoint wakeup_time =
+            start_ + tick_ * static_cast<int64_t>(next_tick);
+        bool timeout = cv_.wait_until(lock, wakeup_time);
+        if (timeout) break;
+      }
     }
+    woken_ = false;
   }
-  // No active timer found. Return a nullptr.
-  return nullptr;
 }
 
 TimerQueue::TimerHandle TimerQueue::ScheduleTimerAt(TimePoint deadline,
                                                     TimerCallback callback) {
   TimerHandle th = TimerEntry::Create(deadline, std::move(callback));
-  bool notify = false;
+  th->expiry_tick_ = ToTick(deadline);
+
+  // Shard the wheels by the calling thread.
+  size_t thread_hash = std::hash<std::thread::id>()(std::this_thread::get_id());
+  Shard* shard = shards_[thread_hash % shards_.size()].get();
+  th->shard_ = shard;
+
+  uint64_t next_tick;
   {
+    mutex_lock lock(shard->mu);
+    // The wheel holds a reference to the timer.
+    th->AddRef();
+    Insert(shard, th.get());
+    ++shard->num_timers;
+    next_tick = NextEventTick(*shard);
+  }
+  num_timers_.fetch_add(1, std::memory_order_relaxed);
+
+  // Notify the timer thread if it sleeps past the new timer.
+  if (next_tick < next_wakeup_tick_.load()) {
     mutex_lock lock(mu_);
-    // Only notify timer thread when the queue is empty, or when the newly added
-    // timer's deadline is shorter.
-    notify = timers_.empty() || timers_.top()->deadline_ > deadline;
-    timers_.push(th);
+    woken_ = true;
+    cv_.notify_one();
   }
-  // Notify the timer thread that a new timer is added.
-  if (notify) cv_.notify_one();
   return th;
 }
 
@@ -103,6 +282,24 @@ void TimerQueue::CancelTimer(const TimerQueue::TimerHandle& timer_handle) {
   // callback has started execution, the CancelTimer() will block until
   // the execution finishes.
   timer_handle->cancelled_.store(true, std::memory_order_release);
+
+  // Remove the timer from the wheel, so that its callback is destroyed
+  // without waiting for the deadline.
+  Shard* shard = timer_handle->shard_;
+  if (!shard) return;
+  bool unlinked = false;
+  {
+    mutex_lock lock(shard->mu);
+    if (timer_handle->pprev_) {
+      Unlink(timer_handle.get());
+      --shard->num_timers;
+      unlinked = true;
+    }
+  }
+  if (unlinked) {
+    num_timers_.fetch_sub(1, std::memory_order_relaxed);
+    timer_handle->DropRef();
+  }
 }
 
 }  // namespace tfrt
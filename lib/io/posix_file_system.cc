@@ -20,6 +20,8 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <limits>
@@ -81,6 +83,38 @@ llvm::Expected<size_t> PosixRandomAccessFile::Read(char* buf, size_t max_count,
 
   return actual_count;
 }
+
+// This class is used to read data from a file mapped into memory.
+class PosixMemoryMappedFile : public MemoryMappedFile {
+ public:
+  explicit PosixMemoryMappedFile(void* address, size_t size,
+                                 const std::string& path)
+      : address_(address), size_(size), path_(path) {}
+
+  ~PosixMemoryMappedFile() override;
+
+  // This class is not copyable or movable.
+  PosixMemoryMappedFile(const PosixMemoryMappedFile&) = delete;
+  PosixMemoryMappedFile operator=(const PosixMemoryMappedFile&) = delete;
+
+  string_view data() const override {
+    return string_view(static_cast<const char*>(address_), size_);
+  }
+
+ private:
+  // nullptr iff the file is empty, since empty files cannot be mapped.
+  void* address_;
+  size_t size_;
+  const std::string path_;
+};
+
+PosixMemoryMappedFile::~PosixMemoryMappedFile() {
+  if (address_ == nullptr) return;
+  if (munmap(address_, size_) < 0) {
+    tfrt::errs() << "failed to unmap file " << path_
+                 << " due to error: " << strerror(errno) << "\n";
+  }
+}
 }  // namespace
 
 llvm::Error PosixFileSystem::NewRandomAccessFile(
@@ -95,6 +129,50 @@ llvm::Error PosixFileSystem::NewRandomAccessFile(
   return llvm::Error::success();
 }
 
+llvm::Error PosixFileSystem::NewMemoryMappedFile(
+    const std::string& path, RCReference<MemoryMappedFile>* file) {
+  file->reset();
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return MakeStringError("failed to open file ", path,
+                           " due to error: ", strerror(errno));
+  }
+  // The mapping keeps its own reference to the file, so the descriptor can be
+  // closed right away.
+  auto close_fd = [&] {
+    if (close(fd) < 0) {
+      tfrt::errs() << "failed to close file " << path
+                   << " due to error: " << strerror(errno) << "\n";
+    }
+  };
+
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    auto error = MakeStringError("failed to stat file ", path,
+                                 " due to error: ", strerror(errno));
+    close_fd();
+    return error;
+  }
+
+  size_t size = st.st_size;
+  void* address = nullptr;
+  if (size > 0) {
+    address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+      auto error = MakeStringError("failed to map file ", path,
+                                   " due to error: ", strerror(errno));
+      close_fd();
+      return error;
+    }
+    // Records are usually consumed front to back.
+    madvise(address, size, MADV_SEQUENTIAL);
+  }
+  close_fd();
+
+  *file = TakeRef(new PosixMemoryMappedFile(address, size, path));
+  return llvm::Error::success();
+}
+
 void RegisterFileSystem(FileSystemRegistry* registry) {
   auto file_system = std::make_unique<PosixFileSystem>();
   // The scheme is an empty string to be backward-compatible with TF.
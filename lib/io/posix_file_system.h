@@ -36,6 +36,9 @@ class PosixFileSystem : public FileSystem {
   llvm::Error NewRandomAccessFile(
       const std::string& path,
       std::unique_ptr<RandomAccessFile>* file) override;
+
+  llvm::Error NewMemoryMappedFile(const std::string& path,
+                                  RCReference<MemoryMappedFile>* file) override;
 };
 
 }  // namespace io
@@ -0,0 +1,280 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements the in-process DefaultMetricsRegistry.
+
+#include "tfrt/metrics/default_metrics_registry.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "llvm/Support/Format.h"
+#include "tfrt/support/logging.h"
+#include "tfrt/support/sharded_counter.h"
+
+namespace tfrt {
+namespace metrics {
+
+class DefaultMetricsRegistry::Metric {
+ public:
+  enum class Kind {
+    kStringGauge,
+    kIntGauge,
+    kIntGaugeCallback,
+    kCounter,
+    kHistogram
+  };
+
+  explicit Metric(Kind kind) : kind_(kind) {}
+  virtual ~Metric() {}
+
+  Kind kind() const { return kind_; }
+
+  // Writes the samples of this metric in Prometheus text format.
+  virtual void WritePrometheusText(raw_ostream& os,
+                                   const std::string& name) const = 0;
+
+ private:
+  const Kind kind_;
+};
+
+namespace {
+
+using Metric = DefaultMetricsRegistry::Metric;
+
+void WriteLabelValue(raw_ostream& os, const std::string& value) {
+  os << '"';
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      os << '\\' << c;
+    } else if (c == '\n') {
+      os << "\\n";
+    } else {
+      os << c;
+    }
+  }
+  os << '"';
+}
+
+std::string ToPrometheusName(const std::string& name) {
+  std::string result;
+  for (char c : name) {
+    if (std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == ':') {
+      result.push_back(c);
+    } else if (!result.empty()) {
+      result.push_back('_');
+    }
+  }
+  if (result.empty() || std::isdigit(static_cast<unsigned char>(result[0])))
+    result.insert(0, "_");
+  return result;
+}
+
+class StringGauge : public Metric, public Gauge<std::string> {
+ public:
+  static constexpr Kind kKind = Kind::kStringGauge;
+
+  StringGauge() : Metric(kKind) {}
+
+  void Set(std::string value) override {
+    mutex_lock lock(mu_);
+    value_ = std::move(value);
+  }
+
+  void WritePrometheusText(raw_ostream& os,
+                           const std::string& name) const override {
+    mutex_lock lock(mu_);
+    os << "# TYPE " << name << " gauge\n" << name << "{value=";
+    WriteLabelValue(os, value_);
+    os << "} 1\n";
+  }
+
+ private:
+  mutable mutex mu_;
+  std::string value_ TFRT_GUARDED_BY(mu_);
+};
+
+class IntGauge : public Metric, public Gauge<int64_t> {
+ public:
+  static constexpr Kind kKind = Kind::kIntGauge;
+
+  IntGauge() : Metric(kKind) {}
+
+  void Set(int64_t value) override {
+    value_.store(value, std::memory_order_relaxed);
+  }
+
+  void WritePrometheusText(raw_ostream& os,
+                           const std::string& name) const override {
+    os << "# TYPE " << name << " gauge\n"
+       << name << " " << value_.load(std::memory_order_relaxed) << "\n";
+  }
+
+ private:
+  std::atomic<int64_t> value_{0};
+};
+
+class IntGaugeCallback : public Metric {
+ public:
+  static constexpr Kind kKind = Kind::kIntGaugeCallback;
+
+  explicit IntGaugeCallback(std::function<int64_t()> callback)
+      : Metric(kKind), callback_(std::move(callback)) {}
+
+  void WritePrometheusText(raw_ostream& os,
+                           const std::string& name) const override {
+    os << "# TYPE " << name << " gauge\n"
+       << name << " " << callback_() << "\n";
+  }
+
+ private:
+  const std::function<int64_t()> callback_;
+};
+
+// Counters and histograms are sharded to avoid contention between threads.
+class CounterMetric : public Metric, public Counter {
+ public:
+  static constexpr Kind kKind = Kind::kCounter;
+
+  CounterMetric() : Metric(kKind) {}
+
+  void IncrementBy(int64_t value) override { value_.Add(value); }
+
+  void WritePrometheusText(raw_ostream& os,
+                           const std::string& name) const override {
+    os << "# TYPE " << name << " counter\n"
+       << name << " " << value_.Sum() << "\n";
+  }
+
+ private:
+  ShardedCounter value_;
+};
+
+class HistogramMetric : public Metric, public Histogram {
+ public:
+  static constexpr Kind kKind = Kind::kHistogram;
+
+  explicit HistogramMetric(const Buckets& buckets)
+      : Metric(kKind),
+        bounds_(buckets.explicit_bounds()),
+        counts_(new ShardedCounter[bounds_.size() + 1]) {}
+
+  void Record(double value) override {
+    // Bucket i holds the values in (bounds_[i - 1], bounds_[i]], where the
+    // first bucket has no lower bound and the last bucket has no upper bound.
+    size_t bucket = std::lower_bound(bounds_.begin(), bounds_.end(), value) -
+                    bounds_.begin();
+    counts_[bucket].Add(1);
+
+    auto& sum = sums_[ShardedCounter::ShardIndex()].value;
+    double old_sum = sum.load(std::memory_order_relaxed);
+    while (!sum.compare_exchange_weak(old_sum, old_sum + value,
+                                      std::memory_order_relaxed)) {
+    }
+  }
+
+  void WritePrometheusText(raw_ostream& os,
+                           const std::string& name) const override {
+    double sum = 0;
+    for (const auto& shard : sums_)
+      sum += shard.value.load(std::memory_order_relaxed);
+
+    // Prometheus buckets are cumulative: each one counts all the values less
+    // than or equal to its `le` bound.
+    os << "# TYPE " << name << " histogram\n";
+    int64_t cumulative_count = 0;
+    for (size_t i = 0; i < bounds_.size(); ++i) {
+      cumulative_count += counts_[i].Sum();
+      os << name << "_bucket{le=\"" << llvm::format("%g", bounds_[i]) << "\"} "
+         << cumulative_count << "\n";
+    }
+    cumulative_count += counts_[bounds_.size()].Sum();
+    os << name << "_bucket{le=\"+Inf\"} " << cumulative_count << "\n";
+    os << name << "_sum " << llvm::format("%.17g", sum) << "\n";
+    os << name << "_count " << cumulative_count << "\n";
+  }
+
+ private:
+  struct alignas(64) SumShard {
+    std::atomic<double> value{0};
+  };
+
+  const std::vector<double> bounds_;
+  std::unique_ptr<ShardedCounter[]> counts_;
+  SumShard sums_[ShardedCounter::kNumShards];
+};
+
+}  // namespace
+
+DefaultMetricsRegistry::DefaultMetricsRegistry() {}
+
+DefaultMetricsRegistry::~DefaultMetricsRegistry() {}
+
+template <typename T, typename... Args>
+T* DefaultMetricsRegistry::GetOrCreate(std::string name, Args&&... args) {
+  mutex_lock lock(mu_);
+  auto& metric = metrics_[ToPrometheusName(name)];
+  if (metric == nullptr) {
+    metric = std::make_unique<T>(std::forward<Args>(args)...);
+  } else if (metric->kind() != T::kKind) {
+    TFRT_LOG(WARNING) << "Metric '" << name
+                      << "' already exists with a different type";
+    // Return a metric of the requested type that is shared by all such
+    // lookups. It can still be recorded to, but it is not exported.
+    static T* const unexported_metric = new T(std::forward<Args>(args)...);
+    return unexported_metric;
+  }
+  return static_cast<T*>(metric.get());
+}
+
+Gauge<std::string>* DefaultMetricsRegistry::NewStringGauge(std::string name) {
+  return GetOrCreate<StringGauge>(std::move(name));
+}
+
+Gauge<int64_t>* DefaultMetricsRegistry::NewIntGauge(std::string name) {
+  return GetOrCreate<IntGauge>(std::move(name));
+}
+
+void DefaultMetricsRegistry::NewIntGaugeCallback(
+    std::string name, std::function<int64_t()> callback) {
+  GetOrCreate<IntGaugeCallback>(std::move(name), std::move(callback));
+}
+
+Counter* DefaultMetricsRegistry::NewCounter(std::string name) {
+  return GetOrCreate<CounterMetric>(std::move(name));
+}
+
+Histogram* DefaultMetricsRegistry::NewHistogram(std::string name,
+                                                const Buckets& buckets) {
+  return GetOrCreate<HistogramMetric>(std::move(name), buckets);
+}
+
+void DefaultMetricsRegistry::WritePrometheusText(raw_ostream& os) const {
+  mutex_lock lock(mu_);
+  for (const auto& it : metrics_) it.second->WritePrometheusText(os, it.first);
+  os.flush();
+}
+
+DefaultMetricsRegistry* RegisterDefaultMetricsRegistry() {
+  auto* registry = new DefaultMetricsRegistry;
+  RegisterMetricsRegistry(registry);
+  return registry;
+}
+
+}  // namespace metrics
+}  // namespace tfrt
@@ -38,14 +38,16 @@ namespace tfrt {
 // larger than or equals to EIGEN_DEFAULT_ALIGN_BYTES (16).
 static constexpr size_t kTensorBufferAlignment = 16;
 
+size_t DenseHostTensor::GetBufferAlignment(DType dtype) {
+  return std::max(GetHostAlignment(dtype), kTensorBufferAlignment);
+}
+
 llvm::Optional<DenseHostTensor> DenseHostTensor::CreateUninitialized(
     const TensorMetadata& metadata, HostAllocator* allocator) {
-  size_t alignment =
-      std::max(GetHostAlignment(metadata.dtype), kTensorBufferAlignment);
   auto& shape = metadata.shape;
   auto data = HostBuffer::CreateUninitialized(
-      GetHostSize(metadata.dtype) * shape.GetNumElements(), alignment,
-      allocator);
+      GetHostSize(metadata.dtype) * shape.GetNumElements(),
+      GetBufferAlignment(metadata.dtype), allocator);
   if (!data) return llvm::None;
   return DenseHostTensor(metadata, std::move(data));
 }
@@ -45,6 +45,29 @@ static Expected<DenseHostTensor> CreateUninitializedDenseTensor(
   return std::move(*result);
 }
 
+// Allocates an uninitialized DenseHostTensor for a result of a synchronous
+// kernel. The body is placed according to the memory plan of the kernel caller
+// if it has one.
+static llvm::Optional<DenseHostTensor> SyncCreateUninitialized(
+    const TensorMetadata& metadata, const SyncKernelFrame& frame) {
+  auto data = frame.AllocateBuffer(
+      GetHostSize(metadata.dtype) * metadata.shape.GetNumElements(),
+      DenseHostTensor::GetBufferAlignment(metadata.dtype));
+  if (!data) return llvm::None;
+  return DenseHostTensor(metadata, std::move(data));
+}
+
+template <typename T, size_t Rank>
+static Expected<DenseHostTensor> SyncCreateUninitializedDenseTensor(
+    ArrayAttribute<Index> shape_in, SyncKernelFrame* frame) {
+  auto result = SyncCreateUninitialized(
+      TensorMetadata(GetDType<T>(), TensorShape(shape_in.data())), *frame);
+  if (!result.hasValue()) {
+    return MakeStringError("Cannot allocate tensor");
+  }
+  return std::move(*result);
+}
+
 template <typename T>
 static void MakeTensor(Argument<RCReference<HostBuffer>> buffer,
                        Argument<TensorShape> shape, Argument<Chain> in_chain,
@@ -80,11 +103,11 @@ static Expected<DenseHostTensor> SyncMakeTensor(
 }
 
 template <typename T>
-static Expected<DenseHostTensor> CreateDenseTensor(
-    ArrayAttribute<Index> shape, ArrayAttribute<T> values,
-    const ExecutionContext& exec_ctx) {
-  auto result = DenseHostTensor::CreateUninitialized<T>(
-      TensorShape(shape.data()), exec_ctx.host());
+static Expected<DenseHostTensor> CreateDenseTensor(ArrayAttribute<Index> shape,
+                                                   ArrayAttribute<T> values,
+                                                   SyncKernelFrame* frame) {
+  auto result = SyncCreateUninitialized(
+      TensorMetadata(GetDType<T>(), TensorShape(shape.data())), *frame);
   if (!result.hasValue()) {
     return MakeStringError("Cannot allocate tensor");
   }
@@ -170,9 +193,8 @@ static llvm::Expected<RCReference<HostBuffer>> AllocateBuffer(
 // Constructs a `HostBuffer` based on the given size (in bytes) and alignment.
 static llvm::Expected<RCReference<HostBuffer>> SyncAllocateBuffer(
     int64_t size, int64_t alignment, SyncKernelFrame* frame) {
-  auto data = HostBuffer::CreateUninitialized(
-      static_cast<size_t>(size), static_cast<size_t>(alignment),
-      frame->GetHostContext()->allocator());
+  auto data = frame->AllocateBuffer(static_cast<size_t>(size),
+                                    static_cast<size_t>(alignment));
   if (!data) return MakeStringError("Cannot allocate host buffer");
   return std::move(data);
 }
@@ -250,7 +272,7 @@ static void RegisterDhtCreationKernelsForTypeAndRank(
                       TFRT_KERNEL(CreateUninitializedDenseTensor<T, Rank>));
   registry->AddSyncKernel(
       "tfrt_dht_sync.create_uninitialized_tensor." + suffix,
-      TFRT_SYNC_KERNEL(CreateUninitializedDenseTensor<T, Rank>));
+      TFRT_SYNC_KERNEL(SyncCreateUninitializedDenseTensor<T, Rank>));
 }
 
 template <typename T>
@@ -0,0 +1,228 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//===- chrome_tracing_sink.cc - Chrome trace event Tracing Sink -----------===//
+//
+// This file implements a tracing sink which records activities into per-thread
+// ring buffers and serializes them as Chrome trace event JSON.
+
+#include "tfrt/tracing/chrome_tracing_sink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/logging.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/seqlock_ring_buffer.h"
+#include "tfrt/support/thread_annotations.h"
+#include "tfrt/tracing/tracing.h"
+
+namespace tfrt {
+namespace tracing {
+
+namespace {
+
+const auto kProcessStart = std::chrono::steady_clock::now();
+
+// Activity names are truncated so that events have a fixed size and recording
+// does not allocate.
+constexpr size_t kMaxNameSize = 111;
+
+// The number of events kept per thread (about 4MB).
+constexpr size_t kEventsPerThread = 1 << 15;
+
+// One recorded activity.
+struct TraceEvent {
+  int64_t timestamp_ns;
+  // 'B' (begin scope), 'E' (end scope) or 'i' (instant event).
+  char phase;
+  char name[kMaxNameSize + 1];
+};
+static_assert(sizeof(TraceEvent) == 128, "Unexpected TraceEvent size");
+
+// Buffer of the activities of one thread.
+class ThreadBuffer {
+ public:
+  explicit ThreadBuffer(int thread_id)
+      : thread_id_(thread_id), events_(kEventsPerThread) {}
+
+  int thread_id() const { return thread_id_; }
+
+  void Append(char phase, string_view name) {
+    TraceEvent event;
+    event.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - kProcessStart)
+                             .count();
+    event.phase = phase;
+    size_t size = std::min<size_t>(name.size(), kMaxNameSize);
+    std::memcpy(event.name, name.data(), size);
+    event.name[size] = '\0';
+    events_.Append(event);
+  }
+
+  // Appends the events that are currently in the buffer to `events`.
+  void Collect(std::vector<TraceEvent>* events) const {
+    events_.Collect(events);
+  }
+
+  void Clear() { events_.Clear(); }
+
+ private:
+  const int thread_id_;
+  SeqlockRingBuffer<TraceEvent> events_;
+};
+
+// Owns the buffers of all threads that recorded an activity. Buffers are kept
+// after their thread exits so that its activities can still be serialized.
+class ThreadBufferRegistry {
+ public:
+  ThreadBuffer* GetThreadBuffer() {
+    static thread_local ThreadBuffer* thread_buffer = [this] {
+      mutex_lock lock(mu_);
+      int thread_id = buffers_.size() + 1;
+      buffers_.push_back(std::make_unique<ThreadBuffer>(thread_id));
+      return buffers_.back().get();
+    }();
+    return thread_buffer;
+  }
+
+  template <typename F>
+  void ForEach(F&& f) {
+    mutex_lock lock(mu_);
+    for (const auto& buffer : buffers_) f(*buffer);
+  }
+
+ private:
+  mutex mu_;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_ TFRT_GUARDED_BY(mu_);
+};
+
+ThreadBufferRegistry& GetThreadBufferRegistry() {
+  static auto* registry = new ThreadBufferRegistry;
+  return *registry;
+}
+
+void WriteJsonString(raw_ostream& os, const char* str) {
+  os << '"';
+  for (; *str; ++str) {
+    char c = *str;
+    if (c == '"' || c == '\\') {
+      os << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      os << llvm::format("\\u%04x", c);
+    } else {
+      os << c;
+    }
+  }
+  os << '"';
+}
+
+class ChromeTracingSink : public TracingSink {
+ public:
+  Error RequestTracing(bool enable) override {
+    if (enable) return Error::success();
+    if (const char* path = std::getenv("TFRT_CHROME_TRACE_FILE"))
+      return WriteChromeTraceToFile(path);
+    return Error::success();
+  }
+
+  void RecordTracingEvent(NameGenerator gen_name) override {
+    GetThreadBufferRegistry().GetThreadBuffer()->Append('i', gen_name());
+  }
+
+  void PushTracingScope(NameGenerator gen_name) override {
+    GetThreadBufferRegistry().GetThreadBuffer()->Append('B', gen_name());
+  }
+
+  void PopTracingScope() override {
+    GetThreadBufferRegistry().GetThreadBuffer()->Append('E', {});
+  }
+};
+
+}  // namespace
+
+void WriteChromeTrace(raw_ostream& os) {
+  os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  auto separator = [&]() -> raw_ostream& {
+    if (!first) os << ",";
+    first = false;
+    return os << "\n";
+  };
+
+  std::vector<TraceEvent> events;
+  GetThreadBufferRegistry().ForEach([&](const ThreadBuffer& buffer) {
+    events.clear();
+    buffer.Collect(&events);
+    if (events.empty()) return;
+
+    int tid = buffer.thread_id();
+    separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"
+                << tid << ",\"args\":{\"name\":\"Thread " << tid << "\"}}";
+
+    // Skip the ends of scopes whose beginning has been overwritten.
+    int depth = 0;
+    for (const auto& event : events) {
+      if (event.phase == 'E') {
+        if (depth == 0) continue;
+        --depth;
+      } else if (event.phase == 'B') {
+        ++depth;
+      }
+      separator() << "{\"ph\":\"" << event.phase << "\",\"ts\":"
+                  << llvm::format("%.3f", event.timestamp_ns / 1000.0)
+                  << ",\"pid\":0,\"tid\":" << tid;
+      if (event.phase != 'E') {
+        os << ",\"name\":";
+        WriteJsonString(os, event.name);
+      }
+      if (event.phase == 'i') os << ",\"s\":\"t\"";
+      os << "}";
+    }
+  });
+  os << "\n]}\n";
+  os.flush();
+}
+
+Error WriteChromeTraceToFile(string_view path) {
+  std::error_code error_code;
+  llvm::raw_fd_ostream os(path, error_code, llvm::sys::fs::OF_None);
+  if (error_code) {
+    return MakeStringError("Failed to open '", path,
+                           "': ", error_code.message());
+  }
+  WriteChromeTrace(os);
+  return Error::success();
+}
+
+void ClearChromeTrace() {
+  GetThreadBufferRegistry().ForEach(
+      [](ThreadBuffer& buffer) { buffer.Clear(); });
+}
+
+static const bool kRegisterTracingSink = [] {
+  RegisterTracingSink(new ChromeTracingSink);
+  return true;
+}();
+
+}  // namespace tracing
+}  // namespace tfrt
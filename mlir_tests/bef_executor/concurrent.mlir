@@ -12,10 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-// Test both serial and concurrent workqueues: all tests should be determinstic.
+// Test both serial and concurrent workqueues, and work-stealing kernel
+// scheduling: all tests should be determinstic.
 
 // RUN: bef_executor_lite %s.bef | FileCheck %s
 // RUN: bef_executor_lite -work_queue_type=mstd %s.bef | FileCheck %s
+// RUN: bef_executor_lite -work_queue_type=mstd -kernel_scheduling=work_stealing %s.bef | FileCheck %s
 
 // Asynchronously increment %counter once.
 // CHECK-LABEL: async_incs
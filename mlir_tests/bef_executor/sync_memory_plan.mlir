@@ -0,0 +1,49 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: bef_executor_lite --print_memory_plan %s.bef 2>&1 | FileCheck %s
+
+// The functions are run twice, the second time with the planned buffers.
+
+// CHECK-LABEL: --- Running 'disjoint_tensors'
+func @disjoint_tensors() attributes {tfrt.sync} {
+  %a = tfrt_dht_sync.create_uninitialized_tensor.i32.2 [2 : i64, 2 : i64]
+  tfrt_dht_sync.set_tensor_with_constant_values.i32 %a
+    [1 : i32, 2 : i32, 3 : i32, 4 : i32]
+  // CHECK: shape = [2, 2], values = [1, 2, 3, 4]
+  tfrt_dht_sync.print_tensor %a
+
+  // %b is allocated after %a is released and reuses its offset.
+  %b = tfrt_dht_sync.create_uninitialized_tensor.i32.2 [2 : i64, 2 : i64]
+  tfrt_dht_sync.set_tensor_with_constant_values.i32 %b
+    [5 : i32, 6 : i32, 7 : i32, 8 : i32]
+  // CHECK: shape = [2, 2], values = [5, 6, 7, 8]
+  tfrt_dht_sync.print_tensor %b
+
+  tfrt.return
+}
+// CHECK: --- Rerunning 'disjoint_tensors' with its memory plan
+// CHECK-NEXT: shape = [2, 2], values = [1, 2, 3, 4]
+// CHECK-NEXT: shape = [2, 2], values = [5, 6, 7, 8]
+// CHECK-NEXT: 'disjoint_tensors' memory plan: 2 of 2 buffers planned, total 32 bytes, peak 16 bytes, planned 16 bytes
+
+// CHECK-LABEL: --- Running 'no_tensors'
+func @no_tensors() -> i32 attributes {tfrt.sync} {
+  %x = "tfrt.constant_s.i32"() {value = 42 : i32} : () -> i32
+  // CHECK: 'no_tensors' returned 42
+  tfrt.return %x : i32
+}
+// CHECK: --- Rerunning 'no_tensors' with its memory plan
+// CHECK-NEXT: 'no_tensors' returned 42
+// CHECK-NEXT: 'no_tensors' memory plan: 0 of 0 buffers planned, total 0 bytes, peak 0 bytes, planned 0 bytes
@@ -0,0 +1,25 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: tfrt_translate -mlir-to-bef --fuse-cwise-ops %s | tfrt_translate --bef-to-mlir | FileCheck %s
+
+// CHECK-LABEL: func @fuse_chain
+func @fuse_chain(%cpu: !corert.ophandler, %x: !corert.tensorhandle, %y: !corert.tensorhandle) -> !corert.tensorhandle {
+  // CHECK-NOT: "tf.AddV2"
+  // CHECK: "tf._FusedCwise"
+  // CHECK-NOT: "tf.Relu"
+  %0 = corert.executeop(%cpu) "tf.AddV2"(%x, %y) {T = f32} : 1
+  %1 = corert.executeop(%cpu) "tf.Relu"(%0) {T = f32} : 1
+  tfrt.return %1 : !corert.tensorhandle
+}
@@ -0,0 +1,60 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: tfrt_opt -tfrt-fuse-cwise-ops %s | FileCheck %s -dump-input=fail
+
+// CHECK-LABEL: @fuse_chain
+// CHECK-SAME: ([[cpu:%.*]]: !corert.ophandler, [[x:%.*]]: !corert.tensorhandle, [[y:%.*]]: !corert.tensorhandle, [[bias:%.*]]: !corert.tensorhandle)
+func @fuse_chain(%cpu: !corert.ophandler, %x: !corert.tensorhandle, %y: !corert.tensorhandle, %bias: !corert.tensorhandle) -> !corert.tensorhandle {
+  // CHECK-NEXT: [[result:%.*]] = corert.executeop([[cpu]]) "tf._FusedCwise"([[x]], [[y]], [[bias]], [[y]]) {T = f32, fused_ops = ["AddV2", "BiasAdd", "Relu", "Mul"]} : 1
+  // CHECK-NEXT: tfrt.return [[result]]
+  %0 = corert.executeop(%cpu) "tf.AddV2"(%x, %y) {T = f32} : 1
+  %1 = corert.executeop(%cpu) "tf.BiasAdd"(%0, %bias) {T = f32, data_format = "NHWC"} : 1
+  %2 = corert.executeop(%cpu) "tf.Relu"(%1) {T = f32} : 1
+  %3 = corert.executeop(%cpu) "tf.Mul"(%y, %2) {T = f32} : 1
+  tfrt.return %3 : !corert.tensorhandle
+}
+
+// CHECK-LABEL: @intermediate_result_used
+func @intermediate_result_used(%cpu: !corert.ophandler, %x: !corert.tensorhandle, %y: !corert.tensorhandle) -> (!corert.tensorhandle, !corert.tensorhandle) {
+  // CHECK-NEXT: [[sum:%.*]] = corert.executeop({{.*}}) "tf.AddV2"
+  // CHECK-NEXT: [[result:%.*]] = corert.executeop({{.*}}) "tf._FusedCwise"([[sum]]) {T = f32, fused_ops = ["Relu", "Log"]} : 1
+  // CHECK-NEXT: tfrt.return [[sum]], [[result]]
+  %0 = corert.executeop(%cpu) "tf.AddV2"(%x, %y) {T = f32} : 1
+  %1 = corert.executeop(%cpu) "tf.Relu"(%0) {T = f32} : 1
+  %2 = corert.executeop(%cpu) "tf.Log"(%1) {T = f32} : 1
+  tfrt.return %0, %2 : !corert.tensorhandle, !corert.tensorhandle
+}
+
+// CHECK-LABEL: @not_fusible
+func @not_fusible(%cpu: !corert.ophandler, %x: !corert.tensorhandle, %y: !corert.tensorhandle) -> !corert.tensorhandle {
+  // Non commutative ops must use the chain value as the left operand.
+  // CHECK-NEXT: "tf.Sub"
+  // CHECK-NEXT: "tf.Sub"
+  %0 = corert.executeop(%cpu) "tf.Sub"(%x, %y) {T = f32} : 1
+  %1 = corert.executeop(%cpu) "tf.Sub"(%y, %0) {T = f32} : 1
+
+  // Integer types are not supported by tf._FusedCwise.
+  // CHECK-NEXT: "tf.AddV2"
+  // CHECK-NEXT: "tf.Relu"
+  %2 = corert.executeop(%cpu) "tf.AddV2"(%1, %y) {T = i32} : 1
+  %3 = corert.executeop(%cpu) "tf.Relu"(%2) {T = i32} : 1
+
+  // Ops without a dtype are not fused.
+  // CHECK-NEXT: "tf.Relu"
+  // CHECK-NEXT: "tf.Log"
+  %4 = corert.executeop(%cpu) "tf.Relu"(%3) : 1
+  %5 = corert.executeop(%cpu) "tf.Log"(%4) : 1
+  tfrt.return %5 : !corert.tensorhandle
+}
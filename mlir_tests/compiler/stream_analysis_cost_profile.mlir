@@ -0,0 +1,39 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A kernel cost profile as written by bef_executor --kernel_cost_profile.
+// RUN: echo "# <mean_ns> <count> <location>" > %t.profile
+// RUN: echo "2000 4 %s:30:3" >> %t.profile
+// RUN: echo "3100 4 %s:32:3" >> %t.profile
+// RUN: echo "2900 4 %s:34:3" >> %t.profile
+// RUN: tfrt_opt -tfrt-apply-cost-profile="profile=%t.profile" -tfrt-print-stream -verify-diagnostics %s
+
+module attributes {tfrt.cost_threshold = 10 : i64} {
+
+// Without a profile, each constant costs the threshold and is assigned to its
+// own stream (see @no_merge in stream_analysis.mlir). The measured costs are
+// only 2, 3 and 3 us, so all the constants are merged into a single stream.
+// expected-remark@+1 {{stream id: 2, stream cost: 10, parent stream: -1}}
+func @profiled() -> (i32, i32, i32) {
+  // expected-remark@+1 {{stream id: 2, stream cost: 10, parent stream: -1}}
+  %0 = tfrt.constant.i32 0
+  // expected-remark@+1 {{stream id: 2, stream cost: 10, parent stream: -1}}
+  %1 = tfrt.constant.i32 1
+  // expected-remark@+1 {{stream id: 2, stream cost: 10, parent stream: -1}}
+  %2 = tfrt.constant.i32 2
+  // expected-remark@+1 {{stream id: 2, stream cost: 10, parent stream: -1}}
+  tfrt.return %0, %1, %2 : i32, i32, i32
+}
+
+}
@@ -82,3 +82,36 @@ func @BM_corert.matmul_sync() attributes {tfrt.sync} {
 
   tfrt.return
 }
+
+// Executes the same op with the same attributes and argument shapes, so that
+// after the first iteration the op and its result metadata are served from the
+// op dispatch and metadata caches.
+// CHECK-LABEL: --- Running 'BM_corert.argmax_dispatch'
+func @BM_corert.argmax_dispatch() {
+  // CHECK: BM:BM_corert.argmax_dispatch:Duration(ns):
+  // CHECK: BM:BM_corert.argmax_dispatch:Count: 10000
+  // CHECK: BM:BM_corert.argmax_dispatch:Time Min(ns):
+  // CHECK: BM:BM_corert.argmax_dispatch:Time 50%(ns):
+  // CHECK: BM:BM_corert.argmax_dispatch:Time 95%(ns):
+  // CHECK: BM:BM_corert.argmax_dispatch:Time 99%(ns):
+  // CHECK: BM:BM_corert.argmax_dispatch:CPU Min(ns):
+  // CHECK: BM:BM_corert.argmax_dispatch:CPU 50%(ns):
+  // CHECK: BM:BM_corert.argmax_dispatch:CPU 95%(ns):
+  // CHECK: BM:BM_corert.argmax_dispatch:CPU 99%(ns):
+  // CHECK: BM:BM_corert.argmax_dispatch:CPU utilization(percent):
+
+  // Prepare input.
+  %ch0 = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch0 "cpu"
+  %a_handle = corert.executeop(%cpu)
+    "tfrt_test.create_dense_tensor"() { shape = [1, 2], values = [1.0 : f32, 2.0 : f32] } : 1
+
+  tfrt_test.benchmark "BM_corert.argmax_dispatch"(%cpu : !corert.ophandler, %a_handle : !corert.tensorhandle, %ch0 : !tfrt.chain) duration_secs = 1, max_count = 10000
+  {
+    %result = corert.executeop(%cpu) "tfrt_test.argmax"(%a_handle)
+      { axis = 1 : i32 } : 1
+    tfrt.return %result : !corert.tensorhandle
+  }
+
+  tfrt.return
+}
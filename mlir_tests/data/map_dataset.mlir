@@ -0,0 +1,113 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: bef_executor %s.bef | FileCheck %s
+// RUN: bef_executor -work_queue_type=mstd %s.bef | FileCheck %s
+
+func @times_two(%x: i32) -> i32 {
+  %two = tfrt.constant.i32 2
+  %y = tfrt.mul.i32 %x, %two
+  tfrt.return %y : i32
+}
+
+func @add(%x: i32, %sum: i32) -> i32 {
+  %y = tfrt.add.i32 %x, %sum
+  tfrt.return %y : i32
+}
+
+// Prints the first two elements of the dataset, then the sum of the rest.
+func @print_dataset(%dataset: !tfrt_data.dataset) {
+  %ch0 = tfrt.new.chain
+  %iterator = tfrt_data.make_iterator %dataset
+  %ch1, %v0 = "tfrt_data.iterator_get_next"(%iterator, %ch0)
+    : (!tfrt_data.iterator, !tfrt.chain) -> (!tfrt.chain, i32)
+  %ch2 = tfrt.print.i32 %v0, %ch1
+  %ch3, %v1 = "tfrt_data.iterator_get_next"(%iterator, %ch2)
+    : (!tfrt_data.iterator, !tfrt.chain) -> (!tfrt.chain, i32)
+  %ch4 = tfrt.print.i32 %v1, %ch3
+  %zero = tfrt.constant.i32 0
+  %sum = tfrt_data.enumerate.iterator %iterator, %zero { function = @add } : i32
+  %ch5 = tfrt.print.i32 %sum, %ch4
+  tfrt.return
+}
+
+// CHECK-LABEL: --- Running 'map_dataset_default_attributes'
+func @map_dataset_default_attributes() {
+  %start = tfrt.constant.i64 0
+  %stop = tfrt.constant.i64 16
+  %step = tfrt.constant.i64 1
+  %dataset_1 = tfrt_data.range_dataset %start, %stop, %step { element_type = i32 }
+  %dataset_2 = tfrt_data.map_dataset %dataset_1 { function = @times_two }
+  tfrt.call @print_dataset(%dataset_2) : (!tfrt_data.dataset) -> ()
+
+  // CHECK-NEXT: int32 = 0
+  // CHECK-NEXT: int32 = 2
+  // CHECK-NEXT: int32 = 238
+  tfrt.return
+}
+
+// CHECK-LABEL: --- Running 'map_dataset_num_parallel_calls'
+func @map_dataset_num_parallel_calls() {
+  %start = tfrt.constant.i64 0
+  %stop = tfrt.constant.i64 16
+  %step = tfrt.constant.i64 1
+  %dataset_1 = tfrt_data.range_dataset %start, %stop, %step { element_type = i32 }
+  %dataset_2 = tfrt_data.map_dataset %dataset_1 {
+    function = @times_two, num_parallel_calls = 4 : i64
+  }
+  tfrt.call @print_dataset(%dataset_2) : (!tfrt_data.dataset) -> ()
+
+  // CHECK-NEXT: int32 = 0
+  // CHECK-NEXT: int32 = 2
+  // CHECK-NEXT: int32 = 238
+  tfrt.return
+}
+
+// CHECK-LABEL: --- Running 'map_dataset_autotune_deterministic'
+func @map_dataset_autotune_deterministic() {
+  %start = tfrt.constant.i64 0
+  %stop = tfrt.constant.i64 16
+  %step = tfrt.constant.i64 1
+  %dataset_1 = tfrt_data.range_dataset %start, %stop, %step { element_type = i32 }
+  %dataset_2 = tfrt_data.map_dataset %dataset_1 {
+    function = @times_two, is_deterministic = true,
+    num_parallel_calls = -1 : i64
+  }
+  tfrt.call @print_dataset(%dataset_2) : (!tfrt_data.dataset) -> ()
+
+  // CHECK-NEXT: int32 = 0
+  // CHECK-NEXT: int32 = 2
+  // CHECK-NEXT: int32 = 238
+  tfrt.return
+}
+
+// CHECK-LABEL: --- Running 'map_dataset_non_deterministic'
+func @map_dataset_non_deterministic() {
+  %start = tfrt.constant.i64 0
+  %stop = tfrt.constant.i64 16
+  %step = tfrt.constant.i64 1
+  %dataset_1 = tfrt_data.range_dataset %start, %stop, %step { element_type = i32 }
+  %dataset_2 = tfrt_data.map_dataset %dataset_1 {
+    function = @times_two, is_deterministic = false,
+    num_parallel_calls = 4 : i64
+  }
+  %iterator = tfrt_data.make_iterator %dataset_2
+  %zero = tfrt.constant.i32 0
+  %sum = tfrt_data.enumerate.iterator %iterator, %zero { function = @add } : i32
+  %ch0 = tfrt.new.chain
+  %ch1 = tfrt.print.i32 %sum, %ch0
+
+  // CHECK-NEXT: int32 = 240
+  tfrt.return
+}
@@ -0,0 +1,29 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: tfrt_opt %s -split-input-file --verify-diagnostics
+
+func @times_two(%x: i32) -> i32 {
+  %two = tfrt.constant.i32 2
+  %y = tfrt.mul.i32 %x, %two
+  tfrt.return %y : i32
+}
+
+func @is_deterministic_without_num_parallel_calls(%dataset: !tfrt_data.dataset) {
+  // expected-error @+1 {{'tfrt_data.map_dataset' op requires num_parallel_calls when is_deterministic is set}}
+  %mapped = tfrt_data.map_dataset %dataset {
+    function = @times_two, is_deterministic = false
+  }
+  tfrt.return
+}
@@ -10,8 +10,10 @@
 #include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/host_context/concurrent_work_queue.h"
 #include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/execution_context.h"
 #include "tfrt/host_context/host_allocator.h"
 #include "tfrt/host_context/host_context.h"
+#include "tfrt/support/latch.h"
 
 namespace tfrt {
 namespace {
@@ -50,5 +52,58 @@ TEST(MultiThreadedWorkQueueTest, PingPong) {
   ASSERT_EQ(last_executed_task, num_tasks - 1);
 }
 
+TEST(MultiThreadedWorkQueueTest, WorkerThreadIndex) {
+  auto host = CreateTestHostContext(4);
+  EXPECT_EQ(host->GetWorkerThreadIndex(), -1);
+
+  // Wait with a latch rather than Quiesce(), which can run the tasks in the
+  // caller thread.
+  std::atomic<int> worker_index{-2};
+  std::atomic<int> blocking_index{-2};
+  latch done(2);
+  EnqueueWork(host.get(), [&]() {
+    worker_index = host->GetWorkerThreadIndex();
+    done.count_down();
+  });
+  ASSERT_TRUE(EnqueueBlockingWork(host.get(), [&]() {
+    blocking_index = host->GetWorkerThreadIndex();
+    done.count_down();
+  }));
+  done.wait();
+
+  EXPECT_GE(worker_index, 0);
+  EXPECT_LT(worker_index, 4);
+  EXPECT_EQ(blocking_index, -1);
+}
+
+TEST(MultiThreadedWorkQueueTest, NumaAwareWithNodePreference) {
+  auto work_queue = CreateWorkQueue("mstd_numa:4,4,2");
+  ASSERT_NE(work_queue, nullptr);
+  auto host = std::make_unique<HostContext>(
+      [](const DecodedDiagnostic&) {}, CreateMallocAllocator(),
+      std::move(work_queue));
+
+  RequestOptions request_options;
+  request_options.numa_node = 1;
+  auto req_ctx = RequestContextBuilder(host.get(), /*resource_context=*/nullptr)
+                     .set_request_options(request_options)
+                     .build();
+  ASSERT_TRUE(static_cast<bool>(req_ctx));
+  ExecutionContext exec_ctx(std::move(*req_ctx));
+
+  std::atomic<int> num_executed{0};
+  for (int i = 0; i < 1000; ++i)
+    EnqueueWork(exec_ctx, [&] { num_executed++; });
+  host->Quiesce();
+  ASSERT_EQ(num_executed, 1000);
+}
+
+TEST(MultiThreadedWorkQueueTest, NumaAwareInvalidConfig) {
+  EXPECT_EQ(CreateWorkQueue("mstd_numa:4"), nullptr);
+  EXPECT_EQ(CreateWorkQueue("mstd_numa:4,4,-1"), nullptr);
+  EXPECT_EQ(CreateWorkQueue("mstd_numa:4,4,0,core"), nullptr);
+  EXPECT_NE(CreateWorkQueue("mstd_numa:4,4,0,node"), nullptr);
+}
+
 }  // namespace
 }  // namespace tfrt
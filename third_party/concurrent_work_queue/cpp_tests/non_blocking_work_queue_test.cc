@@ -6,7 +6,17 @@
 
 #include "non_blocking_work_queue.h"
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#endif
+
 #include "benchmark/benchmark.h"
+#include "gtest/gtest.h"
 #include "tfrt/host_context/task_function.h"
 #include "tfrt/support/latch.h"
 #include "tfrt/support/thread_environment.h"
@@ -78,5 +88,223 @@ BM_NoOp(8, 8);
 BM_NoOp(16, 16);
 BM_NoOp(32, 32);
 
+TEST(NonBlockingWorkQueueTest, AddTaskToGroup) {
+  internal::QuiescingState qstate;
+  internal::ThreadGroups groups;
+  groups.num_groups = 2;
+  WorkQueue queue(&qstate, 4, groups);
+  ASSERT_EQ(queue.num_groups(), 2);
+
+  ::tfrt::latch latch(100);
+  for (int i = 0; i < 100; ++i) {
+    queue.AddTask(TaskFunction([&] { latch.count_down(); }), i % 2);
+  }
+  latch.wait();
+}
+
+#if defined(__linux__)
+// Returns the CPUs that the caller thread is allowed to run on.
+std::vector<int> GetAllowedCpus() {
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  std::vector<int> cpus;
+  if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0)
+    return cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    if (CPU_ISSET(cpu, &cpu_set)) cpus.push_back(cpu);
+  return cpus;
+}
+
+TEST(NonBlockingWorkQueueTest, PinThreadsToSingleCpu) {
+  std::vector<int> cpus = GetAllowedCpus();
+  if (cpus.size() < 2) GTEST_SKIP() << "Requires at least two CPUs";
+  cpus.resize(2);
+
+  for (bool pin_to_single_cpu : {true, false}) {
+    internal::QuiescingState qstate;
+    internal::ThreadGroups groups;
+    groups.cpus = {cpus};
+    groups.pin_to_single_cpu = pin_to_single_cpu;
+    WorkQueue queue(&qstate, 4, groups);
+
+    // Every worker thread eventually runs one of the tasks, which block until
+    // all of them observed the affinity of their thread.
+    ::tfrt::latch latch(4);
+    std::atomic<int> num_pinned_to_one{0};
+    for (int i = 0; i < 4; ++i) {
+      queue.AddTask(TaskFunction([&] {
+        if (GetAllowedCpus().size() == 1) ++num_pinned_to_one;
+        latch.count_down();
+        latch.wait();
+      }));
+    }
+    latch.wait();
+    EXPECT_EQ(num_pinned_to_one, pin_to_single_cpu ? 4 : 0);
+  }
+}
+#endif
+
+TEST(NonBlockingWorkQueueTest, AddTasks) {
+  internal::QuiescingState qstate;
+  WorkQueue queue(&qstate, 4);
+
+  ::tfrt::latch latch(100);
+  std::vector<TaskFunction> tasks;
+  for (int i = 0; i < 100; ++i)
+    tasks.emplace_back([&] { latch.count_down(); });
+  queue.AddTasks(tasks);
+  latch.wait();
+
+  // Idle worker threads eventually park, and the spin count stays in bounds.
+  while (queue.GetSchedulingStats().num_parks == 0) std::this_thread::yield();
+  EXPECT_GT(queue.spin_count(), 0);
+}
+
+// Benchmark a single producer submitting 100k tasks, which overflows the
+// fixed-size task queues of the worker threads. If `from_worker` is true the
+// producer is a worker thread of the queue (tasks are pushed into its own
+// queue), otherwise it's a free-standing thread.
+void Submit100k(benchmark::State& state, int num_threads, bool from_worker) {
+  const int num_tasks = 100000;
+
+  auto qstate = std::make_unique<internal::QuiescingState>();
+  WorkQueue queue(qstate.get(), num_threads);
+
+  for (auto _ : state) {
+    ::tfrt::latch latch(num_tasks);
+    auto submit = [&] {
+      for (int i = 0; i < num_tasks; ++i)
+        queue.AddTask(TaskFunction([&] { latch.count_down(); }));
+    };
+    if (from_worker) {
+      queue.AddTask(TaskFunction(submit));
+    } else {
+      submit();
+    }
+    latch.wait();
+  }
+
+  state.SetItemsProcessed(num_tasks * state.iterations());
+}
+
+#define BM_Submit100k(num_threads, from_worker)                          \
+  static void BM_Submit100k_##num_threads##_threads_##from_worker(       \
+      benchmark::State& state) {                                         \
+    Submit100k(state, num_threads, from_worker);                         \
+  }                                                                      \
+  BENCHMARK(BM_Submit100k_##num_threads##_threads_##from_worker)         \
+      ->UseRealTime()
+
+BM_Submit100k(4, false);
+BM_Submit100k(4, true);
+BM_Submit100k(16, false);
+BM_Submit100k(16, true);
+
+// Benchmark bursts of tasks submitted from a free-standing thread into a work
+// queue with parked worker threads, one by one or as a single batch, and report
+// the worker threads parking decisions.
+void Burst(benchmark::State& state, int num_threads, bool batch) {
+  const int num_tasks = state.range(0);
+
+  auto qstate = std::make_unique<internal::QuiescingState>();
+  WorkQueue queue(qstate.get(), num_threads);
+  std::vector<TaskFunction> tasks(num_tasks);
+
+  for (auto _ : state) {
+    ::tfrt::latch latch(num_tasks);
+    for (auto& task : tasks) task = [&] { latch.count_down(); };
+    if (batch) {
+      queue.AddTasks(tasks);
+    } else {
+      for (auto& task : tasks) queue.AddTask(std::move(task));
+    }
+    latch.wait();
+
+    // Let the worker threads park before the next burst.
+    state.PauseTiming();
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    state.ResumeTiming();
+  }
+
+  internal::SchedulingStats stats = queue.GetSchedulingStats();
+  state.counters["spin_hits"] = stats.num_spin_hits;
+  state.counters["parks"] = stats.num_parks;
+  state.counters["wakeups"] = stats.num_wakeups;
+  state.counters["wakeups_per_second"] = benchmark::Counter(
+      stats.num_wakeups, benchmark::Counter::kIsRate);
+  state.SetItemsProcessed(num_tasks * state.iterations());
+}
+
+#define BM_Burst(num_threads, batch)                                  \
+  static void BM_Burst_##num_threads##_threads_##batch(               \
+      benchmark::State& state) {                                      \
+    Burst(state, num_threads, batch);                                 \
+  }                                                                   \
+  BENCHMARK(BM_Burst_##num_threads##_threads_##batch)->UseRealTime()  \
+      ->Arg(16)                                                       \
+      ->Arg(256)
+
+BM_Burst(8, false);
+BM_Burst(8, true);
+BM_Burst(32, false);
+BM_Burst(32, true);
+
+// Benchmark the latency of fanned out tasks in a work queue with threads
+// partitioned into thread groups, and report how many tasks were stolen inside
+// and across the groups.
+//
+// A free-standing thread submits `num_producers` tasks to each thread group,
+// each submitting `num_tasks` tasks that do a bit of work into its own queue.
+void GroupedFanOut(benchmark::State& state, int num_threads, int num_groups) {
+  const int num_producers = state.range(0);
+  const int num_tasks = state.range(1);
+
+  auto qstate = std::make_unique<internal::QuiescingState>();
+  internal::ThreadGroups groups;
+  groups.num_groups = num_groups;
+  WorkQueue queue(qstate.get(), num_threads, groups);
+
+  for (auto _ : state) {
+    ::tfrt::latch latch(num_groups * num_producers * num_tasks);
+    for (int g = 0; g < num_groups; ++g) {
+      for (int i = 0; i < num_producers; ++i) {
+        queue.AddTask(TaskFunction([&] {
+                        for (int j = 0; j < num_tasks; ++j) {
+                          queue.AddTask(TaskFunction([&] {
+                            benchmark::DoNotOptimize(
+                                std::chrono::steady_clock::now());
+                            latch.count_down();
+                          }));
+                        }
+                      }),
+                      g);
+      }
+    }
+    latch.wait();
+  }
+
+  internal::StealStats stats = queue.GetStealStats();
+  state.counters["local_steals"] = stats.num_local_steals;
+  state.counters["remote_steals"] = stats.num_remote_steals;
+  state.SetItemsProcessed(num_groups * num_producers * num_tasks *
+                          state.iterations());
+}
+
+#define BM_GroupedFanOut(num_threads, num_groups)                             \
+  static void BM_GroupedFanOut_##num_threads##_threads_##num_groups##_groups( \
+      benchmark::State& state) {                                              \
+    GroupedFanOut(state, num_threads, num_groups);                            \
+  }                                                                           \
+  BENCHMARK(BM_GroupedFanOut_##num_threads##_threads_##num_groups##_groups)   \
+      ->UseRealTime()                                                         \
+      ->ArgPair(1, 1000)                                                      \
+      ->ArgPair(4, 1000)
+
+BM_GroupedFanOut(8, 1);
+BM_GroupedFanOut(8, 2);
+BM_GroupedFanOut(16, 1);
+BM_GroupedFanOut(16, 2);
+BM_GroupedFanOut(16, 4);
+
 }  // namespace
 }  // namespace tfrt
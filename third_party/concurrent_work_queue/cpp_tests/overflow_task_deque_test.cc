@@ -0,0 +1,149 @@
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+// Unit tests for OverflowTaskDeque.
+
+#include "overflow_task_deque.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "llvm/ADT/None.h"
+#include "llvm/ADT/Optional.h"
+#include "task_deque.h"
+#include "tfrt/host_context/task_function.h"
+
+namespace tfrt {
+namespace {
+
+using OverflowTaskDeque = ::tfrt::internal::OverflowTaskDeque;
+using TaskDeque = ::tfrt::internal::TaskDeque;
+
+// Helper class to create TaskFunction with an observable side effect.
+struct TaskFunctions {
+  TaskFunction Next(int value) {
+    return TaskFunction([this, value]() { this->value = value; });
+  }
+
+  int Run(llvm::Optional<TaskFunction> task) {
+    if (!task.hasValue()) return -1;
+    (*task)();
+    return value;
+  }
+
+  int value = -1;
+};
+
+TEST(OverflowTaskDequeTest, QueueCreatedEmpty) {
+  OverflowTaskDeque queue;
+
+  ASSERT_TRUE(queue.Empty());
+  ASSERT_EQ(queue.Size(), 0);
+
+  ASSERT_EQ(queue.PopFront(), llvm::None);
+  ASSERT_EQ(queue.PopBack(), llvm::None);
+}
+
+TEST(OverflowTaskDequeTest, PushFrontToOverflow) {
+  TaskFunctions fn;
+  OverflowTaskDeque queue;
+
+  const int num_tasks = 3 * TaskDeque::kCapacity;
+  for (int i = 0; i < num_tasks; ++i) queue.PushFront(fn.Next(i));
+  ASSERT_EQ(queue.Size(), num_tasks);
+  ASSERT_FALSE(queue.Empty());
+
+  // Owner pops tasks in LIFO order.
+  for (int i = num_tasks - 1; i >= 0; --i) {
+    ASSERT_EQ(fn.Run(queue.PopFront()), i);
+  }
+  ASSERT_TRUE(queue.Empty());
+}
+
+TEST(OverflowTaskDequeTest, PushFrontToOverflowAndPopBack) {
+  TaskFunctions fn;
+  OverflowTaskDeque queue;
+
+  const int num_tasks = 3 * TaskDeque::kCapacity;
+  for (int i = 0; i < num_tasks; ++i) queue.PushFront(fn.Next(i));
+
+  // Thieves pop the oldest tasks first.
+  for (int i = 0; i < num_tasks; ++i) {
+    ASSERT_EQ(fn.Run(queue.PopBack()), i);
+  }
+  ASSERT_TRUE(queue.Empty());
+}
+
+TEST(OverflowTaskDequeTest, PushBackToOverflow) {
+  TaskFunctions fn;
+  OverflowTaskDeque queue;
+
+  const int num_tasks = 3 * TaskDeque::kCapacity;
+  for (int i = 0; i < num_tasks; ++i) queue.PushBack(fn.Next(i));
+  ASSERT_EQ(queue.Size(), num_tasks);
+
+  // Thieves pop tasks in LIFO order.
+  for (int i = num_tasks - 1; i >= 0; --i) {
+    ASSERT_EQ(fn.Run(queue.PopBack()), i);
+  }
+  ASSERT_TRUE(queue.Empty());
+}
+
+TEST(OverflowTaskDequeTest, PushBackToOverflowAndPopFront) {
+  TaskFunctions fn;
+  OverflowTaskDeque queue;
+
+  const int num_tasks = 3 * TaskDeque::kCapacity;
+  for (int i = 0; i < num_tasks; ++i) queue.PushBack(fn.Next(i));
+
+  // Owner pops the tasks that were pushed first.
+  for (int i = 0; i < num_tasks; ++i) {
+    ASSERT_EQ(fn.Run(queue.PopFront()), i);
+  }
+  ASSERT_TRUE(queue.Empty());
+}
+
+TEST(OverflowTaskDequeTest, Flush) {
+  TaskFunctions fn;
+  OverflowTaskDeque queue;
+
+  for (int i = 0; i < 2 * TaskDeque::kCapacity; ++i) {
+    queue.PushFront(fn.Next(i));
+  }
+  queue.Flush();
+  ASSERT_TRUE(queue.Empty());
+  ASSERT_EQ(queue.Size(), 0);
+}
+
+TEST(OverflowTaskDequeTest, ConcurrentPushAndSteal) {
+  OverflowTaskDeque queue;
+  const int num_tasks = 100000;
+
+  std::atomic<int> num_executed{0};
+  std::atomic<bool> done{false};
+
+  // Owner pushes all tasks into its own queue, thieves steal them.
+  std::vector<std::thread> thieves;
+  for (int t = 0; t < 4; ++t) {
+    thieves.emplace_back([&]() {
+      while (!done || !queue.Empty()) {
+        llvm::Optional<TaskFunction> task = queue.PopBack();
+        if (task.hasValue()) (*task)();
+      }
+    });
+  }
+
+  for (int i = 0; i < num_tasks; ++i)
+    queue.PushFront(TaskFunction([&]() { num_executed++; }));
+  while (llvm::Optional<TaskFunction> task = queue.PopFront()) (*task)();
+  done = true;
+
+  for (auto& thief : thieves) thief.join();
+  ASSERT_EQ(num_executed, num_tasks);
+}
+
+}  // namespace
+}  // namespace tfrt
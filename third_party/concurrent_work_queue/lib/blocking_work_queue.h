@@ -71,8 +71,8 @@ class BlockingWorkQueue
   friend class WorkQueueBase;
 
   using Base::GetPerThread;
-  using Base::IsNotifyParkedThreadRequired;
   using Base::IsQuiescing;
+  using Base::NotifyParkedThreads;
   using Base::WithPendingTaskCounter;
 
   using Base::coprimes_;
@@ -188,7 +188,7 @@ BlockingWorkQueue<ThreadingEnvironment>::EnqueueBlockingTask(
   // destruction of this. We expect that such a scenario is prevented by the
   // program, that is, this is kept alive while any threads can potentially be
   // in Schedule.
-  if (IsNotifyParkedThreadRequired()) event_count_.Notify(false);
+  NotifyParkedThreads(/*num_tasks=*/1);
 
   return llvm::None;
 }
@@ -5,14 +5,24 @@
 // Concurrent Work Queue implementation composed from a blocking and
 // non-blocking work queues.
 
+#include <algorithm>
+#include <fstream>
 #include <memory>
+#include <string>
 #include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
 
 #include "blocking_work_queue.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringExtras.h"
 #include "non_blocking_work_queue.h"
 #include "tfrt/host_context/async_value.h"
 #include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/execution_context.h"
 #include "tfrt/host_context/task_function.h"
 #include "tfrt/support/latch.h"
 #include "tfrt/support/ref_count.h"
@@ -23,17 +33,22 @@ namespace tfrt {
 
 class MultiThreadedWorkQueue : public ConcurrentWorkQueue {
  public:
-  MultiThreadedWorkQueue(int num_threads, int num_blocking_threads);
+  MultiThreadedWorkQueue(int num_threads, int num_blocking_threads,
+                         internal::ThreadGroups groups = {});
   ~MultiThreadedWorkQueue() override;
 
   std::string name() const override {
     return StrCat("Multi-threaded C++ work queue (", num_threads_, " threads, ",
-                  num_blocking_threads_, " blocking threads)");
+                  num_blocking_threads_, " blocking threads, ",
+                  non_blocking_work_queue_.num_groups(), " thread groups)");
   }
 
   int GetParallelismLevel() const final { return num_threads_; }
 
   void AddTask(TaskFunction task) final;
+  void AddTask(const ExecutionContext& exec_ctx, TaskFunction task) final;
+  void AddTasks(const ExecutionContext& exec_ctx,
+                MutableArrayRef<TaskFunction> tasks) final;
   Optional<TaskFunction> AddBlockingTask(TaskFunction task,
                                          bool allow_queuing) final;
   void Quiesce() final;
@@ -41,6 +56,14 @@ class MultiThreadedWorkQueue : public ConcurrentWorkQueue {
 
   bool IsInWorkerThread() const final;
 
+  int GetWorkerThreadIndex() const final {
+    return non_blocking_work_queue_.CurrentThreadId();
+  }
+
+  int GetNumBusyWorkerThreads() const final {
+    return non_blocking_work_queue_.NumBusyThreads();
+  }
+
  private:
   const int num_threads_;
   const int num_blocking_threads_;
@@ -51,11 +74,13 @@ class MultiThreadedWorkQueue : public ConcurrentWorkQueue {
 };
 
 MultiThreadedWorkQueue::MultiThreadedWorkQueue(int num_threads,
-                                               int num_blocking_threads)
+                                               int num_blocking_threads,
+                                               internal::ThreadGroups groups)
     : num_threads_(num_threads),
       num_blocking_threads_(num_blocking_threads),
       quiescing_state_(std::make_unique<internal::QuiescingState>()),
-      non_blocking_work_queue_(quiescing_state_.get(), num_threads),
+      non_blocking_work_queue_(quiescing_state_.get(), num_threads,
+                               std::move(groups)),
       blocking_work_queue_(quiescing_state_.get(), num_blocking_threads) {}
 
 MultiThreadedWorkQueue::~MultiThreadedWorkQueue() {
@@ -68,6 +93,22 @@ void MultiThreadedWorkQueue::AddTask(TaskFunction task) {
   non_blocking_work_queue_.AddTask(std::move(task));
 }
 
+// Returns the preferred NUMA node of the request, or -1 if there is none.
+static int GetNumaNode(const ExecutionContext& exec_ctx) {
+  RequestContext* request_ctx = exec_ctx.request_ctx();
+  return request_ctx ? request_ctx->request_options().numa_node : -1;
+}
+
+void MultiThreadedWorkQueue::AddTask(const ExecutionContext& exec_ctx,
+                                     TaskFunction task) {
+  non_blocking_work_queue_.AddTask(std::move(task), GetNumaNode(exec_ctx));
+}
+
+void MultiThreadedWorkQueue::AddTasks(const ExecutionContext& exec_ctx,
+                                      MutableArrayRef<TaskFunction> tasks) {
+  non_blocking_work_queue_.AddTasks(tasks, GetNumaNode(exec_ctx));
+}
+
 Optional<TaskFunction> MultiThreadedWorkQueue::AddBlockingTask(
     TaskFunction task, bool allow_queuing) {
   if (allow_queuing) {
@@ -125,4 +166,121 @@ std::unique_ptr<ConcurrentWorkQueue> CreateMultiThreadedWorkQueue(
                                                   num_blocking_threads);
 }
 
+namespace {
+
+// Parses a Linux cpulist or nodelist string (e.g. "0-3,8-11") into a list of
+// ids.
+std::vector<int> ParseCpuList(string_view cpu_list) {
+  std::vector<int> cpus;
+  llvm::SmallVector<string_view, 8> ranges;
+  cpu_list.trim().split(ranges, ',', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  for (string_view range : ranges) {
+    std::pair<string_view, string_view> bounds = range.split('-');
+    int first, last;
+    if (bounds.first.getAsInteger(10, first)) return {};
+    if (bounds.second.empty()) {
+      last = first;
+    } else if (bounds.second.getAsInteger(10, last)) {
+      return {};
+    }
+    for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+// Returns the first line of the file at `path`, or an empty string if the file
+// can't be read.
+std::string ReadFirstLine(const std::string& path) {
+  std::string line;
+  std::ifstream file(path);
+  if (file) std::getline(file, line);
+  return line;
+}
+
+// Returns the CPUs that the caller thread is allowed to run on, or an empty
+// vector if the affinity mask is not available.
+std::vector<int> GetAllowedCpus() {
+  std::vector<int> cpus;
+#if defined(__linux__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) != 0) return cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    if (CPU_ISSET(cpu, &cpu_set)) cpus.push_back(cpu);
+#endif
+  return cpus;
+}
+
+// Returns the CPUs of each NUMA node of the host that the process is allowed
+// to run on. Falls back on a single node with all CPUs if the topology is not
+// available.
+std::vector<std::vector<int>> GetNumaNodeCpus() {
+  std::vector<int> allowed = GetAllowedCpus();
+  std::vector<std::vector<int>> nodes;
+#if defined(__linux__)
+  // Node ids are not necessarily contiguous, e.g. after hot-unplug, so walk
+  // the list of online nodes rather than probing node0, node1, ... in order.
+  for (int node :
+       ParseCpuList(ReadFirstLine("/sys/devices/system/node/online"))) {
+    std::vector<int> cpus = ParseCpuList(ReadFirstLine(
+        StrCat("/sys/devices/system/node/node", node, "/cpulist")));
+    if (!allowed.empty()) {
+      cpus.erase(std::remove_if(cpus.begin(), cpus.end(),
+                                [&](int cpu) {
+                                  return !std::binary_search(
+                                      allowed.begin(), allowed.end(), cpu);
+                                }),
+                 cpus.end());
+    }
+    // Memory-only nodes and nodes outside of the affinity mask have no CPUs.
+    if (!cpus.empty()) nodes.push_back(std::move(cpus));
+  }
+#endif
+  if (nodes.empty()) {
+    if (allowed.empty()) {
+      for (int cpu = 0; cpu < std::thread::hardware_concurrency(); ++cpu)
+        allowed.push_back(cpu);
+    }
+    nodes.push_back(std::move(allowed));
+  }
+  return nodes;
+}
+
+}  // namespace
+
+std::unique_ptr<ConcurrentWorkQueue> CreateNumaAwareMultiThreadedWorkQueue(
+    int num_threads, int num_blocking_threads, int num_groups,
+    bool pin_to_single_cpu) {
+  assert(num_threads > 0 && num_blocking_threads > 0 && num_groups >= 0);
+  std::vector<std::vector<int>> nodes = GetNumaNodeCpus();
+
+  internal::ThreadGroups groups;
+  groups.pin_to_single_cpu = pin_to_single_cpu;
+  if (num_groups == 0 || num_groups == nodes.size()) {
+    groups.num_groups = nodes.size();
+    groups.cpus = std::move(nodes);
+  } else {
+    // Split all CPUs evenly into the requested number of groups.
+    std::vector<int> cpus;
+    for (auto& node : nodes) cpus.insert(cpus.end(), node.begin(), node.end());
+    groups.num_groups = std::min<int>(num_groups, cpus.size());
+    for (int g = 0; g < groups.num_groups; ++g) {
+      groups.cpus.emplace_back(
+          cpus.begin() +
+              static_cast<int64_t>(g) * cpus.size() / groups.num_groups,
+          cpus.begin() +
+              static_cast<int64_t>(g + 1) * cpus.size() / groups.num_groups);
+    }
+  }
+
+  // Threads can't be split into more groups than there are threads.
+  if (groups.num_groups > num_threads) {
+    groups.num_groups = 1;
+    groups.cpus.clear();
+  }
+
+  return std::make_unique<MultiThreadedWorkQueue>(
+      num_threads, num_blocking_threads, std::move(groups));
+}
+
 }  // namespace tfrt
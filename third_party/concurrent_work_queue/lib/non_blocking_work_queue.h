@@ -10,11 +10,12 @@
 // Work queue implementation based on non-blocking concurrency primitives
 // optimized for CPU intensive non-blocking compute tasks.
 //
-// This work queue uses TaskDeque for storing pending tasks. Thread tries to
-// pop a task from the front of its own queue, and in a steal loop it tries to
-// steal a task from the back of another thread pending tasks queue. This gives
-// mostly LIFO task execution order, which is optimal for cache locality for
-// compute intensive tasks.
+// This work queue uses OverflowTaskDeque for storing pending tasks, so adding a
+// task never fails even if the fixed-size TaskDeque of a thread is full (tasks
+// go into an overflow list instead). Thread tries to pop a task from the front
+// of its own queue, and in a steal loop it tries to steal a task from the back
+// of another thread pending tasks queue. This gives mostly LIFO task execution
+// order, which is optimal for cache locality for compute intensive tasks.
 //
 // Work stealing algorithm is based on:
 //
@@ -24,9 +25,11 @@
 #ifndef TFRT_THIRD_PARTY_CONCURRENT_WORK_QUEUE_NON_BLOCKING_WORK_QUEUE_H_
 #define TFRT_THIRD_PARTY_CONCURRENT_WORK_QUEUE_NON_BLOCKING_WORK_QUEUE_H_
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/Support/Compiler.h"
-#include "task_deque.h"
+#include "overflow_task_deque.h"
 #include "tfrt/host_context/task_function.h"
+#include "tfrt/metrics/common_metrics.h"
 #include "work_queue_base.h"
 
 namespace tfrt {
@@ -39,7 +42,7 @@ template <typename ThreadingEnvironmentTy>
 struct WorkQueueTraits<NonBlockingWorkQueue<ThreadingEnvironmentTy>> {
   using ThreadingEnvironment = ThreadingEnvironmentTy;
   using Thread = typename ThreadingEnvironment::Thread;
-  using Queue = ::tfrt::internal::TaskDeque;
+  using Queue = ::tfrt::internal::OverflowTaskDeque;
 };
 
 template <typename ThreadingEnvironment>
@@ -54,29 +57,54 @@ class NonBlockingWorkQueue
 
  public:
   explicit NonBlockingWorkQueue(QuiescingState* quiescing_state,
-                                int num_threads);
+                                int num_threads, ThreadGroups groups = {});
   ~NonBlockingWorkQueue() = default;
 
-  void AddTask(TaskFunction task);
+  // Adds a task to the work queue. If the caller is not a worker thread of this
+  // queue and `group` is not negative, the task is added to a thread of that
+  // thread group (taken modulo the number of groups).
+  void AddTask(TaskFunction task, int group = -1);
+
+  // Adds a batch of tasks to the work queue (see AddTask), and wakes up parked
+  // worker threads once for the whole batch.
+  void AddTasks(llvm::MutableArrayRef<TaskFunction> tasks, int group = -1);
 
   using Base::Steal;
 
  private:
   static constexpr char const* kThreadNamePrefix = "tfrt-non-blocking-queue";
 
+  // One in this many pushed tasks records the queue depth. Must be a power of
+  // 2.
+  static constexpr unsigned kQueueDepthSamplingPeriod = 64;
+
   template <typename WorkQueue>
   friend class WorkQueueBase;
 
   using Base::GetPerThread;
-  using Base::IsNotifyParkedThreadRequired;
+  using Base::GroupBegin;
+  using Base::GroupSize;
   using Base::IsQuiescing;
+  using Base::NotifyParkedThreads;
   using Base::WithPendingTaskCounter;
 
   using Base::coprimes_;
   using Base::event_count_;
+  using Base::num_groups_;
   using Base::num_threads_;
   using Base::thread_data_;
 
+  // Pushes `task` into one of the worker queues according to the caller thread
+  // and the preferred thread group. Returns the queue the task was pushed to.
+  Queue* PushTask(PerThread* pt, TaskFunction task, int group);
+
+  // Records the size of `queue` after a push for a random sample of the pushed
+  // tasks, to keep the metric off the enqueue fast path.
+  void MaybeRecordQueueDepth(PerThread* pt, Queue* queue) {
+    if ((pt->rng() & (kQueueDepthSamplingPeriod - 1)) == 0)
+      metrics::GetWorkQueueDepthHistogram()->Record(queue->Size());
+  }
+
   LLVM_NODISCARD Optional<TaskFunction> NextTask(Queue* queue);
   LLVM_NODISCARD Optional<TaskFunction> Steal(Queue* queue);
   LLVM_NODISCARD bool Empty(Queue* queue);
@@ -84,38 +112,53 @@ class NonBlockingWorkQueue
 
 template <typename ThreadingEnvironment>
 NonBlockingWorkQueue<ThreadingEnvironment>::NonBlockingWorkQueue(
-    QuiescingState* quiescing_state, int num_threads)
+    QuiescingState* quiescing_state, int num_threads, ThreadGroups groups)
     : WorkQueueBase<NonBlockingWorkQueue>(quiescing_state, kThreadNamePrefix,
-                                          num_threads) {}
+                                          num_threads, std::move(groups)) {}
 
 template <typename ThreadingEnvironment>
-void NonBlockingWorkQueue<ThreadingEnvironment>::AddTask(TaskFunction task) {
-  // Keep track of the number of pending tasks.
-  if (IsQuiescing()) task = WithPendingTaskCounter(std::move(task));
-
-  // If the worker queue is full, we will execute `task` in the current thread.
-  llvm::Optional<TaskFunction> inline_task;
-
+typename NonBlockingWorkQueue<ThreadingEnvironment>::Queue*
+NonBlockingWorkQueue<ThreadingEnvironment>::PushTask(PerThread* pt,
+                                                     TaskFunction task,
+                                                     int group) {
   // If a caller thread is managed by `this` we push the new task into the front
   // of thread own queue (LIFO execution order). PushFront is completely lock
   // free (PushBack requires a mutex lock), and improves data locality (in
   // practice tasks submitted together share some data).
   //
   // If a caller is a free-standing thread (or worker of another pool), we push
-  // the new task into a random queue (FIFO execution order). Tasks still could
-  // be executed in LIFO order, if they would be stolen by other workers.
-
-  PerThread* pt = GetPerThread();
+  // the new task into a random queue (FIFO execution order), restricted to the
+  // requested thread group if any. Tasks still could be executed in LIFO order,
+  // if they would be stolen by other workers.
+  Queue* q;
   if (pt->parent == this) {
     // Worker thread of this pool, push onto the thread's queue.
-    Queue& q = thread_data_[pt->thread_id].queue;
-    inline_task = q.PushFront(std::move(task));
+    q = &thread_data_[pt->thread_id].queue;
+    q->PushFront(std::move(task));
+  } else if (group >= 0 && num_groups_ > 1) {
+    // A free-standing thread that prefers a group of worker threads.
+    group %= num_groups_;
+    unsigned rnd = FastReduce(pt->rng(), GroupSize(group));
+    q = &thread_data_[GroupBegin(group) + rnd].queue;
+    q->PushBack(std::move(task));
   } else {
     // A free-standing thread (or worker of another pool).
     unsigned rnd = FastReduce(pt->rng(), num_threads_);
-    Queue& q = thread_data_[rnd].queue;
-    inline_task = q.PushBack(std::move(task));
+    q = &thread_data_[rnd].queue;
+    q->PushBack(std::move(task));
   }
+  return q;
+}
+
+template <typename ThreadingEnvironment>
+void NonBlockingWorkQueue<ThreadingEnvironment>::AddTask(TaskFunction task,
+                                                         int group) {
+  // Keep track of the number of pending tasks.
+  if (IsQuiescing()) task = WithPendingTaskCounter(std::move(task));
+
+  PerThread* pt = GetPerThread();
+  Queue* q = PushTask(pt, std::move(task), group);
+
   // Note: below we touch `*this` after making `task` available to worker
   // threads. Strictly speaking, this can lead to a racy-use-after-free.
   // Consider that Schedule is called from a thread that is neither main thread
@@ -124,12 +167,26 @@ void NonBlockingWorkQueue<ThreadingEnvironment>::AddTask(TaskFunction task) {
   // destruction of this. We expect that such a scenario is prevented by the
   // program, that is, this is kept alive while any threads can potentially be
   // in Schedule.
-  if (!inline_task.hasValue()) {
-    if (IsNotifyParkedThreadRequired())
-      event_count_.Notify(/*notify_all=*/false);
-  } else {
-    (*inline_task)();  // Push failed, execute directly.
+  MaybeRecordQueueDepth(pt, q);
+  NotifyParkedThreads(/*num_tasks=*/1);
+}
+
+template <typename ThreadingEnvironment>
+void NonBlockingWorkQueue<ThreadingEnvironment>::AddTasks(
+    llvm::MutableArrayRef<TaskFunction> tasks, int group) {
+  if (tasks.empty()) return;
+  PerThread* pt = GetPerThread();
+
+  for (TaskFunction& task : tasks) {
+    // Keep track of the number of pending tasks.
+    if (IsQuiescing()) task = WithPendingTaskCounter(std::move(task));
+
+    Queue* q = PushTask(pt, std::move(task), group);
+    MaybeRecordQueueDepth(pt, q);
   }
+
+  // See the note about touching `*this` in AddTask.
+  NotifyParkedThreads(tasks.size());
 }
 
 template <typename ThreadingEnvironment>
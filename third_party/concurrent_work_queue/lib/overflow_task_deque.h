@@ -0,0 +1,183 @@
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+// OverflowTaskDeque is a TaskDeque that never rejects a task. Tasks that do not
+// fit into the fixed size TaskDeque are kept in an unbounded overflow list
+// guarded by a mutex, which logically extends the TaskDeque past its back:
+//
+//   front [ TaskDeque ][ overflow list ] back
+//
+// When PushFront() finds the TaskDeque full, the owner moves the back half of
+// the TaskDeque to the front of the overflow list, so that the newest tasks
+// stay in the TaskDeque. PushBack() appends to the back of the overflow list
+// when the TaskDeque is full or the overflow list is not empty. PopFront()
+// takes from the overflow list only once the TaskDeque is empty, and PopBack()
+// takes from the overflow list first. This keeps the order of a deque: LIFO for
+// the owner at the front, and LIFO at the back.
+//
+// The overflow list is only touched when the TaskDeque is full (on push), or
+// when it is empty (on pop), so the fast paths are the same as in the
+// TaskDeque. The owner moves tasks between the TaskDeque and the overflow list
+// in batches of kCapacity / 2, so it takes the overflow mutex once per batch.
+// Remote threads already serialize on the mutex of TaskDeque::PushBack() and
+// TaskDeque::PopBack(), so a lock-free overflow list would not make their path
+// lock-free.
+
+#ifndef TFRT_THIRD_PARTY_CONCURRENT_WORK_QUEUE_OVERFLOW_TASK_DEQUE_H_
+#define TFRT_THIRD_PARTY_CONCURRENT_WORK_QUEUE_OVERFLOW_TASK_DEQUE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <iterator>
+#include <vector>
+
+#include "llvm/ADT/None.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/Support/Compiler.h"
+#include "task_deque.h"
+#include "tfrt/host_context/task_function.h"
+#include "tfrt/metrics/common_metrics.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace internal {
+
+class OverflowTaskDeque {
+ public:
+  OverflowTaskDeque() : overflow_size_(0) {}
+  OverflowTaskDeque(const OverflowTaskDeque&) = delete;
+  void operator=(const OverflowTaskDeque&) = delete;
+
+  ~OverflowTaskDeque() { assert(Size() == 0); }
+
+  // PushFront() inserts task at the beginning of the queue. Must be called only
+  // by the owner thread.
+  void PushFront(TaskFunction task) {
+    llvm::Optional<TaskFunction> overflow = deque_.PushFront(std::move(task));
+    while (LLVM_UNLIKELY(overflow.hasValue())) {
+      SpillBackHalf();
+      overflow = deque_.PushFront(std::move(*overflow));
+    }
+  }
+
+  // PushBack() inserts task at the end of the queue.
+  void PushBack(TaskFunction task) {
+    if (!HasOverflow()) {
+      llvm::Optional<TaskFunction> overflow = deque_.PushBack(std::move(task));
+      if (LLVM_LIKELY(!overflow.hasValue())) return;
+      task = std::move(*overflow);
+    }
+    PushBackToOverflow(std::move(task));
+  }
+
+  // PopFront() removes and returns the first element in the queue. Must be
+  // called only by the owner thread.
+  //
+  // If the queue is empty returns empty optional.
+  LLVM_NODISCARD llvm::Optional<TaskFunction> PopFront() {
+    llvm::Optional<TaskFunction> task = deque_.PopFront();
+    if (task.hasValue() || !HasOverflow()) return task;
+    RefillFromOverflow();
+    return deque_.PopFront();
+  }
+
+  // PopBack() removes and returns the last element in the queue.
+  //
+  // If the queue is empty returns empty optional.
+  LLVM_NODISCARD llvm::Optional<TaskFunction> PopBack() {
+    if (HasOverflow()) {
+      mutex_lock lock(overflow_mu_);
+      if (!overflow_.empty()) {
+        llvm::Optional<TaskFunction> task(std::move(overflow_.back()));
+        overflow_.pop_back();
+        overflow_size_.fetch_sub(1, std::memory_order_release);
+        return task;
+      }
+    }
+    return deque_.PopBack();
+  }
+
+  // Size returns current queue size.
+  // Can be called by any thread at any time.
+  unsigned Size() const {
+    return deque_.Size() + overflow_size_.load(std::memory_order_acquire);
+  }
+
+  // Empty tests whether container is empty.
+  // Can be called by any thread at any time.
+  bool Empty() const { return deque_.Empty() && !HasOverflow(); }
+
+  // Delete all the elements from the queue.
+  void Flush() {
+    while (!Empty()) {
+      llvm::Optional<TaskFunction> task = PopFront();
+      assert(task.hasValue());
+    }
+  }
+
+ private:
+  bool HasOverflow() const {
+    return overflow_size_.load(std::memory_order_acquire) != 0;
+  }
+
+  // Moves the back half of the TaskDeque to the front of the overflow list.
+  LLVM_ATTRIBUTE_NOINLINE void SpillBackHalf() {
+    std::vector<TaskFunction> tasks;
+    // The tasks are returned from the middle of the TaskDeque to its back.
+    unsigned num_tasks = deque_.PopBackHalf(&tasks);
+    {
+      mutex_lock lock(overflow_mu_);
+      overflow_.insert(overflow_.begin(),
+                       std::make_move_iterator(tasks.begin()),
+                       std::make_move_iterator(tasks.end()));
+      overflow_size_.fetch_add(num_tasks, std::memory_order_release);
+    }
+    metrics::GetWorkQueueOverflowCounter()->IncrementBy(num_tasks);
+  }
+
+  // Moves up to kCapacity / 2 tasks from the front of the overflow list to the
+  // empty TaskDeque.
+  LLVM_ATTRIBUTE_NOINLINE void RefillFromOverflow() {
+    mutex_lock lock(overflow_mu_);
+    unsigned num_tasks =
+        std::min<size_t>(overflow_.size(), TaskDeque::kCapacity / 2);
+    // The front of the overflow list holds the most recent overflowed tasks,
+    // which go to the front of the TaskDeque.
+    unsigned num_moved = 0;
+    for (; num_moved < num_tasks; ++num_moved) {
+      llvm::Optional<TaskFunction> overflow =
+          deque_.PushFront(std::move(overflow_[num_tasks - num_moved - 1]));
+      if (overflow.hasValue()) {
+        overflow_[num_tasks - num_moved - 1] = std::move(*overflow);
+        break;
+      }
+    }
+    overflow_.erase(overflow_.begin() + (num_tasks - num_moved),
+                    overflow_.begin() + num_tasks);
+    overflow_size_.fetch_sub(num_moved, std::memory_order_release);
+  }
+
+  LLVM_ATTRIBUTE_NOINLINE void PushBackToOverflow(TaskFunction task) {
+    {
+      mutex_lock lock(overflow_mu_);
+      overflow_.push_back(std::move(task));
+      overflow_size_.fetch_add(1, std::memory_order_release);
+    }
+    metrics::GetWorkQueueOverflowCounter()->Increment();
+  }
+
+  TaskDeque deque_;
+
+  mutex overflow_mu_;
+  std::deque<TaskFunction> overflow_ TFRT_GUARDED_BY(overflow_mu_);
+  // The number of tasks in `overflow_`, readable without the lock.
+  std::atomic<unsigned> overflow_size_;
+};
+
+}  // namespace internal
+}  // namespace tfrt
+
+#endif  // TFRT_THIRD_PARTY_CONCURRENT_WORK_QUEUE_OVERFLOW_TASK_DEQUE_H_
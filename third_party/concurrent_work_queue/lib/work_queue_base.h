@@ -21,12 +21,24 @@
 //
 // Before parking on a conditional variable, thread might go into a spin loop
 // (controlled by `kMaxSpinningThreads` constant), and execute steal loop for a
-// fixed number of iterations. This allows to skip expensive park/unpark
-// operations, and reduces latency. Increasing `kMaxSpinningThreads` improves
-// latency at the cost of burned CPU cycles.
+// number of iterations. This allows to skip expensive park/unpark operations,
+// and reduces latency. Increasing `kMaxSpinningThreads` improves latency at the
+// cost of burned CPU cycles. The number of spin iterations adapts to the load:
+// it grows when spinning threads find new tasks, and shrinks when they end up
+// parking anyway.
+//
+// Producers adding a batch of tasks (see `AddTasks` in the derived work
+// queues) wake up at most one parked thread per task and stop as soon as there
+// are no parked threads left, instead of notifying for every task.
 //
 // See derived work queue implementation for more details about work stealing.
 //
+// Worker threads can be partitioned into groups of consecutive thread ids (e.g.
+// one group per NUMA node), and optionally pinned to the CPUs of their group,
+// either to one CPU each or to all of them.
+// A grouped worker thread out of work first tries to steal from the threads of
+// its own group, and only then from all the other threads.
+//
 // -------------------------------------------------------------------------- //
 // Work queue implementations are parametrized by `ThreadingEnvironment` that
 // allows to provide custom thread implementation:
@@ -49,15 +61,25 @@
 #ifndef TFRT_THIRD_PARTY_CONCURRENT_WORK_QUEUE_WORK_QUEUE_BASE_H_
 #define TFRT_THIRD_PARTY_CONCURRENT_WORK_QUEUE_WORK_QUEUE_BASE_H_
 
+#include <algorithm>
 #include <atomic>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 #include "event_count.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/Support/Compiler.h"
 #include "task_queue.h"
 #include "tfrt/host_context/task_function.h"
+#include "tfrt/metrics/common_metrics.h"
 #include "tfrt/support/forward_decls.h"
 #include "tfrt/support/logging.h"
 #include "tfrt/support/mutex.h"
@@ -90,6 +112,74 @@ inline uint32_t FastReduce(uint32_t x, uint32_t size) {
 template <typename Derived>
 struct WorkQueueTraits;
 
+//===----------------------------------------------------------------------===//
+// Partitioning of the worker threads into groups.
+//===----------------------------------------------------------------------===//
+struct ThreadGroups {
+  // Threads are split into `num_groups` groups of consecutive thread ids with
+  // sizes that differ by at most one.
+  int num_groups = 1;
+
+  // If not empty, `cpus[g]` are the CPUs that the threads of group `g` are
+  // pinned to.
+  std::vector<std::vector<int>> cpus;
+
+  // If true, each thread is pinned to a single CPU of its group, assigned
+  // round-robin by the index of the thread in the group. This keeps the caches
+  // of a thread warm and avoids migrations within the group. Otherwise the
+  // threads can run on any CPU of their group.
+  bool pin_to_single_cpu = true;
+};
+
+// Pins the caller thread to the given CPUs, restricted to the CPUs the thread
+// is already allowed to run on (e.g. by taskset or cgroups). Leaves the
+// affinity unchanged if none of the given CPUs are allowed. Does nothing on
+// the platforms without thread affinity support.
+inline void PinCurrentThreadToCpus(llvm::ArrayRef<int> cpus) {
+#if defined(__linux__)
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  int err = pthread_getaffinity_np(pthread_self(), sizeof(allowed), &allowed);
+  if (err != 0) {
+    TFRT_LOG(WARNING) << "Failed to get work queue thread affinity: "
+                      << strerror(err);
+    return;
+  }
+
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))
+      CPU_SET(cpu, &cpu_set);
+  }
+  if (CPU_COUNT(&cpu_set) == 0) {
+    TFRT_LOG(WARNING) << "Not pinning work queue thread: none of its CPUs are "
+                         "in the allowed affinity mask";
+    return;
+  }
+  err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+  TFRT_LOG_IF(WARNING, err != 0)
+      << "Failed to pin work queue thread: " << strerror(err);
+#endif
+}
+
+// Number of tasks stolen by the worker threads, split by whether the victim
+// thread is in the same group as the thief.
+struct StealStats {
+  uint64_t num_local_steals = 0;
+  uint64_t num_remote_steals = 0;
+};
+
+// Counters of the worker threads parking decisions.
+struct SchedulingStats {
+  // Number of spin loops that found a task to execute.
+  uint64_t num_spin_hits = 0;
+  // Number of times a worker thread parked waiting for new tasks.
+  uint64_t num_parks = 0;
+  // Number of parked worker threads woken up by producers.
+  uint64_t num_wakeups = 0;
+};
+
 //===----------------------------------------------------------------------===//
 // Quiescing enables pending tasks counter to implement strong work queue
 // emptiness check in the MultiThreadedWorkQueue::Quiesce() implementation.
@@ -238,9 +328,40 @@ class WorkQueueBase {
     return per_thread->parent == &derived_;
   }
 
+  // Returns current thread id if the caller thread is managed by `this`,
+  // returns `-1` otherwise.
+  int CurrentThreadId() const;
+
   // Stop all threads managed by this work queue.
   void Cancel();
 
+  int num_groups() const { return num_groups_; }
+
+  // Returns the number of tasks stolen by the worker threads so far.
+  StealStats GetStealStats() const;
+
+  SchedulingStats GetSchedulingStats() const {
+    SchedulingStats stats;
+    stats.num_spin_hits = num_spin_hits_.load(std::memory_order_relaxed);
+    stats.num_parks = num_parks_.load(std::memory_order_relaxed);
+    stats.num_wakeups = num_wakeups_.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  // Returns an estimate of the number of worker threads that are running
+  // tasks, i.e. neither parked nor spinning in the steal loop.
+  int NumBusyThreads() const {
+    SpinningState state = SpinningState::Decode(
+        spinning_state_.load(std::memory_order_relaxed));
+    int num_busy = num_threads_ - static_cast<int>(blocked_.load()) -
+                   static_cast<int>(state.num_spinning);
+    return num_busy > 0 ? num_busy : 0;
+  }
+
+  // Returns the current number of steal loop spin iterations before parking
+  // (before dividing by the number of threads).
+  int spin_count() const { return spin_count_.load(std::memory_order_relaxed); }
+
  private:
   template <typename ThreadingEnvironment>
   friend class BlockingWorkQueue;
@@ -259,6 +380,9 @@ class WorkQueueBase {
     ThreadData() : thread(), queue() {}
     std::unique_ptr<Thread> thread;
     Queue queue;
+    // Only updated by the owning worker thread.
+    std::atomic<uint64_t> num_local_steals{0};
+    std::atomic<uint64_t> num_remote_steals{0};
   };
 
   // Returns a TaskFunction with an attached pending tasks counter, if the
@@ -274,9 +398,12 @@ class WorkQueueBase {
   // to reduce latency at the cost of wasted CPU cycles.
   static constexpr int kMaxSpinningThreads = 1;
 
-  // The number of steal loop spin iterations before parking (this number is
-  // divided by the number of threads, to get spin count for each thread).
+  // The initial number of steal loop spin iterations before parking (this
+  // number is divided by the number of threads, to get spin count for each
+  // thread), and the bounds of its adaptive adjustments.
   static constexpr int kSpinCount = 5000;
+  static constexpr int kMinSpinCount = 500;
+  static constexpr int kMaxSpinCount = 50000;
 
   // If there are enough active threads with an empty pending task queues, there
   // is no need for spinning before parking a thread that is out of work to do,
@@ -289,9 +416,26 @@ class WorkQueueBase {
   static constexpr int kMinActiveThreadsToStartSpinning = 4;
 
   explicit WorkQueueBase(QuiescingState* quiescing_state,
-                         string_view name_prefix, int num_threads);
+                         string_view name_prefix, int num_threads,
+                         ThreadGroups groups = {});
   ~WorkQueueBase();
 
+  // Returns the first thread id of the group `group`.
+  int GroupBegin(int group) const {
+    return static_cast<int64_t>(group) * num_threads_ / num_groups_;
+  }
+  int GroupSize(int group) const {
+    return GroupBegin(group + 1) - GroupBegin(group);
+  }
+
+  // Tries to steal a task from the threads [begin, begin + size) visiting them
+  // in a random order. On success stores the victim thread id in `victim`.
+  LLVM_NODISCARD llvm::Optional<TaskFunction> StealFrom(
+      unsigned begin, unsigned size, llvm::ArrayRef<unsigned> coprimes,
+      unsigned r, unsigned* victim);
+
+  void CountSteal(PerThread* pt, unsigned victim);
+
   // Main worker thread loop.
   void WorkerLoop(int thread_id);
 
@@ -320,11 +464,18 @@ class WorkQueueBase {
   // be picked up by one of the spinning threads.
   LLVM_NODISCARD bool IsNotifyParkedThreadRequired();
 
-  void Notify() { event_count_.Notify(false); }
+  // Wakes up parked threads after `num_tasks` tasks were added to the queues,
+  // at most one per task that is not going to be picked up by a spinning
+  // thread.
+  void NotifyParkedThreads(int num_tasks);
 
-  // Returns current thread id if the caller thread is managed by `this`,
-  // returns `-1` otherwise.
-  int CurrentThreadId() const;
+  // Adjusts the spin count after a spin loop that found a task after
+  // `num_iterations` iterations (`found` is true), or didn't find anything.
+  void UpdateSpinCount(bool found, int num_iterations);
+
+  static void IncrementRelaxed(std::atomic<uint64_t>& counter) {
+    counter.fetch_add(1, std::memory_order_relaxed);
+  }
 
   // NonEmptyQueueIndex() returns the index of a non-empty worker queue, or `-1`
   // if all queues are empty.
@@ -340,10 +491,17 @@ class WorkQueueBase {
   unsigned NumActiveThreads() const { return num_threads_ - blocked_.load(); }
 
   const int num_threads_;
+  const int num_groups_;
 
   std::vector<ThreadData> thread_data_;
   std::vector<unsigned> coprimes_;
 
+  // Group of each thread, and coprimes of each group size.
+  std::vector<int> thread_group_;
+  std::vector<std::vector<unsigned>> group_coprimes_;
+  std::vector<std::vector<int>> group_cpus_;
+  const bool pin_to_single_cpu_;
+
   std::atomic<unsigned> blocked_;
   std::atomic<bool> done_;
   std::atomic<bool> cancelled_;
@@ -396,6 +554,13 @@ class WorkQueueBase {
     }
   };
 
+  // The adaptive number of steal loop spin iterations before parking.
+  std::atomic<int> spin_count_;
+
+  std::atomic<uint64_t> num_spin_hits_;
+  std::atomic<uint64_t> num_parks_;
+  std::atomic<uint64_t> num_wakeups_;
+
   EventCount event_count_;
   Derived& derived_;
 };
@@ -426,18 +591,34 @@ inline std::vector<unsigned> ComputeCoprimes(int n) {
 
 template <typename Derived>
 WorkQueueBase<Derived>::WorkQueueBase(QuiescingState* quiescing_state,
-                                      string_view name_prefix, int num_threads)
+                                      string_view name_prefix, int num_threads,
+                                      ThreadGroups groups)
     : num_threads_(num_threads),
+      num_groups_(std::max(1, std::min(groups.num_groups, num_threads))),
       thread_data_(num_threads),
       coprimes_(ComputeCoprimes(num_threads)),
+      thread_group_(num_threads),
+      group_cpus_(std::move(groups.cpus)),
+      pin_to_single_cpu_(groups.pin_to_single_cpu),
       blocked_(0),
       done_(false),
       cancelled_(false),
       quiescing_state_(quiescing_state),
       spinning_state_(0),
+      spin_count_(kSpinCount),
+      num_spin_hits_(0),
+      num_parks_(0),
+      num_wakeups_(0),
       event_count_(num_threads),
       derived_(static_cast<Derived&>(*this)) {
   assert(num_threads >= 1);
+  assert(group_cpus_.empty() || group_cpus_.size() == groups.num_groups);
+  if (group_cpus_.size() != num_groups_) group_cpus_.clear();
+  for (int g = 0; g < num_groups_; ++g) {
+    group_coprimes_.push_back(ComputeCoprimes(GroupSize(g)));
+    for (int i = GroupBegin(g); i < GroupBegin(g + 1); ++i)
+      thread_group_[i] = g;
+  }
   for (int i = 0; i < num_threads; i++) {
     thread_data_[i].thread = ThreadingEnvironment::StartThread(
         name_prefix, [this, i]() { WorkerLoop(i); });
@@ -505,22 +686,72 @@ template <typename Derived>
 LLVM_NODISCARD llvm::Optional<TaskFunction> WorkQueueBase<Derived>::Steal() {
   PerThread* pt = GetPerThread();
   unsigned r = pt->rng();
-  unsigned victim = FastReduce(r, num_threads_);
-  unsigned inc = coprimes_[FastReduce(r, coprimes_.size())];
+  unsigned victim;
 
-  for (unsigned i = 0; i < num_threads_; i++) {
+  // Grouped worker threads try to steal inside their own group first.
+  if (num_groups_ > 1 && pt->parent == &derived_) {
+    int group = thread_group_[pt->thread_id];
     llvm::Optional<TaskFunction> t =
-        derived_.Steal(&(thread_data_[victim].queue));
-    if (t.hasValue()) return t;
+        StealFrom(GroupBegin(group), GroupSize(group), group_coprimes_[group],
+                  r, &victim);
+    if (t.hasValue()) {
+      CountSteal(pt, victim);
+      return t;
+    }
+  }
 
-    victim += inc;
-    if (victim >= num_threads_) {
-      victim -= num_threads_;
+  llvm::Optional<TaskFunction> t =
+      StealFrom(0, num_threads_, coprimes_, r, &victim);
+  if (t.hasValue() && pt->parent == &derived_) CountSteal(pt, victim);
+  return t;
+}
+
+template <typename Derived>
+LLVM_NODISCARD llvm::Optional<TaskFunction> WorkQueueBase<Derived>::StealFrom(
+    unsigned begin, unsigned size, llvm::ArrayRef<unsigned> coprimes,
+    unsigned r, unsigned* victim) {
+  unsigned index = FastReduce(r, size);
+  unsigned inc = coprimes[FastReduce(r, coprimes.size())];
+
+  for (unsigned i = 0; i < size; i++) {
+    llvm::Optional<TaskFunction> t =
+        derived_.Steal(&(thread_data_[begin + index].queue));
+    if (t.hasValue()) {
+      *victim = begin + index;
+      return t;
+    }
+
+    index += inc;
+    if (index >= size) {
+      index -= size;
     }
   }
   return llvm::None;
 }
 
+template <typename Derived>
+void WorkQueueBase<Derived>::CountSteal(PerThread* pt, unsigned victim) {
+  ThreadData& data = thread_data_[pt->thread_id];
+  std::atomic<uint64_t>& counter =
+      thread_group_[victim] == thread_group_[pt->thread_id]
+          ? data.num_local_steals
+          : data.num_remote_steals;
+  counter.store(counter.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+}
+
+template <typename Derived>
+StealStats WorkQueueBase<Derived>::GetStealStats() const {
+  StealStats stats;
+  for (const ThreadData& data : thread_data_) {
+    stats.num_local_steals +=
+        data.num_local_steals.load(std::memory_order_relaxed);
+    stats.num_remote_steals +=
+        data.num_remote_steals.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
 template <typename Derived>
 void WorkQueueBase<Derived>::WorkerLoop(int thread_id) {
   PerThread* pt = GetPerThread();
@@ -528,15 +759,17 @@ void WorkQueueBase<Derived>::WorkerLoop(int thread_id) {
   pt->rng = FastRng(ThreadingEnvironment::ThisThreadIdHash());
   pt->thread_id = thread_id;
 
+  if (!group_cpus_.empty()) {
+    const int group = thread_group_[thread_id];
+    llvm::ArrayRef<int> cpus = group_cpus_[group];
+    if (pin_to_single_cpu_ && !cpus.empty())
+      cpus = cpus.slice((thread_id - GroupBegin(group)) % cpus.size(), 1);
+    PinCurrentThreadToCpus(cpus);
+  }
+
   Queue* q = &(thread_data_[thread_id].queue);
   EventCount::Waiter* waiter = event_count_.waiter(thread_id);
 
-  // TODO(dvyukov,rmlarsen): The time spent in NonEmptyQueueIndex() is
-  // proportional to num_threads_ and we assume that new work is scheduled at
-  // a constant rate, so we set spin_count to 5000 / num_threads_. The
-  // constant was picked based on a fair dice roll, tune it.
-  const int spin_count = num_threads_ > 0 ? kSpinCount / num_threads_ : 0;
-
   while (!cancelled_) {
     Optional<TaskFunction> t = derived_.NextTask(q);
     if (!t.hasValue()) {
@@ -545,9 +778,16 @@ void WorkQueueBase<Derived>::WorkerLoop(int thread_id) {
         // Maybe leave thread spinning. This reduces latency.
         const bool start_spinning = StartSpinning();
         if (start_spinning) {
-          for (int i = 0; i < spin_count && !t.hasValue(); ++i) {
+          // The time spent in Steal() is proportional to num_threads_ and we
+          // assume that new work is scheduled at a constant rate, so we divide
+          // the spin count by num_threads_.
+          const int spin_count = spin_count_.load(std::memory_order_relaxed) /
+                                 num_threads_;
+          int i = 0;
+          for (; i < spin_count && !t.hasValue(); ++i) {
             t = Steal();
           }
+          UpdateSpinCount(t.hasValue(), i);
 
           const bool stopped_spinning = StopSpinning();
           // If a task was submitted to the queue without a call to
@@ -625,11 +865,49 @@ bool WorkQueueBase<Derived>::WaitForWork(EventCount::Waiter* waiter,
     return false;
   }
 
+  IncrementRelaxed(num_parks_);
+  metrics::GetWorkQueueParksCounter()->Increment();
   event_count_.CommitWait(waiter);
   blocked_.fetch_sub(1);
   return true;
 }
 
+template <typename Derived>
+void WorkQueueBase<Derived>::NotifyParkedThreads(int num_tasks) {
+  int num_wakeups = 0;
+  for (int i = 0; i < std::min(num_tasks, num_threads_); ++i) {
+    if (!IsNotifyParkedThreadRequired()) continue;
+    // Stop as soon as there are no parked threads left to wake up.
+    if (!event_count_.Notify(/*notify_all=*/false)) break;
+    ++num_wakeups;
+  }
+  if (num_wakeups > 0) {
+    num_wakeups_.fetch_add(num_wakeups, std::memory_order_relaxed);
+    metrics::GetWorkQueueWakeupsCounter()->IncrementBy(num_wakeups);
+  }
+}
+
+template <typename Derived>
+void WorkQueueBase<Derived>::UpdateSpinCount(bool found, int num_iterations) {
+  // Racy updates from concurrently spinning threads are fine, the spin count
+  // is only a heuristic.
+  int spin_count = spin_count_.load(std::memory_order_relaxed);
+  if (found) {
+    IncrementRelaxed(num_spin_hits_);
+    metrics::GetWorkQueueSpinHitsCounter()->Increment();
+    // A task arrived late in the spin loop, spinning longer would likely avoid
+    // parking in the future.
+    if (num_iterations * num_threads_ * 2 > spin_count)
+      spin_count = spin_count * 2 < kMaxSpinCount ? spin_count * 2
+                                                  : kMaxSpinCount;
+  } else {
+    // Spinning didn't help, waste less CPU next time.
+    spin_count -= spin_count / 8;
+    if (spin_count < kMinSpinCount) spin_count = kMinSpinCount;
+  }
+  spin_count_.store(spin_count, std::memory_order_relaxed);
+}
+
 template <typename Derived>
 bool WorkQueueBase<Derived>::StartSpinning() {
   if (NumActiveThreads() > kMinActiveThreadsToStartSpinning) return false;
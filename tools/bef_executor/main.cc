@@ -22,6 +22,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "tfrt/bef_executor_driver/bef_executor_driver.h"
 #include "tfrt/host_context/host_allocator.h"
+#include "tfrt/metrics/default_metrics_registry.h"
 #include "tfrt/tracing/tracing.h"
 
 static llvm::cl::opt<std::string> cl_input_filename(  // NOLINT
@@ -60,9 +61,22 @@ static llvm::cl::opt<tfrt::HostAllocatorType> cl_host_allocator_type(  // NOLINT
         clEnumValN(tfrt::HostAllocatorType::kProfiledMalloc,
                    "profiled_allocator", "Malloc with metric profiling."),
         clEnumValN(tfrt::HostAllocatorType::kLeakCheckMalloc,
-                   "leak_check_allocator", "Malloc with memory leak check.")),
+                   "leak_check_allocator", "Malloc with memory leak check."),
+        clEnumValN(tfrt::HostAllocatorType::kThreadCachingMalloc,
+                   "thread_caching_allocator",
+                   "Per-thread caches of size-classed chunks.")),
     llvm::cl::init(tfrt::HostAllocatorType::kLeakCheckMalloc));
 
+static llvm::cl::opt<tfrt::KernelScheduling> cl_kernel_scheduling(  // NOLINT
+    "kernel_scheduling",
+    llvm::cl::desc("Specify the scheduling policy of ready kernels:"),
+    llvm::cl::values(
+        clEnumValN(tfrt::KernelScheduling::kStreamTask, "stream_task",
+                   "Enqueue one work queue task per stream."),
+        clEnumValN(tfrt::KernelScheduling::kWorkStealing, "work_stealing",
+                   "Push stream runs to per-worker lists for stealing.")),
+    llvm::cl::init(tfrt::KernelScheduling::kStreamTask));
+
 // Enable aggregate op handler types to be specified on the command line.
 static llvm::cl::opt<bool> cl_enable_tracing(  // NOLINT
     "enable_tracing", llvm::cl::desc("Enable Performance Tracing"),
@@ -82,6 +96,27 @@ static llvm::cl::opt<bool> cl_print_error_code(  // NOLINT
     llvm::cl::desc("Print error code if there's any error."),
     llvm::cl::Optional, llvm::cl::ValueDisallowed);
 
+static llvm::cl::opt<bool> cl_profile_kernels(  // NOLINT
+    "profile_kernels",
+    llvm::cl::desc("Print a per-kernel profile of each executed function."),
+    llvm::cl::Optional, llvm::cl::ValueDisallowed);
+
+static llvm::cl::opt<bool> cl_print_memory_plan(  // NOLINT
+    "print_memory_plan",
+    llvm::cl::desc("Run each sync function twice and print its memory plan."),
+    llvm::cl::Optional, llvm::cl::ValueDisallowed);
+
+static llvm::cl::opt<std::string> cl_kernel_cost_profile(  // NOLINT
+    "kernel_cost_profile",
+    llvm::cl::desc("Write the mean run time of each kernel to this file, to "
+                   "be used by tfrt_opt -tfrt-apply-cost-profile."),
+    llvm::cl::value_desc("filename"), llvm::cl::init(""));
+
+static llvm::cl::opt<bool> cl_print_metrics(  // NOLINT
+    "print_metrics",
+    llvm::cl::desc("Print the runtime metrics in Prometheus text format."),
+    llvm::cl::Optional, llvm::cl::ValueDisallowed);
+
 //===----------------------------------------------------------------------===//
 // Driver main
 //===----------------------------------------------------------------------===//
@@ -97,11 +132,21 @@ int main(int argc, char** argv) {
   run_config.test_init_function = cl_test_init_function;
   run_config.work_queue_type = cl_work_queue_type;
   run_config.host_allocator_type = cl_host_allocator_type;
+  run_config.kernel_scheduling = cl_kernel_scheduling;
   run_config.print_error_code = cl_print_error_code;
+  run_config.profile_kernels = cl_profile_kernels;
+  run_config.print_memory_plan = cl_print_memory_plan;
+  run_config.kernel_cost_profile = cl_kernel_cost_profile;
 
   llvm::Optional<tfrt::tracing::TracingRequester> tracing;
   if (cl_enable_tracing) tracing.emplace();
   tfrt::tracing::SetTracingLevel(cl_tracing_level);
 
-  return RunBefExecutor(run_config);
+  tfrt::metrics::DefaultMetricsRegistry* metrics_registry = nullptr;
+  if (cl_print_metrics)
+    metrics_registry = tfrt::metrics::RegisterDefaultMetricsRegistry();
+
+  int status = RunBefExecutor(run_config);
+  if (metrics_registry) metrics_registry->WritePrometheusText(llvm::outs());
+  return status;
 }